@@ -36,6 +36,9 @@
 #include <errno.h>
 #include <unistd.h>
 #include <assert.h>
+#include <poll.h>
+#include <time.h>
+#include <sys/eventfd.h>
 #include "fpga_dma_internal.h"
 #include "fpga_dma.h"
 #include "tbb/concurrent_queue.h"
@@ -333,6 +336,7 @@ static void assign_hw_desc(msgdma_sw_desc_t *sw_desc,
 	else
 		hw_descp->hw_desc->owned_by_hw = 0;
 
+	hw_descp->hw_desc->ctrl.transfer_irq_en = 0;
 	hw_descp->hw_desc->ctrl.early_done_en = 1;
 	hw_descp->hw_desc->ctrl.wait_for_wr_rsp = 1;
 	hw_descp->hw_desc->block_size = block_size;
@@ -379,6 +383,102 @@ static fpga_result destroy_sw_desc(msgdma_sw_desc *sw_desc) {
 	return FPGA_OK;
 }
 
+// Segment tx_ctrl for a vector request: the segments form one packet,
+// so SOP goes on the first segment and EOP on the last
+static fpga_dma_tx_ctrl_t segment_tx_ctrl(fpga_dma_tx_ctrl_t tx_ctrl,
+					  bool first, bool last) {
+	bool sop, eop;
+
+	if (tx_ctrl != GENERATE_SOP &&
+	    tx_ctrl != GENERATE_EOP &&
+	    tx_ctrl != GENERATE_SOP_AND_EOP)
+		return tx_ctrl;
+
+	sop = first && (tx_ctrl == GENERATE_SOP || tx_ctrl == GENERATE_SOP_AND_EOP);
+	eop = last && (tx_ctrl == GENERATE_EOP || tx_ctrl == GENERATE_SOP_AND_EOP);
+
+	if (sop && eop)
+		return GENERATE_SOP_AND_EOP;
+	if (sop)
+		return GENERATE_SOP;
+	if (eop)
+		return GENERATE_EOP;
+	return TX_NO_PACKET;
+}
+
+// A vector request: one sw_desc (and one semaphore) for the request,
+// plus one lightweight child per segment for the dispatcher to pack
+static msgdma_sw_desc* init_vec_sw_desc(fpga_dma_transfer_t transfer,
+					const fpga_dma_segment_t *segs,
+					uint64_t num_segs) {
+	msgdma_sw_desc_t *req;
+	struct fpga_dma_transfer *seg_transfers;
+	uint64_t i;
+
+	req = init_sw_desc(transfer);
+	if (!req)
+		return NULL;
+
+	req->children = (msgdma_sw_desc_t*)calloc((size_t)num_segs, sizeof(msgdma_sw_desc_t));
+	seg_transfers = (struct fpga_dma_transfer*)calloc((size_t)num_segs, sizeof(struct fpga_dma_transfer));
+	if (!req->children || !seg_transfers) {
+		free(req->children);
+		free(seg_transfers);
+		destroy_sw_desc(req);
+		return NULL;
+	}
+
+	req->num_children = num_segs;
+	req->remaining = num_segs;
+	req->transfer->bytes_transferred = 0;
+	req->transfer->eop_arrived = false;
+
+	for (i = 0; i < num_segs; i++) {
+		struct fpga_dma_transfer *t = &seg_transfers[i];
+		t->src = segs[i].src;
+		t->dst = segs[i].dst;
+		t->len = segs[i].len;
+		t->transfer_type = transfer->transfer_type;
+		t->tx_ctrl = segment_tx_ctrl(transfer->tx_ctrl, i == 0, i == num_segs - 1);
+		t->rx_ctrl = transfer->rx_ctrl;
+		// hand the final block to hardware with the last segment
+		t->is_last_buf = (i == num_segs - 1);
+		req->children[i].transfer = t;
+		req->children[i].parent = req;
+	}
+
+	return req;
+}
+
+static fpga_result destroy_vec_sw_desc(msgdma_sw_desc *req) {
+	// children share one allocation of transfers
+	free(req->children[0].transfer);
+	free(req->children);
+	req->children = NULL;
+	return destroy_sw_desc(req);
+}
+
+// Account for one completed segment of a vector request. The request
+// completes, once, with its last segment.
+static void complete_segment(msgdma_sw_desc_t *req,
+			     fpga_dma_transfer_status_t status) {
+	req->transfer->bytes_transferred += status.bytes_transferred;
+	if (status.eop_arrived)
+		req->transfer->eop_arrived = true;
+
+	if (--req->remaining)
+		return;
+
+	if (req->transfer->cb) {
+		status.eop_arrived = req->transfer->eop_arrived;
+		status.bytes_transferred = req->transfer->bytes_transferred;
+		req->transfer->cb(req->transfer->context, status);
+		destroy_vec_sw_desc(req);
+	} else {
+		sem_post(&req->tf_status);
+	}
+}
+
 // debug utilities
 #if FPGA_DMA_DEBUG
 static void dump_hw_desc(int i, msgdma_hw_desc_t *desc)
@@ -422,6 +522,112 @@ static void dump_hw_desc_log(int i, msgdma_hw_desc_t *desc, ofstream &f)
 #endif
 }
 
+static inline fpga_dma_completion_mode_t completion_mode(fpga_dma_handle_t dma_h)
+{
+	return __atomic_load_n(&dma_h->completion_mode, __ATOMIC_RELAXED);
+}
+
+static inline void cpu_relax(void)
+{
+	__builtin_ia32_pause();
+}
+
+// Wake a worker sleeping in queue_wait(). Called after pushing to
+// a queue the worker consumes. The fence orders the push before the
+// load of the sleeping flag; queue_wait() orders the store of the
+// flag before its final emptiness check, so one side always sees
+// the other and no wake-up is lost.
+static void queue_notify(int efd, bool *sleeping)
+{
+	uint64_t one = 1;
+
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if (__atomic_load_n(sleeping, __ATOMIC_RELAXED)) {
+		if (write(efd, &one, sizeof(one)) != sizeof(one))
+			FPGA_DMA_ERR("eventfd write failed");
+	}
+}
+
+// Wait for q to become non-empty. Busy-polls in
+// FPGA_DMA_COMPLETION_POLL mode; otherwise spins for
+// FPGA_DMA_SPIN_COUNT iterations, then sleeps on efd.
+template <typename T>
+static void queue_wait(fpga_dma_handle_t dma_h, concurrent_queue<T> &q,
+		       int efd, bool *sleeping)
+{
+	uint64_t spins = 0;
+	uint64_t cnt;
+
+	while (q.empty()) {
+		if (completion_mode(dma_h) == FPGA_DMA_COMPLETION_POLL)
+			continue;
+
+		if (++spins < FPGA_DMA_SPIN_COUNT) {
+			cpu_relax();
+			continue;
+		}
+
+		__atomic_store_n(sleeping, true, __ATOMIC_RELAXED);
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+		if (q.empty()) {
+			if (read(efd, &cnt, sizeof(cnt)) < 0 && errno != EINTR)
+				FPGA_DMA_ERR("eventfd read failed");
+		}
+		__atomic_store_n(sleeping, false, __ATOMIC_RELAXED);
+		spins = 0;
+	}
+}
+
+// Acknowledge the prefetcher interrupt (write-1-to-clear)
+static void clear_irq(fpga_dma_handle_t dma_h)
+{
+	msgdma_prefetcher_status_t status;
+	status.reg = 0;
+	status.st.irq = 1;
+	MMIOWrite32Blk(dma_h, PREFETCHER_STATUS(dma_h), (uint64_t)&status.reg, sizeof(uint32_t));
+}
+
+// Wait for hardware to hand a descriptor back to software
+static void hw_desc_wait(fpga_dma_handle_t dma_h, msgdma_hw_desc_t *hw_desc)
+{
+	uint64_t spins = 0;
+	uint64_t sleep_ns = FPGA_DMA_MIN_SLEEP_NS;
+	fpga_dma_completion_mode_t mode;
+	struct pollfd pfd;
+	struct timespec ts;
+	uint64_t cnt;
+
+	while (hw_desc->owned_by_hw == 1) {
+		mode = completion_mode(dma_h);
+		if (mode == FPGA_DMA_COMPLETION_POLL)
+			continue;
+
+		if (++spins < FPGA_DMA_SPIN_COUNT) {
+			cpu_relax();
+			continue;
+		}
+
+		if (mode == FPGA_DMA_COMPLETION_INTERRUPT && dma_h->irq_fd >= 0) {
+			pfd.fd = dma_h->irq_fd;
+			pfd.events = POLLIN;
+			pfd.revents = 0;
+			if (poll(&pfd, 1, FPGA_DMA_IRQ_TIMEOUT_MS) > 0 &&
+			    (pfd.revents & POLLIN)) {
+				if (read(dma_h->irq_fd, &cnt, sizeof(cnt)) < 0)
+					FPGA_DMA_ERR("interrupt read failed");
+				clear_irq(dma_h);
+			}
+			continue;
+		}
+
+		ts.tv_sec = 0;
+		ts.tv_nsec = sleep_ns;
+		nanosleep(&ts, NULL);
+		if (sleep_ns < FPGA_DMA_MAX_SLEEP_NS)
+			sleep_ns <<= 1;
+	}
+}
+
 // Dispatcher worker thread
 // Process transfers from ingress queue. For each transfer,
 // assign a hardware descriptor from a block
@@ -438,6 +644,8 @@ static void *dispatcherWorker(void* dma_handle) {
 	uint64_t desc_count = 1;
 	msgdma_sw_desc_t *sw_desc[FPGA_DMA_BLOCK_SIZE+1];
 	msgdma_sw_desc_t *first_sw_desc;
+	msgdma_sw_desc_t *req = nullptr;
+	uint64_t num_segs, seg;
 	msgdma_hw_descp_t *hw_descp = nullptr;
 	bool is_owned_by_hw;
 	uint8_t block_size = 0;
@@ -464,14 +672,22 @@ static void *dispatcherWorker(void* dma_handle) {
 	debug_print("started dispatcher worker\n");
 	while (1) {
 		// wait for a valid transfer
-		while(dma_h->ingress_queue.empty());
-		if (dma_h->ingress_queue.try_pop(sw_desc[desc_count])) {
-			if (sw_desc[desc_count]->kill_worker) {
-				disp_log.close();
-				dma_h->pending_queue.push(sw_desc[desc_count]);
-				debug_print("Killing worker\n");
-				break;
-			}
+		queue_wait(dma_h, dma_h->ingress_queue, dma_h->disp_efd, &dma_h->disp_sleeping);
+		if (!dma_h->ingress_queue.try_pop(req))
+			continue;
+
+		if (req->kill_worker) {
+			disp_log.close();
+			dma_h->pending_queue.push(req);
+			queue_notify(dma_h->comp_efd, &dma_h->comp_sleeping);
+			debug_print("Killing worker\n");
+			break;
+		}
+
+		// a vector request is packed as one descriptor per segment
+		num_segs = req->num_children ? req->num_children : 1;
+		for (seg = 0; seg < num_segs; seg++) {
+			sw_desc[desc_count] = req->num_children ? &req->children[seg] : req;
 
 			// make a note of the first block descriptor
 			// mark it valid only after packing rest of the block
@@ -491,7 +707,7 @@ static void *dispatcherWorker(void* dma_handle) {
 			
 			// assign a free hardware descriptor to this transfer
 			// if a free descriptor isn't available, wait here
-			while(dma_h->free_desc.empty());
+			queue_wait(dma_h, dma_h->free_desc, dma_h->disp_efd, &dma_h->disp_sleeping);
 			dma_h->free_desc.try_pop(hw_descp);
 
 			sw_desc[desc_count]->id = desc_count;
@@ -502,6 +718,10 @@ static void *dispatcherWorker(void* dma_handle) {
 				sw_desc[desc_count]->transfer->is_last_buf /*app. requested block dispatch for this transfer*/
 				) {
 
+				// interrupt once the whole block has completed
+				if (completion_mode(dma_h) == FPGA_DMA_COMPLETION_INTERRUPT)
+					sw_desc[desc_count]->hw_descp->hw_desc->ctrl.transfer_irq_en = 1;
+
 				first_sw_desc->hw_descp->hw_desc->block_size = desc_count - 1;
 				first_sw_desc->hw_descp->hw_desc->owned_by_hw = 1;
 
@@ -513,11 +733,12 @@ static void *dispatcherWorker(void* dma_handle) {
 						sw_desc[k]->last = 1;
 					dma_h->pending_queue.push(sw_desc[k]);
 				}
+				queue_notify(dma_h->comp_efd, &dma_h->comp_sleeping);
 
 				// Skip invalid descriptors
 				for(k=1; k<= (FPGA_DMA_BLOCK_SIZE-desc_count); k++) {
 					msgdma_hw_descp_t *unused_hw_descp = nullptr;
-					while(dma_h->free_desc.empty());
+					queue_wait(dma_h, dma_h->free_desc, dma_h->disp_efd, &dma_h->disp_sleeping);
 					dma_h->free_desc.try_pop(unused_hw_descp);
 					dump_hw_desc_log(0, unused_hw_descp->hw_desc, disp_log);
 					dma_h->invalid_desc_queue.push(unused_hw_descp);
@@ -548,13 +769,18 @@ static void *completionWorker(void* dma_handle) {
 
 	debug_print("started completion worker\n");
 	while (1) {
-		while(dma_h->pending_queue.empty());
+		queue_wait(dma_h, dma_h->pending_queue, dma_h->comp_efd, &dma_h->comp_sleeping);
 		if (dma_h->pending_queue.try_pop(sw_desc)) {
 			if (sw_desc->kill_worker)
 				break;
-			while(sw_desc->hw_descp->hw_desc->owned_by_hw == 1);
+			hw_desc_wait(dma_h, sw_desc->hw_descp->hw_desc);
 			sw_desc->hw_descp->hw_desc->owned_by_hw = 0;
 
+			// capture the status before the descriptor is reused
+			fpga_dma_transfer_status_t status;
+			status.eop_arrived = sw_desc->hw_descp->hw_desc->eop_arrived;
+			status.bytes_transferred = sw_desc->hw_descp->hw_desc->bytes_transferred;
+
 			// return hw_descp to free pool
 			dma_h->free_desc.push(sw_desc->hw_descp);
 
@@ -565,11 +791,14 @@ static void *completionWorker(void* dma_handle) {
 					dma_h->free_desc.push(unused_hw_descp);
 				}
 			}
+			queue_notify(dma_h->disp_efd, &dma_h->disp_sleeping);
+
+			if (sw_desc->parent) {
+				complete_segment(sw_desc->parent, status);
+				continue;
+			}
 
 			if (sw_desc->transfer->cb) {
-				fpga_dma_transfer_status_t status;
-				status.eop_arrived = sw_desc->hw_descp->hw_desc->eop_arrived;
-				status.bytes_transferred = sw_desc->hw_descp->hw_desc->bytes_transferred;
 				sw_desc->transfer->cb(sw_desc->transfer->context, status);
 				destroy_sw_desc(sw_desc);
 			}
@@ -580,6 +809,73 @@ static void *completionWorker(void* dma_handle) {
 	return dma_h;
 }
 
+// Register for the DMA interrupt and unmask it in the prefetcher
+// and dispatcher
+static fpga_result enable_irq(fpga_dma_handle_t dma_h, uint32_t irq_vector)
+{
+	fpga_result res;
+	msgdma_prefetcher_ctrl_t prefetcher_ctrl;
+	msgdma_ctrl_t ctrl;
+
+	res = fpgaCreateEventHandle(&dma_h->irq_eh);
+	ON_ERR_RETURN(res, "fpgaCreateEventHandle");
+
+	res = fpgaRegisterEvent(dma_h->fpga_h, FPGA_EVENT_INTERRUPT, dma_h->irq_eh, irq_vector);
+	if (res != FPGA_OK) {
+		fpgaDestroyEventHandle(&dma_h->irq_eh);
+		dma_h->irq_eh = NULL;
+		return res;
+	}
+
+	res = fpgaGetOSObjectFromEventHandle(dma_h->irq_eh, &dma_h->irq_fd);
+	if (res != FPGA_OK) {
+		fpgaUnregisterEvent(dma_h->fpga_h, FPGA_EVENT_INTERRUPT, dma_h->irq_eh);
+		fpgaDestroyEventHandle(&dma_h->irq_eh);
+		dma_h->irq_eh = NULL;
+		dma_h->irq_fd = -1;
+		return res;
+	}
+
+	res = MMIORead64Blk(dma_h, PREFETCHER_CTRL(dma_h), (uint64_t)&prefetcher_ctrl.reg, sizeof(prefetcher_ctrl.reg));
+	ON_ERR_RETURN(res, "reading prefetcher control");
+	prefetcher_ctrl.ct.irq_mask = 1;
+	res = MMIOWrite64Blk(dma_h, PREFETCHER_CTRL(dma_h), (uint64_t)&prefetcher_ctrl.reg, sizeof(prefetcher_ctrl.reg));
+	ON_ERR_RETURN(res, "enabling prefetcher interrupt");
+
+	res = MMIORead32Blk(dma_h, CSR_CONTROL(dma_h), (uint64_t)&ctrl.reg, sizeof(ctrl.reg));
+	ON_ERR_RETURN(res, "reading dispatcher control");
+	ctrl.ct.global_intr_en_mask = 1;
+	res = MMIOWrite32Blk(dma_h, CSR_CONTROL(dma_h), (uint64_t)&ctrl.reg, sizeof(ctrl.reg));
+	ON_ERR_RETURN(res, "enabling dispatcher interrupt");
+
+	clear_irq(dma_h);
+	return FPGA_OK;
+}
+
+static void disable_irq(fpga_dma_handle_t dma_h)
+{
+	msgdma_prefetcher_ctrl_t prefetcher_ctrl;
+	msgdma_ctrl_t ctrl;
+
+	if (!dma_h->irq_eh)
+		return;
+
+	if (MMIORead64Blk(dma_h, PREFETCHER_CTRL(dma_h), (uint64_t)&prefetcher_ctrl.reg, sizeof(prefetcher_ctrl.reg)) == FPGA_OK) {
+		prefetcher_ctrl.ct.irq_mask = 0;
+		MMIOWrite64Blk(dma_h, PREFETCHER_CTRL(dma_h), (uint64_t)&prefetcher_ctrl.reg, sizeof(prefetcher_ctrl.reg));
+	}
+
+	if (MMIORead32Blk(dma_h, CSR_CONTROL(dma_h), (uint64_t)&ctrl.reg, sizeof(ctrl.reg)) == FPGA_OK) {
+		ctrl.ct.global_intr_en_mask = 0;
+		MMIOWrite32Blk(dma_h, CSR_CONTROL(dma_h), (uint64_t)&ctrl.reg, sizeof(ctrl.reg));
+	}
+
+	fpgaUnregisterEvent(dma_h->fpga_h, FPGA_EVENT_INTERRUPT, dma_h->irq_eh);
+	fpgaDestroyEventHandle(&dma_h->irq_eh);
+	dma_h->irq_eh = NULL;
+	dma_h->irq_fd = -1;
+}
+
 // public APIs
 fpga_result fpgaCountDMAChannels(fpga_handle fpga, size_t *count) {
 	// Discover total# DMA channels by traversing the device feature list
@@ -695,6 +991,11 @@ fpga_result fpgaDMAOpen(fpga_handle fpga, uint64_t dma_channel_index, fpga_dma_h
 	dma_h->fpga_h = fpga;
 	dma_h->mmio_num = 0;
 	dma_h->mmio_offset = 0;
+	dma_h->completion_mode = FPGA_DMA_COMPLETION_POLL;
+	dma_h->disp_efd = -1;
+	dma_h->comp_efd = -1;
+	dma_h->irq_eh = NULL;
+	dma_h->irq_fd = -1;
 
 #ifndef USE_ASE
 	res = fpgaMapMMIO(dma_h->fpga_h, 0, (uint64_t **)&dma_h->mmio_va);
@@ -847,6 +1148,12 @@ fpga_result fpgaDMAOpen(fpga_handle fpga, uint64_t dma_channel_index, fpga_dma_h
 		nxt->next = chan;
 	}
 
+	// Wake-up channels for the worker threads
+	dma_h->disp_efd = eventfd(0, EFD_CLOEXEC);
+	dma_h->comp_efd = eventfd(0, EFD_CLOEXEC);
+	if (dma_h->disp_efd < 0 || dma_h->comp_efd < 0)
+		ON_ERR_GOTO(FPGA_EXCEPTION, rel_buf, "eventfd");
+
 	// Start worker threads
 	if (pthread_create(&dma_h->ingress_id, NULL, dispatcherWorker, (void*)dma_h) != 0) {
 		res = FPGA_EXCEPTION;
@@ -864,6 +1171,7 @@ fpga_result fpgaDMAOpen(fpga_handle fpga, uint64_t dma_channel_index, fpga_dma_h
 			ON_ERR_GOTO(FPGA_NO_MEMORY, rel_buf, "init sw desc");
 		sw_desc->kill_worker = true;
 		dma_h->ingress_queue.push(sw_desc);
+		queue_notify(dma_h->disp_efd, &dma_h->disp_sleeping);
 
 		// wait workers to die
 		if (pthread_join(dma_h->ingress_id, &th_retval))
@@ -878,6 +1186,10 @@ fpga_result fpgaDMAOpen(fpga_handle fpga, uint64_t dma_channel_index, fpga_dma_h
 rel_buf:
 	if(dma_h){
 		pthread_mutex_destroy(&dma_h->dma_mutex);
+		if (dma_h->disp_efd >= 0)
+			close(dma_h->disp_efd);
+		if (dma_h->comp_efd >= 0)
+			close(dma_h->comp_efd);
 	}
 	if(dummy_transfer){
 		free(dummy_transfer);
@@ -957,6 +1269,7 @@ fpga_result fpgaDMAClose(fpga_dma_handle_t dma_h) {
 	}
 	sw_desc->kill_worker = true;
 	dma_h->ingress_queue.push(sw_desc);
+	queue_notify(dma_h->disp_efd, &dma_h->disp_sleeping);
 
 	// wait workers to die
 	if (pthread_join(dma_h->ingress_id, &th_retval)) {
@@ -968,6 +1281,10 @@ fpga_result fpgaDMAClose(fpga_dma_handle_t dma_h) {
 	}
 	fpgaDMATransferDestroy(&dummy_transfer);
 
+	disable_irq(dma_h);
+	close(dma_h->disp_efd);
+	close(dma_h->comp_efd);
+
 	// stop dispatcher
 	msgdma_ctrl_t ctrl;
 	ctrl = {0};
@@ -1030,6 +1347,60 @@ fpga_result fpgaGetDMAChannelType(fpga_dma_handle_t dma, fpga_dma_channel_type_t
 	return FPGA_OK;
 }
 
+fpga_result fpgaDMASetCompletionMode(fpga_dma_handle_t dma,
+				     fpga_dma_completion_mode_t mode,
+				     uint32_t irq_vector) {
+	uint64_t one = 1;
+
+	if (!dma) {
+		FPGA_DMA_ERR("Invalid DMA handle");
+		return FPGA_INVALID_PARAM;
+	}
+
+	if (mode >= FPGA_DMA_MAX_COMPLETION_MODE) {
+		FPGA_DMA_ERR("Invalid completion mode");
+		return FPGA_INVALID_PARAM;
+	}
+
+	// Fall back to polling while the interrupt is reconfigured
+	__atomic_store_n(&dma->completion_mode, FPGA_DMA_COMPLETION_POLL, __ATOMIC_SEQ_CST);
+	disable_irq(dma);
+
+	if (mode == FPGA_DMA_COMPLETION_INTERRUPT &&
+	    enable_irq(dma, irq_vector) != FPGA_OK) {
+		debug_print("DMA interrupt unavailable, using adaptive completion\n");
+		disable_irq(dma);
+		mode = FPGA_DMA_COMPLETION_ADAPTIVE;
+	}
+
+	__atomic_store_n(&dma->completion_mode, mode, __ATOMIC_SEQ_CST);
+
+	// Kick sleeping workers so they pick up the new mode
+	if (write(dma->disp_efd, &one, sizeof(one)) != sizeof(one) ||
+	    write(dma->comp_efd, &one, sizeof(one)) != sizeof(one)) {
+		FPGA_DMA_ERR("eventfd write failed");
+		return FPGA_EXCEPTION;
+	}
+
+	return FPGA_OK;
+}
+
+fpga_result fpgaDMAGetCompletionMode(fpga_dma_handle_t dma,
+				     fpga_dma_completion_mode_t *mode) {
+	if (!dma) {
+		FPGA_DMA_ERR("Invalid DMA handle");
+		return FPGA_INVALID_PARAM;
+	}
+
+	if (!mode) {
+		FPGA_DMA_ERR("Invalid pointer to completion mode");
+		return FPGA_INVALID_PARAM;
+	}
+
+	*mode = completion_mode(dma);
+	return FPGA_OK;
+}
+
 fpga_result fpgaDMATransferInit(fpga_dma_transfer_t *transfer_p) {
 	fpga_result res = FPGA_OK;
 	fpga_dma_transfer_t tmp;
@@ -1336,17 +1707,10 @@ fpga_result fpgaDMATransferCheckEopArrived(fpga_dma_transfer_t transfer, bool *e
 	return FPGA_OK;
 }
 
-fpga_result fpgaDMATransfer(fpga_dma_handle_t dma, fpga_dma_transfer_t transfer) {
-	if (!dma) {
-		FPGA_DMA_ERR("Invalid DMA handle");
-		return FPGA_INVALID_PARAM;
-	}
-
-	if (!transfer) {
-		FPGA_DMA_ERR("Invalid DMA transfer");
-		return FPGA_INVALID_PARAM;
-	}
-
+// Check that a transfer of len bytes with the attributes of transfer
+// and the given tx_ctrl is valid on the channel
+static fpga_result check_transfer(fpga_dma_handle_t dma, fpga_dma_transfer_t transfer,
+				  fpga_dma_tx_ctrl_t tx_ctrl, uint64_t len) {
 	if (!(transfer->transfer_type == HOST_MM_TO_FPGA_ST ||
 		transfer->transfer_type == FPGA_ST_TO_HOST_MM ||
 		transfer->transfer_type == HOST_MM_TO_FPGA_MM ||
@@ -1373,22 +1737,43 @@ fpga_result fpgaDMATransfer(fpga_dma_handle_t dma, fpga_dma_transfer_t transfer)
 	}
 
 	// Avalon ST does not allow signalling of partial data for non-packet transfers (transfers without SOP/EOP).
-	if (((transfer->tx_ctrl == TX_NO_PACKET && dma->ch_type == TX_ST) || 
-		(transfer->rx_ctrl == RX_NO_PACKET && dma->ch_type == RX_ST)) && ((transfer->len % 64) != 0)) {
+	if (((tx_ctrl == TX_NO_PACKET && dma->ch_type == TX_ST) || 
+		(transfer->rx_ctrl == RX_NO_PACKET && dma->ch_type == RX_ST)) && ((len % 64) != 0)) {
 		FPGA_DMA_ERR("Incompatible transfer length for transfer type NO_PKT");
 		return FPGA_INVALID_PARAM;
 	}
 	// Partial data transfer is not permitted for MM TO MM transfers
-	if ((dma->ch_type == MM ) && (transfer->len % 64) != 0) {
+	if ((dma->ch_type == MM ) && (len % 64) != 0) {
                 FPGA_DMA_ERR("Incompatible transfer length for MM to MM transfers");
                 return FPGA_INVALID_PARAM;
         }
 
+	return FPGA_OK;
+}
+
+fpga_result fpgaDMATransfer(fpga_dma_handle_t dma, fpga_dma_transfer_t transfer) {
+	fpga_result res;
+
+	if (!dma) {
+		FPGA_DMA_ERR("Invalid DMA handle");
+		return FPGA_INVALID_PARAM;
+	}
+
+	if (!transfer) {
+		FPGA_DMA_ERR("Invalid DMA transfer");
+		return FPGA_INVALID_PARAM;
+	}
+
+	res = check_transfer(dma, transfer, transfer->tx_ctrl, transfer->len);
+	if (res != FPGA_OK)
+		return res;
+
 	// create a copy of the buffer and enqueue to ingress queue
 	msgdma_sw_desc *sw_desc = init_sw_desc(transfer);
 	if (!sw_desc)
 		return FPGA_EXCEPTION;
 	dma->ingress_queue.push(sw_desc);
+	queue_notify(dma->disp_efd, &dma->disp_sleeping);
 
 	// Blocking transfer
 	if (!sw_desc->transfer->cb) {
@@ -1405,6 +1790,56 @@ fpga_result fpgaDMATransfer(fpga_dma_handle_t dma, fpga_dma_transfer_t transfer)
 	return FPGA_OK;
 }
 
+fpga_result fpgaDMATransferVec(fpga_dma_handle_t dma,
+			       fpga_dma_transfer_t transfer,
+			       const fpga_dma_segment_t *segs,
+			       uint64_t num_segs) {
+	fpga_result res;
+	uint64_t i;
+
+	if (!dma) {
+		FPGA_DMA_ERR("Invalid DMA handle");
+		return FPGA_INVALID_PARAM;
+	}
+
+	if (!transfer) {
+		FPGA_DMA_ERR("Invalid DMA transfer");
+		return FPGA_INVALID_PARAM;
+	}
+
+	if (!segs || !num_segs) {
+		FPGA_DMA_ERR("Invalid segment list");
+		return FPGA_INVALID_PARAM;
+	}
+
+	// check each segment as the dispatcher will issue it: only the
+	// first carries SOP and only the last carries EOP
+	for (i = 0; i < num_segs; i++) {
+		res = check_transfer(dma, transfer,
+				     segment_tx_ctrl(transfer->tx_ctrl, i == 0, i == num_segs - 1),
+				     segs[i].len);
+		if (res != FPGA_OK)
+			return res;
+	}
+
+	// one request for all segments, enqueued once
+	msgdma_sw_desc *req = init_vec_sw_desc(transfer, segs, num_segs);
+	if (!req)
+		return FPGA_NO_MEMORY;
+	dma->ingress_queue.push(req);
+	queue_notify(dma->disp_efd, &dma->disp_sleeping);
+
+	// Blocking transfer
+	if (!req->transfer->cb) {
+		sem_wait(&req->tf_status);
+		transfer->eop_arrived = req->transfer->eop_arrived;
+		transfer->bytes_transferred = req->transfer->bytes_transferred;
+		return destroy_vec_sw_desc(req);
+	}
+
+	return FPGA_OK;
+}
+
 fpga_result fpgaDMAInvalidate(fpga_dma_handle_t dma) {
 	fpga_result res = FPGA_OK;
 	if (!dma) {
@@ -1432,6 +1867,7 @@ fpga_result fpgaDMAInvalidate(fpga_dma_handle_t dma) {
 
 	// reenable dispatcher
 	ctrl = {0};
+	ctrl.ct.global_intr_en_mask = dma->irq_eh ? 1 : 0;
 	res = MMIOWrite32Blk(dma, CSR_CONTROL(dma), (uint64_t)&ctrl.reg, sizeof(ctrl.reg));
 	return res;
 }
@@ -93,6 +93,46 @@ fpga_result fpgaDMAClose(fpga_dma_handle_t dma);
 */
 fpga_result fpgaGetDMAChannelType(fpga_dma_handle_t dma, fpga_dma_channel_type_t *ch_type);
 
+/**
+* fpgaDMASetCompletionMode
+*
+* @brief                  Select how the channel waits for work and completions
+*
+*                         FPGA_DMA_COMPLETION_POLL (the default) busy-polls the
+*                         ingress queue and the hardware descriptors.
+*                         FPGA_DMA_COMPLETION_ADAPTIVE spins for a short while,
+*                         then sleeps on an eventfd while the queues are empty
+*                         and with an exponential backoff while descriptors are
+*                         owned by hardware.
+*                         FPGA_DMA_COMPLETION_INTERRUPT sleeps on the DMA
+*                         interrupt (irq_vector) between descriptor blocks. If
+*                         the interrupt cannot be registered, the channel uses
+*                         FPGA_DMA_COMPLETION_ADAPTIVE instead; query the mode
+*                         in effect with fpgaDMAGetCompletionMode().
+*
+*                         Must not be called while transfers are in flight.
+*
+* @param[in]  dma         DMA channel handle
+* @param[in]  mode        Completion mode
+* @param[in]  irq_vector  AFU interrupt vector of the channel (interrupt mode only)
+* @returns                FPGA_OK on success, return code otherwise
+*/
+fpga_result fpgaDMASetCompletionMode(fpga_dma_handle_t dma,
+				     fpga_dma_completion_mode_t mode,
+				     uint32_t irq_vector);
+
+/**
+* fpgaDMAGetCompletionMode
+*
+* @brief                  Query the completion mode in effect
+*
+* @param[in]  dma         DMA channel handle
+* @param[out] mode        Pointer to the completion mode
+* @returns                FPGA_OK on success, return code otherwise
+*/
+fpga_result fpgaDMAGetCompletionMode(fpga_dma_handle_t dma,
+				     fpga_dma_completion_mode_t *mode);
+
 /**
 * fpgaDMATransferInit
 *
@@ -317,6 +357,39 @@ fpga_result fpgaDMATransferSetLast(fpga_dma_transfer_t transfer, bool is_last_bu
 fpga_result fpgaDMATransfer(fpga_dma_handle_t dma, const fpga_dma_transfer_t transfer);
 
 
+/**
+* fpgaDMATransferVec
+*
+* @brief                  Perform a scatter-gather DMA transfer
+*
+*                         Submits num_segs {src, dst, len} segments as a single
+*                         request. The segments are packed directly into
+*                         hardware descriptor blocks, and the request completes
+*                         once, after its last segment: the transfer callback
+*                         is invoked once (asynchronous), or the call returns
+*                         once (synchronous). Bytes transferred are summed over
+*                         the segments.
+*
+*                         The transfer supplies every other attribute. The src,
+*                         dst and len of the transfer are ignored. For TX
+*                         streaming, GENERATE_SOP marks the first segment and
+*                         GENERATE_EOP marks the last, so that the segments
+*                         form one packet. The final block is always handed
+*                         to hardware, so the transfer's last-buffer flag is
+*                         implied.
+*
+* @param[dma] dma         DMA handle
+* @param[in]  transfer    Transfer attribute object
+* @param[in]  segs        Array of segments
+* @param[in]  num_segs    Number of segments in segs
+*
+* @returns                FPGA_OK on success, return code otherwise
+*/
+fpga_result fpgaDMATransferVec(fpga_dma_handle_t dma,
+			       const fpga_dma_transfer_t transfer,
+			       const fpga_dma_segment_t *segs,
+			       uint64_t num_segs);
+
 /**
 * fpgaDMAInvalidate
 *
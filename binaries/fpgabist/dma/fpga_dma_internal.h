@@ -117,6 +117,15 @@ using namespace tbb;
 #define ALIGN_TO_CL(x) ((uint64_t)(x) & ~(CACHE_LINE_SIZE - 1))
 #define IS_CL_ALIGNED(x) (((uint64_t)(x) & (CACHE_LINE_SIZE - 1)) == 0)
 
+// Adaptive completion: busy-wait iterations before sleeping, and the
+// bounds of the exponential sleep while a descriptor is owned by hardware
+#define FPGA_DMA_SPIN_COUNT 4096
+#define FPGA_DMA_MIN_SLEEP_NS 1000
+#define FPGA_DMA_MAX_SLEEP_NS 100000
+// Interrupt completion: re-check descriptors at least this often
+// in case an interrupt is missed
+#define FPGA_DMA_IRQ_TIMEOUT_MS 10
+
 #define HOST_MEM_MASK(dma_h) (dma_h->ch_type == MM ? 0x1000000000000 : 0x0)
 
 // Convenience macros
@@ -332,6 +341,13 @@ typedef struct msgdma_sw_desc {
 	sem_t tf_status; // When locked, the transfer in progress
 	bool kill_worker;
 	uint64_t last;
+	// Vector requests (fpgaDMATransferVec) carry one child per
+	// segment. Children share the request's completion, which is
+	// signalled once the last child completes.
+	struct msgdma_sw_desc *parent;
+	struct msgdma_sw_desc *children;
+	uint64_t num_children;
+	uint64_t remaining; // children not yet complete
 } msgdma_sw_desc_t;
 
 // DMA handle
@@ -361,6 +377,18 @@ struct fpga_dma_handle {
 	sem_t dma_init;
 	volatile bool invalidate;
 	volatile bool terminate;
+	// completion mode, see fpgaDMASetCompletionMode()
+	fpga_dma_completion_mode_t completion_mode;
+	// eventfds the dispatcher and completion workers sleep on
+	// while their queues are empty; producers write to them
+	// only when the matching *_sleeping flag is set
+	int disp_efd;
+	int comp_efd;
+	bool disp_sleeping;
+	bool comp_sleeping;
+	// DMA interrupt (FPGA_DMA_COMPLETION_INTERRUPT)
+	fpga_event_handle irq_eh;
+	int irq_fd;
 };
 
 // Prefetcher ctrl register
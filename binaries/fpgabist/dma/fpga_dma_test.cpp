@@ -56,7 +56,9 @@ static void printUsage()
 "     fpga_dma_test [-h] [-B <bus>] [-D <device>] [-F <function>] [-S <segment>]\n"
 "                   -l <loopback on/off> -s <data size (bytes)> -p <payload size (bytes)>\n"
 "                   -r <transfer direction> -t <transfer type> [-f <decimation factor>]\n"
-"                   -a <FPGA local memory address>\n\n"
+"                   -a <FPGA local memory address>\n"
+"                   [-c <completion mode>] [-i <interrupt vector>]\n"
+"                   [-g <segments per submission>]\n\n"
 "         -h,--help           Print this help\n"
 "         -v,--version        Print version and exit\n"
 "         -B,--bus            Set target bus number\n"
@@ -65,6 +67,14 @@ static void printUsage()
 "         -S,--segment        Set PCIe segment\n"
 "         -s,--data_size      Total data size\n"
 "         -p,--payload_size   Payload size per DMA transfer\n"
+"         -c,--completion     How the DMA threads wait for work and completions\n"
+"            poll             Busy-poll (default)\n"
+"            adaptive         Spin briefly, then sleep\n"
+"            irq              Spin briefly, then sleep on the DMA interrupt\n"
+"         -i,--irq_vector     Interrupt vector of channel 0 for -c irq (default: 0);\n"
+"                             channel 1 uses the next vector\n"
+"         -g,--segments       Submit payloads as scatter-gather vectors of this\n"
+"                             many segments (default: one transfer per payload)\n"
 "         -r,--direction      Transfer direction\n"
 "            mtos             Memory to stream (valid for streaming DMA)\n"
 "            stom             Stream to memory (valid for streaming DMA)\n"
@@ -105,13 +115,16 @@ static void parse_args(struct config *config, int argc, char *argv[])
 			{"loopback", required_argument, 0, 'l'},
 			{"decim_factor", required_argument, 0, 'f'},
 			{"fpga_addr", required_argument, 0, 'a'},
+			{"completion", required_argument, 0, 'c'},
+			{"irq_vector", required_argument, 0, 'i'},
+			{"segments", required_argument, 0, 'g'},
       {"version", no_argument, 0, 'v'},
 			{0, 0, 0, 0}
 		};
 		char *endptr;
 		const char *tmp_optarg;
 
-		c = getopt_long(argc, argv, "hB:D:F:S:s:p:r:l:f:t:a:v", options, NULL);
+		c = getopt_long(argc, argv, "hB:D:F:S:s:p:r:l:f:t:a:c:i:g:v", options, NULL);
 		if (c == -1) {
 			break;
 		}
@@ -258,6 +271,36 @@ static void parse_args(struct config *config, int argc, char *argv[])
 			debug_print("fpga local memory address = %lx\n", (uint64_t)config->fpga_addr);
 			break;
 
+		case 'c':    /* completion mode */
+			if (NULL == tmp_optarg)
+				break;
+			if (!STR_CONST_CMP(tmp_optarg, "poll")) {
+				config->completion_mode = FPGA_DMA_COMPLETION_POLL;
+			} else if (!STR_CONST_CMP(tmp_optarg, "adaptive")) {
+				config->completion_mode = FPGA_DMA_COMPLETION_ADAPTIVE;
+			} else if (!STR_CONST_CMP(tmp_optarg, "irq")) {
+				config->completion_mode = FPGA_DMA_COMPLETION_INTERRUPT;
+			} else {
+				fprintf(stderr, "Invalid completion mode\n");
+				printUsage();
+			}
+			debug_print("completion mode = %d\n", config->completion_mode);
+			break;
+
+		case 'i':    /* interrupt vector */
+			if (NULL == tmp_optarg)
+				break;
+			config->irq_vector = (uint32_t) strtoul(tmp_optarg, &endptr, 0);
+			debug_print("irq vector = %u\n", config->irq_vector);
+			break;
+
+		case 'g':    /* segments per vector */
+			if (NULL == tmp_optarg)
+				break;
+			config->segments = (uint64_t) strtoull(tmp_optarg, &endptr, 0);
+			debug_print("segments = %ld\n", config->segments);
+			break;
+
     case 'v':    /* version */
         cout << "fpga_dma_test " << OPAE_VERSION
              << " " << OPAE_GIT_COMMIT_HASH;
@@ -290,6 +333,9 @@ int main(int argc, char *argv[]) {
 	 	.loopback = DMA_INVAL_LOOPBACK,
 		.decim_factor = CONFIG_UNINIT,
 		.fpga_addr = CONFIG_UNINIT,
+		.completion_mode = FPGA_DMA_COMPLETION_POLL,
+		.irq_vector = 0,
+		.segments = 0,
 	};
 
 	parse_args(&config, argc, argv);
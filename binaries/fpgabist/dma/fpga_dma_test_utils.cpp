@@ -29,6 +29,8 @@
  */
 #include <iostream>
 #include <cmath>
+#include <vector>
+#include <sys/resource.h>
 #include "fpga_dma_test_utils.h"
 #include "fpga_dma_common.h"
 
@@ -386,6 +388,43 @@ out:
 	return res;
 }
 
+// Submit total_size bytes as payload-size segments, config->segments
+// segments per fpgaDMATransferVec() call. Streaming ends keep their
+// address fixed. Vectors are non-blocking, except for the very last.
+static fpga_result sg_transfer(fpga_dma_handle_t dma_h, fpga_dma_transfer_t transfer,
+			       uint64_t src, bool inc_src, uint64_t dst, bool inc_dst,
+			       uint64_t total_size, struct config *config)
+{
+	std::vector<fpga_dma_segment_t> segs(config->segments);
+	fpga_result res = FPGA_OK;
+
+	while(total_size > 0) {
+		uint64_t n = 0;
+		while(n < config->segments && total_size > 0) {
+			uint64_t transfer_bytes = MIN(total_size, config->payload_size);
+			segs[n].src = src;
+			segs[n].dst = dst;
+			segs[n].len = transfer_bytes;
+			if (inc_src)
+				src += transfer_bytes;
+			if (inc_dst)
+				dst += transfer_bytes;
+			total_size -= transfer_bytes;
+			n++;
+		}
+
+		if(total_size == 0)
+			fpgaDMATransferSetTransferCallback(transfer, NULL, NULL);
+		else
+			fpgaDMATransferSetTransferCallback(transfer, transferComplete, NULL);
+
+		res = fpgaDMATransferVec(dma_h, transfer, segs.data(), n);
+		if (res != FPGA_OK)
+			break;
+	}
+	return res;
+}
+
 static fpga_result non_loopback_test(fpga_handle afc_h, fpga_dma_handle_t dma_h, struct config *config) {
 	fpga_dma_transfer_t transfer;
 	fpga_result res = FPGA_OK;
@@ -427,6 +466,12 @@ static fpga_result non_loopback_test(fpga_handle afc_h, fpga_dma_handle_t dma_h,
 		int64_t tid = ceil((double)config->data_size /(double)config->payload_size);
 		uint64_t src = battrs.iova; // host memory addr
 		uint64_t dst = config->fpga_addr; // fpga memory addr
+		if(config->segments) {
+			fpgaDMATransferSetTransferType(transfer, HOST_MM_TO_FPGA_MM);
+			res = sg_transfer(dma_h, transfer, src, true, dst, true, total_size, config);
+			ON_ERR_GOTO(res, free_transfer, "transfer error");
+			total_size = 0;
+		}
 		while(total_size > 0) {
 			uint64_t transfer_bytes = MIN(total_size, config->payload_size);
 			//debug_print("Transfer src=%lx, dst=%lx, bytes=%ld\n", (uint64_t)src, (uint64_t)0, transfer_bytes);
@@ -462,6 +507,12 @@ static fpga_result non_loopback_test(fpga_handle afc_h, fpga_dma_handle_t dma_h,
 		tid = ceil((double)config->data_size / (double)config->payload_size);
 		src = config->fpga_addr;
 		dst = battrs.iova;
+		if(config->segments) {
+			fpgaDMATransferSetTransferType(transfer, FPGA_MM_TO_HOST_MM);
+			res = sg_transfer(dma_h, transfer, src, true, dst, true, total_size, config);
+			ON_ERR_GOTO(res, free_transfer, "transfer error");
+			total_size = 0;
+		}
 		while(total_size > 0) {
 			uint64_t transfer_bytes = MIN(total_size, config->payload_size);
 
@@ -509,6 +560,13 @@ static fpga_result non_loopback_test(fpga_handle afc_h, fpga_dma_handle_t dma_h,
 		uint64_t total_size = config->data_size;
 		int64_t tid = ceil(config->data_size / config->payload_size);
 		uint64_t src = battrs.iova;
+		if(config->segments) {
+			fpgaDMATransferSetTransferType(transfer, HOST_MM_TO_FPGA_ST);
+			fpgaDMATransferSetTxControl(transfer, tx_ctrl);
+			res = sg_transfer(dma_h, transfer, src, true, 0, false, total_size, config);
+			ON_ERR_GOTO(res, free_transfer, "transfer error");
+			total_size = 0;
+		}
 		while(total_size > 0) {
 			uint64_t transfer_bytes = MIN(total_size, config->payload_size);
 			//debug_print("Transfer src=%lx, dst=%lx, bytes=%ld\n", (uint64_t)src, (uint64_t)0, transfer_bytes);
@@ -556,6 +614,13 @@ static fpga_result non_loopback_test(fpga_handle afc_h, fpga_dma_handle_t dma_h,
 		uint64_t total_size = config->data_size;
 		int64_t tid = ceil(config->data_size / config->payload_size);
 		uint64_t dst = battrs.iova;
+		if(config->segments) {
+			fpgaDMATransferSetTransferType(transfer, FPGA_ST_TO_HOST_MM);
+			fpgaDMATransferSetRxControl(transfer, rx_ctrl);
+			res = sg_transfer(dma_h, transfer, 0, false, dst, true, total_size, config);
+			ON_ERR_GOTO(res, free_transfer, "transfer error");
+			total_size = 0;
+		}
 		while(total_size > 0) {
 			uint64_t transfer_bytes = MIN(total_size, config->payload_size);
 
@@ -732,6 +797,40 @@ out:
 		return 0;
 }
 
+// Apply the requested completion mode to an open channel
+static fpga_result set_completion_mode(fpga_dma_handle_t dma_h,
+				       struct config *config,
+				       uint64_t channel)
+{
+	static const char *names[] = { "poll", "adaptive", "irq" };
+	fpga_dma_completion_mode_t mode;
+	fpga_result res;
+
+	res = fpgaDMASetCompletionMode(dma_h, config->completion_mode,
+				       config->irq_vector + channel);
+	if (res != FPGA_OK)
+		return res;
+
+	res = fpgaDMAGetCompletionMode(dma_h, &mode);
+	if (res != FPGA_OK)
+		return res;
+
+	if (mode != config->completion_mode)
+		fprintf(stderr, "channel %ld: %s completion unavailable, using %s\n",
+			channel, names[config->completion_mode], names[mode]);
+	return FPGA_OK;
+}
+
+// CPU time consumed by the process, including the DMA worker threads
+static double cpu_seconds(void)
+{
+	struct rusage ru;
+	if (getrusage(RUSAGE_SELF, &ru))
+		return 0.0;
+	return (double)(ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) +
+		(double)(ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e6;
+}
+
 fpga_result do_action(struct config *config, fpga_token afc_tok)
 {
 	fpga_dma_handle_t dma_h = NULL;
@@ -771,11 +870,17 @@ fpga_result do_action(struct config *config, fpga_token afc_tok)
 
 	debug_print("found %ld dma channels\n", ch_count);
 
+	double cpu_start;
+	cpu_start = cpu_seconds();
+
 	if(config->direction == DMA_MTOM) {
 		res = fpgaDMAOpen(afc_h, 0, &dma_h);
 		ON_ERR_GOTO(res, out_dma_close, "fpgaDMAOpen");
 		debug_print("opened memory to memory channel\n");
 
+		res = set_completion_mode(dma_h, config, 0);
+		ON_ERR_GOTO(res, out_dma_close, "fpgaDMASetCompletionMode");
+
 		// Run test
 		res = non_loopback_test(afc_h, dma_h, config);
 		ON_ERR_GOTO(res, out_dma_close, "fpgaDMAOpen");
@@ -787,11 +892,17 @@ fpga_result do_action(struct config *config, fpga_token afc_tok)
 				res = fpgaDMAOpen(afc_h, 0, &dma_h);
 				ON_ERR_GOTO(res, out_dma_close, "fpgaDMAOpen");
 				debug_print("opened memory to stream channel\n");
+
+				res = set_completion_mode(dma_h, config, 0);
+				ON_ERR_GOTO(res, out_dma_close, "fpgaDMASetCompletionMode");
 			} else {
 				// Stream to memory -> Channel 1
 				res = fpgaDMAOpen(afc_h, 1, &dma_h);
 				ON_ERR_GOTO(res, out_dma_close, "fpgaDMAOpen");
 				debug_print("opened stream to memory channel\n");
+
+				res = set_completion_mode(dma_h, config, 1);
+				ON_ERR_GOTO(res, out_dma_close, "fpgaDMASetCompletionMode");
 			}
 
 			// Run test
@@ -805,6 +916,12 @@ fpga_result do_action(struct config *config, fpga_token afc_tok)
 			res = fpgaDMAOpen(afc_h, 1, &rx_dma_h);
 			ON_ERR_GOTO(res, out_rx_close, "fpgaDMAOpen rx");
 
+			res = set_completion_mode(tx_dma_h, config, 0);
+			ON_ERR_GOTO(res, out_rx_close, "fpgaDMASetCompletionMode tx");
+
+			res = set_completion_mode(rx_dma_h, config, 1);
+			ON_ERR_GOTO(res, out_rx_close, "fpgaDMASetCompletionMode rx");
+
 			// Run test
 			res = loopback_test(afc_h, tx_dma_h, rx_dma_h, config);
 			ON_ERR_GOTO(res, out_rx_close, "loopback test failed");
@@ -812,6 +929,8 @@ fpga_result do_action(struct config *config, fpga_token afc_tok)
 		}
 	}
 
+	std::cout << "CPU time = " << cpu_seconds() - cpu_start << " s" << std::endl;
+
 out_rx_close:
 	if(rx_dma_h) {
 		res = fpgaDMAClose(rx_dma_h);
@@ -99,6 +99,9 @@ struct config {
 	enum dma_loopback loopback;
 	uint16_t decim_factor;
 	uint64_t fpga_addr;
+	fpga_dma_completion_mode_t completion_mode;
+	uint32_t irq_vector;
+	uint64_t segments;
 };
 
 typedef union {
@@ -81,6 +81,22 @@ typedef enum {
 	MM
 } fpga_dma_channel_type_t;
 
+// One segment of a scatter-gather transfer
+typedef struct {
+	uint64_t src;
+	uint64_t dst;
+	uint64_t len;
+} fpga_dma_segment_t;
+
+// How the channel worker threads wait for new transfers and for
+// the hardware to complete descriptors
+typedef enum {
+	FPGA_DMA_COMPLETION_POLL = 0,  // busy-poll (lowest latency, 2 cores/channel)
+	FPGA_DMA_COMPLETION_ADAPTIVE,  // spin briefly, then sleep with backoff
+	FPGA_DMA_COMPLETION_INTERRUPT, // spin briefly, then sleep on the DMA IRQ
+	FPGA_DMA_MAX_COMPLETION_MODE
+} fpga_dma_completion_mode_t;
+
 // Opaque object that describes a DMA transfer
 typedef struct fpga_dma_transfer *fpga_dma_transfer_t;
 
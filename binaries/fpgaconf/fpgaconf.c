@@ -35,6 +35,8 @@
  * Features:
  *   * Auto-discovery of compatible slots for supplied bitstream
  *   * Dry-run mode ("what would happen if...?")
+ *   * Streaming mode, reading the bitstream from a file or pipe
+ *   * Programming every compatible slot in parallel
  */
 #define _GNU_SOURCE
 #ifdef HAVE_CONFIG_H
@@ -46,6 +48,10 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
+#include <pthread.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <sys/stat.h>
 
 #include <uuid/uuid.h>
@@ -79,11 +85,17 @@ struct config {
 	} mode;
 	int flags;
 	char *filename;
+	bool stream;
+	bool all;
+	unsigned int jobs;
 } config = {.verbosity = 0,
 	    .dry_run = false,
 	    .mode = NORMAL,
 	    .flags = 0,
-	    .filename = NULL };
+	    .filename = NULL,
+	    .stream = false,
+	    .all = false,
+	    .jobs = 0 };
 
 /*
  * Print readable error message for fpga_results
@@ -113,12 +125,23 @@ void help(void)
 	       "\n"
 	       "Usage:\n"
 	       "        fpgaconf [-hVvn] [-S <segment>] [-B <bus>] [-D <device>] [-F <function>] [PCI_ADDR] <gbs>\n"
+	       "        fpgaconf --stream [-hVn] [-S <segment>] [-B <bus>] [-D <device>] [-F <function>] [PCI_ADDR] <gbs|->\n"
+	       "        fpgaconf --all [-hVn] [-j <jobs>] [-S <segment>] [-B <bus>] [-D <device>] [-F <function>] [PCI_ADDR] <gbs>\n"
 	       "\n"
 	       "                -h,--help           Print this help\n"
 	       "                -V,--verbose        Increase verbosity\n"
 	       "                -n,--dry-run        Don't actually perform actions\n"
 	       "                --force             Attempt to reconfigure even if in use\n"
 	       "                --skip-usrclk       Don't program user clocks\n"
+	       "                --stream            Read the bitstream from a file or pipe (- for stdin)\n"
+	       "                                    while programming. The device is selected by the\n"
+	       "                                    PCI address options only, and its interface ID is\n"
+	       "                                    checked before the AFU logic is read\n"
+	       "                --all               Program every slot that matches the bitstream's\n"
+	       "                                    interface ID (and the PCI address options, if any)\n"
+	       "                                    concurrently, then print a per-device timing report\n"
+	       "                -j,--jobs           Maximum number of slots programmed at once with\n"
+	       "                                    --all (default: all of them)\n"
 	       "                -S,--segment        Set target segment number\n"
 	       "                -B,--bus            Set target bus number\n"
 	       "                -D,--device         Set target device number\n"
@@ -130,7 +153,7 @@ void help(void)
 /*
  * Parse command line arguments
  */
-#define GETOPT_STRING ":hVvnAIQ"
+#define GETOPT_STRING ":hVvnAIQj:"
 int parse_args(int argc, char *argv[])
 {
 	struct option longopts[] = {
@@ -139,11 +162,16 @@ int parse_args(int argc, char *argv[])
 		{"dry-run",     no_argument,       NULL, 'n'},
 		{"force",       no_argument,       NULL, 0xf},
 		{"skip-usrclk", no_argument,       NULL, 0x5},
+		{"stream",      no_argument,       NULL, 0x6},
+		{"all",         no_argument,       NULL, 0x7},
+		{"jobs",        required_argument, NULL, 'j'},
 		{"version",     no_argument,       NULL, 'v'},
 		{0, 0, 0, 0} };
 
 	int getopt_ret;
 	int option_index;
+	char *endptr;
+	unsigned long jobs;
 
 	while (-1
 	       != (getopt_ret = getopt_long(argc, argv, GETOPT_STRING, longopts,
@@ -175,6 +203,24 @@ int parse_args(int argc, char *argv[])
 			config.flags |= FPGA_RECONF_SKIP_USRCLK;
 			break;
 
+		case 0x6: /* stream */
+			config.stream = true;
+			break;
+
+		case 0x7: /* all */
+			config.all = true;
+			break;
+
+		case 'j': /* jobs */
+			errno = 0;
+			jobs = strtoul(tmp_optarg, &endptr, 0);
+			if (errno || *endptr || !jobs || jobs > 1024) {
+				fprintf(stderr, "Invalid jobs: %s\n", tmp_optarg);
+				return -1;
+			}
+			config.jobs = (unsigned int)jobs;
+			break;
+
 		case 'A': /* auto */
 			config.mode = AUTOMATIC;
 			break;
@@ -205,12 +251,20 @@ int parse_args(int argc, char *argv[])
 		}
 	}
 
+	if (config.all && config.stream) {
+		fprintf(stderr, "--all can't be combined with --stream\n");
+		return -1;
+	}
+
 	/* use first non-option argument as GBS filename */
 	if (optind == argc) {
 		fprintf(stderr, "No GBS file\n");
 		return -1;
 	}
-	config.filename = opae_canonicalize_file_name(argv[optind]);
+	if (config.stream && !strcmp(argv[optind], "-"))
+		config.filename = opae_strdup(argv[optind]);
+	else
+		config.filename = opae_canonicalize_file_name(argv[optind]);
 	if (config.filename) {
 		return 0;
 	} else {
@@ -324,6 +378,7 @@ out_err:
 
 /*
  * Find first FPGA matching the interface ID of the GBS
+ * (or any FPGA matching device_filter if interface_id is NULL)
  *
  * @returns the total number of FPGAs matching the interface ID
  */
@@ -342,8 +397,10 @@ int find_fpga(fpga_properties device_filter,
 	res = fpgaPropertiesSetObjectType(filter, FPGA_DEVICE);
 	ON_ERR_GOTO(res, out_destroy, "setting object type");
 
-	res = fpgaPropertiesSetGUID(filter, interface_id);
-	ON_ERR_GOTO(res, out_destroy, "setting interface ID");
+	if (interface_id) {
+		res = fpgaPropertiesSetGUID(filter, interface_id);
+		ON_ERR_GOTO(res, out_destroy, "setting interface ID");
+	}
 
 	/* Get number of FPGAs in system */
 	res = fpgaEnumerate(&filter, 1, fpga, 1, &num_matches);
@@ -393,6 +450,318 @@ out_err:
 	return -1;
 }
 
+/*
+ * Find all FPGAs matching the interface ID of the GBS
+ *
+ * @returns the number of FPGAs found (the size of *fpgas),
+ * or -1 on error. The caller destroys the tokens and frees *fpgas.
+ */
+int find_all_fpgas(fpga_properties device_filter,
+		   fpga_guid interface_id,
+		   fpga_token **fpgas)
+{
+	fpga_properties filter = NULL;
+	uint32_t num_matches = 0;
+	uint32_t i;
+	fpga_result res;
+	int retval = -1;
+
+	*fpgas = NULL;
+
+	res = fpgaCloneProperties(device_filter, &filter);
+	ON_ERR_GOTO(res, out_err, "cloning properties");
+
+	res = fpgaPropertiesSetObjectType(filter, FPGA_DEVICE);
+	ON_ERR_GOTO(res, out_destroy, "setting object type");
+
+	res = fpgaPropertiesSetGUID(filter, interface_id);
+	ON_ERR_GOTO(res, out_destroy, "setting interface ID");
+
+	res = fpgaEnumerate(&filter, 1, NULL, 0, &num_matches);
+	ON_ERR_GOTO(res, out_destroy, "enumerating FPGAs");
+
+	if (!num_matches) {
+		retval = 0;
+		goto out_destroy;
+	}
+
+	*fpgas = opae_calloc(num_matches, sizeof(fpga_token));
+	if (!*fpgas) {
+		print_err("allocating tokens", FPGA_NO_MEMORY);
+		goto out_destroy;
+	}
+
+	// The number of matches may change between the two calls.
+	res = fpgaEnumerate(&filter, 1, *fpgas, num_matches, &i);
+	ON_ERR_GOTO(res, out_free, "enumerating FPGAs");
+
+	if (i < num_matches)
+		num_matches = i;
+	retval = (int)num_matches;
+	goto out_destroy;
+
+out_free:
+	opae_free(*fpgas);
+	*fpgas = NULL;
+out_destroy:
+	res = fpgaDestroyProperties(&filter); /* not needed anymore */
+	ON_ERR_GOTO(res, out_err, "destroying properties object");
+out_err:
+	return retval;
+}
+
+struct program_job {
+	fpga_token token;
+	int result;
+	double seconds;
+};
+
+struct program_pool {
+	struct program_job *jobs;
+	uint32_t num_jobs;
+	uint32_t next;
+	uint32_t slot_num;
+	opae_bitstream_info *info;
+};
+
+void *program_worker(void *arg)
+{
+	struct program_pool *pool = (struct program_pool *)arg;
+	struct program_job *job;
+	struct timespec begin, end;
+	uint32_t n;
+
+	while ((n = __atomic_fetch_add(&pool->next, 1, __ATOMIC_RELAXED)) <
+	       pool->num_jobs) {
+		job = &pool->jobs[n];
+
+		clock_gettime(CLOCK_MONOTONIC, &begin);
+		job->result = program_bitstream(job->token, pool->slot_num,
+						pool->info, config.flags);
+		clock_gettime(CLOCK_MONOTONIC, &end);
+
+		job->seconds = (double)(end.tv_sec - begin.tv_sec) +
+			       (double)(end.tv_nsec - begin.tv_nsec) / 1e9;
+	}
+
+	return NULL;
+}
+
+void print_job_report(struct program_job *jobs, uint32_t num_jobs,
+		      double seconds)
+{
+	fpga_properties props;
+	uint16_t segment;
+	uint8_t bus, device, function;
+	uint32_t failed = 0;
+	uint32_t i;
+
+	printf("%-14s %-8s %s\n", "Device", "Result", "Time (s)");
+
+	for (i = 0 ; i < num_jobs ; ++i) {
+		segment = 0;
+		bus = device = function = 0;
+		if (fpgaGetProperties(jobs[i].token, &props) == FPGA_OK) {
+			fpgaPropertiesGetSegment(props, &segment);
+			fpgaPropertiesGetBus(props, &bus);
+			fpgaPropertiesGetDevice(props, &device);
+			fpgaPropertiesGetFunction(props, &function);
+			fpgaDestroyProperties(&props);
+		}
+
+		if (jobs[i].result < 0)
+			++failed;
+
+		printf("%04x:%02x:%02x.%x   %-8s %.3f\n",
+		       segment, bus, device, function,
+		       jobs[i].result < 0 ? "FAILED" : "OK",
+		       jobs[i].seconds);
+	}
+
+	printf("Programmed %u of %u slot(s) in %.3f s\n",
+	       num_jobs - failed, num_jobs, seconds);
+}
+
+/*
+ * Program every matching slot from the one loaded copy of the
+ * bitstream, using at most config.jobs concurrent workers.
+ *
+ * @returns 0 if every slot was programmed, else a non-zero exit code.
+ */
+int program_all(fpga_properties device_filter, uint32_t slot_num,
+		opae_bitstream_info *info)
+{
+	struct program_pool pool;
+	struct timespec begin, end;
+	fpga_token *tokens = NULL;
+	pthread_t *workers = NULL;
+	uint32_t num_workers;
+	uint32_t started = 0;
+	uint32_t i;
+	int retval = 0;
+	int res;
+
+	print_msg(1, "Looking for slots");
+	res = find_all_fpgas(device_filter, info->pr_interface_id, &tokens);
+	if (res < 0)
+		return 3;
+	if (res == 0) {
+		fprintf(stderr, "No suitable slots found.\n");
+		if (config.verbosity > 0)
+			print_interface_id(device_filter, info->pr_interface_id);
+		return 4;
+	}
+
+	memset(&pool, 0, sizeof(pool));
+	pool.num_jobs = (uint32_t)res;
+	pool.slot_num = slot_num;
+	pool.info = info;
+
+	pool.jobs = opae_calloc(pool.num_jobs, sizeof(struct program_job));
+	num_workers = config.jobs && config.jobs < pool.num_jobs ?
+		      config.jobs : pool.num_jobs;
+	workers = opae_calloc(num_workers, sizeof(pthread_t));
+	if (!pool.jobs || !workers) {
+		print_err("allocating workers", FPGA_NO_MEMORY);
+		retval = 5;
+		goto out_free;
+	}
+
+	for (i = 0 ; i < pool.num_jobs ; ++i) {
+		pool.jobs[i].token = tokens[i];
+		pool.jobs[i].result = -1;
+	}
+
+	if (config.verbosity > 0)
+		printf("Programming %u slot(s) with %u worker(s)\n",
+		       pool.num_jobs, num_workers);
+
+	clock_gettime(CLOCK_MONOTONIC, &begin);
+
+	for (started = 0 ; started < num_workers ; ++started) {
+		if (pthread_create(&workers[started], NULL,
+				   program_worker, &pool))
+			break;
+	}
+
+	if (!started) {
+		fprintf(stderr, "Failed to start workers\n");
+		retval = 5;
+		goto out_free;
+	}
+
+	for (i = 0 ; i < started ; ++i)
+		pthread_join(workers[i], NULL);
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	print_job_report(pool.jobs, pool.num_jobs,
+			 (double)(end.tv_sec - begin.tv_sec) +
+			 (double)(end.tv_nsec - begin.tv_nsec) / 1e9);
+
+	for (i = 0 ; i < pool.num_jobs ; ++i) {
+		if (pool.jobs[i].result < 0)
+			retval = 5;
+	}
+
+out_free:
+	for (i = 0 ; i < (uint32_t)res ; ++i)
+		fpgaDestroyToken(&tokens[i]);
+	opae_free(tokens);
+	if (pool.jobs)
+		opae_free(pool.jobs);
+	if (workers)
+		opae_free(workers);
+	return retval;
+}
+
+int program_bitstream_fd(fpga_token token, uint32_t slot_num,
+			 int fd, int flags)
+{
+	fpga_handle handle;
+	fpga_result res;
+
+	print_msg(2, "Opening FPGA");
+	res = fpgaOpen(token, &handle, 0);
+	ON_ERR_GOTO(res, out_err, "opening FPGA");
+
+	print_msg(1, "Streaming bitstream");
+	if (config.dry_run) {
+		print_msg(1, "[--dry-run] Skipping reconfiguration");
+	} else {
+		res = fpgaReconfigureSlotByFd(handle, slot_num, fd, flags);
+		ON_ERR_GOTO(res, out_close, "writing bitstream to FPGA");
+	}
+
+	print_msg(2, "Closing FPGA");
+	res = fpgaClose(handle);
+	ON_ERR_GOTO(res, out_err, "closing FPGA");
+	return 1;
+
+out_close:
+	res = fpgaClose(handle);
+	ON_ERR_GOTO(res, out_err, "closing FPGA");
+out_err:
+	return -1;
+}
+
+/*
+ * Streaming mode: the bitstream is not loaded up front, so the slot
+ * can't be matched by interface ID. Select it by the device filter
+ * and let fpgaReconfigureSlotByFd() check its interface ID.
+ */
+int stream_bitstream(fpga_properties device_filter, uint32_t slot_num)
+{
+	fpga_token token;
+	int retval = 0;
+	int fd;
+	int res;
+
+	if (!strcmp(config.filename, "-")) {
+		fd = STDIN_FILENO;
+	} else {
+		fd = opae_open(config.filename, O_RDONLY);
+		if (fd < 0) {
+			fprintf(stderr, "Error opening GBS file: \"%s\"\n",
+				strerror(errno));
+			return 2;
+		}
+	}
+
+	print_msg(1, "Looking for slot");
+	res = find_fpga(device_filter, NULL, &token);
+	if (res < 0) {
+		retval = 3;
+		goto out_close;
+	}
+	if (res == 0) {
+		fprintf(stderr, "No suitable slots found.\n");
+		retval = 4;
+		goto out_close;
+	}
+	if (res > 1) {
+		fprintf(stderr,
+			"Found more than one slot, please specify the PCI address.\n");
+		retval = 5;
+		goto out_destroy;
+	}
+	print_msg(1, "Found slot");
+
+	print_msg(1, "Programming bitstream");
+	res = program_bitstream_fd(token, slot_num, fd, config.flags);
+	if (res < 0) {
+		retval = 5;
+		goto out_destroy;
+	}
+	print_msg(1, "Done");
+
+out_destroy:
+	fpgaDestroyToken(&token);
+out_close:
+	if (fd != STDIN_FILENO)
+		opae_close(fd);
+	return retval;
+}
 
 int main(int argc, char *argv[])
 {
@@ -434,6 +803,11 @@ int main(int argc, char *argv[])
 	if (config.dry_run)
 		printf("--dry-run is set\n");
 
+	if (config.stream) {
+		retval = stream_bitstream(device_filter, slot_num);
+		goto out_exit;
+	}
+
 	/* allocate memory and read bitstream data */
 	print_msg(1, "Reading bitstream");
 	result = opae_load_bitstream(config.filename, &info);
@@ -442,6 +816,11 @@ int main(int argc, char *argv[])
 		goto out_exit;
 	}
 
+	if (config.all) {
+		retval = program_all(device_filter, slot_num, &info);
+		goto out_free;
+	}
+
 	/* find suitable slot */
 	print_msg(1, "Looking for slot");
 	res = find_fpga(device_filter, info.pr_interface_id, &token);
@@ -28,7 +28,10 @@
 #include <config.h>
 #endif // HAVE_CONFIG_H
 
+#include <unistd.h>
+
 #include "device_monitoring.h"
+#include "mock/opae_std.h"
 
 #ifdef LOG
 #undef LOG
@@ -71,3 +74,41 @@ void mon_remove_device_error(fpgad_monitored_device *d, void *err)
 	}
 	d->num_error_occurrences -= removed;
 }
+
+bool mon_add_device_watch(fpgad_monitored_device *d, const char *path)
+{
+	char buf[64];
+	int fd;
+
+	if (d->num_watches >= MAX_DEV_WATCHES) {
+		LOG("exceeded max number of device watches!\n");
+		return false;
+	}
+
+	fd = opae_open(path, O_RDONLY);
+	if (fd < 0) {
+		LOG("failed to open watch \"%s\": %s\n",
+		    path, strerror(errno));
+		return false;
+	}
+
+	// sysfs only delivers POLLPRI for an attribute
+	// that has been read since the last notification.
+	if (pread(fd, buf, sizeof(buf), 0) < 0) {
+		LOG("failed to read watch \"%s\": %s\n",
+		    path, strerror(errno));
+		opae_close(fd);
+		return false;
+	}
+
+	d->watch_fds[d->num_watches++] = fd;
+	return true;
+}
+
+void mon_remove_device_watches(fpgad_monitored_device *d)
+{
+	unsigned i;
+	for (i = 0 ; i < d->num_watches ; ++i)
+		opae_close(d->watch_fds[i]);
+	d->num_watches = 0;
+}
@@ -43,4 +43,12 @@ bool mon_add_device_error(fpgad_monitored_device *d, void *err);
 
 void mon_remove_device_error(fpgad_monitored_device *d, void *err);
 
+// Open the sysfs attribute at path and add it to d's watch list.
+// The event-driven monitor wakes up and runs d's detections when
+// the attribute signals POLLPRI. Returns true on success.
+bool mon_add_device_watch(fpgad_monitored_device *d, const char *path);
+
+// Close all of d's watches.
+void mon_remove_device_watches(fpgad_monitored_device *d);
+
 #endif /* __FPGAD_API_DEVICE_MONITORING_H__ */
@@ -40,7 +40,28 @@
 log_printf("opae_events_api: " format, ##__VA_ARGS__)
 
 STATIC pthread_mutex_t list_lock = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
-STATIC api_client_event_registry *event_registry_list;
+// Registrations hashed by (object_id, event), so that signaling an
+// event visits only that object's subscribers, and by conn_socket,
+// so that a disconnecting client's registrations are found directly.
+STATIC api_client_event_registry *event_registry_index[OPAE_API_EVENT_BUCKETS];
+STATIC api_client_event_registry *client_registry_index[OPAE_API_EVENT_BUCKETS];
+STATIC size_t num_event_registrations;
+
+STATIC unsigned event_bucket(fpga_event_type e, uint64_t object_id)
+{
+	uint64_t h = object_id ^ ((uint64_t)e << 56);
+
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+
+	return (unsigned)(h & (OPAE_API_EVENT_BUCKETS - 1));
+}
+
+STATIC unsigned client_bucket(int conn_socket)
+{
+	return (unsigned)conn_socket & (OPAE_API_EVENT_BUCKETS - 1);
+}
 
 int opae_api_register_event(int conn_socket,
 			    int fd,
@@ -49,6 +70,8 @@ int opae_api_register_event(int conn_socket,
 {
 	api_client_event_registry *r =
 		(api_client_event_registry *) opae_malloc(sizeof(*r));
+	unsigned eb;
+	unsigned cb;
 	int err;
 
 	if (!r)
@@ -60,10 +83,18 @@ int opae_api_register_event(int conn_socket,
 	r->event = e;
 	r->object_id = object_id;
 
+	eb = event_bucket(e, object_id);
+	cb = client_bucket(conn_socket);
+
 	fpgad_mutex_lock(err, &list_lock);
 
-	r->next = event_registry_list;
-	event_registry_list = r;
+	r->next = event_registry_index[eb];
+	event_registry_index[eb] = r;
+
+	r->next_for_client = client_registry_index[cb];
+	client_registry_index[cb] = r;
+
+	++num_event_registrations;
 
 	fpgad_mutex_unlock(err, &list_lock);
 
@@ -76,72 +107,55 @@ STATIC void release_event_registry(api_client_event_registry *r)
 	opae_free(r);
 }
 
-int opae_api_unregister_event(int conn_socket,
-			      fpga_event_type e,
-			      uint64_t object_id)
+// Called with list_lock held.
+STATIC void unlink_event_registry(api_client_event_registry *r)
 {
-	api_client_event_registry *trash;
-	api_client_event_registry *save;
-	int err;
-	int res = 0;
-
-	fpgad_mutex_lock(err, &list_lock);
-
-	trash = event_registry_list;
-
-	if (!trash) { // empty list
-		res = 1;
-		goto out_unlock;
-	}
-
-	if ((conn_socket == trash->conn_socket) &&
-		(e == trash->event) &&
-		(object_id == trash->object_id)) {
+	api_client_event_registry **pp;
 
-		// found at head of list
-
-		event_registry_list = event_registry_list->next;
-		release_event_registry(trash);
-		goto out_unlock;
-	}
-
-	save = trash;
-	trash = trash->next;
-	while (trash) {
-
-		if ((conn_socket == trash->conn_socket) &&
-			(e == trash->event) &&
-			(object_id == trash->object_id))
+	for (pp = &event_registry_index[event_bucket(r->event,
+						     r->object_id)] ;
+	     *pp ; pp = &(*pp)->next) {
+		if (*pp == r) {
+			*pp = r->next;
 			break;
-
-		save = trash;
-		trash = trash->next;
+		}
 	}
 
-	if (!trash) { // not found
-		res = 1;
-		goto out_unlock;
+	for (pp = &client_registry_index[client_bucket(r->conn_socket)] ;
+	     *pp ; pp = &(*pp)->next_for_client) {
+		if (*pp == r) {
+			*pp = r->next_for_client;
+			break;
+		}
 	}
 
-	// found at trash
-	save->next = trash->next;
-	release_event_registry(trash);
-
-out_unlock:
-	fpgad_mutex_unlock(err, &list_lock);
-	return res;
+	--num_event_registrations;
 }
 
-STATIC api_client_event_registry *
-find_event_for(int conn_socket)
+int opae_api_unregister_event(int conn_socket,
+			      fpga_event_type e,
+			      uint64_t object_id)
 {
 	api_client_event_registry *r;
+	int err;
+	int res = 1;
 
-	for (r = event_registry_list ; r ; r = r->next)
-		if (conn_socket == r->conn_socket)
+	fpgad_mutex_lock(err, &list_lock);
+
+	for (r = event_registry_index[event_bucket(e, object_id)] ;
+	     r ; r = r->next) {
+		if ((conn_socket == r->conn_socket) &&
+		    (e == r->event) &&
+		    (object_id == r->object_id)) {
+			unlink_event_registry(r);
+			release_event_registry(r);
+			res = 0;
 			break;
+		}
+	}
 
-	return r;
+	fpgad_mutex_unlock(err, &list_lock);
+	return res;
 }
 
 void opae_api_unregister_all_events_for(int conn_socket)
@@ -151,10 +165,16 @@ void opae_api_unregister_all_events_for(int conn_socket)
 
 	fpgad_mutex_lock(err, &list_lock);
 
-	r = find_event_for(conn_socket);
+	r = client_registry_index[client_bucket(conn_socket)];
 	while (r) {
-		opae_api_unregister_event(conn_socket, r->event, r->object_id);
-		r = find_event_for(conn_socket);
+		api_client_event_registry *trash = r;
+
+		r = r->next_for_client;
+
+		if (trash->conn_socket == conn_socket) {
+			unlink_event_registry(trash);
+			release_event_registry(trash);
+		}
 	}
 
 	fpgad_mutex_unlock(err, &list_lock);
@@ -163,18 +183,23 @@ void opae_api_unregister_all_events_for(int conn_socket)
 void opae_api_unregister_all_events(void)
 {
 	api_client_event_registry *r;
+	unsigned i;
 	int err;
 
 	fpgad_mutex_lock(err, &list_lock);
 
-	for (r = event_registry_list ; r != NULL ; ) {
-		api_client_event_registry *trash;
-		trash = r;
-		r = r->next;
-		release_event_registry(trash);
+	for (i = 0 ; i < OPAE_API_EVENT_BUCKETS ; ++i) {
+		for (r = event_registry_index[i] ; r != NULL ; ) {
+			api_client_event_registry *trash;
+			trash = r;
+			r = r->next;
+			release_event_registry(trash);
+		}
+		event_registry_index[i] = NULL;
+		client_registry_index[i] = NULL;
 	}
 
-	event_registry_list = NULL;
+	num_event_registrations = 0;
 
 	fpgad_mutex_unlock(err, &list_lock);
 }
@@ -184,57 +209,50 @@ void opae_api_for_each_registered_event
 void *context)
 {
 	api_client_event_registry *r;
+	unsigned i;
 	int err;
 
 	fpgad_mutex_lock(err, &list_lock);
 
-	for (r = event_registry_list; r != NULL; r = r->next) {
-		cb(r, context);
+	for (i = 0 ; i < OPAE_API_EVENT_BUCKETS ; ++i) {
+		for (r = event_registry_index[i]; r != NULL; r = r->next) {
+			cb(r, context);
+		}
 	}
 
 	fpgad_mutex_unlock(err, &list_lock);
 }
 
-STATIC void check_and_send_EVENT_ERROR(api_client_event_registry *r,
-				       void *context)
+// Signal every registration for event e on object_id.
+STATIC void send_event(fpga_event_type e, uint64_t object_id,
+		       const char *name)
 {
-	fpgad_monitored_device *d =
-		(fpgad_monitored_device *)context;
-
-	if ((r->event == FPGA_EVENT_ERROR) &&
-	    (r->object_id == d->object_id)) {
-		LOG("object_id: 0x%" PRIx64 " event: FPGA_EVENT_ERROR\n",
-			d->object_id);
-		if (write(r->fd, &r->data, sizeof(r->data)) < 0)
-			LOG("write failed: %s\n", strerror(errno));
-		r->data++;
+	api_client_event_registry *r;
+	int err;
+
+	fpgad_mutex_lock(err, &list_lock);
+
+	for (r = event_registry_index[event_bucket(e, object_id)] ;
+	     r ; r = r->next) {
+		if ((r->event == e) && (r->object_id == object_id)) {
+			LOG("object_id: 0x%" PRIx64 " event: %s\n",
+				object_id, name);
+			if (write(r->fd, &r->data, sizeof(r->data)) < 0)
+				LOG("write failed: %s\n", strerror(errno));
+			r->data++;
+		}
 	}
-}
 
-void opae_api_send_EVENT_ERROR(fpgad_monitored_device *d)
-{
-	opae_api_for_each_registered_event(check_and_send_EVENT_ERROR,
-					   d);
+	fpgad_mutex_unlock(err, &list_lock);
 }
 
-STATIC void check_and_send_EVENT_POWER_THERMAL(api_client_event_registry *r,
-					       void *context)
+void opae_api_send_EVENT_ERROR(fpgad_monitored_device *d)
 {
-	fpgad_monitored_device *d =
-		(fpgad_monitored_device *)context;
-
-	if ((r->event == FPGA_EVENT_POWER_THERMAL) &&
-	    (r->object_id == d->object_id)) {
-		LOG("object_id: 0x%" PRIx64 " event: FPGA_EVENT_POWER_THERMAL\n",
-			d->object_id);
-		if (write(r->fd, &r->data, sizeof(r->data)) < 0)
-			LOG("write failed: %s\n", strerror(errno));
-		r->data++;
-	}
+	send_event(FPGA_EVENT_ERROR, d->object_id, "FPGA_EVENT_ERROR");
 }
 
 void opae_api_send_EVENT_POWER_THERMAL(fpgad_monitored_device *d)
 {
-	opae_api_for_each_registered_event(check_and_send_EVENT_POWER_THERMAL,
-					   d);
+	send_event(FPGA_EVENT_POWER_THERMAL, d->object_id,
+		   "FPGA_EVENT_POWER_THERMAL");
 }
@@ -50,6 +50,10 @@ struct event_request {
 	uint64_t object_id;
 };
 
+// A client's registration for one event on one object. Each entry
+// is linked into two hash chains: next, in the bucket for its
+// (object_id, event) pair, and next_for_client, in the bucket for
+// its conn_socket.
 typedef struct _api_client_event_registry {
 	int conn_socket;
 	int fd;
@@ -57,8 +61,12 @@ typedef struct _api_client_event_registry {
 	fpga_event_type event;
 	uint64_t object_id;
 	struct _api_client_event_registry *next;
+	struct _api_client_event_registry *next_for_client;
 } api_client_event_registry;
 
+// Must be a power of 2.
+#define OPAE_API_EVENT_BUCKETS 256
+
 // 0 on success
 int opae_api_register_event(int conn_socket,
 			    int fd,
@@ -47,15 +47,17 @@
 #define LOG(format, ...) \
 log_printf("args: " format, ##__VA_ARGS__)
 
-#define OPT_STR ":hdl:p:s:n:v"
+#define OPT_STR ":hdel:p:s:n:w:v"
 
 STATIC struct option longopts[] = {
 	{ "help",           no_argument,       NULL, 'h' },
 	{ "daemon",         no_argument,       NULL, 'd' },
+	{ "event-driven",   no_argument,       NULL, 'e' },
 	{ "logfile",        required_argument, NULL, 'l' },
 	{ "pidfile",        required_argument, NULL, 'p' },
 	{ "socket",         required_argument, NULL, 's' },
 	{ "null-bitstream", required_argument, NULL, 'n' },
+	{ "workers",        required_argument, NULL, 'w' },
 	{ "version",        no_argument,       NULL, 'v' },
 
 	{ 0, 0, 0, 0 }
@@ -71,11 +73,14 @@ void cmd_show_help(FILE *fptr)
 	fprintf(fptr, "Usage: fpgad <options>\n");
 	fprintf(fptr, "\n");
 	fprintf(fptr, "\t-d,--daemon                 run as daemon process.\n");
+	fprintf(fptr, "\t-e,--event-driven           monitor sysfs notifications and uevents\n"
+		      "\t                            instead of polling at a fixed interval.\n");
 	fprintf(fptr, "\t-l,--logfile <file>         the log file for daemon mode [%s].\n", DEFAULT_LOG);
 	fprintf(fptr, "\t-p,--pidfile <file>         the pid file for daemon mode [%s].\n", DEFAULT_PID);
 	fprintf(fptr, "\t-s,--socket <sock>          the unix domain socket [/tmp/fpga_event_socket].\n");
 	fprintf(fptr, "\t-n,--null-bitstream <file>  NULL bitstream (for AP6 handling, may be\n"
 		      "\t                            given multiple times).\n");
+	fprintf(fptr, "\t-w,--workers <n>            poll the devices from n monitor threads [1].\n");
 	fprintf(fptr, "\t-v,--version                display the version and exit.\n");
 }
 
@@ -142,6 +147,11 @@ int cmd_parse_args(struct fpgad_config *c, int argc, char *argv[])
 			LOG("daemon requested\n");
 			break;
 
+		case 'e':
+			c->event_driven = true;
+			LOG("event-driven monitoring requested\n");
+			break;
+
 		case 'l':
 			if (tmp_optarg) {
 				len = strnlen(tmp_optarg, PATH_MAX - 1);
@@ -186,6 +196,28 @@ int cmd_parse_args(struct fpgad_config *c, int argc, char *argv[])
 			}
 			break;
 
+		case 'w':
+			if (tmp_optarg) {
+				char *endptr = NULL;
+				unsigned long workers =
+					strtoul(tmp_optarg, &endptr, 0);
+
+				if (*endptr || !workers ||
+				    workers > MAX_MONITOR_WORKERS) {
+					LOG("invalid workers parameter: \"%s\"\n",
+					    tmp_optarg);
+					return 1;
+				}
+
+				c->monitor_workers = (unsigned)workers;
+				LOG("%u monitor workers requested\n",
+				    c->monitor_workers);
+			} else {
+				LOG("missing workers parameter.\n");
+				return 1;
+			}
+			break;
+
 		case 'v':
 			fprintf(stdout, "fpgad %s %s%s\n",
 					OPAE_VERSION,
@@ -35,10 +35,22 @@
 #include "cfg-file.h"
 
 #define MAX_NULL_GBS 32
+#define MAX_MONITOR_WORKERS 64
 
 struct fpgad_config {
 	useconds_t poll_interval_usec;
 
+	// When set, the monitor sleeps until a watched sysfs attribute
+	// or a device uevent fires. Devices that are watched are still
+	// polled every poll_fallback_usec.
+	bool event_driven;
+	useconds_t poll_fallback_usec;
+
+	// When greater than 1, the monitored devices are sharded
+	// across this many worker threads, each polling its devices
+	// on its own schedule.
+	unsigned monitor_workers;
+
 	bool daemon;
 	char directory[PATH_MAX];
 	char logfile[PATH_MAX];
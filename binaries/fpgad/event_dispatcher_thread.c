@@ -28,9 +28,11 @@
 #include <config.h>
 #endif // HAVE_CONFIG_H
 
-#include <semaphore.h>
 #include <time.h>
 #include <inttypes.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
 #include "event_dispatcher_thread.h"
 
 #ifdef LOG
@@ -45,40 +47,72 @@ event_dispatcher_thread_config event_dispatcher_config = {
 	.sched_priority = 30,
 };
 
+// Must be a power of 2.
 #define EVENT_DISPATCH_QUEUE_DEPTH 512
 
+typedef struct _evt_dispatch_slot {
+	uint64_t seq;
+	event_dispatch_queue_item item;
+} evt_dispatch_slot;
+
+// A bounded multi-producer, single-consumer ring. Producers claim
+// a position by advancing tail; the dispatcher thread is the only
+// consumer and advances head. Each slot's seq tells whose turn it
+// is, relative to the start of the lap containing the position:
+// the producer of pos may fill the slot when seq == lap(pos), and
+// the consumer may empty it when seq == lap(pos) + 1. Measuring
+// from the lap makes an all-zero queue a valid empty queue.
 typedef struct _evt_dispatch_queue {
-	event_dispatch_queue_item q[EVENT_DISPATCH_QUEUE_DEPTH];
-	unsigned head;
-	unsigned tail;
-	pthread_mutex_t lock;
+	evt_dispatch_slot q[EVENT_DISPATCH_QUEUE_DEPTH];
+	uint64_t tail;
+	uint64_t head;
+	uint64_t drops;
+	uint64_t high_water;
+	uint64_t reported_high_water;
 } evt_dispatch_queue;
 
-STATIC sem_t evt_dispatch_sem;
+#define EVT_QUEUE_LAP(__pos) \
+	((__pos) & ~((uint64_t)EVENT_DISPATCH_QUEUE_DEPTH - 1))
 
-STATIC evt_dispatch_queue normal_queue = {
-	{ { NULL, NULL, NULL }, },
-	0,
-	0,
-	PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP,
-};
+STATIC evt_dispatch_queue normal_queue;
+STATIC evt_dispatch_queue high_priority_queue;
 
-STATIC evt_dispatch_queue high_priority_queue = {
-	{ { NULL, NULL, NULL }, },
-	0,
-	0,
-	PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP,
-};
+// Signaled by producers after queueing an item, to wake the dispatcher.
+STATIC int evt_dispatch_efd = -1;
+// Signaled by the dispatcher after taking an item while producers
+// are waiting for room in a full queue.
+STATIC int evt_space_efd = -1;
+STATIC uint32_t evt_space_waiters;
 
 STATIC void evt_queue_init(evt_dispatch_queue *q)
 {
-	memset(q->q, 0, sizeof(q->q));
-	q->head = q->tail = 0;
+	memset(q, 0, sizeof(*q));
+}
+
+STATIC void evt_queue_report(const char *name, evt_dispatch_queue *q,
+			     bool final)
+{
+	uint64_t high_water =
+		__atomic_load_n(&q->high_water, __ATOMIC_RELAXED);
+	uint64_t drops =
+		__atomic_load_n(&q->drops, __ATOMIC_RELAXED);
+
+	if (final) {
+		LOG("%s queue: high-water %" PRIu64 " of %d,"
+		    " %" PRIu64 " dropped.\n",
+		    name, high_water, EVENT_DISPATCH_QUEUE_DEPTH, drops);
+	} else if ((high_water > q->reported_high_water) &&
+		   (high_water >= EVENT_DISPATCH_QUEUE_DEPTH / 2)) {
+		LOG("%s queue: new high-water %" PRIu64 " of %d.\n",
+		    name, high_water, EVENT_DISPATCH_QUEUE_DEPTH);
+		q->reported_high_water = high_water;
+	}
 }
 
-STATIC void evt_queue_destroy(evt_dispatch_queue *q)
+STATIC void evt_queue_destroy(const char *name, evt_dispatch_queue *q)
 {
-	q->head = q->tail = 0;
+	evt_queue_report(name, q, true);
+	evt_queue_init(q);
 }
 
 STATIC volatile bool dispatcher_is_ready = (bool)0;
@@ -88,23 +122,73 @@ bool evt_dispatcher_is_ready(void)
 	return dispatcher_is_ready;
 }
 
+STATIC void evt_signal(int efd)
+{
+	uint64_t one = 1;
+
+	if (efd >= 0 && write(efd, &one, sizeof(one)) < 0)
+		LOG("eventfd write failed: %s\n", strerror(errno));
+}
+
 STATIC bool evt_queue_is_full(evt_dispatch_queue *q)
 {
-	const size_t num = sizeof(q->q) / sizeof(q->q[0]);
-
-	if (q->tail > q->head) {
-		if ((q->head == 0) && (q->tail == (num - 1)))
-			return true;
-	} else if (q->tail < q->head) {
-		if (q->tail == (q->head - 1))
-			return true;
-	}
-	return false;
+	uint64_t pos = __atomic_load_n(&q->tail, __ATOMIC_RELAXED);
+	evt_dispatch_slot *slot =
+		&q->q[pos & (EVENT_DISPATCH_QUEUE_DEPTH - 1)];
+
+	return (int64_t)(__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) -
+			 EVT_QUEUE_LAP(pos)) < 0;
 }
 
-STATIC bool evt_queue_is_empty(evt_dispatch_queue *q)
+STATIC bool evt_queue_try_put(evt_dispatch_queue *q,
+			      fpgad_respond_event_t callback,
+			      fpgad_monitored_device *device,
+			      void *context)
 {
-	return q->head == q->tail;
+	uint64_t pos = __atomic_load_n(&q->tail, __ATOMIC_RELAXED);
+	evt_dispatch_slot *slot;
+	uint64_t depth;
+	uint64_t high_water;
+
+	for (;;) {
+		int64_t diff;
+
+		slot = &q->q[pos & (EVENT_DISPATCH_QUEUE_DEPTH - 1)];
+		diff = (int64_t)(__atomic_load_n(&slot->seq,
+						 __ATOMIC_ACQUIRE) -
+				 EVT_QUEUE_LAP(pos));
+
+		if (!diff) {
+			if (__atomic_compare_exchange_n(&q->tail, &pos,
+							pos + 1, true,
+							__ATOMIC_RELAXED,
+							__ATOMIC_RELAXED))
+				break;
+		} else if (diff < 0) {
+			return false; // full
+		} else {
+			// Another producer claimed pos.
+			pos = __atomic_load_n(&q->tail, __ATOMIC_RELAXED);
+		}
+	}
+
+	slot->item.callback = callback;
+	slot->item.device = device;
+	slot->item.context = context;
+
+	__atomic_store_n(&slot->seq, EVT_QUEUE_LAP(pos) + 1,
+			 __ATOMIC_RELEASE);
+
+	depth = pos + 1 - __atomic_load_n(&q->head, __ATOMIC_RELAXED);
+	high_water = __atomic_load_n(&q->high_water, __ATOMIC_RELAXED);
+	while (depth > high_water &&
+	       !__atomic_compare_exchange_n(&q->high_water, &high_water,
+					    depth, true,
+					    __ATOMIC_RELAXED,
+					    __ATOMIC_RELAXED))
+		/* retry */ ;
+
+	return true;
 }
 
 STATIC bool _evt_queue_response(evt_dispatch_queue *q,
@@ -112,24 +196,56 @@ STATIC bool _evt_queue_response(evt_dispatch_queue *q,
 				fpgad_monitored_device *device,
 				void *context)
 {
-	int res;
+	struct timespec ts;
+	uint64_t now;
+	uint64_t deadline;
+	bool queued;
+
+	queued = evt_queue_try_put(q, callback, device, context);
+
+	if (!queued && (evt_space_efd >= 0)) {
+		// The queue is full. Wait up to one poll interval
+		// for the dispatcher to make room.
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		now = ((uint64_t)ts.tv_sec * 1000000) + (ts.tv_nsec / 1000);
+		deadline = now + global_config.poll_interval_usec;
+
+		__atomic_add_fetch(&evt_space_waiters, 1, __ATOMIC_SEQ_CST);
+
+		while (!queued && (now < deadline)) {
+			struct pollfd pfd = { evt_space_efd, POLLIN, 0 };
+			uint64_t count;
+			uint64_t wait = deadline - now;
+
+			// Bound each wait, in case another
+			// producer consumed our wake-up.
+			if (wait > 10000)
+				wait = 10000;
+
+			if ((poll(&pfd, 1, (int)((wait + 999) / 1000)) > 0) &&
+			    (read(evt_space_efd, &count, sizeof(count)) < 0) &&
+			    (errno != EAGAIN))
+				LOG("eventfd read failed: %s\n",
+				    strerror(errno));
+
+			if (!evt_queue_is_full(q))
+				queued = evt_queue_try_put(q, callback,
+							   device, context);
+
+			clock_gettime(CLOCK_MONOTONIC, &ts);
+			now = ((uint64_t)ts.tv_sec * 1000000) +
+				(ts.tv_nsec / 1000);
+		}
 
-	opae_mutex_lock(res, &q->lock);
+		__atomic_sub_fetch(&evt_space_waiters, 1, __ATOMIC_SEQ_CST);
+	}
 
-	if (evt_queue_is_full(q)) {
-		opae_mutex_unlock(res, &q->lock);
+	if (!queued) {
+		__atomic_add_fetch(&q->drops, 1, __ATOMIC_RELAXED);
 		return false;
 	}
 
-	q->q[q->tail].callback = callback;
-	q->q[q->tail].device = device;
-	q->q[q->tail].context = context;
-
-	q->tail = (q->tail + 1) % EVENT_DISPATCH_QUEUE_DEPTH;
-
-	opae_mutex_unlock(res, &q->lock);
-
-	sem_post(&evt_dispatch_sem);
+	evt_signal(evt_dispatch_efd);
 
 	return true;
 }
@@ -137,20 +253,24 @@ STATIC bool _evt_queue_response(evt_dispatch_queue *q,
 STATIC bool _evt_queue_get(evt_dispatch_queue *q,
 			   event_dispatch_queue_item *item)
 {
-	int res;
-
-	opae_mutex_lock(res, &q->lock);
+	uint64_t pos = q->head;
+	evt_dispatch_slot *slot =
+		&q->q[pos & (EVENT_DISPATCH_QUEUE_DEPTH - 1)];
 
-	if (evt_queue_is_empty(q)) {
-		opae_mutex_unlock(res, &q->lock);
+	if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) !=
+	    EVT_QUEUE_LAP(pos) + 1)
 		return false;
-	}
 
-	*item = q->q[q->head];
-	memset(&q->q[q->head], 0, sizeof(q->q[0]));
-	q->head = (q->head + 1) % EVENT_DISPATCH_QUEUE_DEPTH;
+	*item = slot->item;
+	memset(&slot->item, 0, sizeof(slot->item));
+
+	__atomic_store_n(&slot->seq,
+			 EVT_QUEUE_LAP(pos) + EVENT_DISPATCH_QUEUE_DEPTH,
+			 __ATOMIC_RELEASE);
+	__atomic_store_n(&q->head, pos + 1, __ATOMIC_RELEASE);
 
-	opae_mutex_unlock(res, &q->lock);
+	if (__atomic_load_n(&evt_space_waiters, __ATOMIC_SEQ_CST))
+		evt_signal(evt_space_efd);
 
 	return true;
 }
@@ -191,8 +311,8 @@ void *event_dispatcher_thread(void *thread_context)
 		(event_dispatcher_thread_config *)thread_context;
 	struct sched_param sched_param;
 	int policy = 0;
+	int timeout_msec;
 	int res;
-	struct timespec ts;
 
 	LOG("starting\n");
 
@@ -215,51 +335,72 @@ void *event_dispatcher_thread(void *thread_context)
 	evt_queue_init(&normal_queue);
 	evt_queue_init(&high_priority_queue);
 
-	if (sem_init(&evt_dispatch_sem, 0, 0)) {
-		LOG("failed to init queue sem.\n");
+	evt_dispatch_efd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	if (evt_dispatch_efd < 0) {
+		LOG("failed to create queue eventfd.\n");
 		goto out_exit;
 	}
 
-	dispatcher_is_ready = true;
+	evt_space_efd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK |
+				   EFD_SEMAPHORE);
+	if (evt_space_efd < 0) {
+		LOG("failed to create queue space eventfd.\n");
+		goto out_close_dispatch;
+	}
 
-	while (c->global->running) {
+	// Round the wakeup interval up to whole msec for poll(). A
+	// sub-msec interval must not turn into a zero (busy) timeout.
+	timeout_msec = (int)(((uint64_t)c->global->poll_interval_usec + 999) / 1000);
+	if (timeout_msec < 1)
+		timeout_msec = 1;
 
-		clock_gettime(CLOCK_REALTIME, &ts);
+	dispatcher_is_ready = true;
 
-		ts.tv_nsec += c->global->poll_interval_usec * 1000;
-		if (ts.tv_nsec > 1000000000) {
-			++ts.tv_sec;
-			ts.tv_nsec -= 1000000000;
-		}
+	while (c->global->running) {
+		struct pollfd pfd = { evt_dispatch_efd, POLLIN, 0 };
+		event_dispatch_queue_item item;
+		uint64_t count;
 
-		res = sem_timedwait(&evt_dispatch_sem, &ts);
+		res = poll(&pfd, 1, timeout_msec);
 
-		if (!res) {
-			event_dispatch_queue_item item;
+		if (res > 0 &&
+		    read(evt_dispatch_efd, &count, sizeof(count)) < 0 &&
+		    errno != EAGAIN)
+			LOG("eventfd read failed: %s\n", strerror(errno));
 
-			// Process all high-priority items first
+		// Drain both queues, dispatching all
+		// high-priority items before each normal one.
+		do {
 			while (evt_queue_get_high(&item)) {
 				LOG("dispatching (high) for object_id: 0x%" PRIx64 ".\n",
 					item.device->object_id);
 				item.callback(item.device, item.context);
 			}
 
-			if (evt_queue_get(&item)) {
-				LOG("dispatching for object_id: 0x%" PRIx64 ".\n",
-					item.device->object_id);
-				item.callback(item.device, item.context);
-			}
-		}
+			if (!evt_queue_get(&item))
+				break;
 
+			LOG("dispatching for object_id: 0x%" PRIx64 ".\n",
+				item.device->object_id);
+			item.callback(item.device, item.context);
+		} while (c->global->running);
+
+		evt_queue_report("high priority", &high_priority_queue, false);
+		evt_queue_report("normal", &normal_queue, false);
 	}
 
 	dispatcher_is_ready = false;
 
-	evt_queue_destroy(&normal_queue);
-	evt_queue_destroy(&high_priority_queue);
-
-	sem_destroy(&evt_dispatch_sem);
+	evt_queue_destroy("high priority", &high_priority_queue);
+	evt_queue_destroy("normal", &normal_queue);
 
+	res = evt_space_efd;
+	evt_space_efd = -1;
+	close(res);
+out_close_dispatch:
+	res = evt_dispatch_efd;
+	evt_dispatch_efd = -1;
+	close(res);
 out_exit:
 	LOG("exiting\n");
 	return NULL;
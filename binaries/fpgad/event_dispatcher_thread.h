@@ -48,6 +48,9 @@ typedef struct _event_dispatch_queue_item {
 
 bool evt_dispatcher_is_ready(void);
 
+// Queue a response for the event dispatcher thread. If the queue is
+// full, wait up to one poll interval for the dispatcher to make room.
+// Returns false if the response was dropped.
 bool evt_queue_response(fpgad_respond_event_t callback,
 			fpgad_monitored_device *device,
 			void *context);
@@ -37,7 +37,7 @@
 
 #include <sys/socket.h>
 #include <sys/un.h>
-#include <poll.h>
+#include <sys/epoll.h>
 #include <inttypes.h>
 #include "events_api_thread.h"
 #include "api/opae_events_api.h"
@@ -56,37 +56,76 @@ events_api_thread_config events_api_config = {
 };
 
 #define MAX_CLIENT_CONNECTIONS 1023
-#define SRV_SOCKET             0
-#define FIRST_CLIENT_SOCKET    1
+#define MAX_EPOLL_EVENTS       64
 
-/* array keeping track of all connection file descriptors (plus server socket) */
-STATIC struct pollfd pollfds[MAX_CLIENT_CONNECTIONS+1];
-STATIC nfds_t num_fds = 1;
+typedef struct _api_client {
+	int conn_socket;
+	struct _api_client *prev;
+	struct _api_client *next;
+} api_client;
+
+// The server socket and all client connections are registered with
+// epoll_fd. A client's epoll data is its api_client; the server
+// socket's is NULL.
+STATIC int epoll_fd = -1;
+STATIC api_client *client_list;
+STATIC unsigned num_clients;
+
+STATIC api_client *add_client(int conn_socket)
+{
+	struct epoll_event ev;
+	api_client *client;
+
+	client = (api_client *)opae_calloc(1, sizeof(api_client));
+	if (!client) {
+		LOG("calloc failed\n");
+		return NULL;
+	}
+
+	client->conn_socket = conn_socket;
+
+	ev.events = EPOLLIN | EPOLLPRI;
+	ev.data.ptr = client;
+
+	if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, conn_socket, &ev) < 0) {
+		LOG("epoll_ctl(ADD) failed: %s\n", strerror(errno));
+		opae_free(client);
+		return NULL;
+	}
+
+	client->next = client_list;
+	if (client_list)
+		client_list->prev = client;
+	client_list = client;
+	++num_clients;
 
-STATIC void remove_client(int conn_socket)
+	return client;
+}
+
+STATIC void remove_client(api_client *client)
 {
-	nfds_t i, j;
-	nfds_t removed = 0;
+	int conn_socket = client->conn_socket;
 
 	opae_api_unregister_all_events_for(conn_socket);
 	LOG("closing connection conn_socket=%d.\n", conn_socket);
+
+	epoll_ctl(epoll_fd, EPOLL_CTL_DEL, conn_socket, NULL);
 	opae_close(conn_socket);
 
-	for (i = j = FIRST_CLIENT_SOCKET ; i < num_fds ; ++i) {
-		if (conn_socket != pollfds[i].fd) {
-			if (j != i)
-				pollfds[j] = pollfds[i];
-			++j;
-		} else {
-			++removed;
-		}
-	}
+	if (client->prev)
+		client->prev->next = client->next;
+	else
+		client_list = client->next;
+	if (client->next)
+		client->next->prev = client->prev;
+	--num_clients;
 
-	num_fds -= removed;
+	opae_free(client);
 }
 
-STATIC int handle_message(int conn_socket)
+STATIC int handle_message(api_client *client)
 {
+	int conn_socket = client->conn_socket;
 	struct msghdr mh;
 	struct cmsghdr *cmh;
 	struct iovec iov[1];
@@ -118,7 +157,7 @@ STATIC int handle_message(int conn_socket)
 	}
 
 	if (!n) { // socket closed by peer
-		remove_client(conn_socket);
+		remove_client(client);
 		return (int)n;
 	}
 
@@ -177,7 +216,8 @@ void *events_api_thread(void *thread_context)
 	int policy = 0;
 	int res;
 
-	nfds_t i;
+	struct epoll_event events[MAX_EPOLL_EVENTS];
+	struct epoll_event ev;
 	struct sockaddr_un addr;
 	int server_socket;
 	int conn_socket;
@@ -228,55 +268,53 @@ void *events_api_thread(void *thread_context)
 	}
 	LOG("listening for connections.\n");
 
-	evt_api_is_ready = true;
+	epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	if (epoll_fd < 0) {
+		LOG("failed to create epoll instance.\n");
+		goto out_close_server;
+	}
 
-	pollfds[SRV_SOCKET].fd = server_socket;
-	pollfds[SRV_SOCKET].events = POLLIN | POLLPRI;
-	num_fds = 1;
+	ev.events = EPOLLIN | EPOLLPRI;
+	ev.data.ptr = NULL;
+	if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, server_socket, &ev) < 0) {
+		LOG("failed to add server socket to epoll.\n");
+		goto out_close_epoll;
+	}
+
+	evt_api_is_ready = true;
 
 	while (c->global->running) {
+		int i;
 
-		res = poll(pollfds, num_fds, 100);
+		res = epoll_wait(epoll_fd, events, MAX_EPOLL_EVENTS, 100);
 		if (res < 0) {
-			LOG("poll error\n");
-			continue;
-		}
-
-		if (0 == res) // timeout
-			continue;
-
-		if ((nfds_t)res > num_fds) { // weird
-			LOG("something bad happened during poll!\n");
+			if (errno != EINTR)
+				LOG("epoll_wait error\n");
 			continue;
 		}
 
-		// handle requests on existing sockets
-		for (i = FIRST_CLIENT_SOCKET ; i < num_fds ; ++i) {
-			if (pollfds[i].revents) {
-				handle_message(pollfds[i].fd);
-			}
-		}
+		for (i = 0 ; i < res ; ++i) {
+			api_client *client = (api_client *)events[i].data.ptr;
 
-		// handle new connection requests
-		if (pollfds[SRV_SOCKET].revents) {
-
-			if (num_fds == MAX_CLIENT_CONNECTIONS+1) {
-				LOG("exceeded max connections!\n");
+			if (client) {
+				// handle requests on existing sockets
+				handle_message(client);
 				continue;
 			}
 
+			// handle new connection requests
 			conn_socket = accept(server_socket, NULL, NULL);
 
 			if (conn_socket < 0) {
 				LOG("failed to accept new connection!\n");
+			} else if (num_clients == MAX_CLIENT_CONNECTIONS) {
+				LOG("exceeded max connections!\n");
+				opae_close(conn_socket);
+			} else if (!add_client(conn_socket)) {
+				opae_close(conn_socket);
 			} else {
 				LOG("accepting connection %d.\n", conn_socket);
-
-				pollfds[num_fds].fd = conn_socket;
-				pollfds[num_fds].events = POLLIN | POLLPRI;
-				++num_fds;
 			}
-
 		}
 
 	}
@@ -284,10 +322,12 @@ void *events_api_thread(void *thread_context)
 	opae_api_unregister_all_events();
 
 	// close any active client sockets
-	for (i = FIRST_CLIENT_SOCKET ; i < num_fds ; ++i) {
-		opae_close(pollfds[i].fd);
-	}
+	while (client_list)
+		remove_client(client_list);
 
+out_close_epoll:
+	opae_close(epoll_fd);
+	epoll_fd = -1;
 out_close_server:
 	evt_api_is_ready = false;
 	opae_close(server_socket);
@@ -69,6 +69,7 @@ int main(int argc, char *argv[])
 	memset(&global_config, 0, sizeof(global_config));
 
 	global_config.poll_interval_usec = 100 * 1000;
+	global_config.poll_fallback_usec = 1000 * 1000;
 	global_config.running = true;
 	global_config.api_socket = "/tmp/fpga_event_socket";
 	global_config.num_null_gbs = 0;
@@ -29,10 +29,16 @@
 #endif // HAVE_CONFIG_H
 
 #include <dlfcn.h>
+#include <inttypes.h>
 #include <sched.h>
+#include <poll.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
 #include "monitored_device.h"
 #include "monitor_thread.h"
 #include "event_dispatcher_thread.h"
+#include "api/device_monitoring.h"
 #include "mock/opae_std.h"
 
 #ifdef LOG
@@ -49,6 +55,9 @@ monitor_thread_config monitor_config = {
 
 STATIC pthread_mutex_t mon_list_lock = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
 STATIC fpgad_monitored_device *monitored_device_list;
+// Bumped each time monitored_device_list changes, so that the
+// event-driven monitor knows to rebuild its poll set.
+STATIC unsigned mon_list_gen;
 
 STATIC void mon_queue_response(fpgad_detection_status status,
 			       fpgad_respond_event_t response,
@@ -57,34 +66,59 @@ STATIC void mon_queue_response(fpgad_detection_status status,
 {
 	if (status == FPGAD_STATUS_DETECTED_HIGH) {
 
-		if (evt_queue_response_high(response,
-					    d,
-					    response_context)) {
-			sched_yield();
-		} else {
+		if (!evt_queue_response_high(response,
+					     d,
+					     response_context)) {
 			LOG("high priority event queue is full. Dropping!\n");
 		}
 
 	} else if (status == FPGAD_STATUS_DETECTED) {
 
-		if (evt_queue_response(response,
-				       d,
-				       response_context)) {
-			sched_yield();
-		} else {
+		if (!evt_queue_response(response,
+					d,
+					response_context)) {
 			LOG("event queue is full. Dropping!\n");
 		}
 
 	}
 }
 
+STATIC uint64_t mon_now_usec(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((uint64_t)ts.tv_sec * 1000000) + (ts.tv_nsec / 1000);
+}
+
+STATIC void mon_update_stats(fpgad_monitored_device *d, uint64_t usec)
+{
+	d->poll_last_usec = usec;
+	d->poll_total_usec += usec;
+	++d->poll_count;
+
+	if (usec > d->poll_max_usec) {
+		d->poll_max_usec = usec;
+
+		if (d->config && (usec > d->config->poll_interval_usec)) {
+			LOG("slow detections on objid=0x%" PRIx64 ":"
+			    " %" PRIu64 " usec (poll interval %u usec)\n",
+			    d->object_id, usec,
+			    d->config->poll_interval_usec);
+		}
+	}
+}
+
 STATIC void mon_monitor(fpgad_monitored_device *d)
 {
 	unsigned i;
+	uint64_t start;
 
 	if (!d->detections)
 		return;
 
+	start = mon_now_usec();
+
 	for (i = 0 ; d->detections[i] ; ++i) {
 		fpgad_detection_status result;
 		fpgad_detect_event_t detect =
@@ -110,6 +144,394 @@ STATIC void mon_monitor(fpgad_monitored_device *d)
 			}
 		}
 	}
+
+	mon_update_stats(d, mon_now_usec() - start);
+}
+
+// State of the event-driven monitor. fds[0] is the uevent socket,
+// followed by the watch fds of each monitored device in list order.
+typedef struct _mon_events {
+	int uevent_fd;
+	unsigned gen;
+	struct pollfd *fds;
+	nfds_t num_fds;
+	uint64_t next_poll;     // usec: next poll of unwatched devices
+	uint64_t next_fallback; // usec: next poll of watched devices
+} mon_events;
+
+STATIC int mon_uevent_open(void)
+{
+	struct sockaddr_nl addr;
+	int fd;
+
+	fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK,
+		    NETLINK_KOBJECT_UEVENT);
+	if (fd < 0) {
+		LOG("failed to open uevent socket: %s\n", strerror(errno));
+		return -1;
+	}
+
+	memset(&addr, 0, sizeof(addr));
+	addr.nl_family = AF_NETLINK;
+	addr.nl_groups = 1; // kernel uevents
+
+	if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+		LOG("failed to bind uevent socket: %s\n", strerror(errno));
+		close(fd);
+		return -1;
+	}
+
+	return fd;
+}
+
+// msg is "action@devpath" followed by NUL-separated KEY=value
+// strings. Returns true when it concerns an FPGA device.
+STATIC bool mon_uevent_is_fpga(const char *msg, size_t len)
+{
+	size_t pos = 0;
+
+	while (pos < len) {
+		const char *s = msg + pos;
+		size_t n = strnlen(s, len - pos);
+
+		if (!strncmp(s, "SUBSYSTEM=", 10)) {
+			s += 10;
+			if (!strncmp(s, "dfl", 3) ||
+			    !strncmp(s, "fpga", 4) ||
+			    !strncmp(s, "intel-fpga", 10))
+				return true;
+		} else if (!strncmp(s, "DEVPATH=", 8)) {
+			if (strstr(s, "/dfl") || strstr(s, "fpga"))
+				return true;
+		}
+
+		pos += n + 1;
+	}
+
+	return false;
+}
+
+// Drain the uevent socket. Returns true if any
+// of the pending uevents concerns an FPGA device.
+STATIC bool mon_uevent_drain(int fd)
+{
+	char buf[4096];
+	ssize_t len;
+	bool fpga = false;
+
+	while ((len = recv(fd, buf, sizeof(buf), 0)) > 0) {
+		if (mon_uevent_is_fpga(buf, (size_t)len))
+			fpga = true;
+	}
+
+	return fpga;
+}
+
+// Called with mon_list_lock held.
+STATIC int mon_events_rebuild(mon_events *e)
+{
+	fpgad_monitored_device *d;
+	struct pollfd *fds;
+	nfds_t num_fds = 1;
+	unsigned i;
+
+	for (d = monitored_device_list ; d ; d = d->next)
+		num_fds += d->num_watches;
+
+	fds = opae_calloc(num_fds, sizeof(struct pollfd));
+	if (!fds) {
+		LOG("calloc failed\n");
+		return 1;
+	}
+
+	fds[0].fd = e->uevent_fd;
+	fds[0].events = POLLIN;
+
+	num_fds = 1;
+	for (d = monitored_device_list ; d ; d = d->next) {
+		for (i = 0 ; i < d->num_watches ; ++i) {
+			fds[num_fds].fd = d->watch_fds[i];
+			fds[num_fds].events = POLLPRI;
+			++num_fds;
+		}
+	}
+
+	if (e->fds)
+		opae_free(e->fds);
+	e->fds = fds;
+	e->num_fds = num_fds;
+	e->gen = mon_list_gen;
+
+	return 0;
+}
+
+STATIC void mon_events_init(mon_events *e)
+{
+	memset(e, 0, sizeof(*e));
+	e->uevent_fd = mon_uevent_open();
+	e->gen = mon_list_gen - 1;
+}
+
+STATIC void mon_events_destroy(mon_events *e)
+{
+	if (e->fds) {
+		opae_free(e->fds);
+		e->fds = NULL;
+	}
+	e->num_fds = 0;
+
+	if (e->uevent_fd >= 0) {
+		close(e->uevent_fd);
+		e->uevent_fd = -1;
+	}
+}
+
+// Wait for a watch or uevent to fire, or for a timed poll to come
+// due, then run the detections of the devices that need it.
+STATIC void mon_events_run(monitor_thread_config *c, mon_events *e)
+{
+	fpgad_monitored_device *d;
+	bool have_unwatched = false;
+	bool poll_unwatched;
+	bool poll_watched;
+	bool poll_all = false;
+	uint64_t now;
+	uint64_t deadline;
+	uint64_t timeout;
+	nfds_t j;
+	int res;
+	int err;
+
+	fpgad_mutex_lock(err, &mon_list_lock);
+
+	if ((e->gen != mon_list_gen) && mon_events_rebuild(e)) {
+		fpgad_mutex_unlock(err, &mon_list_lock);
+		usleep(c->global->poll_interval_usec);
+		return;
+	}
+
+	for (d = monitored_device_list ; d ; d = d->next) {
+		if (!d->num_watches) {
+			have_unwatched = true;
+			break;
+		}
+	}
+
+	fpgad_mutex_unlock(err, &mon_list_lock);
+
+	now = mon_now_usec();
+
+	deadline = e->next_fallback;
+	if (have_unwatched && (e->next_poll < deadline))
+		deadline = e->next_poll;
+
+	timeout = (deadline > now) ? deadline - now : 0;
+	// Don't sleep past one poll interval, so that
+	// shutdown is noticed promptly.
+	if (timeout > c->global->poll_interval_usec)
+		timeout = c->global->poll_interval_usec;
+
+	res = poll(e->fds, e->num_fds, (int)((timeout + 999) / 1000));
+	if (res < 0) {
+		if (errno != EINTR)
+			LOG("poll failed: %s\n", strerror(errno));
+		res = 0;
+	}
+
+	fpgad_mutex_lock(err, &mon_list_lock);
+
+	if (e->gen != mon_list_gen) {
+		// The poll set is stale. Poll everything and
+		// rebuild on the next pass.
+		poll_all = true;
+		res = 0;
+	} else if (res > 0 && (e->fds[0].revents & POLLIN)) {
+		poll_all = mon_uevent_drain(e->uevent_fd);
+	}
+
+	now = mon_now_usec();
+
+	poll_unwatched = now >= e->next_poll;
+	if (poll_unwatched)
+		e->next_poll = now + c->global->poll_interval_usec;
+
+	poll_watched = now >= e->next_fallback;
+	if (poll_watched)
+		e->next_fallback = now + c->global->poll_fallback_usec;
+
+	j = 1;
+	for (d = monitored_device_list ; d ; d = d->next) {
+		bool run = poll_all ||
+			(d->num_watches ? poll_watched : poll_unwatched);
+		unsigned i;
+
+		for (i = 0 ; (res > 0) && (i < d->num_watches) ; ++i, ++j) {
+			struct pollfd *p = &e->fds[j];
+			char buf[64];
+
+			if (!(p->revents & (POLLPRI | POLLERR)))
+				continue;
+
+			run = true;
+
+			// Re-arm the notification. An attribute that can
+			// no longer be read (device removed) signals
+			// continuously, so stop watching it; the device
+			// is still covered by the fallback poll.
+			if (pread(p->fd, buf, sizeof(buf), 0) < 0)
+				p->fd = -1;
+		}
+
+		if (run)
+			mon_monitor(d);
+	}
+
+	fpgad_mutex_unlock(err, &mon_list_lock);
+}
+
+// One thread of the worker-pool monitor. Worker index polls
+// every num_workers-th device of monitored_device_list.
+typedef struct _mon_worker {
+	monitor_thread_config *c;
+	volatile bool *stop;
+	unsigned index;
+	unsigned num_workers;
+	unsigned gen;
+	fpgad_monitored_device **devs;
+	unsigned num_devs;
+	pthread_t thread;
+} mon_worker;
+
+// Called with mon_list_lock held.
+STATIC int mon_worker_shard(mon_worker *w)
+{
+	fpgad_monitored_device *d;
+	fpgad_monitored_device **devs = NULL;
+	unsigned count = 0;
+	unsigned i;
+
+	for (d = monitored_device_list, i = 0 ; d ; d = d->next, ++i) {
+		if ((i % w->num_workers) == w->index)
+			++count;
+	}
+
+	if (count) {
+		devs = opae_calloc(count, sizeof(fpgad_monitored_device *));
+		if (!devs) {
+			LOG("calloc failed\n");
+			return 1;
+		}
+
+		count = 0;
+		for (d = monitored_device_list, i = 0 ;
+		     d ; d = d->next, ++i) {
+			if ((i % w->num_workers) == w->index)
+				devs[count++] = d;
+		}
+	}
+
+	if (w->devs)
+		opae_free(w->devs);
+	w->devs = devs;
+	w->num_devs = count;
+	w->gen = mon_list_gen;
+
+	return 0;
+}
+
+STATIC void *mon_worker_thread(void *thread_context)
+{
+	mon_worker *w = (mon_worker *)thread_context;
+	useconds_t interval = w->c->global->poll_interval_usec;
+	uint64_t next;
+	uint64_t now;
+	unsigned i;
+	int err;
+
+	// Stagger the workers across the poll interval.
+	next = mon_now_usec() +
+		((uint64_t)interval * w->index) / w->num_workers;
+
+	while (w->c->global->running && !*w->stop) {
+		now = mon_now_usec();
+		if (next > now)
+			usleep(next - now);
+
+		fpgad_mutex_lock(err, &mon_list_lock);
+		if (w->gen != mon_list_gen)
+			mon_worker_shard(w);
+		fpgad_mutex_unlock(err, &mon_list_lock);
+
+		// Devices are only freed by mon_destroy(),
+		// after the workers have been joined.
+		for (i = 0 ; i < w->num_devs ; ++i)
+			mon_monitor(w->devs[i]);
+
+		// A worker that falls behind resumes from now
+		// rather than polling back-to-back to catch up.
+		next += interval;
+		now = mon_now_usec();
+		if (next < now)
+			next = now;
+	}
+
+	if (w->devs) {
+		opae_free(w->devs);
+		w->devs = NULL;
+	}
+	w->num_devs = 0;
+
+	return NULL;
+}
+
+// Run the worker pool until fpgad stops. Returns non-zero
+// if the pool could not be started.
+STATIC int mon_run_workers(monitor_thread_config *c)
+{
+	unsigned num_workers = c->global->monitor_workers;
+	volatile bool stop = false;
+	mon_worker *workers;
+	unsigned started;
+	int res;
+
+	workers = opae_calloc(num_workers, sizeof(mon_worker));
+	if (!workers) {
+		LOG("calloc failed\n");
+		return 1;
+	}
+
+	for (started = 0 ; started < num_workers ; ++started) {
+		mon_worker *w = &workers[started];
+
+		w->c = c;
+		w->stop = &stop;
+		w->index = started;
+		w->num_workers = num_workers;
+		w->gen = mon_list_gen - 1;
+
+		res = pthread_create(&w->thread, NULL,
+				     mon_worker_thread, w);
+		if (res) {
+			LOG("failed to create monitor worker %u: %s\n",
+			    started, strerror(res));
+			break;
+		}
+	}
+
+	if (started == num_workers) {
+		LOG("monitoring with %u workers\n", num_workers);
+		while (c->global->running)
+			usleep(c->global->poll_interval_usec);
+	}
+
+	stop = true;
+	while (started)
+		pthread_join(workers[--started].thread, NULL);
+
+	res = c->global->running ? 1 : 0;
+	opae_free(workers);
+
+	return res;
 }
 
 STATIC volatile bool mon_is_ready = (bool)0;
@@ -148,6 +570,25 @@ void *monitor_thread(void *thread_context)
 
 	mon_is_ready = true;
 
+	if (c->global->event_driven) {
+		mon_events events;
+
+		LOG("event-driven monitoring\n");
+		if (c->global->monitor_workers > 1)
+			LOG("monitor workers are not used"
+			    " in event-driven mode\n");
+
+		mon_events_init(&events);
+
+		while (c->global->running)
+			mon_events_run(c, &events);
+
+		mon_events_destroy(&events);
+	} else if (c->global->monitor_workers > 1) {
+		if (mon_run_workers(c))
+			LOG("falling back to a single monitor thread\n");
+	}
+
 	while (c->global->running) {
 		fpgad_mutex_lock(err, &mon_list_lock);
 
@@ -181,6 +622,7 @@ void mon_monitor_device(fpgad_monitored_device *d)
 	fpgad_mutex_lock(err, &mon_list_lock);
 
 	d->next = NULL;
+	++mon_list_gen;
 
 	if (!monitored_device_list) {
 		monitored_device_list = d;
@@ -226,6 +668,15 @@ void mon_destroy(struct fpgad_config *c)
 			pthread_join(trash->thread, NULL);
 		}
 
+		if (trash->poll_count) {
+			LOG("objid=0x%" PRIx64 " polled %" PRIu64 " times,"
+			    " avg %" PRIu64 " usec, max %" PRIu64 " usec\n",
+			    trash->object_id,
+			    trash->poll_count,
+			    trash->poll_total_usec / trash->poll_count,
+			    trash->poll_max_usec);
+		}
+
 		destroy = (fpgad_plugin_destroy_t)
 			dlsym(trash->supported->dl_handle,
 				FPGAD_PLUGIN_DESTROY);
@@ -237,12 +688,15 @@ void mon_destroy(struct fpgad_config *c)
 				trash->supported->module_library);
 		}
 
+		mon_remove_device_watches(trash);
+
 		if (trash->token)
 			fpgaDestroyToken(&trash->token);
 
 		opae_free(trash);
 	}
 	monitored_device_list = NULL;
+	++mon_list_gen;
 
 	if (c->supported_devices) {
 		for (i = 0 ; c->supported_devices[i].module_library ; ++i) {
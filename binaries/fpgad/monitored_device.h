@@ -99,6 +99,25 @@ typedef struct _fpgad_monitored_device {
 #define MAX_DEV_SCRATCHPAD 2
 	uint64_t scratchpad[MAX_DEV_SCRATCHPAD];
 
+	// sysfs attributes that raise POLLPRI (sysfs_notify) when
+	// they change. The event-driven monitor runs this device's
+	// detections when one of them fires. See mon_add_device_watch().
+#define MAX_DEV_WATCHES 16
+	int watch_fds[MAX_DEV_WATCHES];
+	unsigned num_watches;
+
+	// Time spent running this device's detections,
+	// updated by the monitor after each poll.
+	uint64_t poll_count;
+	uint64_t poll_total_usec;
+	uint64_t poll_max_usec;
+	uint64_t poll_last_usec;
+
+	// Private per-device state owned by the plugin. Set in
+	// fpgad_plugin_configure() and released in
+	// fpgad_plugin_destroy().
+	void *plugin_context;
+
 	struct _fpgad_monitored_device *next;
 } fpgad_monitored_device;
 
@@ -28,14 +28,22 @@
 #include <config.h>
 #endif // HAVE_CONFIG_H
 
+#include <errno.h>
+#include <fcntl.h>
 #include <glob.h>
 #include <poll.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include "fpgad/api/opae_events_api.h"
 #include "fpgad/api/device_monitoring.h"
 #include "fpgad/api/sysfs.h"
 #include "mock/opae_std.h"
 #include "cfg-file.h"
+#include "telemetry-shm.h"
 
 #ifdef LOG
 #undef LOG
@@ -80,6 +88,7 @@ typedef struct _vc_sensor {
 #define FPGAD_SENSOR_VC_LOW_WARN_VALID   0x00000010
 	uint32_t read_errors;
 #define FPGAD_SENSOR_VC_MAX_READ_ERRORS  25
+	uint64_t timestamp_ns;
 } vc_sensor;
 
 #define MAX_SENSOR_NAME 32
@@ -118,6 +127,8 @@ typedef struct _vc_device {
 	bool fpga_seu_err;
 	bool bmc_seu_err;
 	char sbdf[16];
+	opae_telemetry_shm *telemetry;
+	char telemetry_name[OPAE_TELEMETRY_SHM_NAME_LEN];
 } vc_device;
 
 #define BIT_SET_MASK(__n)  (1 << ((__n) % 8))
@@ -180,6 +191,7 @@ STATIC void vc_destroy_sensor(vc_sensor *sensor)
 	}
 	sensor->flags = 0;
 	sensor->read_errors = 0;
+	sensor->timestamp_ns = 0;
 }
 
 STATIC void vc_destroy_sensors(vc_device *vc)
@@ -202,8 +214,19 @@ STATIC void vc_destroy_sensors(vc_device *vc)
 	}
 }
 
+STATIC void vc_telemetry_close(vc_device *vc)
+{
+	if (!vc->telemetry)
+		return;
+
+	munmap(vc->telemetry, sizeof(opae_telemetry_shm));
+	vc->telemetry = NULL;
+	shm_unlink(vc->telemetry_name);
+}
+
 STATIC void vc_destroy_device(vc_device *vc)
 {
+	vc_telemetry_close(vc);
 	vc_destroy_sensors(vc);
 	if (vc->config_sensors) {
 		opae_free(vc->config_sensors);
@@ -651,6 +674,120 @@ STATIC fpga_result vc_enable_aer(vc_device *vc)
 	return FPGA_OK;
 }
 
+STATIC uint64_t vc_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// Create the shared memory segment that fpgaTelemetryRead() copies
+// the sensor table from. Failure is not fatal: sensors are still
+// monitored, only not published.
+STATIC void vc_telemetry_open(vc_device *vc,
+			      uint16_t seg,
+			      uint8_t bus,
+			      uint8_t dev,
+			      uint8_t fn)
+{
+	opae_telemetry_shm *shm;
+	int fd;
+
+	opae_telemetry_shm_name(vc->telemetry_name, seg, bus, dev, fn);
+
+	fd = shm_open(vc->telemetry_name,
+		      O_CREAT | O_TRUNC | O_RDWR | O_CLOEXEC, 0644);
+	if (fd < 0) {
+		LOG("shm_open(\"%s\") failed: %s\n",
+		    vc->telemetry_name, strerror(errno));
+		return;
+	}
+
+	if (ftruncate(fd, sizeof(opae_telemetry_shm))) {
+		LOG("ftruncate(\"%s\") failed: %s\n",
+		    vc->telemetry_name, strerror(errno));
+		goto out_unlink;
+	}
+
+	shm = mmap(NULL, sizeof(opae_telemetry_shm),
+		   PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (shm == MAP_FAILED) {
+		LOG("mmap(\"%s\") failed: %s\n",
+		    vc->telemetry_name, strerror(errno));
+		goto out_unlink;
+	}
+
+	close(fd);
+
+	shm->version = OPAE_TELEMETRY_SHM_VERSION;
+	shm->size = sizeof(opae_telemetry_shm);
+	// Readers check the magic before anything else.
+	__atomic_store_n(&shm->magic, OPAE_TELEMETRY_SHM_MAGIC,
+			 __ATOMIC_RELEASE);
+
+	vc->telemetry = shm;
+	return;
+
+out_unlink:
+	close(fd);
+	shm_unlink(vc->telemetry_name);
+}
+
+// Every sensor of a device must fit in the published snapshot.
+_Static_assert(MAX_VC_SENSORS <= FPGA_TELEMETRY_MAX_SENSORS,
+	       "MAX_VC_SENSORS exceeds FPGA_TELEMETRY_MAX_SENSORS");
+
+// Called at the end of each poll, while vc->state_tripped
+// still holds the result of the poll.
+STATIC void vc_telemetry_publish(vc_device *vc, uint64_t now)
+{
+	opae_telemetry_shm *shm = vc->telemetry;
+	uint32_t i;
+
+	if (!shm)
+		return;
+
+	opae_telemetry_write_begin(shm);
+
+	shm->snapshot.timestamp_ns = now;
+	shm->snapshot.num_sensors = vc->num_sensors;
+
+	for (i = 0 ; i < vc->num_sensors ; ++i) {
+		vc_sensor *s = &vc->sensors[i];
+		fpga_telemetry_sensor *t = &shm->snapshot.sensors[i];
+		uint32_t flags = 0;
+
+		snprintf(t->name, sizeof(t->name), "%s",
+			 s->name ? s->name : "");
+		snprintf(t->type, sizeof(t->type), "%s",
+			 s->type ? s->type : "");
+
+		t->value = s->value;
+		t->high_fatal = s->high_fatal;
+		t->high_warn = s->high_warn;
+		t->low_fatal = s->low_fatal;
+		t->low_warn = s->low_warn;
+		t->timestamp_ns = s->timestamp_ns;
+
+		if (s->flags & FPGAD_SENSOR_VC_HIGH_FATAL_VALID)
+			flags |= FPGA_TELEMETRY_HIGH_FATAL_VALID;
+		if (s->flags & FPGAD_SENSOR_VC_HIGH_WARN_VALID)
+			flags |= FPGA_TELEMETRY_HIGH_WARN_VALID;
+		if (s->flags & FPGAD_SENSOR_VC_LOW_FATAL_VALID)
+			flags |= FPGA_TELEMETRY_LOW_FATAL_VALID;
+		if (s->flags & FPGAD_SENSOR_VC_LOW_WARN_VALID)
+			flags |= FPGA_TELEMETRY_LOW_WARN_VALID;
+		if (s->flags & FPGAD_SENSOR_VC_IGNORE)
+			flags |= FPGA_TELEMETRY_IGNORED;
+		if (BIT_IS_SET(vc->state_tripped, s->id))
+			flags |= FPGA_TELEMETRY_TRIPPED;
+		t->flags = flags;
+	}
+
+	opae_telemetry_write_end(shm);
+}
+
 STATIC bool vc_monitor_sensors(vc_device *vc)
 {
 	uint32_t i;
@@ -681,6 +818,9 @@ STATIC bool vc_monitor_sensors(vc_device *vc)
 			continue;
 		}
 
+		if (vc->telemetry)
+			s->timestamp_ns = vc_now_ns();
+
 		if (HIGH_WARN(s) || LOW_WARN(s)) {
 			opae_api_send_EVENT_POWER_THERMAL(vc->base_device);
 			BIT_SET_SET(vc->state_tripped, s->id);
@@ -742,6 +882,9 @@ STATIC bool vc_monitor_sensors(vc_device *vc)
 			BIT_SET_CLR(vc->state_last, s->id);
 	}
 
+	if (vc->telemetry)
+		vc_telemetry_publish(vc, vc_now_ns());
+
 	memset(vc->state_tripped, 0, (vc->num_sensors + 7) / 8);
 
 	return res;
@@ -1314,6 +1457,8 @@ int fpgad_plugin_configure(fpgad_monitored_device *d,
 		snprintf(vc->sbdf, sizeof(vc->sbdf), "%04x:%02x:%02x.%d",
 			 (int)seg, (int)bus, (int)dev, (int)fn);
 
+		vc_telemetry_open(vc, seg, bus, dev, fn);
+
 		LOG("monitoring 0x%04x:0x%04x 0x%04x:0x%04x (%s)\n",
 			d->supported->vendor_id,
 			d->supported->device_id,
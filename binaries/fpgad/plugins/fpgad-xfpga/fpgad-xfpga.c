@@ -28,8 +28,11 @@
 #include <config.h>
 #endif // HAVE_CONFIG_H
 
+#include <glob.h>
+
 #include "fpgad/api/opae_events_api.h"
 #include "fpgad/api/device_monitoring.h"
+#include "mock/opae_std.h"
 
 #ifdef LOG
 #undef LOG
@@ -37,6 +40,135 @@
 #define LOG(format, ...) \
 log_printf("fpgad-xfpga: " format, ##__VA_ARGS__)
 
+#define FPGAD_XFPGA_MAX_OBJECTS 8
+
+typedef struct _fpgad_xfpga_object {
+	const char *sysfs_file;
+	fpga_object obj;
+	uint64_t value;
+	uint64_t seq;
+} fpgad_xfpga_object;
+
+// The sysfs objects read by one monitored device's detections. They
+// are acquired once in fpgad_plugin_configure() and re-read with
+// FPGA_OBJECT_SYNC on each poll. Many detections share a file, so each
+// object is read at most once per poll; a poll starts when the first
+// detection of the device runs.
+typedef struct _fpgad_xfpga_objects {
+	uint64_t seq;
+	unsigned num_objects;
+	fpgad_xfpga_object objects[FPGAD_XFPGA_MAX_OBJECTS];
+} fpgad_xfpga_objects;
+
+STATIC fpgad_xfpga_object *
+fpgad_xfpga_find_object(fpgad_xfpga_objects *objs, const char *sysfs_file)
+{
+	unsigned i;
+
+	for (i = 0 ; i < objs->num_objects ; ++i) {
+		if (!strcmp(objs->objects[i].sysfs_file, sysfs_file))
+			return &objs->objects[i];
+	}
+
+	return NULL;
+}
+
+STATIC void fpgad_xfpga_add_object(fpgad_monitored_device *d,
+				   fpgad_xfpga_objects *objs,
+				   const char *sysfs_file)
+{
+	fpgad_xfpga_object *o;
+
+	if (fpgad_xfpga_find_object(objs, sysfs_file))
+		return;
+
+	if (objs->num_objects == FPGAD_XFPGA_MAX_OBJECTS) {
+		LOG("too many sysfs objects, not caching %s\n", sysfs_file);
+		return;
+	}
+
+	o = &objs->objects[objs->num_objects++];
+	o->sysfs_file = sysfs_file;
+
+	// A missing object is retried when it is first read.
+	if (fpgaTokenGetObject(d->token, sysfs_file, &o->obj, 0) != FPGA_OK)
+		o->obj = NULL;
+}
+
+STATIC fpga_result fpgad_xfpga_read64_once(fpgad_monitored_device *d,
+					   const char *sysfs_file,
+					   uint64_t *value)
+{
+	fpga_object obj = NULL;
+	fpga_result res;
+
+	res = fpgaTokenGetObject(d->token, sysfs_file,
+				 &obj, 0);
+	if (res != FPGA_OK) {
+		LOG("failed to get error object\n");
+		return res;
+	}
+
+	res = fpgaObjectRead64(obj, value, 0);
+	if (res != FPGA_OK)
+		LOG("failed to read error object\n");
+
+	fpgaDestroyObject(&obj);
+
+	return res;
+}
+
+STATIC fpga_result fpgad_xfpga_read64(fpgad_monitored_device *d,
+				      void *context,
+				      const char *sysfs_file,
+				      uint64_t *value)
+{
+	fpgad_xfpga_objects *objs =
+		(fpgad_xfpga_objects *)d->plugin_context;
+	fpgad_xfpga_object *o;
+	fpga_result res;
+
+	if (!objs)
+		return fpgad_xfpga_read64_once(d, sysfs_file, value);
+
+	if (d->detection_contexts && (context == d->detection_contexts[0]))
+		++objs->seq;
+
+	o = fpgad_xfpga_find_object(objs, sysfs_file);
+	if (!o)
+		return fpgad_xfpga_read64_once(d, sysfs_file, value);
+
+	if (o->obj && (o->seq == objs->seq)) {
+		*value = o->value;
+		return FPGA_OK;
+	}
+
+	if (!o->obj) {
+		res = fpgaTokenGetObject(d->token, sysfs_file,
+					 &o->obj, 0);
+		if (res != FPGA_OK) {
+			o->obj = NULL;
+			LOG("failed to get error object\n");
+			return res;
+		}
+	}
+
+	res = fpgaObjectRead64(o->obj, &o->value, FPGA_OBJECT_SYNC);
+	if (res != FPGA_OK) {
+		LOG("failed to read error object\n");
+		// The device may have been removed. Drop the object
+		// and acquire it again on a later poll.
+		fpgaDestroyObject(&o->obj);
+		o->obj = NULL;
+		return res;
+	}
+
+	o->seq = objs->seq;
+	*value = o->value;
+
+	return FPGA_OK;
+}
+
 enum fpga_power_state {
 	FPGAD_NORMAL_PWR = 0,
 	FPGAD_AP1_STATE,
@@ -63,7 +195,6 @@ fpgad_xfpga_detect_AP1_or_AP2(fpgad_monitored_device *d,
 {
 	fpgad_xfpga_AP_context *c =
 		(fpgad_xfpga_AP_context *)context;
-	fpga_object obj = NULL;
 	fpga_result res;
 	uint64_t err = 0;
 	uint64_t mask;
@@ -71,21 +202,9 @@ fpgad_xfpga_detect_AP1_or_AP2(fpgad_monitored_device *d,
 	int i;
 	bool detected = false;
 
-	res = fpgaTokenGetObject(d->token, c->sysfs_file,
-				 &obj, 0);
-	if (res != FPGA_OK) {
-		LOG("failed to get error object\n");
+	res = fpgad_xfpga_read64(d, context, c->sysfs_file, &err);
+	if (res != FPGA_OK)
 		return FPGAD_STATUS_NOT_DETECTED;
-	}
-
-	res = fpgaObjectRead64(obj, &err, 0);
-	if (res != FPGA_OK) {
-		LOG("failed to read error object\n");
-		fpgaDestroyObject(&obj);
-		return FPGAD_STATUS_NOT_DETECTED;
-	}
-
-	fpgaDestroyObject(&obj);
 
 	mask = 0;
 	for (i = c->low_bit ; i <= c->high_bit ; ++i)
@@ -122,7 +241,6 @@ fpgad_xfpga_detect_PowerStateChange(fpgad_monitored_device *d,
 {
 	fpgad_xfpga_AP_context *c =
 		(fpgad_xfpga_AP_context *)context;
-	fpga_object obj = NULL;
 	fpga_result res;
 	uint64_t err = 0;
 	uint64_t mask;
@@ -130,21 +248,9 @@ fpgad_xfpga_detect_PowerStateChange(fpgad_monitored_device *d,
 	int i;
 	bool detected = false;
 
-	res = fpgaTokenGetObject(d->token, c->sysfs_file,
-				 &obj, 0);
-	if (res != FPGA_OK) {
-		LOG("failed to get error object\n");
+	res = fpgad_xfpga_read64(d, context, c->sysfs_file, &err);
+	if (res != FPGA_OK)
 		return FPGAD_STATUS_NOT_DETECTED;
-	}
-
-	res = fpgaObjectRead64(obj, &err, 0);
-	if (res != FPGA_OK) {
-		LOG("failed to read error object\n");
-		fpgaDestroyObject(&obj);
-		return FPGAD_STATUS_NOT_DETECTED;
-	}
-
-	fpgaDestroyObject(&obj);
 
 	mask = 0;
 	for (i = c->low_bit ; i <= c->high_bit ; ++i)
@@ -307,7 +413,6 @@ fpgad_xfpga_detect_Error(fpgad_monitored_device *d,
 {
 	fpgad_xfpga_Error_context *c =
 		(fpgad_xfpga_Error_context *)context;
-	fpga_object obj = NULL;
 	fpga_result res;
 	uint64_t err = 0;
 	uint64_t mask;
@@ -315,21 +420,9 @@ fpgad_xfpga_detect_Error(fpgad_monitored_device *d,
 	int i;
 	bool detected = false;
 
-	res = fpgaTokenGetObject(d->token, c->sysfs_file,
-				 &obj, 0);
-	if (res != FPGA_OK) {
-		LOG("failed to get error object\n");
-		return FPGAD_STATUS_NOT_DETECTED;
-	}
-
-	res = fpgaObjectRead64(obj, &err, 0);
-	if (res != FPGA_OK) {
-		LOG("failed to read error object\n");
-		fpgaDestroyObject(&obj);
+	res = fpgad_xfpga_read64(d, context, c->sysfs_file, &err);
+	if (res != FPGA_OK)
 		return FPGAD_STATUS_NOT_DETECTED;
-	}
-
-	fpgaDestroyObject(&obj);
 
 	mask = 0;
 	for (i = c->low_bit ; i <= c->high_bit ; ++i)
@@ -951,9 +1044,116 @@ STATIC void *fpgad_xfpga_fme_response_contexts[] = {
 	NULL
 };
 
+// Where the Port and FME sysfs directories live, relative to the
+// PCIe device, for the DFL and the legacy intel-fpga drivers.
+STATIC const char *fpgad_xfpga_port_dirs[] = {
+	"/sys/bus/pci/devices/%04x:%02x:%02x.%d/fpga_region/region*/dfl-port.*",
+	"/sys/bus/pci/devices/%04x:%02x:%02x.%d/fpga/intel-fpga-dev.*/intel-fpga-port.*",
+	NULL
+};
+
+STATIC const char *fpgad_xfpga_fme_dirs[] = {
+	"/sys/bus/pci/devices/%04x:%02x:%02x.%d/fpga_region/region*/dfl-fme.*",
+	"/sys/bus/pci/devices/%04x:%02x:%02x.%d/fpga/intel-fpga-dev.*/intel-fpga-fme.*",
+	NULL
+};
+
+// Watch each matching instance of the pattern file, relative
+// to the device's sysfs directory. Returns the number of watches.
+STATIC unsigned fpgad_xfpga_watch(fpgad_monitored_device *d,
+				  const char *dir,
+				  const char *file)
+{
+	char pattern[PATH_MAX];
+	glob_t glob_data;
+	unsigned watches = 0;
+	size_t i;
+
+	snprintf(pattern, sizeof(pattern), "%s/%s", dir, file);
+
+	if (opae_glob(pattern, 0, NULL, &glob_data)) {
+		if (glob_data.gl_pathv)
+			opae_globfree(&glob_data);
+		return 0;
+	}
+
+	for (i = 0 ; i < glob_data.gl_pathc ; ++i) {
+		if (mon_add_device_watch(d, glob_data.gl_pathv[i]))
+			++watches;
+	}
+
+	opae_globfree(&glob_data);
+
+	return watches;
+}
+
+// Register the sysfs attributes read by d's detections, plus any
+// FME hwmon alarms, for change notification by the event-driven
+// monitor. Attributes that don't exist are covered by timed polling.
+STATIC void fpgad_xfpga_add_watches(fpgad_monitored_device *d,
+				    fpgad_xfpga_objects *objs)
+{
+	fpga_properties prop = NULL;
+	uint16_t segment = 0;
+	uint8_t bus = 0;
+	uint8_t device = 0;
+	uint8_t function = 0;
+	const char **dirs;
+	char dir[PATH_MAX];
+	glob_t glob_data;
+	unsigned i;
+
+	if (fpgaGetProperties(d->token, &prop) != FPGA_OK) {
+		LOG("failed to get properties, not watching sysfs\n");
+		return;
+	}
+
+	if ((fpgaPropertiesGetSegment(prop, &segment) != FPGA_OK) ||
+	    (fpgaPropertiesGetBus(prop, &bus) != FPGA_OK) ||
+	    (fpgaPropertiesGetDevice(prop, &device) != FPGA_OK) ||
+	    (fpgaPropertiesGetFunction(prop, &function) != FPGA_OK)) {
+		LOG("failed to get PCIe address, not watching sysfs\n");
+		fpgaDestroyProperties(&prop);
+		return;
+	}
+
+	fpgaDestroyProperties(&prop);
+
+	dirs = (d->object_type == FPGA_ACCELERATOR) ?
+		fpgad_xfpga_port_dirs : fpgad_xfpga_fme_dirs;
+
+	for ( ; *dirs ; ++dirs) {
+		snprintf(dir, sizeof(dir), *dirs,
+			 segment, bus, device, function);
+
+		if (opae_glob(dir, 0, NULL, &glob_data)) {
+			if (glob_data.gl_pathv)
+				opae_globfree(&glob_data);
+			continue;
+		}
+
+		// One device per PCIe function.
+		snprintf(dir, sizeof(dir), "%s", glob_data.gl_pathv[0]);
+		opae_globfree(&glob_data);
+		break;
+	}
+
+	if (!*dirs)
+		return;
+
+	for (i = 0 ; i < objs->num_objects ; ++i)
+		fpgad_xfpga_watch(d, dir, objs->objects[i].sysfs_file);
+
+	if (d->object_type == FPGA_DEVICE)
+		fpgad_xfpga_watch(d, dir, "hwmon/hwmon*/*_alarm");
+}
+
 int fpgad_plugin_configure(fpgad_monitored_device *d,
 			   const char *cfg)
 {
+	fpgad_xfpga_objects *objs;
+	unsigned i;
+
 	UNUSED_PARAM(cfg);
 
 	LOG("monitoring vid=0x%04x did=0x%04x objid=0x%x (%s)\n",
@@ -977,15 +1177,56 @@ int fpgad_plugin_configure(fpgad_monitored_device *d,
 		d->response_contexts = fpgad_xfpga_fme_response_contexts;
 	}
 
+	objs = (fpgad_xfpga_objects *)opae_calloc(1,
+			sizeof(fpgad_xfpga_objects));
+	if (!objs) {
+		LOG("calloc failed, sysfs objects will not be cached\n");
+		return 0;
+	}
+
+	for (i = 0 ; d->detections[i] ; ++i) {
+		const char *sysfs_file;
+
+		if ((d->detections[i] == fpgad_xfpga_detect_AP1_or_AP2) ||
+		    (d->detections[i] == fpgad_xfpga_detect_PowerStateChange))
+			sysfs_file = ((fpgad_xfpga_AP_context *)
+				d->detection_contexts[i])->sysfs_file;
+		else
+			sysfs_file = ((fpgad_xfpga_Error_context *)
+				d->detection_contexts[i])->sysfs_file;
+
+		fpgad_xfpga_add_object(d, objs, sysfs_file);
+	}
+
+	d->plugin_context = objs;
+
+	if (d->config && d->config->event_driven)
+		fpgad_xfpga_add_watches(d, objs);
+
 	return 0;
 }
 
 void fpgad_plugin_destroy(fpgad_monitored_device *d)
 {
+	fpgad_xfpga_objects *objs =
+		(fpgad_xfpga_objects *)d->plugin_context;
+
 	LOG("stop monitoring vid=0x%04x did=0x%04x objid=0x%x (%s)\n",
 			d->supported->vendor_id,
 			d->supported->device_id,
 			d->object_id,
 			d->object_type == FPGA_ACCELERATOR ?
 			"accelerator" : "device");
+
+	if (objs) {
+		unsigned i;
+
+		for (i = 0 ; i < objs->num_objects ; ++i) {
+			if (objs->objects[i].obj)
+				fpgaDestroyObject(&objs->objects[i].obj);
+		}
+
+		opae_free(objs);
+		d->plugin_context = NULL;
+	}
 }
@@ -43,10 +43,13 @@
 #include <getopt.h>
 #include <stdint.h>
 #include <errno.h>
+#include <signal.h>
 #include <stdbool.h>
+#include <strings.h>
 #include <sys/stat.h>
 #include <argsfilter.h>
 #include "mock/opae_std.h"
+#include "sampler.h"
 
 
 /*
@@ -75,6 +78,15 @@ struct config {
 		bool afu_metrics;
 		int open_flags;
 	} target;
+	struct stream {
+		bool enabled;
+		double rate_hz;
+		uint64_t count;
+		uint64_t history;
+		const char *metrics;
+		const char *output;
+		bool binary;
+	} stream;
 }
 
 config = {
@@ -82,6 +94,15 @@ config = {
 		.fme_metrics = true,
 		.afu_metrics = false,
 		.open_flags = 0
+	},
+	.stream = {
+		.enabled = false,
+		.rate_hz = 10.0,
+		.count = 0,
+		.history = 4096,
+		.metrics = NULL,
+		.output = NULL,
+		.binary = false
 	}
 };
 
@@ -94,6 +115,7 @@ void FpgaMetricsAppShowHelp(void)
 	       "\n");
 	printf("Usage:\n");
 	printf("        fpgametrics [-h]  [-S <segment>] [-B <bus>] [-D <device>] [-F <function>] [PCI_ADDR]\n");
+	printf("                    [-r <hz> [-c <count>] [-m <metrics>] [-o <file>] [-b] [-H <samples>]]\n");
 	printf("\n");
 	printf("                -h,--help               Print this help\n");
 	printf("                -s,--shared             Open in shared mode\n");
@@ -101,9 +123,18 @@ void FpgaMetricsAppShowHelp(void)
 	printf("                -a,--afu-metrics        Display AFU metrics\n");
 	printf("                -v,--version            Display version info and exit\n");
 	printf("\n");
+	printf("        Streaming mode:\n");
+	printf("                -r,--rate <hz>          Sample continuously at <hz> samples per second\n");
+	printf("                -c,--count <n>          Stop after <n> samples (default: until Ctrl-C)\n");
+	printf("                -m,--metrics <list>     Comma-separated metric numbers or names to sample\n");
+	printf("                                        (default: all)\n");
+	printf("                -o,--output <file>      Write samples to <file> (default: stdout)\n");
+	printf("                -b,--binary             Write samples in binary instead of CSV\n");
+	printf("                -H,--history <n>        Ring buffer depth in samples (default: 4096)\n");
+	printf("\n");
 }
 
-#define GETOPT_STRING "hfasv"
+#define GETOPT_STRING "hfasvr:c:m:o:bH:"
 fpga_result parse_args(int argc, char *argv[])
 {
 	struct option longopts[] = {
@@ -112,11 +143,18 @@ fpga_result parse_args(int argc, char *argv[])
 		{ "afu-metrics", no_argument,       NULL, 'a' },
 		{ "shared",      no_argument,       NULL, 's' },
 		{ "version",     no_argument,       NULL, 'v' },
+		{ "rate",        required_argument, NULL, 'r' },
+		{ "count",       required_argument, NULL, 'c' },
+		{ "metrics",     required_argument, NULL, 'm' },
+		{ "output",      required_argument, NULL, 'o' },
+		{ "binary",      no_argument,       NULL, 'b' },
+		{ "history",     required_argument, NULL, 'H' },
 		{ NULL,          0,                 NULL,  0  },
 	};
 
 	int getopt_ret;
 	int option_index;
+	char *endptr;
 
 	while (-1 != (getopt_ret = getopt_long(argc, argv, GETOPT_STRING,
 						longopts, &option_index))) {
@@ -149,6 +187,50 @@ fpga_result parse_args(int argc, char *argv[])
 					OPAE_GIT_SRC_TREE_DIRTY ? "*":"");
 			return -2;
 
+		case 'r':
+			endptr = NULL;
+			config.stream.rate_hz = strtod(tmp_optarg, &endptr);
+			if (endptr == tmp_optarg || *endptr ||
+			    config.stream.rate_hz <= 0.0 ||
+			    config.stream.rate_hz > 1000000.0) {
+				fprintf(stderr, "Invalid rate: %s\n", tmp_optarg);
+				return FPGA_INVALID_PARAM;
+			}
+			config.stream.enabled = true;
+			break;
+
+		case 'c':
+			endptr = NULL;
+			config.stream.count = strtoull(tmp_optarg, &endptr, 0);
+			if (endptr == tmp_optarg || *endptr) {
+				fprintf(stderr, "Invalid count: %s\n", tmp_optarg);
+				return FPGA_INVALID_PARAM;
+			}
+			break;
+
+		case 'm':
+			config.stream.metrics = tmp_optarg;
+			break;
+
+		case 'o':
+			config.stream.output = tmp_optarg;
+			break;
+
+		case 'b':
+			config.stream.binary = true;
+			break;
+
+		case 'H':
+			endptr = NULL;
+			config.stream.history = strtoull(tmp_optarg, &endptr, 0);
+			if (endptr == tmp_optarg || *endptr ||
+			    !config.stream.history ||
+			    config.stream.history > (1ULL << 24)) {
+				fprintf(stderr, "Invalid history: %s\n", tmp_optarg);
+				return FPGA_INVALID_PARAM;
+			}
+			break;
+
 		default: /* invalid option */
 			fprintf(stderr, "Invalid cmdline option \n");
 			return FPGA_EXCEPTION;
@@ -158,6 +240,168 @@ fpga_result parse_args(int argc, char *argv[])
 	return FPGA_OK;
 }
 
+/*
+ * Translate a comma-separated list of metric numbers (as displayed,
+ * starting at 1) and/or metric names into metric indexes.
+ */
+fpga_result parse_metric_list(const char *list,
+			      const struct fpga_metric_info *metric_info,
+			      uint64_t num_metrics,
+			      uint64_t *ids,
+			      uint64_t *num_ids)
+{
+	char *copy;
+	char *tok;
+	char *saveptr = NULL;
+	fpga_result res = FPGA_OK;
+	uint64_t n = 0;
+	uint64_t i;
+
+	copy = opae_strdup(list);
+	if (!copy)
+		return FPGA_NO_MEMORY;
+
+	for (tok = strtok_r(copy, ",", &saveptr) ; tok ;
+	     tok = strtok_r(NULL, ",", &saveptr)) {
+		char *endptr = NULL;
+		uint64_t num = strtoull(tok, &endptr, 0);
+
+		if (n == num_metrics) {
+			fprintf(stderr, "Too many metrics: %s\n", list);
+			res = FPGA_INVALID_PARAM;
+			break;
+		}
+
+		if (endptr != tok && !*endptr) {
+			if (num < 1 || num > num_metrics) {
+				fprintf(stderr, "Invalid metric number: %s\n", tok);
+				res = FPGA_INVALID_PARAM;
+				break;
+			}
+			ids[n++] = num - 1;
+			continue;
+		}
+
+		for (i = 0 ; i < num_metrics ; ++i) {
+			if (!strcasecmp(tok, metric_info[i].metric_name) ||
+			    !strcasecmp(tok, metric_info[i].qualifier_name))
+				break;
+		}
+
+		if (i == num_metrics) {
+			fprintf(stderr, "Unknown metric: %s\n", tok);
+			res = FPGA_INVALID_PARAM;
+			break;
+		}
+
+		ids[n++] = i;
+	}
+
+	if (res == FPGA_OK && !n) {
+		fprintf(stderr, "No metrics given\n");
+		res = FPGA_INVALID_PARAM;
+	}
+
+	*num_ids = n;
+	opae_free(copy);
+	return res;
+}
+
+static volatile sig_atomic_t stream_interrupted;
+
+static void stream_sigint(int sig)
+{
+	(void)sig;
+	stream_interrupted = 1;
+}
+
+/*
+ * Sample the selected metrics on a dedicated thread until the requested
+ * number of samples has been taken or the user interrupts, writing the
+ * samples as they arrive and the statistics at the end.
+ */
+fpga_result stream_metrics(fpga_handle handle,
+			   const struct fpga_metric_info *metric_info,
+			   uint64_t num_metrics)
+{
+	metrics_sampler sampler;
+	sampler_format format = config.stream.binary ?
+		SAMPLER_FORMAT_BINARY : SAMPLER_FORMAT_CSV;
+	uint64_t *ids = NULL;
+	uint64_t num_ids = 0;
+	FILE *out = stdout;
+	FILE *report = stderr;
+	struct sigaction sa;
+	struct sigaction old_sa;
+	fpga_result res = FPGA_OK;
+	int err;
+
+	if (config.stream.metrics) {
+		ids = opae_calloc(num_metrics, sizeof(uint64_t));
+		if (!ids)
+			return FPGA_NO_MEMORY;
+
+		res = parse_metric_list(config.stream.metrics, metric_info,
+					num_metrics, ids, &num_ids);
+		if (res != FPGA_OK)
+			goto out_free;
+	}
+
+	err = sampler_init(&sampler, handle, metric_info, num_metrics,
+			   ids, num_ids, config.stream.rate_hz,
+			   config.stream.history, config.stream.count);
+	if (err) {
+		res = (err == 2) ? FPGA_NO_MEMORY : FPGA_INVALID_PARAM;
+		goto out_free;
+	}
+
+	if (config.stream.output) {
+		out = opae_fopen(config.stream.output,
+				 config.stream.binary ? "wb" : "w");
+		if (!out) {
+			fprintf(stderr, "Failed to open %s: %s\n",
+				config.stream.output, strerror(errno));
+			res = FPGA_EXCEPTION;
+			goto out_destroy;
+		}
+		report = stdout;
+	}
+
+	stream_interrupted = 0;
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = stream_sigint;
+	sigaction(SIGINT, &sa, &old_sa);
+
+	sampler_write_header(&sampler, out, format);
+
+	if (sampler_start(&sampler)) {
+		fprintf(stderr, "Failed to start the sampling thread\n");
+		res = FPGA_EXCEPTION;
+		goto out_restore;
+	}
+
+	while (!sampler_done(&sampler) && !stream_interrupted) {
+		usleep(50000);
+		sampler_drain(&sampler, out, format);
+	}
+
+	sampler_stop(&sampler);
+	sampler_drain(&sampler, out, format);
+	fflush(out);
+
+	sampler_print_stats(&sampler, report);
+
+out_restore:
+	sigaction(SIGINT, &old_sa, NULL);
+	if (out != stdout)
+		opae_fclose(out);
+out_destroy:
+	sampler_destroy(&sampler);
+out_free:
+	if (ids)
+		opae_free(ids);
+	return res;
+}
 
 int main(int argc, char *argv[])
 {
@@ -234,7 +478,8 @@ int main(int argc, char *argv[])
 
 	res = fpgaGetNumMetrics(fpga_handle, &num_metrics);
 	ON_ERR_GOTO(res, out_close, "get num of metrics");
-	printf("\n\n ------Number of Metrics Discovered = %ld ------- \n\n\n", num_metrics);
+	if (!config.stream.enabled)
+		printf("\n\n ------Number of Metrics Discovered = %ld ------- \n\n\n", num_metrics);
 
 	metric_info = opae_calloc(sizeof(struct fpga_metric_info), num_metrics);
 	if (metric_info == NULL) {
@@ -246,6 +491,12 @@ int main(int argc, char *argv[])
 	res = fpgaGetMetricsInfo(fpga_handle, metric_info, &num_metrics);
 	ON_ERR_GOTO(res, out_close, "get num of metrics info");
 
+	if (config.stream.enabled) {
+		res = stream_metrics(fpga_handle, metric_info, num_metrics);
+		ON_ERR_GOTO(res, out_close, "streaming metrics");
+		goto out_close;
+	}
+
 	id_array = opae_calloc(sizeof(uint64_t), num_metrics);
 	if (id_array == NULL) {
 		printf(" Failed to allocate memroy \n");
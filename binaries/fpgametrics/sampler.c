@@ -0,0 +1,483 @@
+// Copyright(c) 2024, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif // HAVE_CONFIG_H
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif // _GNU_SOURCE
+
+#include <errno.h>
+#include <inttypes.h>
+#include <math.h>
+#include <string.h>
+#include <time.h>
+
+#include "sampler.h"
+#include "mock/opae_std.h"
+
+static const double sampler_quantiles[SAMPLER_NUM_QUANTILES] = {
+	0.50, 0.95, 0.99
+};
+
+void p2_init(p2_quantile *q, double p)
+{
+	memset(q, 0, sizeof(*q));
+	q->p = p;
+
+	q->np[0] = 1.0;
+	q->np[1] = 1.0 + 2.0 * p;
+	q->np[2] = 1.0 + 4.0 * p;
+	q->np[3] = 3.0 + 2.0 * p;
+	q->np[4] = 5.0;
+
+	q->dn[0] = 0.0;
+	q->dn[1] = p / 2.0;
+	q->dn[2] = p;
+	q->dn[3] = (1.0 + p) / 2.0;
+	q->dn[4] = 1.0;
+}
+
+static double p2_parabolic(const p2_quantile *q, int i, double d)
+{
+	return q->q[i] + d / (q->n[i + 1] - q->n[i - 1]) *
+		((q->n[i] - q->n[i - 1] + d) * (q->q[i + 1] - q->q[i]) /
+			(q->n[i + 1] - q->n[i]) +
+		 (q->n[i + 1] - q->n[i] - d) * (q->q[i] - q->q[i - 1]) /
+			(q->n[i] - q->n[i - 1]));
+}
+
+static double p2_linear(const p2_quantile *q, int i, int d)
+{
+	return q->q[i] + d * (q->q[i + d] - q->q[i]) /
+		(q->n[i + d] - q->n[i]);
+}
+
+void p2_add(p2_quantile *q, double x)
+{
+	int i;
+	int k;
+
+	if (q->count < 5) {
+		// Warm-up: keep the first five observations sorted.
+		i = (int)q->count++;
+		while (i > 0 && q->q[i - 1] > x) {
+			q->q[i] = q->q[i - 1];
+			--i;
+		}
+		q->q[i] = x;
+		if (q->count == 5) {
+			for (i = 0 ; i < 5 ; ++i)
+				q->n[i] = i + 1;
+		}
+		return;
+	}
+
+	++q->count;
+
+	if (x < q->q[0]) {
+		q->q[0] = x;
+		k = 0;
+	} else if (x >= q->q[4]) {
+		q->q[4] = x;
+		k = 3;
+	} else {
+		for (k = 0 ; k < 3 ; ++k) {
+			if (x < q->q[k + 1])
+				break;
+		}
+	}
+
+	for (i = k + 1 ; i < 5 ; ++i)
+		q->n[i] += 1.0;
+
+	for (i = 0 ; i < 5 ; ++i)
+		q->np[i] += q->dn[i];
+
+	for (i = 1 ; i < 4 ; ++i) {
+		double d = q->np[i] - q->n[i];
+
+		if ((d >= 1.0 && q->n[i + 1] - q->n[i] > 1.0) ||
+		    (d <= -1.0 && q->n[i - 1] - q->n[i] < -1.0)) {
+			int ds = (d > 0.0) ? 1 : -1;
+			double qp = p2_parabolic(q, i, ds);
+
+			if (q->q[i - 1] < qp && qp < q->q[i + 1])
+				q->q[i] = qp;
+			else
+				q->q[i] = p2_linear(q, i, ds);
+			q->n[i] += ds;
+		}
+	}
+}
+
+double p2_value(const p2_quantile *q)
+{
+	if (!q->count)
+		return NAN;
+
+	if (q->count <= 5) {
+		// Exact, from the sorted warm-up observations.
+		uint64_t idx = (uint64_t)(q->p * (q->count - 1) + 0.5);
+		return q->q[idx];
+	}
+
+	return q->q[2];
+}
+
+static uint64_t sampler_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+int sampler_init(metrics_sampler *s,
+		 fpga_handle handle,
+		 const fpga_metric_info *info,
+		 uint64_t num_info,
+		 const uint64_t *ids,
+		 uint64_t num_ids,
+		 double rate_hz,
+		 uint64_t depth,
+		 uint64_t max_samples)
+{
+	uint64_t i;
+	int j;
+
+	if (!s || !handle || !info || !num_info ||
+	    rate_hz <= 0.0 || rate_hz > 1000000.0)
+		return 1;
+
+	memset(s, 0, sizeof(*s));
+
+	if (!ids) {
+		num_ids = num_info;
+		s->all = true;
+	} else if (!num_ids) {
+		return 1;
+	}
+
+	s->handle = handle;
+	s->info = info;
+	s->num_ids = num_ids;
+	s->period_ns = (uint64_t)(1000000000.0 / rate_hz);
+	if (!s->period_ns)
+		s->period_ns = 1;
+	s->max_samples = max_samples;
+
+	s->depth = 64;
+	while (s->depth < depth)
+		s->depth <<= 1;
+
+	s->ids = opae_calloc(num_ids, sizeof(uint64_t));
+	s->scratch = opae_calloc(num_ids, sizeof(fpga_metric));
+	s->timestamps = opae_calloc(s->depth, sizeof(uint64_t));
+	s->values = opae_calloc(s->depth * num_ids, sizeof(double));
+	s->stats = opae_calloc(num_ids, sizeof(sampler_stats));
+
+	if (!s->ids || !s->scratch || !s->timestamps ||
+	    !s->values || !s->stats) {
+		sampler_destroy(s);
+		return 2;
+	}
+
+	for (i = 0 ; i < num_ids ; ++i) {
+		s->ids[i] = ids ? ids[i] : i;
+		if (s->ids[i] >= num_info) {
+			sampler_destroy(s);
+			return 1;
+		}
+
+		s->stats[i].min = INFINITY;
+		s->stats[i].max = -INFINITY;
+		for (j = 0 ; j < SAMPLER_NUM_QUANTILES ; ++j)
+			p2_init(&s->stats[i].quantiles[j],
+				sampler_quantiles[j]);
+	}
+
+	return 0;
+}
+
+void sampler_destroy(metrics_sampler *s)
+{
+	if (!s)
+		return;
+
+	sampler_stop(s);
+
+	opae_free(s->ids);
+	opae_free(s->scratch);
+	opae_free(s->timestamps);
+	opae_free(s->values);
+	opae_free(s->stats);
+
+	s->ids = NULL;
+	s->scratch = NULL;
+	s->timestamps = NULL;
+	s->values = NULL;
+	s->stats = NULL;
+}
+
+static double sampler_value(metrics_sampler *s, uint64_t i)
+{
+	const fpga_metric *m = &s->scratch[i];
+
+	if (!m->isvalid)
+		return NAN;
+
+	switch (s->info[s->ids[i]].metric_datatype) {
+	case FPGA_METRIC_DATATYPE_DOUBLE:
+		return m->value.dvalue;
+	case FPGA_METRIC_DATATYPE_FLOAT:
+		return (double)m->value.fvalue;
+	case FPGA_METRIC_DATATYPE_BOOL:
+		return m->value.bvalue ? 1.0 : 0.0;
+	default:
+		return (double)m->value.ivalue;
+	}
+}
+
+void sampler_sample(metrics_sampler *s, uint64_t timestamp_ns)
+{
+	fpga_result res = FPGA_NOT_SUPPORTED;
+	uint64_t head = s->head;
+	uint64_t tail = __atomic_load_n(&s->tail, __ATOMIC_ACQUIRE);
+	double *slot = NULL;
+	uint64_t i;
+	int j;
+
+	for (i = 0 ; i < s->num_ids ; ++i)
+		s->scratch[i].isvalid = false;
+
+	if (s->all) {
+		uint64_t n = s->num_ids;
+
+		res = fpgaGetMetricsAll(s->handle, s->scratch, &n);
+		if (res == FPGA_NOT_SUPPORTED)
+			s->all = false; // older plugin: read by index
+	}
+
+	if (!s->all)
+		res = fpgaGetMetricsByIndex(s->handle, s->ids,
+					    s->num_ids, s->scratch);
+
+	if (res != FPGA_OK)
+		++s->read_errors;
+
+	if (head - tail < s->depth) {
+		s->timestamps[head & (s->depth - 1)] = timestamp_ns;
+		slot = &s->values[(head & (s->depth - 1)) * s->num_ids];
+	} else {
+		++s->overruns;
+	}
+
+	for (i = 0 ; i < s->num_ids ; ++i) {
+		sampler_stats *st = &s->stats[i];
+		double v = sampler_value(s, i);
+
+		if (slot)
+			slot[i] = v;
+
+		if (isnan(v))
+			continue;
+
+		++st->count;
+		st->sum += v;
+		if (v < st->min)
+			st->min = v;
+		if (v > st->max)
+			st->max = v;
+		for (j = 0 ; j < SAMPLER_NUM_QUANTILES ; ++j)
+			p2_add(&st->quantiles[j], v);
+	}
+
+	if (slot)
+		__atomic_store_n(&s->head, head + 1, __ATOMIC_RELEASE);
+
+	++s->taken;
+}
+
+static void *sampler_thread(void *arg)
+{
+	metrics_sampler *s = (metrics_sampler *)arg;
+	uint64_t next = s->start_ns;
+	struct timespec ts;
+
+	while (!__atomic_load_n(&s->stop, __ATOMIC_ACQUIRE)) {
+		uint64_t now;
+
+		sampler_sample(s, next - s->start_ns);
+
+		if (s->max_samples && s->taken >= s->max_samples)
+			break;
+
+		next += s->period_ns;
+		now = sampler_now_ns();
+		if (now >= next) {
+			// Overran the period: skip the missed ticks rather
+			// than bunching samples together to catch up.
+			uint64_t missed = (now - next) / s->period_ns + 1;
+
+			s->late += missed;
+			next += missed * s->period_ns;
+		}
+
+		ts.tv_sec = (time_t)(next / 1000000000ULL);
+		ts.tv_nsec = (long)(next % 1000000000ULL);
+		while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME,
+				       &ts, NULL) == EINTR)
+			;
+	}
+
+	__atomic_store_n(&s->done, true, __ATOMIC_RELEASE);
+	return NULL;
+}
+
+int sampler_start(metrics_sampler *s)
+{
+	if (s->running)
+		return 1;
+
+	s->stop = false;
+	s->done = false;
+	s->start_ns = sampler_now_ns();
+
+	if (pthread_create(&s->thread, NULL, sampler_thread, s))
+		return 2;
+
+	s->running = true;
+	return 0;
+}
+
+void sampler_stop(metrics_sampler *s)
+{
+	if (!s->running)
+		return;
+
+	__atomic_store_n(&s->stop, true, __ATOMIC_RELEASE);
+	pthread_join(s->thread, NULL);
+	s->running = false;
+}
+
+bool sampler_done(metrics_sampler *s)
+{
+	return __atomic_load_n(&s->done, __ATOMIC_ACQUIRE);
+}
+
+void sampler_write_header(metrics_sampler *s, FILE *fp,
+			  sampler_format format)
+{
+	uint64_t i;
+
+	if (format == SAMPLER_FORMAT_BINARY) {
+		sampler_bin_header hdr = {
+			.magic = SAMPLER_BIN_MAGIC,
+			.version = SAMPLER_BIN_VERSION,
+			.num_metrics = (uint32_t)s->num_ids,
+			.reserved = 0,
+			.period_ns = s->period_ns
+		};
+
+		fwrite(&hdr, sizeof(hdr), 1, fp);
+		fwrite(s->ids, sizeof(uint64_t), s->num_ids, fp);
+		return;
+	}
+
+	fprintf(fp, "timestamp_ns");
+	for (i = 0 ; i < s->num_ids ; ++i)
+		fprintf(fp, ",%s", s->info[s->ids[i]].qualifier_name);
+	fprintf(fp, "\n");
+}
+
+uint64_t sampler_drain(metrics_sampler *s, FILE *fp,
+		       sampler_format format)
+{
+	uint64_t head = __atomic_load_n(&s->head, __ATOMIC_ACQUIRE);
+	uint64_t tail = s->tail;
+	uint64_t written = head - tail;
+	uint64_t i;
+
+	for ( ; tail != head ; ++tail) {
+		uint64_t idx = tail & (s->depth - 1);
+		const double *slot = &s->values[idx * s->num_ids];
+
+		if (format == SAMPLER_FORMAT_BINARY) {
+			fwrite(&s->timestamps[idx], sizeof(uint64_t), 1, fp);
+			fwrite(slot, sizeof(double), s->num_ids, fp);
+			continue;
+		}
+
+		fprintf(fp, "%" PRIu64, s->timestamps[idx]);
+		for (i = 0 ; i < s->num_ids ; ++i) {
+			if (isnan(slot[i]))
+				fputc(',', fp);
+			else
+				fprintf(fp, ",%.3f", slot[i]);
+		}
+		fputc('\n', fp);
+	}
+
+	__atomic_store_n(&s->tail, tail, __ATOMIC_RELEASE);
+
+	return written;
+}
+
+void sampler_print_stats(metrics_sampler *s, FILE *fp)
+{
+	uint64_t i;
+
+	fprintf(fp, "%-50s | %8s | %12s | %12s | %12s | %12s | %12s | %12s\n",
+		"metric", "samples", "min", "max", "mean",
+		"p50", "p95", "p99");
+
+	for (i = 0 ; i < s->num_ids ; ++i) {
+		const sampler_stats *st = &s->stats[i];
+
+		if (!st->count) {
+			fprintf(fp, "%-50s | %8d | %12s | %12s | %12s | "
+				"%12s | %12s | %12s\n",
+				s->info[s->ids[i]].qualifier_name, 0,
+				"-", "-", "-", "-", "-", "-");
+			continue;
+		}
+
+		fprintf(fp, "%-50s | %8" PRIu64 " | %12.3f | %12.3f | %12.3f | "
+			"%12.3f | %12.3f | %12.3f\n",
+			s->info[s->ids[i]].qualifier_name,
+			st->count, st->min, st->max, st->sum / st->count,
+			p2_value(&st->quantiles[0]),
+			p2_value(&st->quantiles[1]),
+			p2_value(&st->quantiles[2]));
+	}
+
+	fprintf(fp, "%" PRIu64 " samples, %" PRIu64 " dropped (ring full), "
+		"%" PRIu64 " periods skipped, %" PRIu64 " read errors\n",
+		s->taken, s->overruns, s->late, s->read_errors);
+}
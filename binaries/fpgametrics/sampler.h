@@ -0,0 +1,183 @@
+// Copyright(c) 2024, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ * @file sampler.h
+ * @brief Streaming metrics sampler for fpgametrics.
+ *
+ * A dedicated thread reads a fixed set of metrics at a fixed rate and
+ * stores each sample in a preallocated single-producer/single-consumer
+ * ring. The main thread drains the ring to CSV or binary output. Running
+ * statistics (min, max, mean and P-square estimates of the 50th, 95th
+ * and 99th percentiles) are kept per metric by the sampling thread.
+ * Nothing is allocated once sampling has started.
+ */
+
+#ifndef __FPGAMETRICS_SAMPLER_H__
+#define __FPGAMETRICS_SAMPLER_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <opae/fpga.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SAMPLER_NUM_QUANTILES 3 // p50, p95, p99
+
+// P-square streaming quantile estimator (Jain & Chlamtac, 1985).
+typedef struct _p2_quantile {
+	double p;
+	uint64_t count;
+	double q[5];  // marker heights
+	double n[5];  // marker positions
+	double np[5]; // desired marker positions
+	double dn[5]; // desired position increments
+} p2_quantile;
+
+void p2_init(p2_quantile *q, double p);
+void p2_add(p2_quantile *q, double x);
+double p2_value(const p2_quantile *q);
+
+typedef struct _sampler_stats {
+	uint64_t count;
+	double min;
+	double max;
+	double sum;
+	p2_quantile quantiles[SAMPLER_NUM_QUANTILES];
+} sampler_stats;
+
+typedef enum _sampler_format {
+	SAMPLER_FORMAT_CSV = 0,
+	SAMPLER_FORMAT_BINARY
+} sampler_format;
+
+// Binary output: one sampler_bin_header, num_metrics uint64_t metric
+// numbers, then one record per sample: a uint64_t timestamp in ns
+// since the start of sampling followed by num_metrics doubles. Values
+// that could not be read are NaN. All fields are host-endian.
+#define SAMPLER_BIN_MAGIC   0x534d504f // "OPMS"
+#define SAMPLER_BIN_VERSION 1
+
+typedef struct _sampler_bin_header {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t num_metrics;
+	uint32_t reserved;
+	uint64_t period_ns;
+} sampler_bin_header;
+
+typedef struct _metrics_sampler {
+	fpga_handle handle;
+	const fpga_metric_info *info; // indexed by metric number
+	uint64_t *ids;                // metric numbers being sampled
+	uint64_t num_ids;
+	bool all;                     // ids is every metric, in order
+	fpga_metric *scratch;         // API output buffer
+	uint64_t period_ns;
+	uint64_t max_samples;         // 0: until sampler_stop()
+
+	// SPSC ring: the sampling thread advances head,
+	// sampler_drain() advances tail.
+	uint64_t depth;               // power of two
+	uint64_t head;
+	uint64_t tail;
+	uint64_t *timestamps;         // [depth]
+	double *values;               // [depth][num_ids]
+
+	// Owned by the sampling thread until it has been joined.
+	sampler_stats *stats;         // [num_ids]
+	uint64_t taken;
+	uint64_t overruns;            // samples dropped, ring full
+	uint64_t late;                // sample periods skipped
+	uint64_t read_errors;
+
+	uint64_t start_ns;
+	bool stop;
+	bool done;
+	bool running;
+	pthread_t thread;
+} metrics_sampler;
+
+/**
+ * Prepare a sampler. Allocates everything the sampler needs.
+ *
+ * @param[in] s           Sampler to initialize.
+ * @param[in] handle      Open handle to read the metrics from.
+ * @param[in] info        Metric info array of the handle, indexed by
+ *                        metric number. Must outlive the sampler.
+ * @param[in] num_info    Number of entries in info.
+ * @param[in] ids         Metric numbers to sample, or NULL for all.
+ * @param[in] num_ids     Number of entries in ids.
+ * @param[in] rate_hz     Samples per second.
+ * @param[in] depth       Minimum ring depth, in samples.
+ * @param[in] max_samples Samples to take, or 0 for no limit.
+ *
+ * @returns 0 on success, 1 on invalid parameters, 2 on allocation
+ * failure.
+ */
+int sampler_init(metrics_sampler *s,
+		 fpga_handle handle,
+		 const fpga_metric_info *info,
+		 uint64_t num_info,
+		 const uint64_t *ids,
+		 uint64_t num_ids,
+		 double rate_hz,
+		 uint64_t depth,
+		 uint64_t max_samples);
+
+void sampler_destroy(metrics_sampler *s);
+
+int sampler_start(metrics_sampler *s);
+
+// Stop the sampling thread (if running) and wait for it to exit.
+void sampler_stop(metrics_sampler *s);
+
+// True once max_samples have been taken.
+bool sampler_done(metrics_sampler *s);
+
+// Take one sample into the ring and the statistics.
+// Called by the sampling thread.
+void sampler_sample(metrics_sampler *s, uint64_t timestamp_ns);
+
+void sampler_write_header(metrics_sampler *s, FILE *fp,
+			  sampler_format format);
+
+// Write every sample in the ring to fp and release it.
+// Returns the number of samples written.
+uint64_t sampler_drain(metrics_sampler *s, FILE *fp,
+		       sampler_format format);
+
+void sampler_print_stats(metrics_sampler *s, FILE *fp);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // __FPGAMETRICS_SAMPLER_H__
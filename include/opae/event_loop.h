@@ -0,0 +1,191 @@
+// Copyright(c) 2024, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ * @file event_loop.h
+ * @brief Functions for servicing many `fpga_event_handle`s from one thread.
+ *
+ * An fpga_event_loop collects registered event handles from any plugin into
+ * a single OS wait set (an epoll instance on Linux). Waiting on the loop
+ * costs time proportional to the number of ready handles, not to the number
+ * of registered ones, so one thread can service interrupts and error events
+ * from many accelerators.
+ *
+ * Ready handles can either be returned to the caller in batches with
+ * fpgaEventLoopWait(), or handed to per-handle callbacks with
+ * fpgaEventLoopDispatch().
+ */
+
+#ifndef __FPGA_EVENT_LOOP_H__
+#define __FPGA_EVENT_LOOP_H__
+
+#include <opae/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Handle to an event loop object
+ *
+ * Created with fpgaCreateEventLoop() and destroyed with
+ * fpgaDestroyEventLoop().
+ */
+typedef void *fpga_event_loop;
+
+/** Event loop registration flags */
+enum fpga_event_loop_flags {
+	/** Read (and so clear) the event counter of a ready handle before
+	 * reporting it. The value read is reported in `count`. Without this
+	 * flag the caller must clear the event, or the handle is reported
+	 * again by the next wait. */
+	FPGA_EVENT_LOOP_CONSUME = (1u << 0)
+};
+
+/** A ready event handle, as returned by fpgaEventLoopWait() */
+typedef struct {
+	fpga_event_handle event_handle; /**< The ready event handle */
+	void *context;                  /**< As given to fpgaEventLoopAdd() */
+	uint64_t count;                 /**< Event count if consumed, else 0 */
+} fpga_event_loop_ready;
+
+/** Event loop callback, called by fpgaEventLoopDispatch()
+ *
+ * @param[in] event_handle The ready event handle.
+ * @param[in] count        Event count, if the handle was added with
+ *                         FPGA_EVENT_LOOP_CONSUME, otherwise 0.
+ * @param[in] context      As given to fpgaEventLoopAdd().
+ */
+typedef void (*fpga_event_loop_cb)(fpga_event_handle event_handle,
+				   uint64_t count,
+				   void *context);
+
+/**
+ * Create an event loop
+ *
+ * @param[out] loop  Pointer to event loop variable.
+ * @param[in]  flags Reserved, must be 0.
+ *
+ * @returns FPGA_OK on success. FPGA_INVALID_PARAM if `loop` is NULL or
+ * `flags` is non-zero. FPGA_NO_MEMORY if allocation fails. FPGA_EXCEPTION
+ * if the OS wait set cannot be created.
+ */
+fpga_result fpgaCreateEventLoop(fpga_event_loop *loop, int flags);
+
+/**
+ * Destroy an event loop
+ *
+ * Removes all event handles from the loop and frees it. The event handles
+ * themselves are not destroyed.
+ *
+ * @param[in] loop Pointer to the event loop to be destroyed.
+ *
+ * @returns FPGA_OK on success. FPGA_INVALID_PARAM if `loop` is invalid.
+ */
+fpga_result fpgaDestroyEventLoop(fpga_event_loop *loop);
+
+/**
+ * Add an event handle to an event loop
+ *
+ * The event handle must already have been registered with
+ * fpgaRegisterEvent(). It must be removed from the loop with
+ * fpgaEventLoopRemove() before it is unregistered or destroyed.
+ *
+ * @param[in] loop         Event loop.
+ * @param[in] event_handle Registered event handle.
+ * @param[in] cb           Callback for fpgaEventLoopDispatch(). May be
+ *                         NULL if the loop is serviced with
+ *                         fpgaEventLoopWait().
+ * @param[in] context      Passed back with each ready report.
+ * @param[in] flags        Bitwise OR of `fpga_event_loop_flags`.
+ *
+ * @returns FPGA_OK on success. FPGA_INVALID_PARAM if an argument is
+ * invalid or the event handle is not registered. FPGA_BUSY if the event
+ * handle is already in the loop. FPGA_NO_MEMORY if allocation fails.
+ * FPGA_EXCEPTION if the handle cannot be added to the OS wait set.
+ */
+fpga_result fpgaEventLoopAdd(fpga_event_loop loop,
+			     fpga_event_handle event_handle,
+			     fpga_event_loop_cb cb,
+			     void *context,
+			     int flags);
+
+/**
+ * Remove an event handle from an event loop
+ *
+ * May be called from within a callback, including for the handle being
+ * dispatched. Once removed, the handle is not reported again, even if it
+ * was part of a batch already being dispatched.
+ *
+ * @param[in] loop         Event loop.
+ * @param[in] event_handle Event handle previously added to `loop`.
+ *
+ * @returns FPGA_OK on success. FPGA_INVALID_PARAM if an argument is
+ * invalid. FPGA_NOT_FOUND if the handle is not in the loop.
+ */
+fpga_result fpgaEventLoopRemove(fpga_event_loop loop,
+				fpga_event_handle event_handle);
+
+/**
+ * Wait for ready event handles
+ *
+ * @param[in]  loop       Event loop.
+ * @param[out] ready      Array to receive up to `max_ready` ready handles.
+ * @param[in]  max_ready  Size of `ready`.
+ * @param[out] num_ready  Number of entries written to `ready`.
+ * @param[in]  timeout_ms Time to wait in milliseconds, 0 to poll, or -1 to
+ *                        wait indefinitely.
+ *
+ * @returns FPGA_OK on success, including when the timeout expires with no
+ * ready handles (`*num_ready` is 0). FPGA_INVALID_PARAM if an argument is
+ * invalid. FPGA_EXCEPTION if the OS wait fails.
+ */
+fpga_result fpgaEventLoopWait(fpga_event_loop loop,
+			      fpga_event_loop_ready *ready,
+			      uint32_t max_ready,
+			      uint32_t *num_ready,
+			      int timeout_ms);
+
+/**
+ * Wait for ready event handles and call their callbacks
+ *
+ * Ready handles that were added without a callback are skipped.
+ *
+ * @param[in]  loop           Event loop.
+ * @param[in]  timeout_ms     As for fpgaEventLoopWait().
+ * @param[out] num_dispatched Number of callbacks called. May be NULL.
+ *
+ * @returns FPGA_OK on success. FPGA_INVALID_PARAM if `loop` is invalid.
+ * FPGA_EXCEPTION if the OS wait fails.
+ */
+fpga_result fpgaEventLoopDispatch(fpga_event_loop loop,
+				  int timeout_ms,
+				  uint32_t *num_dispatched);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif // __cplusplus
+
+#endif // __FPGA_EVENT_LOOP_H__
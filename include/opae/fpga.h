@@ -42,6 +42,8 @@
 #include <opae/buffer.h>
 #include <opae/enum.h>
 #include <opae/event.h>
+#include <opae/event_loop.h>
+#include <opae/telemetry.h>
 #include <opae/manage.h>
 #include <opae/mmio.h>
 #include <opae/properties.h>
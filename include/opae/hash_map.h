@@ -54,9 +54,21 @@ extern "C" {
  * in situations where the key space is guaranteed to produce unique values,
  * for example a memory allocator. When the key space is guaranteed to be
  * unique, opae_hash_map_add() can implement a small performance improvement.
+ *
+ * OPAE_HASH_MAP_OPEN_ADDRESSING selects an open-addressing (Robin Hood)
+ * table in place of the array of lists. Keys and values are stored inline
+ * in a power-of-two slot array, so opae_hash_map_add() does not allocate
+ * per item, and the table doubles in size when it becomes 3/4 full. In
+ * this mode num_buckets is the initial capacity hint, and key_hash is
+ * called with the current slot count as its num_buckets parameter.
+ * Because the slot count is a power of two, a key_hash that mixes all of
+ * the key bits (such as opae_ptr_key_hash()) should be used. The slot
+ * array is private to the implementation and is reached through buckets,
+ * which must not be walked as lists in this mode.
  */
 typedef enum _opae_hash_map_flags {
-	OPAE_HASH_MAP_UNIQUE_KEYSPACE = (1u << 0)
+	OPAE_HASH_MAP_UNIQUE_KEYSPACE = (1u << 0),
+	OPAE_HASH_MAP_OPEN_ADDRESSING = (1u << 1)
 } opae_hash_map_flags;
 
 /**
@@ -150,8 +162,9 @@ fpga_result opae_hash_map_init(opae_hash_map *hm,
  * @param[in]      key   The hash map key.
  * @param[in]      value The hash map value.
  * @returns FPGA_OK on success, FPGA_INVALID_PARAM if hm is NULL, FPGA_NO_MEMORY
- *          if malloc() fails when allocating the list item, or FPGA_INVALID_PARAM
- *          if the key hash produced by key_hash is out of bounds.
+ *          if malloc() fails when allocating the list item (or when growing
+ *          the slot array), or FPGA_INVALID_PARAM if the key hash produced
+ *          by key_hash is out of bounds.
  */
 fpga_result opae_hash_map_add(opae_hash_map *hm,
 			      void *key,
@@ -220,6 +233,17 @@ uint32_t opae_u64_key_hash(uint32_t num_buckets,
 			   uint32_t hash_seed,
 			   void *key);
 
+/**
+ * Convenience hash function for pointer keys.
+ *
+ * Mixes all of the key bits (and hash_seed) before reducing the result
+ * to the range [0, num_buckets), so that aligned pointers and addresses
+ * spread evenly over any number of buckets, including powers of two.
+ */
+uint32_t opae_ptr_key_hash(uint32_t num_buckets,
+			   uint32_t hash_seed,
+			   void *key);
+
 /**
  * Convenience key comparison function for 64-bit values.
  *
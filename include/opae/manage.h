@@ -140,6 +140,34 @@ fpga_result fpgaReconfigureSlot(fpga_handle fpga,
 				const uint8_t *bitstream,
 				size_t bitstream_len, int flags);
 
+/**
+ * Reconfigure a slot from a file descriptor
+ *
+ * Same as fpgaReconfigureSlot(), but reads the green bitstream from `fd`,
+ * starting at its current offset, instead of from a caller-provided buffer.
+ * `fd` may refer to a regular file or to a pipe.
+ *
+ * A regular file is mapped rather than read, so the caller never holds a
+ * copy of the bitstream. Otherwise the bitstream header and metadata are read
+ * and validated first, and an invalid or incompatible bitstream is rejected
+ * before the AFU logic is read. The AFU logic is then read in fixed-size
+ * chunks. The driver still requires the complete AFU logic in memory when
+ * reconfiguration starts.
+ *
+ * @param[in]  fpga           Handle to an FPGA object previously opened
+ * @param[in]  slot           Token identifying the slot to reconfigure
+ * @param[in]  fd             File descriptor to read the bitstream from
+ * @param[in]  flags          Flags that control behavior of reconfiguration,
+ *                            as for fpgaReconfigureSlot().
+ * @returns FPGA_OK on success. FPGA_INVALID_PARAM if the provided parameters
+ * or the bitstream are not valid. FPGA_NO_MEMORY if the bitstream could not be
+ * buffered. FPGA_NOT_SUPPORTED if the plugin for `fpga` does not implement
+ * this function. Otherwise, the same results as fpgaReconfigureSlot().
+ */
+fpga_result fpgaReconfigureSlotByFd(fpga_handle fpga,
+				    uint32_t slot,
+				    int fd, int flags);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif // __cplusplus
@@ -52,6 +52,17 @@ struct mem_alloc {
 	struct mem_link allocated;
 };
 
+/** Flags for mem_alloc_init_ex().
+ */
+enum mem_alloc_flags {
+	/** Index free and allocated blocks in balanced trees so that
+	 * mem_alloc_get(), mem_alloc_put() and mem_alloc_add_free() are
+	 * O(log n) in the number of blocks, and draw the bookkeeping
+	 * nodes from slabs owned by the allocator.
+	 */
+	MEM_ALLOC_INDEXED = (1u << 0)
+};
+
 #ifdef __cplusplus
 extern "C" {
 #endif // __cplusplus
@@ -67,10 +78,35 @@ extern "C" {
  */
 void mem_alloc_init(struct mem_alloc *m);
 
+/**
+ * Initialize a memory allocator object (extended w/ flags)
+ *
+ * Like mem_alloc_init(), but allows choosing the allocator engine.
+ * The allocation policy is the same for every engine: the
+ * lowest-addressed free block that can hold a size-aligned
+ * allocation is used.
+ *
+ * @param[out] m     The address of the memory allocator to initialize.
+ * @param[in]  flags See mem_alloc_flags.
+ * @returns Non-zero on error. Zero on success.
+ *
+ * Example
+ * @code{.c}
+ * struct mem_alloc m;
+ *
+ * if (mem_alloc_init_ex(&m, MEM_ALLOC_INDEXED)) {
+ *   // handle error
+ * }
+ * @endcode
+ */
+int mem_alloc_init_ex(struct mem_alloc *m, int flags);
+
 /**
  * Destroy a memory allocator object
  *
- * Frees all of the allocator's internal resources.
+ * Frees all of the allocator's internal resources. An allocator
+ * created with mem_alloc_init_ex() must be initialized again before
+ * re-use if the same engine is desired.
  *
  * @param[in] m The address of the memory allocator to destroy.
  */
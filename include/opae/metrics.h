@@ -111,6 +111,29 @@ fpga_result fpgaGetMetricsByName(fpga_handle handle,
 				uint64_t num_metric_names,
 				fpga_metric *metrics);
 
+/**
+ * Retrieve the values of all metrics
+ *
+ * Refreshes every metric of the resource in a single pass. Equivalent
+ * to fpgaGetMetricsByIndex() with the indexes 0 through num_metrics - 1,
+ * without the per-index lookup.
+ *
+ * @param[in] handle Handle to previously opened fpga resource
+ * @param[out] metrics Pointer to array of metric struct
+ * user allocates metrics array
+ * @param[inout] num_metrics On input, the size of the metrics array.
+ * On output, the number of entries written, which is at most the value
+ * returned by fpgaGetNumMetrics(). Entries whose value could not be read
+ * have isvalid set to false.
+ *
+ * @returns FPGA_OK on success. FPGA_NOT_FOUND if the Metrics are not
+ * found, or no metric value could be read.
+ *
+ */
+fpga_result fpgaGetMetricsAll(fpga_handle handle,
+				fpga_metric *metrics,
+				uint64_t *num_metrics);
+
 
 /**
  * Retrieve metrics / sendor threshold information and values
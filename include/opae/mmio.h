@@ -138,6 +138,62 @@ fpga_result fpgaWriteMMIO512(fpga_handle handle,
 			    uint32_t mmio_num, uint64_t offset,
 			    const void *value);
 
+/**
+ * Read a batch of values from MMIO space
+ *
+ * This function performs each read described by `ops` against MMIO space
+ * `mmio_num` of the target object, storing the result in the `value` field
+ * of the corresponding descriptor. The handle is validated, and the
+ * underlying resource locked, once for the whole batch rather than once
+ * per register. Each register is still read with its own access.
+ *
+ * All descriptors are checked before any access is made. If any descriptor
+ * has an unsupported width, a misaligned offset, or an offset outside of
+ * the MMIO space, no registers are read. For plugins without native batch
+ * support, an offset outside of the MMIO space is only detected when that
+ * access is reached.
+ *
+ * @param[in]    handle   Handle to previously opened accelerator resource
+ * @param[in]    mmio_num Number of MMIO space to access
+ * @param[inout] ops      Array of `num_ops` access descriptors. On
+ *                        success, each `value` holds the value read.
+ * @param[in]    num_ops  Number of descriptors in `ops`
+ * @returns FPGA_OK on success. FPGA_INVALID_PARAM if any of the supplied
+ * parameters is invalid. FPGA_EXCEPTION if an internal exception occurred
+ * while trying to access the handle.
+ */
+fpga_result fpgaReadMMIOBatch(fpga_handle handle,
+			      uint32_t mmio_num,
+			      fpga_mmio_op *ops,
+			      uint32_t num_ops);
+
+/**
+ * Write a batch of values to MMIO space
+ *
+ * This function performs each write described by `ops` against MMIO space
+ * `mmio_num` of the target object, in array order. The handle is validated,
+ * and the underlying resource locked, once for the whole batch rather than
+ * once per register. Each register is still written with its own access.
+ *
+ * All descriptors are checked before any access is made. If any descriptor
+ * has an unsupported width, a misaligned offset, or an offset outside of
+ * the MMIO space, no registers are written. For plugins without native
+ * batch support, an offset outside of the MMIO space is only detected when
+ * that access is reached, after the preceding writes were made.
+ *
+ * @param[in]  handle   Handle to previously opened accelerator resource
+ * @param[in]  mmio_num Number of MMIO space to access
+ * @param[in]  ops      Array of `num_ops` access descriptors
+ * @param[in]  num_ops  Number of descriptors in `ops`
+ * @returns FPGA_OK on success. FPGA_INVALID_PARAM if any of the supplied
+ * parameters is invalid. FPGA_EXCEPTION if an internal exception occurred
+ * while trying to access the handle.
+ */
+fpga_result fpgaWriteMMIOBatch(fpga_handle handle,
+			       uint32_t mmio_num,
+			       const fpga_mmio_op *ops,
+			       uint32_t num_ops);
+
 /**
  * Map MMIO space
  *
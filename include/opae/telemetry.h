@@ -0,0 +1,155 @@
+// Copyright(c) 2024, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+/**
+ * @file telemetry.h
+ * @brief Functions for reading the sensor snapshot published by fpgad.
+ *
+ * When fpgad monitors the sensors of an FPGA device, it publishes the
+ * latest value, threshold state and sample time of each sensor into a
+ * shared memory segment after every poll. Any number of processes may
+ * map the segment and read the whole sensor table from it.
+ *
+ * Reading a snapshot makes no system calls and never touches the sensor
+ * hardware (or the BMC behind it): the data is copied out of the shared
+ * segment under a sequence lock and is retried when fpgad was updating
+ * the segment at the same time.
+ */
+
+#ifndef __FPGA_TELEMETRY_H__
+#define __FPGA_TELEMETRY_H__
+
+#include <opae/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Maximum number of sensors in a telemetry snapshot */
+#define FPGA_TELEMETRY_MAX_SENSORS 128
+
+/** Maximum length of a sensor name, including the terminator */
+#define FPGA_TELEMETRY_NAME_LEN 32
+
+/** Maximum length of a sensor type, including the terminator */
+#define FPGA_TELEMETRY_TYPE_LEN 16
+
+/** Telemetry sensor flags */
+enum fpga_telemetry_sensor_flags {
+	/** `high_fatal` is valid */
+	FPGA_TELEMETRY_HIGH_FATAL_VALID = (1u << 0),
+	/** `high_warn` is valid */
+	FPGA_TELEMETRY_HIGH_WARN_VALID  = (1u << 1),
+	/** `low_fatal` is valid */
+	FPGA_TELEMETRY_LOW_FATAL_VALID  = (1u << 2),
+	/** `low_warn` is valid */
+	FPGA_TELEMETRY_LOW_WARN_VALID   = (1u << 3),
+	/** `value` is past a warning threshold */
+	FPGA_TELEMETRY_TRIPPED          = (1u << 4),
+	/** The sensor is no longer monitored; `value` is the last
+	 * value read before it was dropped. */
+	FPGA_TELEMETRY_IGNORED          = (1u << 5)
+};
+
+/** One sensor in a telemetry snapshot */
+typedef struct {
+	char name[FPGA_TELEMETRY_NAME_LEN]; /**< Sensor name */
+	char type[FPGA_TELEMETRY_TYPE_LEN]; /**< Sensor type, eg "Temperature" */
+	uint64_t value;        /**< Last value read, in sysfs units */
+	uint64_t high_fatal;   /**< High fatal threshold */
+	uint64_t high_warn;    /**< High warning threshold */
+	uint64_t low_fatal;    /**< Low fatal threshold */
+	uint64_t low_warn;     /**< Low warning threshold */
+	uint32_t flags;        /**< Bitwise OR of fpga_telemetry_sensor_flags */
+	uint32_t reserved;
+	uint64_t timestamp_ns; /**< CLOCK_MONOTONIC time `value` was read */
+} fpga_telemetry_sensor;
+
+/** A consistent copy of the published sensor table */
+typedef struct {
+	uint64_t timestamp_ns; /**< CLOCK_MONOTONIC time of the last poll */
+	uint64_t sequence;     /**< Incremented by each publish */
+	uint32_t num_sensors;  /**< Number of valid entries in `sensors` */
+	uint32_t reserved;
+	fpga_telemetry_sensor sensors[FPGA_TELEMETRY_MAX_SENSORS];
+} fpga_telemetry_snapshot;
+
+/** Handle to a mapped telemetry segment
+ *
+ * Created with fpgaTelemetryOpen() and released with fpgaTelemetryClose().
+ */
+typedef void *fpga_telemetry;
+
+/**
+ * Map the telemetry segment of an FPGA device
+ *
+ * The segment is identified by the PCIe address of `token`, so either
+ * the FPGA_DEVICE token or a physical function accelerator token of the
+ * device may be given.
+ *
+ * @param[in]  token     Token of the device.
+ * @param[out] telemetry Receives the telemetry handle.
+ *
+ * @returns FPGA_OK on success. FPGA_INVALID_PARAM if an argument is
+ * NULL or the token has no PCIe address. FPGA_NOT_FOUND if fpgad is not
+ * publishing telemetry for the device. FPGA_NOT_SUPPORTED if the segment
+ * was published with an incompatible layout. FPGA_NO_MEMORY if
+ * allocation fails. FPGA_EXCEPTION if the segment cannot be mapped.
+ */
+fpga_result fpgaTelemetryOpen(fpga_token token, fpga_telemetry *telemetry);
+
+/**
+ * Unmap a telemetry segment
+ *
+ * @param[in] telemetry Pointer to the handle to be released.
+ *
+ * @returns FPGA_OK on success. FPGA_INVALID_PARAM if `telemetry` is
+ * invalid.
+ */
+fpga_result fpgaTelemetryClose(fpga_telemetry *telemetry);
+
+/**
+ * Copy the latest sensor snapshot
+ *
+ * Makes no system calls. Only the first `num_sensors` entries of
+ * `snapshot->sensors` are written.
+ *
+ * @param[in]  telemetry Telemetry handle.
+ * @param[out] snapshot  Receives the snapshot.
+ *
+ * @returns FPGA_OK on success. FPGA_INVALID_PARAM if an argument is
+ * invalid. FPGA_NOT_FOUND if nothing has been published yet. FPGA_BUSY
+ * if no consistent copy could be taken because the segment was being
+ * updated on every attempt.
+ */
+fpga_result fpgaTelemetryRead(fpga_telemetry telemetry,
+			      fpga_telemetry_snapshot *snapshot);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif // __cplusplus
+
+#endif // __FPGA_TELEMETRY_H__
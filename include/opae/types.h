@@ -252,6 +252,17 @@ typedef struct metric_threshold {
 	threshold hysteresis;                          // Hysteresis
 } metric_threshold;
 
+/** MMIO batch descriptor
+ *
+ * Describes one register access within a batch passed to
+ * fpgaReadMMIOBatch() or fpgaWriteMMIOBatch().
+ */
+typedef struct fpga_mmio_op {
+	uint64_t offset;    // Byte offset into MMIO space
+	uint32_t width;     // Access width in bytes (4 or 8)
+	uint64_t value;     // Value to write, or value read (zero-extended)
+} fpga_mmio_op;
+
 /** Internal token type header
  *
  * Each plugin (dfl: libxfpga.so, vfio: libopae-v.so) implements its own
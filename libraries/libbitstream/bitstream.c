@@ -30,8 +30,11 @@
 
 #include <stdio.h>
 #include <errno.h>
+#include <string.h>
+#include <fcntl.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <unistd.h>
 
 #include <uuid/uuid.h>
@@ -110,6 +113,54 @@ out_close:
 	return res;
 }
 
+// Map the GBS file privately so that its contents are paged in by
+// the kernel rather than copied into a heap buffer. Returns
+// FPGA_NOT_SUPPORTED when the file can't be mapped (eg. it is not
+// a regular file), in which case the caller falls back to
+// opae_bitstream_read_file().
+STATIC fpga_result opae_bitstream_map_file(const char *file,
+					   uint8_t **buf,
+					   size_t *len)
+{
+	struct stat st;
+	void *addr;
+	int fd;
+
+	fd = opae_open(file, O_RDONLY);
+	if (fd < 0) {
+		OPAE_ERR("open failed");
+		return FPGA_EXCEPTION;
+	}
+
+	if (fstat(fd, &st) < 0) {
+		OPAE_ERR("fstat failed");
+		opae_close(fd);
+		return FPGA_EXCEPTION;
+	}
+
+	if (!S_ISREG(st.st_mode) || !st.st_size) {
+		opae_close(fd);
+		return FPGA_NOT_SUPPORTED;
+	}
+
+	addr = mmap(NULL, (size_t)st.st_size, PROT_READ,
+		    MAP_PRIVATE|MAP_POPULATE, fd, 0);
+	opae_close(fd);
+
+	if (addr == MAP_FAILED) {
+		OPAE_DBG("mmap failed: %s", strerror(errno));
+		return FPGA_NOT_SUPPORTED;
+	}
+
+	if (madvise(addr, (size_t)st.st_size, MADV_SEQUENTIAL))
+		OPAE_DBG("madvise failed: %s", strerror(errno));
+
+	*buf = (uint8_t *)addr;
+	*len = (size_t)st.st_size;
+
+	return FPGA_OK;
+}
+
 bool opae_is_legacy_bitstream(opae_bitstream_info *info)
 {
 	opae_legacy_bitstream_header *hdr;
@@ -269,7 +320,14 @@ fpga_result opae_load_bitstream(const char *file, opae_bitstream_info *info)
 
 	memset(info, 0, sizeof(opae_bitstream_info));
 
-	res = opae_bitstream_read_file(file, &info->data, &info->data_len);
+	res = opae_bitstream_map_file(file, &info->data, &info->data_len);
+	if (res == FPGA_OK)
+		info->data_mapped = true;
+	else if (res == FPGA_NOT_SUPPORTED)
+		res = opae_bitstream_read_file(file,
+					       &info->data,
+					       &info->data_len);
+
 	if (res != FPGA_OK) {
 		OPAE_ERR("error loading \"%s\"", file);
 		return res;
@@ -295,8 +353,12 @@ fpga_result opae_unload_bitstream(opae_bitstream_info *info)
 	if (!info)
 		return FPGA_INVALID_PARAM;
 
-	if (info->data)
-		opae_free(info->data);
+	if (info->data) {
+		if (info->data_mapped)
+			munmap(info->data, info->data_len);
+		else
+			opae_free(info->data);
+	}
 
 	if (info->parsed_metadata) {
 
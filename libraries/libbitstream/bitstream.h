@@ -86,10 +86,11 @@ typedef struct _opae_bitstream_info {
 	fpga_guid pr_interface_id;	/**< identifies GBS compatibility */
 	int metadata_version;		/**< identifies metadata format */
 	void *parsed_metadata;		/**< the expanded metadata */
+	bool data_mapped;		/**< data is mmap'd from the file */
 } opae_bitstream_info;
 
 #define OPAE_BITSTREAM_INFO_INITIALIZER \
-{ NULL, NULL, 0, NULL, 0, { 0, }, 0, NULL }
+{ NULL, NULL, 0, NULL, 0, { 0, }, 0, NULL, false }
 
 #ifdef __cplusplus
 extern "C" {
@@ -99,6 +100,9 @@ extern "C" {
  * Load a GBS file from disk into memory
  *
  * Used to validate and load a GBS file into its memory-resident format.
+ * Regular files are mapped read-only rather than read into a heap
+ * buffer. The metadata is copied to a NUL-terminated heap buffer
+ * for parsing, so the mapping is never written.
  *
  * @param[in] file Location of the GBS file on disk.
  * @param[out] info Storage for the loaded GBS file contents
@@ -120,7 +124,8 @@ bool opae_is_legacy_bitstream(opae_bitstream_info *info);
 /**
  * Unload a memory-resident GBS
  *
- * Used to free the resources allocated by `opae_load_bitstream`.
+ * Used to free (or unmap) the resources allocated by
+ * `opae_load_bitstream`.
  *
  * @param[in] info The loaded GBS info to be released.
  *
@@ -71,6 +71,14 @@ typedef struct _opae_api_adapter_table {
 	fpga_result (*fpgaWriteMMIO512)(fpga_handle handle, uint32_t mmio_num,
 				       uint64_t offset, const void *value);
 
+	fpga_result (*fpgaReadMMIOBatch)(fpga_handle handle, uint32_t mmio_num,
+					 fpga_mmio_op *ops, uint32_t num_ops);
+
+	fpga_result (*fpgaWriteMMIOBatch)(fpga_handle handle,
+					  uint32_t mmio_num,
+					  const fpga_mmio_op *ops,
+					  uint32_t num_ops);
+
 	fpga_result (*fpgaMapMMIO)(fpga_handle handle, uint32_t mmio_num,
 				   uint64_t **mmio_ptr);
 
@@ -174,6 +182,9 @@ typedef struct _opae_api_adapter_table {
 					   const uint8_t *bitstream,
 					   size_t bitstream_len, int flags);
 
+	fpga_result (*fpgaReconfigureSlotByFd)(fpga_handle fpga, uint32_t slot,
+					       int fd, int flags);
+
 	fpga_result (*fpgaTokenGetObject)(fpga_token token, const char *name,
 					  fpga_object *object, int flags);
 
@@ -229,6 +240,10 @@ typedef struct _opae_api_adapter_table {
 		metric_threshold *metric_thresholds,
 		uint32_t *num_thresholds);
 
+	fpga_result (*fpgaGetMetricsAll)(fpga_handle handle,
+					fpga_metric *metrics,
+					uint64_t *num_metrics);
+
 	// configuration functions
 	int (*initialize)(void);
 	int (*finalize)(void);
@@ -33,6 +33,7 @@
 #endif // _GNU_SOURCE
 
 #include <stdio.h>
+#include <stdlib.h>
 
 #include <opae/properties.h>
 #include <opae/types_enum.h>
@@ -41,6 +42,8 @@
 #include "opae_int.h"
 #include "props.h"
 #include "multi-port-afu.h"
+#include "enum-cache.h"
+#include "mmio-batch.h"
 #include "mock/opae_std.h"
 
 const char *
@@ -74,11 +77,170 @@ __OPAE_API__ fpgaErrStr(fpga_result e)
 	}
 }
 
-STATIC pthread_mutex_t token_list_lock = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
-STATIC opae_wrapped_token token_list_head = {
-	.prev = &token_list_head,
-	.next = &token_list_head,
+// Reference counts are atomic, so cloning and destroying tokens does
+// not take a lock. The only shared structure that every token joins
+// is the debug-only leak list; FPGA_DEVICE tokens additionally join
+// the parent index, which is sharded by PCIe address so that lookups
+// for unrelated devices do not contend.
+typedef struct _opae_token_shard {
+	pthread_mutex_t lock;
+	opae_wrapped_token head;
+} opae_token_shard;
+
+#define OPAE_TOKEN_SHARD_INITIALIZER(__s, __i) \
+	[__i] = { \
+		.lock = PTHREAD_MUTEX_INITIALIZER, \
+		.head = { \
+			.prev = &(__s)[__i].head, \
+			.next = &(__s)[__i].head, \
+			.leak_prev = &(__s)[__i].head, \
+			.leak_next = &(__s)[__i].head, \
+		}, \
+	}
+
+#define OPAE_TOKEN_SHARDS_INITIALIZER(__s)    \
+	OPAE_TOKEN_SHARD_INITIALIZER(__s, 0),  \
+	OPAE_TOKEN_SHARD_INITIALIZER(__s, 1),  \
+	OPAE_TOKEN_SHARD_INITIALIZER(__s, 2),  \
+	OPAE_TOKEN_SHARD_INITIALIZER(__s, 3),  \
+	OPAE_TOKEN_SHARD_INITIALIZER(__s, 4),  \
+	OPAE_TOKEN_SHARD_INITIALIZER(__s, 5),  \
+	OPAE_TOKEN_SHARD_INITIALIZER(__s, 6),  \
+	OPAE_TOKEN_SHARD_INITIALIZER(__s, 7),  \
+	OPAE_TOKEN_SHARD_INITIALIZER(__s, 8),  \
+	OPAE_TOKEN_SHARD_INITIALIZER(__s, 9),  \
+	OPAE_TOKEN_SHARD_INITIALIZER(__s, 10), \
+	OPAE_TOKEN_SHARD_INITIALIZER(__s, 11), \
+	OPAE_TOKEN_SHARD_INITIALIZER(__s, 12), \
+	OPAE_TOKEN_SHARD_INITIALIZER(__s, 13), \
+	OPAE_TOKEN_SHARD_INITIALIZER(__s, 14), \
+	OPAE_TOKEN_SHARD_INITIALIZER(__s, 15)
+
+STATIC opae_token_shard token_index[OPAE_WRAPPED_TOKEN_SHARDS] = {
+	OPAE_TOKEN_SHARDS_INITIALIZER(token_index)
+};
+
+STATIC uint32_t opae_token_index_shard(const fpga_token_header *hdr)
+{
+	uint32_t key = ((uint32_t)hdr->segment << 16) |
+		       ((uint32_t)hdr->bus << 8) |
+		       hdr->device;
+
+	key ^= key >> 16;
+	key *= 0x45d9f3b;
+	key ^= key >> 16;
+
+	return key % OPAE_WRAPPED_TOKEN_SHARDS;
+}
+
+STATIC void opae_token_index_insert(opae_wrapped_token *wt)
+{
+	fpga_token_header *hdr = (fpga_token_header *)wt->opae_token;
+	opae_token_shard *s;
+	int res;
+
+	wt->prev = wt->next = NULL;
+	wt->shard = OPAE_WRAPPED_TOKEN_NOT_INDEXED;
+
+	if (!hdr || (hdr->objtype != FPGA_DEVICE))
+		return;
+
+	wt->shard = opae_token_index_shard(hdr);
+	s = &token_index[wt->shard];
+
+	opae_mutex_lock(res, &s->lock);
+	wt->prev = &s->head;
+	wt->next = s->head.next;
+	s->head.next->prev = wt;
+	s->head.next = wt;
+	opae_mutex_unlock(res, &s->lock);
+}
+
+STATIC void opae_token_index_remove(opae_wrapped_token *wt)
+{
+	opae_token_shard *s;
+	int res;
+
+	if (wt->shard == OPAE_WRAPPED_TOKEN_NOT_INDEXED)
+		return;
+
+	s = &token_index[wt->shard];
+
+	opae_mutex_lock(res, &s->lock);
+	wt->prev->next = wt->next;
+	wt->next->prev = wt->prev;
+	opae_mutex_unlock(res, &s->lock);
+}
+
+// Take a reference on wt only if it is still live. Used by lookups
+// that can race with the final opae_downref_wrapped_token().
+STATIC bool opae_try_upref_wrapped_token(opae_wrapped_token *wt)
+{
+	uint32_t count = __atomic_load_n(&wt->ref_count, __ATOMIC_ACQUIRE);
+
+	do {
+		if (!count)
+			return false;
+	} while (!__atomic_compare_exchange_n(&wt->ref_count, &count,
+					      count + 1, true,
+					      __ATOMIC_ACQ_REL,
+					      __ATOMIC_ACQUIRE));
+
+	return true;
+}
+
+#ifdef LIBOPAE_DEBUG
+STATIC opae_token_shard token_leaks[OPAE_WRAPPED_TOKEN_SHARDS] = {
+	OPAE_TOKEN_SHARDS_INITIALIZER(token_leaks)
 };
+STATIC uint32_t token_leak_next_shard;
+STATIC uint32_t token_leak_live;
+
+// Each thread records the tokens it allocates in its own shard.
+STATIC uint32_t opae_token_leak_shard(void)
+{
+	static __thread uint32_t shard = OPAE_WRAPPED_TOKEN_NOT_INDEXED;
+
+	if (shard == OPAE_WRAPPED_TOKEN_NOT_INDEXED)
+		shard = __atomic_fetch_add(&token_leak_next_shard, 1,
+					   __ATOMIC_RELAXED) %
+			OPAE_WRAPPED_TOKEN_SHARDS;
+
+	return shard;
+}
+
+STATIC void opae_token_leak_insert(opae_wrapped_token *wt)
+{
+	opae_token_shard *s;
+	int res;
+
+	wt->leak_shard = opae_token_leak_shard();
+	s = &token_leaks[wt->leak_shard];
+
+	opae_mutex_lock(res, &s->lock);
+	wt->leak_prev = &s->head;
+	wt->leak_next = s->head.leak_next;
+	s->head.leak_next->leak_prev = wt;
+	s->head.leak_next = wt;
+	opae_mutex_unlock(res, &s->lock);
+
+	__atomic_add_fetch(&token_leak_live, 1, __ATOMIC_RELAXED);
+}
+
+STATIC void opae_token_leak_remove(opae_wrapped_token *wt)
+{
+	opae_token_shard *s = &token_leaks[wt->leak_shard];
+	int res;
+
+	opae_mutex_lock(res, &s->lock);
+	wt->leak_prev->leak_next = wt->leak_next;
+	wt->leak_next->leak_prev = wt->leak_prev;
+	opae_mutex_unlock(res, &s->lock);
+
+	if (!__atomic_sub_fetch(&token_leak_live, 1, __ATOMIC_RELAXED))
+		OPAE_DBG("token ref count CLEAN HERE");
+}
+#endif // LIBOPAE_DEBUG
 
 opae_wrapped_token *
 opae_allocate_wrapped_token(fpga_token token,
@@ -90,11 +252,16 @@ opae_allocate_wrapped_token(fpga_token token,
 	if (wtok) {
 		wtok->magic = OPAE_WRAPPED_TOKEN_MAGIC;
 		wtok->opae_token = token;
-		wtok->ref_count = 0;
-		wtok->prev = wtok->next = NULL;
+		wtok->ref_count = 1;
 		wtok->adapter_table = (opae_api_adapter_table *)adapter;
+		wtok->leak_shard = OPAE_WRAPPED_TOKEN_NOT_INDEXED;
+		wtok->leak_prev = wtok->leak_next = NULL;
 
-		opae_upref_wrapped_token(wtok);
+		OPAE_DBG("token ref count begin %p", wtok);
+		opae_token_index_insert(wtok);
+#ifdef LIBOPAE_DEBUG
+		opae_token_leak_insert(wtok);
+#endif // LIBOPAE_DEBUG
 	}
 
 	return wtok;
@@ -102,63 +269,46 @@ opae_allocate_wrapped_token(fpga_token token,
 
 void opae_upref_wrapped_token(opae_wrapped_token *wt)
 {
-	int res;
+	uint32_t count;
 
-	opae_mutex_lock(res, &token_list_lock);
+	count = __atomic_add_fetch(&wt->ref_count, 1, __ATOMIC_RELAXED);
 
-	++wt->ref_count;
-	if (wt->ref_count == 1) {
-		OPAE_DBG("token ref count begin %p", wt);
-		wt->prev = &token_list_head;
-		wt->next = token_list_head.next;
-		token_list_head.next->prev = wt;
-		token_list_head.next = wt;
-	}
 #ifdef LIBOPAE_DEBUG
-	else {
-		OPAE_DBG("token ref count up %p, %u", wt, wt->ref_count);
-	}
+	OPAE_DBG("token ref count up %p, %u", wt, count);
+#else
+	UNUSED_PARAM(count);
 #endif // LIBOPAE_DEBUG
-
-	opae_mutex_unlock(res, &token_list_lock);
 }
 
 fpga_result opae_downref_wrapped_token(opae_wrapped_token *wt)
 {
-	int res;
 	fpga_result fres = FPGA_OK;
+	uint32_t count;
 
-	opae_mutex_lock(res, &token_list_lock);
-
-	--wt->ref_count;
-	if (wt->ref_count == 0) {
-		OPAE_DBG("token ref count end %p", wt);
-		wt->prev->next = wt->next;
-		wt->next->prev = wt->prev;
-		wt->magic = 0;
-
-		if (wt->adapter_table->fpgaDestroyToken)
-			fres = wt->adapter_table->fpgaDestroyToken(
-					&wt->opae_token);
-		else
-			fres = FPGA_NOT_SUPPORTED;
-
-		opae_free(wt);
-
+	count = __atomic_sub_fetch(&wt->ref_count, 1, __ATOMIC_ACQ_REL);
+	if (count) {
 #ifdef LIBOPAE_DEBUG
-		if ((token_list_head.prev == &token_list_head) &&
-		    (token_list_head.next == &token_list_head)) {
-			OPAE_DBG("token ref count CLEAN HERE");
-		}
+		OPAE_DBG("token ref count down %p, %u", wt, count);
 #endif // LIBOPAE_DEBUG
+		return FPGA_OK;
 	}
+
+	OPAE_DBG("token ref count end %p", wt);
+
+	opae_token_index_remove(wt);
 #ifdef LIBOPAE_DEBUG
-	else {
-		OPAE_DBG("token ref count down %p, %u", wt, wt->ref_count);
-	}
+	opae_token_leak_remove(wt);
 #endif // LIBOPAE_DEBUG
 
-	opae_mutex_unlock(res, &token_list_lock);
+	wt->magic = 0;
+
+	if (wt->adapter_table->fpgaDestroyToken)
+		fres = wt->adapter_table->fpgaDestroyToken(&wt->opae_token);
+	else
+		fres = FPGA_NOT_SUPPORTED;
+
+	opae_free(wt);
+
 	return fres;
 }
 
@@ -167,19 +317,26 @@ uint32_t opae_wrapped_tokens_in_use(void)
 {
 	int res;
 	uint32_t count = 0;
+	uint32_t i;
 	opae_wrapped_token *wt;
 
-	opae_mutex_lock(res, &token_list_lock);
+	for (i = 0 ; i < OPAE_WRAPPED_TOKEN_SHARDS ; ++i) {
+		opae_token_shard *s = &token_leaks[i];
+
+		opae_mutex_lock(res, &s->lock);
+
+		for (wt = s->head.leak_next ;
+			wt != &s->head ;
+			    wt = wt->leak_next) {
+			++count;
+			OPAE_DBG("token ref count %p, %u LEAKED",
+				 wt, __atomic_load_n(&wt->ref_count,
+						     __ATOMIC_RELAXED));
+		}
 
-	for (wt = token_list_head.next ;
-		wt != &token_list_head ;
-		    wt = wt->next) {
-		++count;
-		OPAE_DBG("token ref count %p, %u LEAKED",
-			 wt, wt->ref_count);
+		opae_mutex_unlock(res, &s->lock);
 	}
 
-	opae_mutex_unlock(res, &token_list_lock);
 	return count;
 }
 #endif // LIBOPAE_DEBUG
@@ -407,26 +564,34 @@ opae_get_parent_token(opae_wrapped_token *child)
 	opae_wrapped_token *parent = NULL;
 	fpga_token_header *child_hdr;
 	fpga_token_header *parent_hdr;
+	opae_token_shard *s;
 
 	child_hdr = (fpga_token_header *)child->opae_token;
 
-	if (opae_mutex_lock(mres, &token_list_lock))
+	if (child_hdr->objtype != FPGA_ACCELERATOR)
 		return NULL;
 
-	for (p = token_list_head.next ;
-		p != &token_list_head ;
+	// A parent has the same segment, bus and device as its
+	// child, so it can only be in the child's shard.
+	s = &token_index[opae_token_index_shard(child_hdr)];
+
+	if (opae_mutex_lock(mres, &s->lock))
+		return NULL;
+
+	for (p = s->head.next ;
+		p != &s->head ;
 		    p = p->next) {
 
 		parent_hdr = (fpga_token_header *)p->opae_token;
 
-		if (fpga_is_parent_child(parent_hdr, child_hdr)) {
+		if (fpga_is_parent_child(parent_hdr, child_hdr) &&
+		    opae_try_upref_wrapped_token(p)) {
 			parent = p;
-			opae_upref_wrapped_token(parent);
 			break;
 		}
 	}
 
-	opae_mutex_unlock(mres, &token_list_lock);
+	opae_mutex_unlock(mres, &s->lock);
 
 	return parent;
 }
@@ -622,6 +787,118 @@ fpga_result __OPAE_API__ fpgaReadMMIO32(fpga_handle handle, uint32_t mmio_num,
 		wrapped_handle->opae_handle, mmio_num, offset, value);
 }
 
+fpga_result __OPAE_API__ fpgaReadMMIOBatch(fpga_handle handle,
+					   uint32_t mmio_num,
+					   fpga_mmio_op *ops,
+					   uint32_t num_ops)
+{
+	fpga_result res = FPGA_OK;
+	uint32_t i;
+	uint32_t value32 = 0;
+	opae_api_adapter_table *adapter;
+	opae_wrapped_handle *wrapped_handle =
+		opae_validate_wrapped_handle(handle);
+
+	ASSERT_NOT_NULL(wrapped_handle);
+	if (!num_ops)
+		return FPGA_OK;
+	ASSERT_NOT_NULL(ops);
+
+	adapter = wrapped_handle->adapter_table;
+
+	if (adapter->fpgaReadMMIOBatch)
+		return adapter->fpgaReadMMIOBatch(wrapped_handle->opae_handle,
+						  mmio_num, ops, num_ops);
+
+	// The plugin has no native batch support: issue the accesses
+	// one at a time, stopping at the first failure. Check the widths
+	// and alignment of the whole batch first, so that a bad descriptor
+	// fails it before any access; the plugin checks the bounds.
+	res = opae_mmio_batch_check(ops, num_ops, UINT64_MAX);
+	if (res != FPGA_OK) {
+		OPAE_ERR("invalid MMIO batch descriptor");
+		return res;
+	}
+
+	for (i = 0; i < num_ops; ++i) {
+		if (ops[i].width == sizeof(uint64_t)) {
+			ASSERT_NOT_NULL_RESULT(adapter->fpgaReadMMIO64,
+					       FPGA_NOT_SUPPORTED);
+			res = adapter->fpgaReadMMIO64(
+				wrapped_handle->opae_handle, mmio_num,
+				ops[i].offset, &ops[i].value);
+		} else if (ops[i].width == sizeof(uint32_t)) {
+			ASSERT_NOT_NULL_RESULT(adapter->fpgaReadMMIO32,
+					       FPGA_NOT_SUPPORTED);
+			res = adapter->fpgaReadMMIO32(
+				wrapped_handle->opae_handle, mmio_num,
+				ops[i].offset, &value32);
+			ops[i].value = value32;
+		} else {
+			OPAE_ERR("invalid MMIO width %u", ops[i].width);
+			res = FPGA_INVALID_PARAM;
+		}
+
+		if (res != FPGA_OK)
+			break;
+	}
+
+	return res;
+}
+
+fpga_result __OPAE_API__ fpgaWriteMMIOBatch(fpga_handle handle,
+					    uint32_t mmio_num,
+					    const fpga_mmio_op *ops,
+					    uint32_t num_ops)
+{
+	fpga_result res = FPGA_OK;
+	uint32_t i;
+	opae_api_adapter_table *adapter;
+	opae_wrapped_handle *wrapped_handle =
+		opae_validate_wrapped_handle(handle);
+
+	ASSERT_NOT_NULL(wrapped_handle);
+	if (!num_ops)
+		return FPGA_OK;
+	ASSERT_NOT_NULL(ops);
+
+	adapter = wrapped_handle->adapter_table;
+
+	if (adapter->fpgaWriteMMIOBatch)
+		return adapter->fpgaWriteMMIOBatch(wrapped_handle->opae_handle,
+						   mmio_num, ops, num_ops);
+
+	res = opae_mmio_batch_check(ops, num_ops, UINT64_MAX);
+	if (res != FPGA_OK) {
+		OPAE_ERR("invalid MMIO batch descriptor");
+		return res;
+	}
+
+	for (i = 0; i < num_ops; ++i) {
+		if (ops[i].width == sizeof(uint64_t)) {
+			ASSERT_NOT_NULL_RESULT(adapter->fpgaWriteMMIO64,
+					       FPGA_NOT_SUPPORTED);
+			res = adapter->fpgaWriteMMIO64(
+				wrapped_handle->opae_handle, mmio_num,
+				ops[i].offset, ops[i].value);
+		} else if (ops[i].width == sizeof(uint32_t)) {
+			ASSERT_NOT_NULL_RESULT(adapter->fpgaWriteMMIO32,
+					       FPGA_NOT_SUPPORTED);
+			res = adapter->fpgaWriteMMIO32(
+				wrapped_handle->opae_handle, mmio_num,
+				ops[i].offset, (uint32_t)ops[i].value);
+		} else {
+			OPAE_ERR("invalid MMIO width %u", ops[i].width);
+			res = FPGA_INVALID_PARAM;
+		}
+
+		if (res != FPGA_OK)
+			break;
+	}
+
+	return res;
+}
+
 fpga_result __OPAE_API__ fpgaWriteMMIO512(fpga_handle handle,
 	uint32_t mmio_num, uint64_t offset, const void *value)
 {
@@ -677,28 +954,38 @@ typedef struct _opae_enumeration_context {
 	uint32_t errors;
 } opae_enumeration_context;
 
-static int opae_enumerate(const opae_api_adapter_table *adapter, void *context)
+// Enumerate a single adapter into tokens[0..max_tokens).
+STATIC fpga_result
+opae_enumerate_adapter(const opae_api_adapter_table *adapter,
+		       const opae_enumeration_context *ctx,
+		       fpga_token *tokens,
+		       uint32_t max_tokens,
+		       uint32_t *num_matches)
 {
-	opae_enumeration_context *ctx = (opae_enumeration_context *)context;
 	fpga_result res;
-	uint32_t num_matches = 0;
-	uint32_t i;
-	uint32_t space_remaining;
-
-	space_remaining = ctx->max_wrapped_tokens - ctx->num_wrapped_tokens;
 
-	if (ctx->wrapped_tokens && !space_remaining)
-		return OPAE_ENUM_STOP;
+	if (opae_enum_cache_enumerate(adapter, ctx->filters, ctx->num_filters,
+				      tokens, max_tokens,
+				      num_matches, &res))
+		res = adapter->fpgaEnumerate(ctx->filters, ctx->num_filters,
+					     tokens, max_tokens, num_matches);
 
-	if (!adapter->fpgaEnumerate) {
-		OPAE_MSG("NULL fpgaEnumerate in adapter \"%s\"",
-			 adapter->plugin.path);
-		return OPAE_ENUM_CONTINUE;
-	}
+	return res;
+}
 
-	res = adapter->fpgaEnumerate(ctx->filters, ctx->num_filters,
-				     ctx->adapter_tokens, space_remaining,
-				     &num_matches);
+// Wrap the tokens returned by a single adapter into ctx. tokens holds
+// up to max_tokens adapter tokens; any that do not fit in the space
+// remaining in ctx are destroyed.
+STATIC int opae_enumerate_collect(const opae_api_adapter_table *adapter,
+				  opae_enumeration_context *ctx,
+				  fpga_result res,
+				  fpga_token *tokens,
+				  uint32_t max_tokens,
+				  uint32_t num_matches)
+{
+	uint32_t i;
+	uint32_t space_remaining;
+	uint32_t returned;
 
 	if (res != FPGA_OK) {
 		OPAE_DBG("fpgaEnumerate() failed for \"%s\": %s",
@@ -716,17 +1003,25 @@ static int opae_enumerate(const opae_api_adapter_table *adapter, void *context)
 
 	*ctx->num_matches += num_matches;
 
-	if (!ctx->adapter_tokens) {
+	if (!tokens) {
 		// requesting token count, only.
 		return OPAE_ENUM_CONTINUE;
 	}
 
-	if (space_remaining > num_matches)
-		space_remaining = num_matches;
+	space_remaining = ctx->max_wrapped_tokens - ctx->num_wrapped_tokens;
+	returned = (num_matches < max_tokens) ? num_matches : max_tokens;
+
+	if (space_remaining > returned)
+		space_remaining = returned;
+
+	for (i = space_remaining; i < returned; ++i) {
+		if (adapter->fpgaDestroyToken)
+			adapter->fpgaDestroyToken(&tokens[i]);
+	}
 
 	for (i = 0; i < space_remaining; ++i) {
 		opae_wrapped_token *wt = opae_allocate_wrapped_token(
-			ctx->adapter_tokens[i], adapter);
+			tokens[i], adapter);
 		if (!wt) {
 			++ctx->errors;
 			return OPAE_ENUM_STOP;
@@ -744,6 +1039,138 @@ static int opae_enumerate(const opae_api_adapter_table *adapter, void *context)
 		       : OPAE_ENUM_CONTINUE;
 }
 
+static int opae_enumerate(const opae_api_adapter_table *adapter, void *context)
+{
+	opae_enumeration_context *ctx = (opae_enumeration_context *)context;
+	fpga_result res;
+	uint32_t num_matches = 0;
+	uint32_t space_remaining;
+
+	space_remaining = ctx->max_wrapped_tokens - ctx->num_wrapped_tokens;
+
+	if (ctx->wrapped_tokens && !space_remaining)
+		return OPAE_ENUM_STOP;
+
+	if (!adapter->fpgaEnumerate) {
+		OPAE_MSG("NULL fpgaEnumerate in adapter \"%s\"",
+			 adapter->plugin.path);
+		return OPAE_ENUM_CONTINUE;
+	}
+
+	res = opae_enumerate_adapter(adapter, ctx, ctx->adapter_tokens,
+				     space_remaining, &num_matches);
+
+	return opae_enumerate_collect(adapter, ctx, res, ctx->adapter_tokens,
+				      space_remaining, num_matches);
+}
+
+// Per-adapter result of a parallel enumeration.
+typedef struct _opae_enumeration_result {
+	int enumerated;
+	fpga_result res;
+	uint32_t num_matches;
+	fpga_token *tokens;
+} opae_enumeration_result;
+
+// Runs concurrently, one adapter per call. ctx is read-only here;
+// everything the adapter returns goes to result.
+STATIC void opae_enumerate_work(const opae_api_adapter_table *adapter,
+				void *result, void *context)
+{
+	const opae_enumeration_context *ctx =
+		(const opae_enumeration_context *)context;
+	opae_enumeration_result *r = (opae_enumeration_result *)result;
+
+	if (!adapter->fpgaEnumerate) {
+		OPAE_MSG("NULL fpgaEnumerate in adapter \"%s\"",
+			 adapter->plugin.path);
+		return;
+	}
+
+	r->enumerated = 1;
+
+	// Each adapter may return up to max_wrapped_tokens, because
+	// the space left by the adapters before it is not yet known.
+	if (ctx->wrapped_tokens && ctx->max_wrapped_tokens) {
+		r->tokens = (fpga_token *)opae_calloc(ctx->max_wrapped_tokens,
+						      sizeof(fpga_token));
+		if (!r->tokens) {
+			OPAE_ERR("out of memory");
+			r->res = FPGA_NO_MEMORY;
+			return;
+		}
+	}
+
+	r->res = opae_enumerate_adapter(adapter, ctx, r->tokens,
+					ctx->max_wrapped_tokens,
+					&r->num_matches);
+}
+
+// Runs serially, in plugin order, so that the resulting token order
+// is the same as that of opae_enumerate().
+STATIC int opae_enumerate_merge(const opae_api_adapter_table *adapter,
+				void *result, void *context)
+{
+	opae_enumeration_context *ctx = (opae_enumeration_context *)context;
+	opae_enumeration_result *r = (opae_enumeration_result *)result;
+	int ret = OPAE_ENUM_CONTINUE;
+
+	if (!r->enumerated)
+		return OPAE_ENUM_CONTINUE;
+
+	if (ctx->wrapped_tokens &&
+	    (ctx->num_wrapped_tokens == ctx->max_wrapped_tokens)) {
+		// opae_enumerate() would have stopped before this adapter,
+		// so its matches are neither counted nor returned.
+		if (r->tokens && (r->res == FPGA_OK)) {
+			uint32_t i;
+			uint32_t n = (r->num_matches < ctx->max_wrapped_tokens) ?
+				r->num_matches : ctx->max_wrapped_tokens;
+
+			for (i = 0; i < n; ++i) {
+				if (adapter->fpgaDestroyToken)
+					adapter->fpgaDestroyToken(&r->tokens[i]);
+			}
+		}
+		ret = OPAE_ENUM_STOP;
+	} else {
+		ret = opae_enumerate_collect(adapter, ctx, r->res, r->tokens,
+					     ctx->max_wrapped_tokens,
+					     r->num_matches);
+	}
+
+	if (r->tokens)
+		opae_free(r->tokens);
+
+	return ret;
+}
+
+#define OPAE_ENUM_MAX_THREADS 16
+
+// Number of threads used to enumerate the plugins, from
+// OPAE_ENUM_THREADS in the environment. 1 (the default) enumerates
+// the plugins one after another on the calling thread.
+STATIC uint32_t opae_enum_threads(void)
+{
+	const char *s = getenv("OPAE_ENUM_THREADS");
+	char *endptr = NULL;
+	unsigned long n;
+
+	if (!s)
+		return 1;
+
+	n = strtoul(s, &endptr, 0);
+	if (endptr == s || *endptr)
+		return 1;
+
+	if (n < 1)
+		n = 1;
+	else if (n > OPAE_ENUM_MAX_THREADS)
+		n = OPAE_ENUM_MAX_THREADS;
+
+	return (uint32_t)n;
+}
+
 fpga_result __OPAE_API__ fpgaEnumerate(const fpga_properties *filters,
 	uint32_t num_filters, fpga_token *tokens, uint32_t max_tokens,
 	uint32_t *num_matches)
@@ -760,6 +1187,7 @@ fpga_result __OPAE_API__ fpgaEnumerate(const fpga_properties *filters,
 	} parent_token_fixup;
 
 	parent_token_fixup *ptf_list = NULL;
+	uint32_t threads;
 	uint32_t i;
 
 	ASSERT_NOT_NULL(num_matches);
@@ -855,7 +1283,15 @@ fpga_result __OPAE_API__ fpgaEnumerate(const fpga_properties *filters,
 	}
 
 	// perform the enumeration.
-	opae_plugin_mgr_for_each_adapter(opae_enumerate, &enum_context);
+	threads = opae_enum_threads();
+	if (threads > 1)
+		opae_plugin_mgr_for_each_adapter_parallel(
+			opae_enumerate_work, opae_enumerate_merge,
+			sizeof(opae_enumeration_result), &enum_context,
+			threads);
+	else
+		opae_plugin_mgr_for_each_adapter(opae_enumerate,
+						 &enum_context);
 
 	res = (enum_context.errors > 0) ? FPGA_EXCEPTION : FPGA_OK;
 
@@ -1380,6 +1816,7 @@ fpga_result __OPAE_API__ fpgaUnregisterEvent(fpga_handle handle,
 fpga_result __OPAE_API__ fpgaAssignPortToInterface(fpga_handle fpga,
 	uint32_t interface_num, uint32_t slot_num, int flags)
 {
+	fpga_result res;
 	opae_wrapped_handle *wrapped_handle =
 		opae_validate_wrapped_handle(fpga);
 
@@ -1388,13 +1825,19 @@ fpga_result __OPAE_API__ fpgaAssignPortToInterface(fpga_handle fpga,
 		wrapped_handle->adapter_table->fpgaAssignPortToInterface,
 		FPGA_NOT_SUPPORTED);
 
-	return wrapped_handle->adapter_table->fpgaAssignPortToInterface(
+	res = wrapped_handle->adapter_table->fpgaAssignPortToInterface(
 		wrapped_handle->opae_handle, interface_num, slot_num, flags);
+
+	// The port moves between the PF and a VF.
+	opae_enum_cache_invalidate();
+
+	return res;
 }
 
 fpga_result __OPAE_API__ fpgaAssignToInterface(fpga_handle fpga,
 	fpga_token accelerator, uint32_t host_interface, int flags)
 {
+	fpga_result res;
 	opae_wrapped_handle *wrapped_handle =
 		opae_validate_wrapped_handle(fpga);
 	opae_wrapped_token *wrapped_token =
@@ -1406,14 +1849,20 @@ fpga_result __OPAE_API__ fpgaAssignToInterface(fpga_handle fpga,
 		wrapped_handle->adapter_table->fpgaAssignToInterface,
 		FPGA_NOT_SUPPORTED);
 
-	return wrapped_handle->adapter_table->fpgaAssignToInterface(
+	res = wrapped_handle->adapter_table->fpgaAssignToInterface(
 		wrapped_handle->opae_handle, wrapped_token->opae_token,
 		host_interface, flags);
+
+	// The accelerator moves between the PF and a VF.
+	opae_enum_cache_invalidate();
+
+	return res;
 }
 
 fpga_result __OPAE_API__ fpgaReleaseFromInterface(fpga_handle fpga,
 						  fpga_token accelerator)
 {
+	fpga_result res;
 	opae_wrapped_handle *wrapped_handle =
 		opae_validate_wrapped_handle(fpga);
 	opae_wrapped_token *wrapped_token =
@@ -1425,14 +1874,20 @@ fpga_result __OPAE_API__ fpgaReleaseFromInterface(fpga_handle fpga,
 		wrapped_handle->adapter_table->fpgaReleaseFromInterface,
 		FPGA_NOT_SUPPORTED);
 
-	return wrapped_handle->adapter_table->fpgaReleaseFromInterface(
+	res = wrapped_handle->adapter_table->fpgaReleaseFromInterface(
 		wrapped_handle->opae_handle, wrapped_token->opae_token);
+
+	// The accelerator moves between the PF and a VF.
+	opae_enum_cache_invalidate();
+
+	return res;
 }
 
 fpga_result __OPAE_API__ fpgaReconfigureSlot(fpga_handle fpga, uint32_t slot,
 				const uint8_t *bitstream, size_t bitstream_len,
 				int flags)
 {
+	fpga_result res;
 	opae_wrapped_handle *wrapped_handle =
 		opae_validate_wrapped_handle(fpga);
 
@@ -1442,9 +1897,42 @@ fpga_result __OPAE_API__ fpgaReconfigureSlot(fpga_handle fpga, uint32_t slot,
 		wrapped_handle->adapter_table->fpgaReconfigureSlot,
 		FPGA_NOT_SUPPORTED);
 
-	return wrapped_handle->adapter_table->fpgaReconfigureSlot(
+	res = wrapped_handle->adapter_table->fpgaReconfigureSlot(
 		wrapped_handle->opae_handle, slot, bitstream, bitstream_len,
 		flags);
+
+	// The AFU (and so the token properties) may have changed,
+	// even when reconfiguration reports failure.
+	opae_enum_cache_invalidate();
+
+	return res;
+}
+
+fpga_result __OPAE_API__ fpgaReconfigureSlotByFd(fpga_handle fpga,
+						 uint32_t slot,
+						 int fd, int flags)
+{
+	fpga_result res;
+	opae_wrapped_handle *wrapped_handle =
+		opae_validate_wrapped_handle(fpga);
+
+	ASSERT_NOT_NULL(wrapped_handle);
+	if (fd < 0) {
+		OPAE_ERR("fd is invalid");
+		return FPGA_INVALID_PARAM;
+	}
+	ASSERT_NOT_NULL_RESULT(
+		wrapped_handle->adapter_table->fpgaReconfigureSlotByFd,
+		FPGA_NOT_SUPPORTED);
+
+	res = wrapped_handle->adapter_table->fpgaReconfigureSlotByFd(
+		wrapped_handle->opae_handle, slot, fd, flags);
+
+	// The AFU (and so the token properties) may have changed,
+	// even when reconfiguration reports failure.
+	opae_enum_cache_invalidate();
+
+	return res;
 }
 
 fpga_result __OPAE_API__ fpgaTokenGetObject(fpga_token token, const char *name,
@@ -1788,6 +2276,24 @@ fpga_result __OPAE_API__ fpgaGetMetricsByName(fpga_handle handle,
 		wrapped_handle->opae_handle, metrics_names, num_metric_names, metrics);
 }
 
+fpga_result __OPAE_API__ fpgaGetMetricsAll(fpga_handle handle,
+				fpga_metric *metrics,
+				uint64_t *num_metrics)
+{
+	opae_wrapped_handle *wrapped_handle =
+		opae_validate_wrapped_handle(handle);
+
+	ASSERT_NOT_NULL(wrapped_handle);
+	ASSERT_NOT_NULL(metrics);
+	ASSERT_NOT_NULL(num_metrics);
+
+	ASSERT_NOT_NULL_RESULT(wrapped_handle->adapter_table->fpgaGetMetricsAll,
+			   FPGA_NOT_SUPPORTED);
+
+	return wrapped_handle->adapter_table->fpgaGetMetricsAll(
+		wrapped_handle->opae_handle, metrics, num_metrics);
+}
+
 fpga_result __OPAE_API__ fpgaGetMetricsThresholdInfo(fpga_handle handle,
 	metric_threshold *metric_thresholds,
 	uint32_t *num_thresholds)
@@ -0,0 +1,593 @@
+// Copyright(c) 2024, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif // HAVE_CONFIG_H
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/inotify.h>
+
+#include <opae/properties.h>
+
+#include "enum-cache.h"
+#include "opae_int.h"
+#include "props.h"
+#include "mock/opae_std.h"
+
+//
+// An adapter's cached enumeration is used while all of these hold:
+//  - the global generation counter has not changed since it was filled.
+//    opae_enum_cache_invalidate() bumps the counter. libopae-c calls it
+//    after partial reconfiguration and after assigning or releasing an
+//    accelerator, and it is also bumped whenever a DFL or vfio device
+//    node is created or removed under /dev.
+//  - it is younger than OPAE_ENUM_CACHE_TTL_MS (default 1000 ms). This
+//    bounds staleness for changes made by other processes that inotify
+//    cannot see, eg an AFU reconfigured by another process.
+//
+// Filters on fields that the plugins read from the live device at
+// enumeration time (error count, accelerator state, MMIO and interrupt
+// counts) or that need plugin-specific comparison (parent token) bypass
+// the cache.
+//
+// The cache is off by default. Set OPAE_ENUM_CACHE=1 in the environment
+// to enable it.
+//
+
+#define OPAE_ENUM_CACHE_DEFAULT_TTL_MS 1000
+
+typedef struct _opae_enum_cache_entry {
+	const opae_api_adapter_table *adapter;
+	pthread_mutex_t lock;
+	int valid;
+	uint64_t generation;
+	struct timespec stamp;
+	fpga_result result;
+	uint32_t num_tokens;
+	fpga_token *tokens;
+	fpga_properties *props;
+	struct _opae_enum_cache_entry *next;
+} opae_enum_cache_entry;
+
+static pthread_mutex_t enum_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static opae_enum_cache_entry *enum_cache_list;
+static uint64_t enum_cache_generation;
+static int enum_cache_configured;
+static int enum_cache_enabled;
+static uint64_t enum_cache_ttl_ms;
+static int enum_cache_inotify_fd = -1;
+static int enum_cache_vfio_wd = -1;
+STATIC uint64_t enum_cache_hits;
+STATIC uint64_t enum_cache_misses;
+
+#define ENUM_CACHE_WATCH_MASK \
+	(IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR)
+
+// Entries of /dev that the plugins enumerate. Sysfs does not raise
+// inotify events for device hotplug, so only device nodes are watched.
+STATIC const char * const enum_cache_dev_prefixes[] = {
+	"dfl-fme.",
+	"dfl-port.",
+	"intel-fpga-",
+	"uio",
+	"vfio",
+	NULL
+};
+
+STATIC bool opae_enum_cache_dev_node(const char *name)
+{
+	int i;
+
+	for (i = 0 ; enum_cache_dev_prefixes[i] ; ++i) {
+		if (!strncmp(name, enum_cache_dev_prefixes[i],
+			     strlen(enum_cache_dev_prefixes[i])))
+			return true;
+	}
+
+	return false;
+}
+
+void opae_enum_cache_invalidate(void)
+{
+	__atomic_add_fetch(&enum_cache_generation, 1, __ATOMIC_SEQ_CST);
+}
+
+// Called with enum_cache_lock held.
+STATIC void opae_enum_cache_configure(void)
+{
+	const char *s;
+
+	if (enum_cache_configured)
+		return;
+	enum_cache_configured = 1;
+
+	enum_cache_enabled = 0;
+	s = getenv("OPAE_ENUM_CACHE");
+	if (s && !strcmp(s, "1"))
+		enum_cache_enabled = 1;
+
+	enum_cache_ttl_ms = OPAE_ENUM_CACHE_DEFAULT_TTL_MS;
+	s = getenv("OPAE_ENUM_CACHE_TTL_MS");
+	if (s) {
+		char *endptr = NULL;
+		unsigned long long ttl = strtoull(s, &endptr, 0);
+		if (endptr && !*endptr)
+			enum_cache_ttl_ms = ttl;
+	}
+
+	if (!enum_cache_enabled || !enum_cache_ttl_ms) {
+		enum_cache_enabled = 0;
+		OPAE_DBG("enumeration cache disabled");
+		return;
+	}
+
+	enum_cache_inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (enum_cache_inotify_fd < 0) {
+		OPAE_DBG("inotify_init1() failed. "
+			 "Enumeration cache relies on its TTL.");
+		return;
+	}
+
+	inotify_add_watch(enum_cache_inotify_fd, "/dev",
+			  ENUM_CACHE_WATCH_MASK);
+	// /dev/vfio may not exist yet. If it is created later, it is
+	// watched from then on (see opae_enum_cache_poll_inotify()).
+	enum_cache_vfio_wd = inotify_add_watch(enum_cache_inotify_fd,
+					       "/dev/vfio",
+					       ENUM_CACHE_WATCH_MASK);
+}
+
+// Called with enum_cache_lock held.
+STATIC void opae_enum_cache_poll_inotify(void)
+{
+	char buf[4096]
+		__attribute__((aligned(__alignof__(struct inotify_event))));
+	const struct inotify_event *ev;
+	ssize_t len;
+	char *p;
+	int changed = 0;
+
+	if (enum_cache_inotify_fd < 0)
+		return;
+
+	while ((len = read(enum_cache_inotify_fd, buf, sizeof(buf))) > 0) {
+		for (p = buf ; p < buf + len ;
+		     p += sizeof(struct inotify_event) + ev->len) {
+			ev = (const struct inotify_event *)p;
+
+			if ((ev->mask & IN_Q_OVERFLOW) ||
+			    (ev->wd == enum_cache_vfio_wd)) {
+				// /dev/vfio itself was removed.
+				if (ev->mask & IN_IGNORED)
+					enum_cache_vfio_wd = -1;
+				changed = 1;
+				continue;
+			}
+
+			if (!ev->len || !opae_enum_cache_dev_node(ev->name))
+				continue;
+
+			changed = 1;
+
+			if (!strcmp(ev->name, "vfio") &&
+			    (ev->mask & (IN_CREATE | IN_MOVED_TO)) &&
+			    (enum_cache_vfio_wd < 0))
+				enum_cache_vfio_wd = inotify_add_watch(
+					enum_cache_inotify_fd, "/dev/vfio",
+					ENUM_CACHE_WATCH_MASK);
+		}
+	}
+
+	if (changed)
+		opae_enum_cache_invalidate();
+}
+
+STATIC void opae_enum_cache_free_entry(opae_enum_cache_entry *e)
+{
+	uint32_t i;
+
+	for (i = 0 ; i < e->num_tokens ; ++i) {
+		if (e->props[i])
+			fpgaDestroyProperties(&e->props[i]);
+		if (e->tokens[i])
+			e->adapter->fpgaDestroyToken(&e->tokens[i]);
+	}
+
+	opae_free(e->props);
+	opae_free(e->tokens);
+	e->props = NULL;
+	e->tokens = NULL;
+	e->num_tokens = 0;
+}
+
+STATIC fpga_result opae_enum_cache_fill(opae_enum_cache_entry *e)
+{
+	const opae_api_adapter_table *adapter = e->adapter;
+	uint32_t num_matches = 0;
+	uint32_t i;
+	fpga_result res;
+
+	opae_enum_cache_free_entry(e);
+
+	res = adapter->fpgaEnumerate(NULL, 0, NULL, 0, &num_matches);
+	if (res != FPGA_OK || !num_matches)
+		goto out_stamp;
+
+	e->tokens = opae_calloc(num_matches, sizeof(fpga_token));
+	e->props = opae_calloc(num_matches, sizeof(fpga_properties));
+	if (!e->tokens || !e->props) {
+		OPAE_ERR("calloc failed");
+		res = FPGA_NO_MEMORY;
+		goto out_free;
+	}
+
+	e->num_tokens = num_matches;
+
+	res = adapter->fpgaEnumerate(NULL, 0, e->tokens, e->num_tokens,
+				     &num_matches);
+	if (res != FPGA_OK)
+		goto out_free;
+
+	if (num_matches < e->num_tokens)
+		e->num_tokens = num_matches;
+
+	for (i = 0 ; i < e->num_tokens ; ++i) {
+		res = adapter->fpgaGetProperties(e->tokens[i], &e->props[i]);
+		if (res != FPGA_OK)
+			goto out_free;
+	}
+
+	goto out_stamp;
+
+out_free:
+	opae_enum_cache_free_entry(e);
+
+out_stamp:
+	// Hard failures are not cached: report them now and
+	// try again on the next call.
+	e->valid = (res == FPGA_OK) ||
+		   (res == FPGA_NO_DRIVER) ||
+		   (res == FPGA_NOT_FOUND);
+	e->result = res;
+	e->generation = __atomic_load_n(&enum_cache_generation,
+					__ATOMIC_SEQ_CST);
+	clock_gettime(CLOCK_MONOTONIC, &e->stamp);
+	return res;
+}
+
+STATIC bool opae_enum_cache_is_fresh(const opae_enum_cache_entry *e)
+{
+	struct timespec now;
+	uint64_t age_ms;
+
+	if (!e->valid)
+		return false;
+
+	if (e->generation != __atomic_load_n(&enum_cache_generation,
+					     __ATOMIC_SEQ_CST))
+		return false;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	age_ms = (now.tv_sec - e->stamp.tv_sec) * 1000 +
+		 (now.tv_nsec - e->stamp.tv_nsec) / 1000000;
+
+	return age_ms < enum_cache_ttl_ms;
+}
+
+#define CACHE_MATCH    1
+#define CACHE_NO_MATCH 0
+#define CACHE_UNKNOWN  -1
+
+// Filter fields that can be checked against a snapshot.
+#define CACHE_COMMON_FIELDS                                   \
+	(((uint64_t)1 << FPGA_PROPERTY_OBJTYPE) |             \
+	 ((uint64_t)1 << FPGA_PROPERTY_SEGMENT) |             \
+	 ((uint64_t)1 << FPGA_PROPERTY_BUS) |                 \
+	 ((uint64_t)1 << FPGA_PROPERTY_DEVICE) |              \
+	 ((uint64_t)1 << FPGA_PROPERTY_FUNCTION) |            \
+	 ((uint64_t)1 << FPGA_PROPERTY_SOCKETID) |            \
+	 ((uint64_t)1 << FPGA_PROPERTY_VENDORID) |            \
+	 ((uint64_t)1 << FPGA_PROPERTY_DEVICEID) |            \
+	 ((uint64_t)1 << FPGA_PROPERTY_GUID) |                \
+	 ((uint64_t)1 << FPGA_PROPERTY_OBJECTID) |            \
+	 ((uint64_t)1 << FPGA_PROPERTY_INTERFACE) |           \
+	 ((uint64_t)1 << FPGA_PROPERTY_SUB_VENDORID) |        \
+	 ((uint64_t)1 << FPGA_PROPERTY_SUB_DEVICEID))
+
+#define CACHE_DEVICE_FIELDS                                   \
+	(((uint64_t)1 << FPGA_PROPERTY_NUM_SLOTS) |           \
+	 ((uint64_t)1 << FPGA_PROPERTY_BBSID) |               \
+	 ((uint64_t)1 << FPGA_PROPERTY_BBSVERSION))
+
+// Returns non-zero if the filter uses only fields that
+// opae_enum_cache_match() can evaluate.
+STATIC int opae_enum_cache_filter_ok(struct _fpga_properties *f)
+{
+	uint64_t allowed = CACHE_COMMON_FIELDS;
+
+	if (FIELD_VALID(f, FPGA_PROPERTY_OBJTYPE)) {
+		if (f->objtype == FPGA_DEVICE)
+			allowed |= CACHE_DEVICE_FIELDS;
+	}
+
+	return !(f->valid_fields & ~allowed);
+}
+
+#define CACHE_CHECK(__f, __s, __field, __member)             \
+	do {                                                 \
+		if (FIELD_VALID(__f, __field)) {             \
+			if (!FIELD_VALID(__s, __field))      \
+				return CACHE_UNKNOWN;        \
+			if ((__f)->__member != (__s)->__member) \
+				return CACHE_NO_MATCH;       \
+		}                                            \
+	} while (0)
+
+STATIC int opae_enum_cache_match(struct _fpga_properties *f,
+				 struct _fpga_properties *s)
+{
+	CACHE_CHECK(f, s, FPGA_PROPERTY_OBJTYPE, objtype);
+	CACHE_CHECK(f, s, FPGA_PROPERTY_SEGMENT, segment);
+	CACHE_CHECK(f, s, FPGA_PROPERTY_BUS, bus);
+	CACHE_CHECK(f, s, FPGA_PROPERTY_DEVICE, device);
+	CACHE_CHECK(f, s, FPGA_PROPERTY_FUNCTION, function);
+	CACHE_CHECK(f, s, FPGA_PROPERTY_SOCKETID, socket_id);
+	CACHE_CHECK(f, s, FPGA_PROPERTY_VENDORID, vendor_id);
+	CACHE_CHECK(f, s, FPGA_PROPERTY_DEVICEID, device_id);
+	CACHE_CHECK(f, s, FPGA_PROPERTY_OBJECTID, object_id);
+	CACHE_CHECK(f, s, FPGA_PROPERTY_INTERFACE, interface);
+	CACHE_CHECK(f, s, FPGA_PROPERTY_SUB_VENDORID, subsystem_vendor_id);
+	CACHE_CHECK(f, s, FPGA_PROPERTY_SUB_DEVICEID, subsystem_device_id);
+
+	if (FIELD_VALID(f, FPGA_PROPERTY_GUID)) {
+		if (!FIELD_VALID(s, FPGA_PROPERTY_GUID))
+			return CACHE_UNKNOWN;
+		if (memcmp(f->guid, s->guid, sizeof(fpga_guid)))
+			return CACHE_NO_MATCH;
+	}
+
+	// FPGA_DEVICE-specific fields. opae_enum_cache_filter_ok() allows
+	// these only when the filter's objtype is FPGA_DEVICE, and the
+	// objtype check above has already matched the snapshot's.
+	if (f->valid_fields & CACHE_DEVICE_FIELDS) {
+		CACHE_CHECK(f, s, FPGA_PROPERTY_NUM_SLOTS, u.fpga.num_slots);
+		CACHE_CHECK(f, s, FPGA_PROPERTY_BBSID, u.fpga.bbs_id);
+		CACHE_CHECK(f, s, FPGA_PROPERTY_BBSVERSION,
+			    u.fpga.bbs_version.major);
+		CACHE_CHECK(f, s, FPGA_PROPERTY_BBSVERSION,
+			    u.fpga.bbs_version.minor);
+		CACHE_CHECK(f, s, FPGA_PROPERTY_BBSVERSION,
+			    u.fpga.bbs_version.patch);
+	}
+
+	return CACHE_MATCH;
+}
+
+// Evaluate the filters (OR'd together) against the snapshot s.
+STATIC int opae_enum_cache_match_filters(const fpga_properties *filters,
+					 uint32_t num_filters,
+					 struct _fpga_properties *s)
+{
+	uint32_t i;
+	int unknown = 0;
+
+	if (!num_filters)
+		return CACHE_MATCH;
+
+	for (i = 0 ; i < num_filters ; ++i) {
+		int m = opae_enum_cache_match(
+			(struct _fpga_properties *)filters[i], s);
+		if (m == CACHE_MATCH)
+			return CACHE_MATCH;
+		if (m == CACHE_UNKNOWN)
+			unknown = 1;
+	}
+
+	return unknown ? CACHE_UNKNOWN : CACHE_NO_MATCH;
+}
+
+// Called with enum_cache_lock held.
+STATIC opae_enum_cache_entry *
+opae_enum_cache_lookup(const opae_api_adapter_table *adapter)
+{
+	opae_enum_cache_entry *e;
+
+	for (e = enum_cache_list ; e ; e = e->next) {
+		if (e->adapter == adapter)
+			return e;
+	}
+
+	e = opae_calloc(1, sizeof(opae_enum_cache_entry));
+	if (!e) {
+		OPAE_ERR("calloc failed");
+		return NULL;
+	}
+
+	if (pthread_mutex_init(&e->lock, NULL)) {
+		OPAE_ERR("pthread_mutex_init failed");
+		opae_free(e);
+		return NULL;
+	}
+
+	e->adapter = adapter;
+	e->next = enum_cache_list;
+	enum_cache_list = e;
+
+	return e;
+}
+
+int opae_enum_cache_enumerate(const opae_api_adapter_table *adapter,
+			      const fpga_properties *filters,
+			      uint32_t num_filters,
+			      fpga_token *tokens,
+			      uint32_t max_tokens,
+			      uint32_t *num_matches,
+			      fpga_result *result)
+{
+	opae_enum_cache_entry *e;
+	uint32_t *matched = NULL;
+	uint32_t count = 0;
+	uint32_t i;
+	fpga_result res = FPGA_OK;
+	int bypass = 1;
+	int err;
+
+	if (!adapter->fpgaEnumerate ||
+	    !adapter->fpgaGetProperties ||
+	    !adapter->fpgaCloneToken ||
+	    !adapter->fpgaDestroyToken)
+		return 1;
+
+	for (i = 0 ; i < num_filters ; ++i) {
+		struct _fpga_properties *p =
+			opae_validate_and_lock_properties(filters[i]);
+		int ok;
+
+		if (!p)
+			return 1;
+		ok = opae_enum_cache_filter_ok(p);
+		opae_mutex_unlock(err, &p->lock);
+
+		if (!ok)
+			return 1;
+	}
+
+	opae_mutex_lock(err, &enum_cache_lock);
+
+	opae_enum_cache_configure();
+	if (!enum_cache_enabled) {
+		opae_mutex_unlock(err, &enum_cache_lock);
+		return 1;
+	}
+
+	opae_enum_cache_poll_inotify();
+
+	e = opae_enum_cache_lookup(adapter);
+
+	opae_mutex_unlock(err, &enum_cache_lock);
+
+	if (!e)
+		return 1;
+
+	// Each entry has its own lock so that a refill for one
+	// plugin does not hold up enumeration of the others.
+	opae_mutex_lock(err, &e->lock);
+
+	if (opae_enum_cache_is_fresh(e)) {
+		__atomic_add_fetch(&enum_cache_hits, 1, __ATOMIC_RELAXED);
+	} else {
+		__atomic_add_fetch(&enum_cache_misses, 1, __ATOMIC_RELAXED);
+		opae_enum_cache_fill(e);
+	}
+
+	res = e->result;
+	if (res != FPGA_OK) {
+		bypass = 0;
+		goto out_result;
+	}
+
+	if (e->num_tokens) {
+		matched = opae_malloc(e->num_tokens * sizeof(uint32_t));
+		if (!matched) {
+			OPAE_ERR("malloc failed");
+			goto out_unlock;
+		}
+	}
+
+	for (i = 0 ; i < e->num_tokens ; ++i) {
+		struct _fpga_properties *s =
+			opae_validate_and_lock_properties(e->props[i]);
+		int m;
+
+		if (!s)
+			goto out_unlock;
+		m = opae_enum_cache_match_filters(filters, num_filters, s);
+		opae_mutex_unlock(err, &s->lock);
+
+		if (m == CACHE_UNKNOWN)
+			goto out_unlock;
+		if (m == CACHE_MATCH)
+			matched[count++] = i;
+	}
+
+	bypass = 0;
+	*num_matches = count;
+
+	if (tokens) {
+		uint32_t n = (count < max_tokens) ? count : max_tokens;
+
+		for (i = 0 ; i < n ; ++i) {
+			res = adapter->fpgaCloneToken(e->tokens[matched[i]],
+						      &tokens[i]);
+			if (res != FPGA_OK) {
+				OPAE_ERR("fpgaCloneToken() failed");
+				while (i--)
+					adapter->fpgaDestroyToken(&tokens[i]);
+				break;
+			}
+		}
+	}
+
+out_result:
+	*result = res;
+
+out_unlock:
+	opae_mutex_unlock(err, &e->lock);
+	if (matched)
+		opae_free(matched);
+	return bypass;
+}
+
+void opae_enum_cache_flush(void)
+{
+	opae_enum_cache_entry *e;
+	int err;
+
+	opae_mutex_lock(err, &enum_cache_lock);
+
+	for (e = enum_cache_list ; e ; ) {
+		opae_enum_cache_entry *trash = e;
+		e = e->next;
+		opae_enum_cache_free_entry(trash);
+		pthread_mutex_destroy(&trash->lock);
+		opae_free(trash);
+	}
+	enum_cache_list = NULL;
+
+	if (enum_cache_inotify_fd >= 0) {
+		close(enum_cache_inotify_fd);
+		enum_cache_inotify_fd = -1;
+	}
+	enum_cache_vfio_wd = -1;
+	enum_cache_configured = 0;
+
+	opae_mutex_unlock(err, &enum_cache_lock);
+}
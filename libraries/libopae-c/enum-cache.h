@@ -0,0 +1,63 @@
+// Copyright(c) 2024, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+//
+// Enumeration cache. Keeps, per plugin adapter, the unfiltered token list
+// and a properties snapshot for each token, so that repeated calls to
+// fpgaEnumerate() can be answered without re-walking sysfs. See
+// enum-cache.c for the invalidation rules.
+//
+
+#ifndef __OPAE_ENUM_CACHE_H__
+#define __OPAE_ENUM_CACHE_H__
+
+#include <stdint.h>
+#include <opae/types.h>
+
+#include "adapter.h"
+
+// Serve adapter->fpgaEnumerate() from the cache. Same parameters as
+// fpgaEnumerate(); returned tokens are adapter tokens owned by the caller.
+// Returns non-zero when the request could not be served from the cache
+// (cache disabled, unsupported filter, ...), in which case the caller
+// must call adapter->fpgaEnumerate() itself. Otherwise, *result holds the
+// enumeration result.
+int opae_enum_cache_enumerate(const opae_api_adapter_table *adapter,
+			      const fpga_properties *filters,
+			      uint32_t num_filters,
+			      fpga_token *tokens,
+			      uint32_t max_tokens,
+			      uint32_t *num_matches,
+			      fpga_result *result);
+
+// Mark every cached enumeration stale (bump the generation counter).
+void opae_enum_cache_invalidate(void);
+
+// Release all cached tokens and properties. Called before the plugins
+// are unloaded.
+void opae_enum_cache_flush(void);
+
+#endif // __OPAE_ENUM_CACHE_H__
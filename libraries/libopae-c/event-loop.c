@@ -0,0 +1,446 @@
+// Copyright(c) 2024, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif // HAVE_CONFIG_H
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif // _GNU_SOURCE
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+
+#include <opae/event.h>
+#include <opae/event_loop.h>
+
+#include "opae_int.h"
+#include "mock/opae_std.h"
+
+//                                 l o o p
+#define OPAE_EVENT_LOOP_MAGIC 0x6c6f6f70
+
+// Maximum number of ready handles taken from epoll per wait.
+#define OPAE_EVENT_LOOP_BATCH 64
+
+typedef struct _opae_event_loop_entry {
+	fpga_event_handle event_handle;
+	int fd;
+	fpga_event_loop_cb cb;
+	void *context;
+	int flags;
+	int removed;
+	struct _opae_event_loop_entry *next;
+} opae_event_loop_entry;
+
+// Entries are indexed by their OS fd, so that removal does not
+// have to search. An entry removed while a wait is in progress
+// may still be referenced by that wait's epoll results, so it is
+// parked on the zombie list until no wait is in progress.
+typedef struct _opae_event_loop {
+	uint32_t magic;
+	pthread_mutex_t lock;
+	int epfd;
+	opae_event_loop_entry **by_fd;
+	uint32_t by_fd_size;
+	uint32_t busy;
+	opae_event_loop_entry *zombies;
+} opae_event_loop;
+
+STATIC opae_event_loop *opae_validate_event_loop(fpga_event_loop loop)
+{
+	opae_event_loop *l = (opae_event_loop *)loop;
+
+	if (!l)
+		return NULL;
+	return (l->magic == OPAE_EVENT_LOOP_MAGIC) ? l : NULL;
+}
+
+// Called with l->lock held.
+STATIC void opae_event_loop_reap(opae_event_loop *l)
+{
+	while (l->zombies) {
+		opae_event_loop_entry *trash = l->zombies;
+		l->zombies = trash->next;
+		opae_free(trash);
+	}
+}
+
+// Called with l->lock held.
+STATIC fpga_result opae_event_loop_grow(opae_event_loop *l, int fd)
+{
+	opae_event_loop_entry **by_fd;
+	uint32_t size = l->by_fd_size ? l->by_fd_size : 64;
+
+	while (size <= (uint32_t)fd)
+		size <<= 1;
+
+	if (size == l->by_fd_size)
+		return FPGA_OK;
+
+	by_fd = (opae_event_loop_entry **)opae_calloc(size,
+			sizeof(opae_event_loop_entry *));
+	if (!by_fd) {
+		OPAE_ERR("calloc failed");
+		return FPGA_NO_MEMORY;
+	}
+
+	if (l->by_fd) {
+		memcpy(by_fd, l->by_fd,
+		       l->by_fd_size * sizeof(opae_event_loop_entry *));
+		opae_free(l->by_fd);
+	}
+
+	l->by_fd = by_fd;
+	l->by_fd_size = size;
+
+	return FPGA_OK;
+}
+
+fpga_result __OPAE_API__ fpgaCreateEventLoop(fpga_event_loop *loop, int flags)
+{
+	opae_event_loop *l;
+	pthread_mutexattr_t mattr;
+
+	ASSERT_NOT_NULL(loop);
+
+	if (flags) {
+		OPAE_ERR("invalid flags 0x%x", flags);
+		return FPGA_INVALID_PARAM;
+	}
+
+	l = (opae_event_loop *)opae_calloc(1, sizeof(opae_event_loop));
+	if (!l) {
+		OPAE_ERR("calloc failed");
+		return FPGA_NO_MEMORY;
+	}
+
+	if (pthread_mutexattr_init(&mattr)) {
+		OPAE_ERR("pthread_mutexattr_init() failed");
+		goto out_free;
+	}
+
+	if (pthread_mutexattr_settype(&mattr, PTHREAD_MUTEX_RECURSIVE)) {
+		OPAE_ERR("pthread_mutexattr_settype() failed");
+		goto out_destroy_attr;
+	}
+
+	if (pthread_mutex_init(&l->lock, &mattr)) {
+		OPAE_ERR("pthread_mutex_init() failed");
+		goto out_destroy_attr;
+	}
+
+	l->epfd = epoll_create1(EPOLL_CLOEXEC);
+	if (l->epfd < 0) {
+		OPAE_ERR("epoll_create1() failed: %s", strerror(errno));
+		goto out_destroy_mutex;
+	}
+
+	pthread_mutexattr_destroy(&mattr);
+
+	l->magic = OPAE_EVENT_LOOP_MAGIC;
+	*loop = l;
+
+	return FPGA_OK;
+
+out_destroy_mutex:
+	pthread_mutex_destroy(&l->lock);
+out_destroy_attr:
+	pthread_mutexattr_destroy(&mattr);
+out_free:
+	opae_free(l);
+	return FPGA_EXCEPTION;
+}
+
+fpga_result __OPAE_API__ fpgaDestroyEventLoop(fpga_event_loop *loop)
+{
+	opae_event_loop *l;
+	uint32_t i;
+	int err;
+
+	ASSERT_NOT_NULL(loop);
+
+	l = opae_validate_event_loop(*loop);
+	ASSERT_NOT_NULL(l);
+
+	opae_mutex_lock(err, &l->lock);
+
+	for (i = 0 ; i < l->by_fd_size ; ++i) {
+		if (l->by_fd[i])
+			opae_free(l->by_fd[i]);
+	}
+	opae_free(l->by_fd);
+	l->by_fd = NULL;
+	l->by_fd_size = 0;
+
+	opae_event_loop_reap(l);
+
+	close(l->epfd);
+	l->epfd = -1;
+	l->magic = 0;
+
+	opae_mutex_unlock(err, &l->lock);
+
+	if (pthread_mutex_destroy(&l->lock))
+		OPAE_ERR("pthread_mutex_destroy() failed");
+
+	opae_free(l);
+	*loop = NULL;
+
+	return FPGA_OK;
+}
+
+fpga_result __OPAE_API__ fpgaEventLoopAdd(fpga_event_loop loop,
+					  fpga_event_handle event_handle,
+					  fpga_event_loop_cb cb,
+					  void *context,
+					  int flags)
+{
+	opae_event_loop *l = opae_validate_event_loop(loop);
+	opae_event_loop_entry *e;
+	struct epoll_event ev;
+	fpga_result res;
+	int fd = -1;
+	int err;
+
+	ASSERT_NOT_NULL(l);
+
+	if (flags & ~FPGA_EVENT_LOOP_CONSUME) {
+		OPAE_ERR("invalid flags 0x%x", flags);
+		return FPGA_INVALID_PARAM;
+	}
+
+	res = fpgaGetOSObjectFromEventHandle(event_handle, &fd);
+	if (res != FPGA_OK)
+		return res;
+
+	if (fd < 0) {
+		OPAE_ERR("invalid OS object for event handle");
+		return FPGA_INVALID_PARAM;
+	}
+
+	e = (opae_event_loop_entry *)opae_calloc(1,
+			sizeof(opae_event_loop_entry));
+	if (!e) {
+		OPAE_ERR("calloc failed");
+		return FPGA_NO_MEMORY;
+	}
+
+	e->event_handle = event_handle;
+	e->fd = fd;
+	e->cb = cb;
+	e->context = context;
+	e->flags = flags;
+
+	opae_mutex_lock(err, &l->lock);
+
+	res = opae_event_loop_grow(l, fd);
+	if (res != FPGA_OK)
+		goto out_unlock;
+
+	if (l->by_fd[fd]) {
+		OPAE_ERR("event handle (fd %d) is already in the loop", fd);
+		res = FPGA_BUSY;
+		goto out_unlock;
+	}
+
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	ev.data.ptr = e;
+
+	if (epoll_ctl(l->epfd, EPOLL_CTL_ADD, fd, &ev)) {
+		OPAE_ERR("epoll_ctl() failed: %s", strerror(errno));
+		res = FPGA_EXCEPTION;
+		goto out_unlock;
+	}
+
+	l->by_fd[fd] = e;
+	e = NULL;
+
+out_unlock:
+	opae_mutex_unlock(err, &l->lock);
+	if (e)
+		opae_free(e);
+	return res;
+}
+
+fpga_result __OPAE_API__ fpgaEventLoopRemove(fpga_event_loop loop,
+					     fpga_event_handle event_handle)
+{
+	opae_event_loop *l = opae_validate_event_loop(loop);
+	opae_event_loop_entry *e;
+	fpga_result res;
+	int fd = -1;
+	int err;
+
+	ASSERT_NOT_NULL(l);
+
+	res = fpgaGetOSObjectFromEventHandle(event_handle, &fd);
+	if (res != FPGA_OK)
+		return res;
+
+	opae_mutex_lock(err, &l->lock);
+
+	if ((fd < 0) || ((uint32_t)fd >= l->by_fd_size) ||
+	    !l->by_fd[fd] ||
+	    (l->by_fd[fd]->event_handle != event_handle)) {
+		opae_mutex_unlock(err, &l->lock);
+		return FPGA_NOT_FOUND;
+	}
+
+	e = l->by_fd[fd];
+	l->by_fd[fd] = NULL;
+
+	if (epoll_ctl(l->epfd, EPOLL_CTL_DEL, fd, NULL) &&
+	    (errno != ENOENT) && (errno != EBADF))
+		OPAE_MSG("epoll_ctl() failed: %s", strerror(errno));
+
+	e->removed = 1;
+	if (l->busy) {
+		e->next = l->zombies;
+		l->zombies = e;
+	} else {
+		opae_free(e);
+	}
+
+	opae_mutex_unlock(err, &l->lock);
+
+	return FPGA_OK;
+}
+
+STATIC fpga_result opae_event_loop_run(opae_event_loop *l,
+				       fpga_event_loop_ready *ready,
+				       uint32_t max_ready,
+				       uint32_t *num_ready,
+				       int timeout_ms)
+{
+	struct epoll_event events[OPAE_EVENT_LOOP_BATCH];
+	int max_events = OPAE_EVENT_LOOP_BATCH;
+	fpga_result res = FPGA_OK;
+	uint32_t count = 0;
+	int n;
+	int i;
+	int err;
+
+	if (ready && (max_ready < (uint32_t)max_events))
+		max_events = (int)max_ready;
+
+	opae_mutex_lock(err, &l->lock);
+	++l->busy;
+	opae_mutex_unlock(err, &l->lock);
+
+	do {
+		n = epoll_wait(l->epfd, events, max_events, timeout_ms);
+	} while ((n < 0) && (errno == EINTR));
+
+	if (n < 0) {
+		OPAE_ERR("epoll_wait() failed: %s", strerror(errno));
+		res = FPGA_EXCEPTION;
+		goto out_release;
+	}
+
+	for (i = 0 ; i < n ; ++i) {
+		opae_event_loop_entry *e =
+			(opae_event_loop_entry *)events[i].data.ptr;
+		fpga_event_handle eh;
+		fpga_event_loop_cb cb;
+		void *context;
+		uint64_t value = 0;
+		int fd;
+		int flags;
+
+		opae_mutex_lock(err, &l->lock);
+		if (e->removed) {
+			opae_mutex_unlock(err, &l->lock);
+			continue;
+		}
+		eh = e->event_handle;
+		cb = e->cb;
+		context = e->context;
+		fd = e->fd;
+		flags = e->flags;
+		opae_mutex_unlock(err, &l->lock);
+
+		if ((flags & FPGA_EVENT_LOOP_CONSUME) &&
+		    (read(fd, &value, sizeof(value)) != sizeof(value)))
+			value = 0;
+
+		if (ready) {
+			ready[count].event_handle = eh;
+			ready[count].context = context;
+			ready[count].count = value;
+			++count;
+		} else if (cb) {
+			cb(eh, value, context);
+			++count;
+		}
+	}
+
+out_release:
+	opae_mutex_lock(err, &l->lock);
+	if (!--l->busy)
+		opae_event_loop_reap(l);
+	opae_mutex_unlock(err, &l->lock);
+
+	if (num_ready)
+		*num_ready = count;
+
+	return res;
+}
+
+fpga_result __OPAE_API__ fpgaEventLoopWait(fpga_event_loop loop,
+					   fpga_event_loop_ready *ready,
+					   uint32_t max_ready,
+					   uint32_t *num_ready,
+					   int timeout_ms)
+{
+	opae_event_loop *l = opae_validate_event_loop(loop);
+
+	ASSERT_NOT_NULL(l);
+	ASSERT_NOT_NULL(ready);
+	ASSERT_NOT_NULL(num_ready);
+
+	if (!max_ready) {
+		OPAE_ERR("max_ready is 0");
+		return FPGA_INVALID_PARAM;
+	}
+
+	return opae_event_loop_run(l, ready, max_ready, num_ready, timeout_ms);
+}
+
+fpga_result __OPAE_API__ fpgaEventLoopDispatch(fpga_event_loop loop,
+					       int timeout_ms,
+					       uint32_t *num_dispatched)
+{
+	opae_event_loop *l = opae_validate_event_loop(loop);
+
+	ASSERT_NOT_NULL(l);
+
+	return opae_event_loop_run(l, NULL, 0, num_dispatched, timeout_ms);
+}
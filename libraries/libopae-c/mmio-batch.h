@@ -0,0 +1,98 @@
+// Copyright(c) 2024, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+//
+// Helpers shared by the plugin implementations of fpgaReadMMIOBatch() and
+// fpgaWriteMMIOBatch(). A plugin validates its handle and takes its lock
+// once, checks the whole batch with opae_mmio_batch_check(), and then
+// performs the accesses against the base of the mapped MMIO space.
+//
+
+#ifndef __OPAE_MMIO_BATCH_H__
+#define __OPAE_MMIO_BATCH_H__
+
+#include <stdint.h>
+#include <opae/types.h>
+
+/*
+ * Check each descriptor for a supported width, natural alignment, and an
+ * offset that lies within the first len bytes of the MMIO space.
+ */
+static inline fpga_result opae_mmio_batch_check(const fpga_mmio_op *ops,
+						uint32_t num_ops,
+						uint64_t len)
+{
+	uint32_t i;
+
+	for (i = 0; i < num_ops; ++i) {
+		if ((ops[i].width != sizeof(uint32_t)) &&
+		    (ops[i].width != sizeof(uint64_t)))
+			return FPGA_INVALID_PARAM;
+
+		if (ops[i].offset % ops[i].width)
+			return FPGA_INVALID_PARAM;
+
+		if ((ops[i].offset > len) ||
+		    (ops[i].width > len - ops[i].offset))
+			return FPGA_INVALID_PARAM;
+	}
+
+	return FPGA_OK;
+}
+
+static inline void opae_mmio_batch_read(volatile uint8_t *base,
+					fpga_mmio_op *ops,
+					uint32_t num_ops)
+{
+	uint32_t i;
+
+	for (i = 0; i < num_ops; ++i) {
+		if (ops[i].width == sizeof(uint64_t))
+			ops[i].value =
+				*((volatile uint64_t *)(base + ops[i].offset));
+		else
+			ops[i].value =
+				*((volatile uint32_t *)(base + ops[i].offset));
+	}
+}
+
+static inline void opae_mmio_batch_write(volatile uint8_t *base,
+					 const fpga_mmio_op *ops,
+					 uint32_t num_ops)
+{
+	uint32_t i;
+
+	for (i = 0; i < num_ops; ++i) {
+		if (ops[i].width == sizeof(uint64_t))
+			*((volatile uint64_t *)(base + ops[i].offset)) =
+				ops[i].value;
+		else
+			*((volatile uint32_t *)(base + ops[i].offset)) =
+				(uint32_t)ops[i].value;
+	}
+}
+
+#endif // __OPAE_MMIO_BATCH_H__
@@ -101,13 +101,23 @@ typedef struct _opae_api_adapter_table opae_api_adapter_table;
 //                                  k o t w
 #define OPAE_WRAPPED_TOKEN_MAGIC 0x6b6f7477
 
+#define OPAE_WRAPPED_TOKEN_SHARDS 16
+#define OPAE_WRAPPED_TOKEN_NOT_INDEXED 0xffffffff
+
 typedef struct _opae_wrapped_token {
 	uint32_t magic;
 	fpga_token opae_token;
-	uint32_t ref_count;
+	uint32_t ref_count; // atomic
+	// FPGA_DEVICE tokens are kept in a sharded index, keyed by PCIe
+	// address, for parent lookup. Others are not indexed.
+	uint32_t shard;
 	struct _opae_wrapped_token *prev;
 	struct _opae_wrapped_token *next;
 	opae_api_adapter_table *adapter_table;
+	// Leak tracking, LIBOPAE_DEBUG only.
+	uint32_t leak_shard;
+	struct _opae_wrapped_token *leak_prev;
+	struct _opae_wrapped_token *leak_next;
 } opae_wrapped_token;
 
 opae_wrapped_token *
@@ -44,6 +44,7 @@
 #include "opae_int.h"
 #include "mock/opae_std.h"
 #include "cfg-file.h"
+#include "enum-cache.h"
 
 #define OPAE_PLUGIN_CONFIGURE "opae_plugin_configure"
 typedef int (*opae_plugin_configure_t)(opae_api_adapter_table *, const char *);
@@ -186,6 +187,9 @@ int opae_plugin_mgr_finalize_all(void)
 
 	finalizing = 1;
 
+	// Cached tokens belong to the plugins. Release them first.
+	opae_enum_cache_flush();
+
 	for (aptr = adapter_list; aptr;) {
 		opae_api_adapter_table *trash;
 
@@ -624,6 +628,120 @@ out_unlock:
 	return cb_res;
 }
 
+typedef struct _opae_parallel_job {
+	opae_api_adapter_table **adapters;
+	size_t num_adapters;
+	size_t next;
+	char *results;
+	size_t result_size;
+	void (*work)(const opae_api_adapter_table *, void *, void *);
+	void *context;
+} opae_parallel_job;
+
+STATIC void *opae_plugin_mgr_parallel_worker(void *arg)
+{
+	opae_parallel_job *job = (opae_parallel_job *)arg;
+	size_t i;
+
+	while ((i = __atomic_fetch_add(&job->next, 1, __ATOMIC_RELAXED)) <
+	       job->num_adapters)
+		job->work(job->adapters[i],
+			  job->results + i * job->result_size,
+			  job->context);
+
+	return NULL;
+}
+
+int opae_plugin_mgr_for_each_adapter_parallel(
+	void (*work)(const opae_api_adapter_table *, void *, void *),
+	int (*merge)(const opae_api_adapter_table *, void *, void *),
+	size_t result_size, void *context, uint32_t max_threads)
+{
+	int res;
+	int cb_res = OPAE_ENUM_CONTINUE;
+	opae_api_adapter_table *aptr;
+	opae_parallel_job job;
+	pthread_t *threads = NULL;
+	size_t num_threads = 0;
+	size_t i;
+
+	if (!work || !merge) {
+		OPAE_ERR("NULL callback passed to %s()", __func__);
+		return OPAE_ENUM_STOP;
+	}
+
+	memset(&job, 0, sizeof(job));
+	job.result_size = result_size;
+	job.work = work;
+	job.context = context;
+
+	opae_mutex_lock(res, &adapter_list_lock);
+
+	for (aptr = adapter_list; aptr; aptr = aptr->next)
+		++job.num_adapters;
+
+	if (!job.num_adapters)
+		goto out_unlock;
+
+	job.adapters = opae_calloc(job.num_adapters,
+				   sizeof(opae_api_adapter_table *));
+	job.results = opae_calloc(job.num_adapters, result_size ?
+				  result_size : 1);
+	if (!job.adapters || !job.results) {
+		OPAE_ERR("calloc failed");
+		cb_res = OPAE_ENUM_STOP;
+		goto out_free;
+	}
+
+	for (i = 0, aptr = adapter_list; aptr; aptr = aptr->next)
+		job.adapters[i++] = aptr;
+
+	// The calling thread is one of the workers.
+	if (max_threads > job.num_adapters)
+		max_threads = job.num_adapters;
+
+	if (max_threads > 1) {
+		threads = opae_calloc(max_threads - 1, sizeof(pthread_t));
+		if (!threads)
+			OPAE_MSG("calloc failed, enumerating serially");
+	}
+
+	for (i = 0 ; threads && (i < max_threads - 1) ; ++i) {
+		if (pthread_create(&threads[i], NULL,
+				   opae_plugin_mgr_parallel_worker, &job)) {
+			OPAE_MSG("pthread_create failed");
+			break;
+		}
+		++num_threads;
+	}
+
+	opae_plugin_mgr_parallel_worker(&job);
+
+	for (i = 0 ; i < num_threads ; ++i)
+		pthread_join(threads[i], NULL);
+
+	for (i = 0 ; i < job.num_adapters ; ++i) {
+		int r = merge(job.adapters[i],
+			      job.results + i * result_size,
+			      context);
+		if ((r != OPAE_ENUM_CONTINUE) && (cb_res == OPAE_ENUM_CONTINUE))
+			cb_res = r;
+	}
+
+out_free:
+	if (threads)
+		opae_free(threads);
+	if (job.results)
+		opae_free(job.results);
+	if (job.adapters)
+		opae_free(job.adapters);
+
+out_unlock:
+	opae_mutex_unlock(res, &adapter_list_lock);
+
+	return cb_res;
+}
+
 int opae_plugin_mgr_register_plugin(const char *name, const char *cfg)
 {
 	int res;
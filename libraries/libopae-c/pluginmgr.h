@@ -41,4 +41,15 @@ int opae_plugin_mgr_finalize_all(void);
 int opae_plugin_mgr_for_each_adapter(
 	int (*callback)(const opae_api_adapter_table *, void *), void *context);
 
+// Runs work() for every adapter on up to max_threads threads, each
+// with its own zeroed result_size-byte result slot, then calls merge()
+// for every adapter in plugin list order. merge() is called for each
+// adapter, even after one returns OPAE_ENUM_STOP, so that per-adapter
+// results can be released. Returns the first non-continue merge()
+// result, or OPAE_ENUM_CONTINUE.
+int opae_plugin_mgr_for_each_adapter_parallel(
+	void (*work)(const opae_api_adapter_table *, void *, void *),
+	int (*merge)(const opae_api_adapter_table *, void *, void *),
+	size_t result_size, void *context, uint32_t max_threads);
+
 #endif /* __OPAE_PLUGINMGR_H__ */
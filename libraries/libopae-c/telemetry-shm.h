@@ -0,0 +1,83 @@
+// Copyright(c) 2024, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+//
+// Layout of the telemetry shared memory segment, shared by the writer
+// (the fpgad-vc plugin) and the reader (telemetry.c).
+//
+// There is a single writer per segment. The writer makes seq odd before
+// it starts to update the snapshot and even again when it is done. A
+// reader copies the snapshot between two loads of seq and keeps the copy
+// only when both loads return the same even value.
+//
+
+#ifndef __OPAE_TELEMETRY_SHM_H__
+#define __OPAE_TELEMETRY_SHM_H__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <opae/telemetry.h>
+
+//                                 t e l m
+#define OPAE_TELEMETRY_SHM_MAGIC  0x74656c6d
+#define OPAE_TELEMETRY_SHM_VERSION 1
+
+// shm_open() name of the segment for the device at seg:bus:dev.fn
+#define OPAE_TELEMETRY_SHM_FMT "/opae-telemetry-%04x:%02x:%02x.%x"
+#define OPAE_TELEMETRY_SHM_NAME_LEN 32
+
+typedef struct _opae_telemetry_shm {
+	uint32_t magic;
+	uint32_t version;
+	uint64_t size;
+	uint64_t seq;
+	fpga_telemetry_snapshot snapshot;
+} opae_telemetry_shm;
+
+static inline void opae_telemetry_shm_name(char *name,
+					   uint16_t seg,
+					   uint8_t bus,
+					   uint8_t dev,
+					   uint8_t fn)
+{
+	snprintf(name, OPAE_TELEMETRY_SHM_NAME_LEN, OPAE_TELEMETRY_SHM_FMT,
+		 (unsigned)seg, (unsigned)bus, (unsigned)dev, (unsigned)fn);
+}
+
+static inline void opae_telemetry_write_begin(opae_telemetry_shm *shm)
+{
+	__atomic_store_n(&shm->seq, shm->seq + 1, __ATOMIC_RELAXED);
+	// Order the odd seq before the snapshot stores that follow.
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static inline void opae_telemetry_write_end(opae_telemetry_shm *shm)
+{
+	++shm->snapshot.sequence;
+	__atomic_store_n(&shm->seq, shm->seq + 1, __ATOMIC_RELEASE);
+}
+
+#endif // __OPAE_TELEMETRY_SHM_H__
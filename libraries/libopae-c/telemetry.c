@@ -0,0 +1,239 @@
+// Copyright(c) 2024, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif // HAVE_CONFIG_H
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif // _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <opae/properties.h>
+#include <opae/telemetry.h>
+
+#include "opae_int.h"
+#include "telemetry-shm.h"
+#include "mock/opae_std.h"
+
+//                                 t l m r
+#define OPAE_TELEMETRY_MAGIC 0x746c6d72
+
+// Number of times fpgaTelemetryRead() retries a copy that raced
+// with the writer before giving up with FPGA_BUSY.
+#define OPAE_TELEMETRY_MAX_RETRIES 1000
+
+typedef struct _opae_telemetry {
+	uint32_t magic;
+	const opae_telemetry_shm *shm;
+	size_t size;
+} opae_telemetry;
+
+STATIC opae_telemetry *opae_validate_telemetry(fpga_telemetry telemetry)
+{
+	opae_telemetry *t = (opae_telemetry *)telemetry;
+
+	if (!t)
+		return NULL;
+	return (t->magic == OPAE_TELEMETRY_MAGIC) ? t : NULL;
+}
+
+STATIC fpga_result opae_telemetry_name(fpga_token token, char *name)
+{
+	fpga_properties props = NULL;
+	fpga_result res;
+	uint16_t seg = 0;
+	uint8_t bus = 0;
+	uint8_t dev = 0;
+	uint8_t fn = 0;
+
+	res = fpgaGetProperties(token, &props);
+	if (res != FPGA_OK)
+		return res;
+
+	if ((fpgaPropertiesGetSegment(props, &seg) != FPGA_OK) ||
+	    (fpgaPropertiesGetBus(props, &bus) != FPGA_OK) ||
+	    (fpgaPropertiesGetDevice(props, &dev) != FPGA_OK) ||
+	    (fpgaPropertiesGetFunction(props, &fn) != FPGA_OK)) {
+		OPAE_ERR("token has no PCIe address");
+		res = FPGA_INVALID_PARAM;
+	} else {
+		opae_telemetry_shm_name(name, seg, bus, dev, fn);
+	}
+
+	fpgaDestroyProperties(&props);
+	return res;
+}
+
+fpga_result __OPAE_API__ fpgaTelemetryOpen(fpga_token token,
+					   fpga_telemetry *telemetry)
+{
+	char name[OPAE_TELEMETRY_SHM_NAME_LEN];
+	opae_telemetry *t;
+	const opae_telemetry_shm *shm;
+	struct stat st;
+	fpga_result res;
+	int fd;
+
+	ASSERT_NOT_NULL(token);
+	ASSERT_NOT_NULL(telemetry);
+
+	res = opae_telemetry_name(token, name);
+	if (res != FPGA_OK)
+		return res;
+
+	fd = shm_open(name, O_RDONLY | O_CLOEXEC, 0);
+	if (fd < 0) {
+		if (errno == ENOENT) {
+			OPAE_DBG("no telemetry published at %s", name);
+			return FPGA_NOT_FOUND;
+		}
+		OPAE_ERR("shm_open(\"%s\") failed: %s", name, strerror(errno));
+		return FPGA_EXCEPTION;
+	}
+
+	if (fstat(fd, &st)) {
+		OPAE_ERR("fstat(\"%s\") failed: %s", name, strerror(errno));
+		close(fd);
+		return FPGA_EXCEPTION;
+	}
+
+	// The writer creates the segment before sizing it.
+	if ((size_t)st.st_size < sizeof(opae_telemetry_shm)) {
+		close(fd);
+		return st.st_size ? FPGA_NOT_SUPPORTED : FPGA_NOT_FOUND;
+	}
+
+	shm = (const opae_telemetry_shm *)mmap(NULL, (size_t)st.st_size,
+					       PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (shm == MAP_FAILED) {
+		OPAE_ERR("mmap(\"%s\") failed: %s", name, strerror(errno));
+		return FPGA_EXCEPTION;
+	}
+
+	if (__atomic_load_n(&shm->magic, __ATOMIC_ACQUIRE) !=
+		OPAE_TELEMETRY_SHM_MAGIC) {
+		// Created, but not yet initialized.
+		res = FPGA_NOT_FOUND;
+		goto out_unmap;
+	}
+
+	if (shm->version != OPAE_TELEMETRY_SHM_VERSION) {
+		OPAE_ERR("%s: unsupported telemetry version %u",
+			 name, shm->version);
+		res = FPGA_NOT_SUPPORTED;
+		goto out_unmap;
+	}
+
+	t = (opae_telemetry *)opae_calloc(1, sizeof(opae_telemetry));
+	if (!t) {
+		OPAE_ERR("calloc failed");
+		res = FPGA_NO_MEMORY;
+		goto out_unmap;
+	}
+
+	t->magic = OPAE_TELEMETRY_MAGIC;
+	t->shm = shm;
+	t->size = (size_t)st.st_size;
+	*telemetry = t;
+
+	return FPGA_OK;
+
+out_unmap:
+	munmap((void *)shm, (size_t)st.st_size);
+	return res;
+}
+
+fpga_result __OPAE_API__ fpgaTelemetryClose(fpga_telemetry *telemetry)
+{
+	opae_telemetry *t;
+
+	ASSERT_NOT_NULL(telemetry);
+
+	t = opae_validate_telemetry(*telemetry);
+	ASSERT_NOT_NULL(t);
+
+	munmap((void *)t->shm, t->size);
+	t->magic = 0;
+	opae_free(t);
+	*telemetry = NULL;
+
+	return FPGA_OK;
+}
+
+fpga_result __OPAE_API__ fpgaTelemetryRead(fpga_telemetry telemetry,
+					   fpga_telemetry_snapshot *snapshot)
+{
+	opae_telemetry *t;
+	const opae_telemetry_shm *shm;
+	uint32_t retries;
+
+	ASSERT_NOT_NULL(snapshot);
+
+	t = opae_validate_telemetry(telemetry);
+	ASSERT_NOT_NULL(t);
+
+	shm = t->shm;
+
+	for (retries = 0 ; retries < OPAE_TELEMETRY_MAX_RETRIES ; ++retries) {
+		uint64_t begin;
+		uint64_t end;
+		uint32_t num_sensors;
+
+		begin = __atomic_load_n(&shm->seq, __ATOMIC_ACQUIRE);
+		if (begin & 1)
+			continue; // write in progress
+
+		if (!begin)
+			return FPGA_NOT_FOUND;
+
+		snapshot->timestamp_ns = shm->snapshot.timestamp_ns;
+		snapshot->sequence = shm->snapshot.sequence;
+		num_sensors = shm->snapshot.num_sensors;
+		if (num_sensors > FPGA_TELEMETRY_MAX_SENSORS)
+			num_sensors = FPGA_TELEMETRY_MAX_SENSORS;
+		snapshot->num_sensors = num_sensors;
+		memcpy(snapshot->sensors, shm->snapshot.sensors,
+		       num_sensors * sizeof(fpga_telemetry_sensor));
+
+		// Order the copy above before the second load of seq.
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		end = __atomic_load_n(&shm->seq, __ATOMIC_RELAXED);
+
+		if (begin == end)
+			return FPGA_OK;
+	}
+
+	return FPGA_BUSY;
+}
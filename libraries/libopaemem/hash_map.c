@@ -52,6 +52,260 @@
 fprintf(stderr, "%s:%u:%s() **ERROR** [%s] : " format, \
 	__SHORT_FILE__, __LINE__, __func__, strerror(errno), ##__VA_ARGS__)
 
+#define OPAE_HASH_MAP_MIN_SLOTS 8
+
+// Open-addressing slot. dist is zero for an empty slot, otherwise one
+// more than the distance of the slot from the key's home slot.
+typedef struct _opae_hash_map_slot {
+	void *key;
+	void *value;
+	uint32_t dist;
+} opae_hash_map_slot;
+
+// With OPAE_HASH_MAP_OPEN_ADDRESSING, hm->buckets points to this table
+// instead of to an array of lists, so that opae_hash_map keeps the same
+// layout in the public structures that embed it.
+typedef struct _opae_hash_map_table {
+	uint32_t num_items;
+	opae_hash_map_slot slots[];
+} opae_hash_map_table;
+
+static inline bool opae_hash_map_is_open(opae_hash_map *hm)
+{
+	return hm->flags & OPAE_HASH_MAP_OPEN_ADDRESSING;
+}
+
+static inline opae_hash_map_table *opae_hash_map_oa_table(opae_hash_map *hm)
+{
+	return (opae_hash_map_table *)hm->buckets;
+}
+
+static inline int opae_hash_map_compare(opae_hash_map *hm,
+					void *keya,
+					void *keyb)
+{
+	if (hm->key_compare == opae_u64_key_compare)
+		return opae_u64_key_compare(keya, keyb);
+	return hm->key_compare(keya, keyb);
+}
+
+static inline uint32_t opae_hash_map_home(opae_hash_map *hm,
+					  uint32_t num_slots,
+					  void *key)
+{
+	if (hm->key_hash == opae_ptr_key_hash)
+		return opae_ptr_key_hash(num_slots, hm->hash_seed, key);
+	return hm->key_hash(num_slots, hm->hash_seed, key);
+}
+
+static opae_hash_map_table *opae_hash_map_oa_alloc(uint32_t num_slots)
+{
+	return (opae_hash_map_table *)
+		opae_calloc(1, sizeof(opae_hash_map_table) +
+			       (size_t)num_slots * sizeof(opae_hash_map_slot));
+}
+
+STATIC uint32_t opae_hash_map_oa_items(opae_hash_map *hm)
+{
+	return opae_hash_map_oa_table(hm)->num_items;
+}
+
+STATIC fpga_result opae_hash_map_oa_init(opae_hash_map *hm,
+					 uint32_t num_buckets)
+{
+	uint32_t num_slots = OPAE_HASH_MAP_MIN_SLOTS;
+	opae_hash_map_table *t;
+
+	while (num_slots < num_buckets && num_slots < (1u << 31))
+		num_slots <<= 1;
+
+	t = opae_hash_map_oa_alloc(num_slots);
+	if (!t) {
+		ERR("calloc() failed");
+		return FPGA_NO_MEMORY;
+	}
+
+	hm->buckets = (opae_hash_map_item **)t;
+	hm->num_buckets = num_slots;
+
+	return FPGA_OK;
+}
+
+// Robin Hood insertion of a key known not to be present. The entry
+// being placed displaces any resident that is closer to its home slot.
+static void opae_hash_map_oa_place(opae_hash_map_slot *slots,
+				   uint32_t num_slots,
+				   uint32_t i,
+				   void *key,
+				   void *value)
+{
+	const uint32_t mask = num_slots - 1;
+	opae_hash_map_slot e = { key, value, 1 };
+
+	while (slots[i].dist) {
+		if (slots[i].dist < e.dist) {
+			opae_hash_map_slot tmp = slots[i];
+			slots[i] = e;
+			e = tmp;
+		}
+		i = (i + 1) & mask;
+		++e.dist;
+	}
+
+	slots[i] = e;
+}
+
+STATIC fpga_result opae_hash_map_oa_grow(opae_hash_map *hm)
+{
+	opae_hash_map_table *old = opae_hash_map_oa_table(hm);
+	opae_hash_map_table *t;
+	uint32_t num_slots;
+	uint32_t i;
+
+	if (hm->num_buckets >= (1u << 31)) {
+		ERR("hash map is at maximum capacity");
+		return FPGA_NO_MEMORY;
+	}
+
+	num_slots = hm->num_buckets << 1;
+	t = opae_hash_map_oa_alloc(num_slots);
+	if (!t) {
+		ERR("calloc() failed");
+		return FPGA_NO_MEMORY;
+	}
+
+	for (i = 0 ; i < hm->num_buckets ; ++i) {
+		opae_hash_map_slot *s = &old->slots[i];
+		uint32_t home;
+
+		if (!s->dist)
+			continue;
+
+		home = opae_hash_map_home(hm, num_slots, s->key);
+		if (home >= num_slots) {
+			ERR("key hash returned %u which is "
+			    "greater or equal num_buckets(%u)\n",
+			    home, num_slots);
+			opae_free(t);
+			return FPGA_INVALID_PARAM;
+		}
+
+		opae_hash_map_oa_place(t->slots, num_slots, home,
+				       s->key, s->value);
+	}
+
+	t->num_items = old->num_items;
+	opae_free(old);
+	hm->buckets = (opae_hash_map_item **)t;
+	hm->num_buckets = num_slots;
+
+	return FPGA_OK;
+}
+
+// Returns the slot index holding key, or hm->num_buckets if not found.
+STATIC uint32_t opae_hash_map_oa_lookup(opae_hash_map *hm,
+					uint32_t home,
+					void *key)
+{
+	opae_hash_map_slot *slots = opae_hash_map_oa_table(hm)->slots;
+	const uint32_t mask = hm->num_buckets - 1;
+	uint32_t i = home;
+	uint32_t dist = 1;
+
+	// Robin Hood invariant: once we reach a slot whose resident is
+	// closer to home than we are, the key cannot be further along.
+	while (slots[i].dist >= dist) {
+		if (!opae_hash_map_compare(hm, key, slots[i].key))
+			return i;
+		i = (i + 1) & mask;
+		++dist;
+	}
+
+	return hm->num_buckets;
+}
+
+STATIC fpga_result opae_hash_map_oa_add(opae_hash_map *hm,
+					uint32_t home,
+					void *key,
+					void *value)
+{
+	opae_hash_map_table *t = opae_hash_map_oa_table(hm);
+	fpga_result res;
+
+	if (!(hm->flags & OPAE_HASH_MAP_UNIQUE_KEYSPACE)) {
+		uint32_t i = opae_hash_map_oa_lookup(hm, home, key);
+
+		if (i < hm->num_buckets) {
+			// Key collision.
+			if (hm->value_cleanup)
+				hm->value_cleanup(t->slots[i].value,
+						  hm->cleanup_context);
+			t->slots[i].value = value; // Replace value only.
+			return FPGA_OK;
+		}
+	}
+
+	if ((uint64_t)(t->num_items + 1) * 4 >
+	    (uint64_t)hm->num_buckets * 3) {
+		res = opae_hash_map_oa_grow(hm);
+		if (res)
+			return res;
+
+		t = opae_hash_map_oa_table(hm);
+		home = opae_hash_map_home(hm, hm->num_buckets, key);
+		if (home >= hm->num_buckets) {
+			ERR("key hash returned %u which is "
+			    "greater or equal num_buckets(%u)\n",
+			    home, hm->num_buckets);
+			return FPGA_INVALID_PARAM;
+		}
+	}
+
+	opae_hash_map_oa_place(t->slots, hm->num_buckets, home, key, value);
+	++t->num_items;
+
+	return FPGA_OK;
+}
+
+STATIC fpga_result opae_hash_map_oa_remove(opae_hash_map *hm,
+					   uint32_t home,
+					   void *key)
+{
+	opae_hash_map_table *t = opae_hash_map_oa_table(hm);
+	const uint32_t mask = hm->num_buckets - 1;
+	opae_hash_map_slot removed;
+	uint32_t i;
+	uint32_t j;
+
+	i = opae_hash_map_oa_lookup(hm, home, key);
+	if (i >= hm->num_buckets)
+		return FPGA_NOT_FOUND;
+
+	removed = t->slots[i];
+
+	// Backward-shift deletion: pull each displaced follower one slot
+	// closer to its home, so no tombstones are needed.
+	j = (i + 1) & mask;
+	while (t->slots[j].dist > 1) {
+		t->slots[i] = t->slots[j];
+		--t->slots[i].dist;
+		i = j;
+		j = (j + 1) & mask;
+	}
+	t->slots[i].key = NULL;
+	t->slots[i].value = NULL;
+	t->slots[i].dist = 0;
+
+	--t->num_items;
+
+	if (hm->key_cleanup)
+		hm->key_cleanup(removed.key, hm->cleanup_context);
+	if (hm->value_cleanup)
+		hm->value_cleanup(removed.value, hm->cleanup_context);
+
+	return FPGA_OK;
+}
+
 fpga_result opae_hash_map_init(opae_hash_map *hm,
 			       uint32_t num_buckets,
 			       uint32_t hash_seed,
@@ -70,15 +324,22 @@ fpga_result opae_hash_map_init(opae_hash_map *hm,
 
 	memset(hm, 0, sizeof(*hm));
 
-	hm->buckets = (opae_hash_map_item **)
-			opae_calloc(num_buckets,
-				    sizeof(opae_hash_map_item *));
-	if (!hm->buckets) {
-		ERR("calloc() failed");
-		return FPGA_NO_MEMORY;
+	if (flags & OPAE_HASH_MAP_OPEN_ADDRESSING) {
+		fpga_result res = opae_hash_map_oa_init(hm, num_buckets);
+		if (res)
+			return res;
+	} else {
+		hm->buckets = (opae_hash_map_item **)
+				opae_calloc(num_buckets,
+					    sizeof(opae_hash_map_item *));
+		if (!hm->buckets) {
+			ERR("calloc() failed");
+			return FPGA_NO_MEMORY;
+		}
+
+		hm->num_buckets = num_buckets;
 	}
 
-	hm->num_buckets = num_buckets;
 	hm->hash_seed = hash_seed;
 	hm->flags = flags;
 	hm->key_hash = key_hash;
@@ -117,9 +378,7 @@ fpga_result opae_hash_map_add(opae_hash_map *hm,
 		return FPGA_INVALID_PARAM;
 	}
 
-	key_hash = hm->key_hash(hm->num_buckets,
-				hm->hash_seed,
-				key);
+	key_hash = opae_hash_map_home(hm, hm->num_buckets, key);
 
 	if (key_hash >= hm->num_buckets) {
 		ERR("key hash returned %u which is "
@@ -128,6 +387,9 @@ fpga_result opae_hash_map_add(opae_hash_map *hm,
 		return FPGA_INVALID_PARAM;
 	}
 
+	if (opae_hash_map_is_open(hm))
+		return opae_hash_map_oa_add(hm, key_hash, key, value);
+
 	item = opae_hash_map_alloc_item(key, value);
 	if (!item) {
 		ERR("malloc() failed");
@@ -191,9 +453,7 @@ fpga_result opae_hash_map_find(opae_hash_map *hm,
 		return FPGA_INVALID_PARAM;
 	}
 
-	key_hash = hm->key_hash(hm->num_buckets,
-				hm->hash_seed,
-				key);
+	key_hash = opae_hash_map_home(hm, hm->num_buckets, key);
 
 	if (key_hash >= hm->num_buckets) {
 		ERR("key hash returned %u which is "
@@ -202,6 +462,16 @@ fpga_result opae_hash_map_find(opae_hash_map *hm,
 		return FPGA_INVALID_PARAM;
 	}
 
+	if (opae_hash_map_is_open(hm)) {
+		uint32_t i = opae_hash_map_oa_lookup(hm, key_hash, key);
+
+		if (i >= hm->num_buckets)
+			return FPGA_NOT_FOUND;
+		if (value)
+			*value = opae_hash_map_oa_table(hm)->slots[i].value;
+		return FPGA_OK;
+	}
+
 	list = hm->buckets[key_hash];
 
 	while (list) {
@@ -235,9 +505,7 @@ fpga_result opae_hash_map_remove(opae_hash_map *hm,
 		return FPGA_INVALID_PARAM;
 	}
 
-	key_hash = hm->key_hash(hm->num_buckets,
-				hm->hash_seed,
-				key);
+	key_hash = opae_hash_map_home(hm, hm->num_buckets, key);
 
 	if (key_hash >= hm->num_buckets) {
 		ERR("key hash returned %u which is "
@@ -246,6 +514,9 @@ fpga_result opae_hash_map_remove(opae_hash_map *hm,
 		return FPGA_INVALID_PARAM;
 	}
 
+	if (opae_hash_map_is_open(hm))
+		return opae_hash_map_oa_remove(hm, key_hash, key);
+
 	list = hm->buckets[key_hash];
 	if (!list)
 		return FPGA_NOT_FOUND;
@@ -292,6 +563,25 @@ fpga_result opae_hash_map_destroy(opae_hash_map *hm)
 		return FPGA_INVALID_PARAM;
 	}
 
+	if (opae_hash_map_is_open(hm)) {
+		opae_hash_map_table *t = opae_hash_map_oa_table(hm);
+
+		for (i = 0 ; i < hm->num_buckets ; ++i) {
+			opae_hash_map_slot *slot = &t->slots[i];
+			if (!slot->dist)
+				continue;
+			if (hm->key_cleanup)
+				hm->key_cleanup(slot->key, hm->cleanup_context);
+			if (hm->value_cleanup)
+				hm->value_cleanup(slot->value, hm->cleanup_context);
+		}
+
+		opae_free(t);
+		memset(hm, 0, sizeof(*hm));
+
+		return FPGA_OK;
+	}
+
 	for (i = 0 ; i < hm->num_buckets ; ++i) {
 		opae_hash_map_item *item;
 		item = hm->buckets[i];
@@ -317,6 +607,9 @@ bool opae_hash_map_is_empty(opae_hash_map *hm)
 {
 	uint32_t i;
 
+	if (opae_hash_map_is_open(hm))
+		return opae_hash_map_oa_items(hm) == 0;
+
 	for (i = 0 ; i < hm->num_buckets ; ++i) {
 		if (hm->buckets[i])
 			return false;
@@ -334,6 +627,23 @@ uint32_t opae_u64_key_hash(uint32_t num_buckets,
 	return (uint32_t)(ukey % num_buckets);
 }
 
+uint32_t opae_ptr_key_hash(uint32_t num_buckets,
+			   uint32_t hash_seed,
+			   void *key)
+{
+	uint64_t h = (uint64_t)key ^ hash_seed;
+
+	// 64-bit finalizer from MurmurHash3.
+	h ^= h >> 33;
+	h *= UINT64_C(0xff51afd7ed558ccd);
+	h ^= h >> 33;
+	h *= UINT64_C(0xc4ceb9fe1a85ec53);
+	h ^= h >> 33;
+
+	// Map the upper 32 bits onto [0, num_buckets) without a divide.
+	return (uint32_t)(((h >> 32) * num_buckets) >> 32);
+}
+
 inline int opae_u64_key_compare(void *keya, void *keyb)
 {
 	uint64_t a = (uint64_t)keya;
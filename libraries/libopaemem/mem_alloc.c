@@ -67,11 +67,29 @@ void mem_alloc_init(struct mem_alloc *m)
 	m->allocated.next = &m->allocated;
 }
 
+struct mem_alloc_index;
+
+// The address field of the allocated list head is otherwise unused.
+// The indexed engine keeps its state there, leaving the layout of the
+// public struct mem_alloc unchanged. Zero selects the list engine.
+STATIC struct mem_alloc_index *mem_alloc_index(struct mem_alloc *m)
+{
+	return (struct mem_alloc_index *)(uintptr_t)m->allocated.address;
+}
+
+STATIC void mem_index_destroy(struct mem_alloc_index *ix);
+
 void mem_alloc_destroy(struct mem_alloc *m)
 {
 	struct mem_link *p;
 	struct mem_link *trash;
 
+	if (mem_alloc_index(m)) {
+		mem_index_destroy(mem_alloc_index(m));
+		mem_alloc_init(m);
+		return;
+	}
+
 	for (p = m->free.next ; p != &m->free ; ) {
 		trash = p;
 		p = p->next;
@@ -122,6 +140,455 @@ static inline void link_unlink(struct mem_link *x)
 	x->prev->next = x->next;
 }
 
+/*
+ * Indexed engine (MEM_ALLOC_INDEXED)
+ *
+ * Free blocks remain on the address-ordered m->free list, so code that
+ * walks the list (eg mem_alloc_apply_constraint()) works for either
+ * engine. Each free block is also a node in an AVL tree keyed by address
+ * and augmented with the largest block size in its subtree, which finds
+ * the lowest-addressed fit and the coalescing neighbors in O(log n).
+ * Allocated blocks are kept in a second AVL tree keyed by address.
+ * Nodes are carved from slabs and recycled through a spare list.
+ */
+
+struct mem_node {
+	struct mem_link link; // Must be first.
+	struct mem_node *left;
+	struct mem_node *right;
+	uint64_t max_size;
+	int height;
+};
+
+#define MEM_NODE_SLAB_COUNT 256
+
+struct mem_node_slab {
+	struct mem_node_slab *next;
+	struct mem_node nodes[MEM_NODE_SLAB_COUNT];
+};
+
+struct mem_alloc_index {
+	struct mem_node *free_root;
+	struct mem_node *alloc_root;
+	struct mem_node *spare;
+	struct mem_node_slab *slabs;
+};
+
+STATIC struct mem_node *mem_node_alloc(struct mem_alloc_index *ix,
+				       uint64_t address,
+				       uint64_t size)
+{
+	struct mem_node *n;
+	int i;
+
+	if (!ix->spare) {
+		struct mem_node_slab *slab;
+
+		slab = opae_malloc(sizeof(struct mem_node_slab));
+		if (!slab)
+			return NULL;
+
+		slab->next = ix->slabs;
+		ix->slabs = slab;
+
+		for (i = 0 ; i < MEM_NODE_SLAB_COUNT ; ++i) {
+			slab->nodes[i].left = ix->spare;
+			ix->spare = &slab->nodes[i];
+		}
+	}
+
+	n = ix->spare;
+	ix->spare = n->left;
+
+	n->link.address = address;
+	n->link.size = size;
+	n->link.prev = &n->link;
+	n->link.next = &n->link;
+	n->left = NULL;
+	n->right = NULL;
+	n->max_size = size;
+	n->height = 1;
+
+	return n;
+}
+
+static inline void mem_node_free(struct mem_alloc_index *ix,
+				 struct mem_node *n)
+{
+	n->left = ix->spare;
+	ix->spare = n;
+}
+
+STATIC void mem_index_destroy(struct mem_alloc_index *ix)
+{
+	struct mem_node_slab *slab;
+
+	for (slab = ix->slabs ; slab ; ) {
+		struct mem_node_slab *trash = slab;
+		slab = slab->next;
+		opae_free(trash);
+	}
+
+	opae_free(ix);
+}
+
+static inline int mem_node_height(const struct mem_node *n)
+{
+	return n ? n->height : 0;
+}
+
+static inline uint64_t mem_node_max(const struct mem_node *n)
+{
+	return n ? n->max_size : 0;
+}
+
+static inline void mem_node_update(struct mem_node *n)
+{
+	int hl = mem_node_height(n->left);
+	int hr = mem_node_height(n->right);
+	uint64_t ml = mem_node_max(n->left);
+	uint64_t mr = mem_node_max(n->right);
+
+	n->height = 1 + ((hl > hr) ? hl : hr);
+
+	n->max_size = n->link.size;
+	if (ml > n->max_size)
+		n->max_size = ml;
+	if (mr > n->max_size)
+		n->max_size = mr;
+}
+
+static struct mem_node *mem_node_rotate_right(struct mem_node *n)
+{
+	struct mem_node *l = n->left;
+
+	n->left = l->right;
+	l->right = n;
+	mem_node_update(n);
+	mem_node_update(l);
+
+	return l;
+}
+
+static struct mem_node *mem_node_rotate_left(struct mem_node *n)
+{
+	struct mem_node *r = n->right;
+
+	n->right = r->left;
+	r->left = n;
+	mem_node_update(n);
+	mem_node_update(r);
+
+	return r;
+}
+
+static struct mem_node *mem_node_balance(struct mem_node *n)
+{
+	int balance;
+
+	mem_node_update(n);
+	balance = mem_node_height(n->left) - mem_node_height(n->right);
+
+	if (balance > 1) {
+		if (mem_node_height(n->left->left) <
+		    mem_node_height(n->left->right))
+			n->left = mem_node_rotate_left(n->left);
+		return mem_node_rotate_right(n);
+	}
+
+	if (balance < -1) {
+		if (mem_node_height(n->right->right) <
+		    mem_node_height(n->right->left))
+			n->right = mem_node_rotate_right(n->right);
+		return mem_node_rotate_left(n);
+	}
+
+	return n;
+}
+
+STATIC struct mem_node *mem_node_insert(struct mem_node *root,
+					struct mem_node *n)
+{
+	if (!root) {
+		n->left = NULL;
+		n->right = NULL;
+		mem_node_update(n);
+		return n;
+	}
+
+	if (n->link.address < root->link.address)
+		root->left = mem_node_insert(root->left, n);
+	else
+		root->right = mem_node_insert(root->right, n);
+
+	return mem_node_balance(root);
+}
+
+static struct mem_node *mem_node_remove_min(struct mem_node *root,
+					    struct mem_node **min)
+{
+	if (!root->left) {
+		*min = root;
+		return root->right;
+	}
+
+	root->left = mem_node_remove_min(root->left, min);
+	return mem_node_balance(root);
+}
+
+STATIC struct mem_node *mem_node_remove(struct mem_node *root,
+					uint64_t address,
+					struct mem_node **removed)
+{
+	struct mem_node *min = NULL;
+
+	if (!root)
+		return NULL;
+
+	if (address < root->link.address) {
+		root->left = mem_node_remove(root->left, address, removed);
+	} else if (address > root->link.address) {
+		root->right = mem_node_remove(root->right, address, removed);
+	} else {
+		*removed = root;
+
+		if (!root->left)
+			return root->right;
+		if (!root->right)
+			return root->left;
+
+		root->right = mem_node_remove_min(root->right, &min);
+		min->left = root->left;
+		min->right = root->right;
+		root = min;
+	}
+
+	return mem_node_balance(root);
+}
+
+/*
+ * Recompute the subtree maxima on the path to the node at address,
+ * after that node's size changed or its address moved without
+ * crossing a neighbor. The tree shape is unchanged.
+ */
+static struct mem_node *mem_node_refresh(struct mem_node *root,
+					 uint64_t address)
+{
+	if (!root)
+		return NULL;
+
+	if (address < root->link.address)
+		root->left = mem_node_refresh(root->left, address);
+	else if (address > root->link.address)
+		root->right = mem_node_refresh(root->right, address);
+
+	mem_node_update(root);
+	return root;
+}
+
+// The node with the greatest address that is <= address.
+static struct mem_node *mem_node_floor(struct mem_node *root,
+				       uint64_t address)
+{
+	struct mem_node *floor = NULL;
+
+	while (root) {
+		if (address < root->link.address) {
+			root = root->left;
+		} else {
+			floor = root;
+			root = root->right;
+		}
+	}
+
+	return floor;
+}
+
+// The lowest-addressed node that can hold a size-aligned block of size.
+STATIC struct mem_node *mem_node_first_fit(struct mem_node *root,
+					   uint64_t size)
+{
+	struct mem_node *fit;
+
+	if (!root || (root->max_size < size))
+		return NULL;
+
+	fit = mem_node_first_fit(root->left, size);
+	if (fit)
+		return fit;
+
+	if ((ALIGNED(root->link.address, size) + size) <=
+	    (root->link.address + root->link.size))
+		return root;
+
+	return mem_node_first_fit(root->right, size);
+}
+
+STATIC int mem_index_add_free(struct mem_alloc *m,
+			      uint64_t address,
+			      uint64_t size)
+{
+	struct mem_alloc_index *ix = mem_alloc_index(m);
+	struct mem_node *pred;
+	struct mem_node *succ = NULL;
+	struct mem_node *removed = NULL;
+	struct mem_link *next;
+	struct mem_node *n;
+
+	pred = mem_node_floor(ix->free_root, address);
+	if (pred && (pred->link.address == address)) {
+		ERR("double free detected 0x%lx\n", address);
+		return 2;
+	}
+
+	next = pred ? pred->link.next : m->free.next;
+	if (next != &m->free)
+		succ = (struct mem_node *)next;
+
+	if (succ && (address + size != succ->link.address))
+		succ = NULL;
+
+	if (pred && (pred->link.address + pred->link.size == address)) {
+		pred->link.size += size;
+
+		if (succ) {
+			ix->free_root = mem_node_remove(ix->free_root,
+							succ->link.address,
+							&removed);
+			pred->link.size += succ->link.size;
+			link_unlink(&succ->link);
+			mem_node_free(ix, succ);
+		}
+
+		ix->free_root = mem_node_refresh(ix->free_root,
+						 pred->link.address);
+		return 0;
+	}
+
+	if (succ) {
+		succ->link.address = address;
+		succ->link.size += size;
+		ix->free_root = mem_node_refresh(ix->free_root, address);
+		return 0;
+	}
+
+	n = mem_node_alloc(ix, address, size);
+	if (!n) {
+		ERR("malloc() failed\n");
+		return 1;
+	}
+
+	link_after(&n->link, pred ? &pred->link : &m->free);
+	ix->free_root = mem_node_insert(ix->free_root, n);
+
+	return 0;
+}
+
+STATIC int mem_index_get(struct mem_alloc *m,
+			 uint64_t *address,
+			 uint64_t size)
+{
+	struct mem_alloc_index *ix = mem_alloc_index(m);
+	struct mem_node *n;
+	struct mem_node *a;
+	struct mem_node *tail = NULL;
+	struct mem_node *removed = NULL;
+	uint64_t aligned_addr;
+	uint64_t tail_size;
+
+	n = mem_node_first_fit(ix->free_root, size);
+	if (!n) {
+		ERR("no free block of sufficient size found\n");
+		return 1; // Out of memory.
+	}
+
+	aligned_addr = ALIGNED(n->link.address, size);
+	tail_size = (n->link.address + n->link.size) - (aligned_addr + size);
+
+	if ((aligned_addr == n->link.address) && !tail_size) {
+		// Exact fit: move the node to the allocated tree.
+		ix->free_root = mem_node_remove(ix->free_root,
+						n->link.address,
+						&removed);
+		link_unlink(&n->link);
+		a = n;
+	} else {
+		a = mem_node_alloc(ix, aligned_addr, size);
+		if (!a) {
+			ERR("malloc() failed\n");
+			return 1;
+		}
+
+		if (aligned_addr == n->link.address) {
+			n->link.address += size;
+			n->link.size -= size;
+		} else {
+			if (tail_size) {
+				tail = mem_node_alloc(ix,
+						      aligned_addr + size,
+						      tail_size);
+				if (!tail) {
+					ERR("malloc() failed\n");
+					mem_node_free(ix, a);
+					return 1;
+				}
+			}
+			n->link.size = aligned_addr - n->link.address;
+		}
+
+		ix->free_root = mem_node_refresh(ix->free_root,
+						 n->link.address);
+
+		if (tail) {
+			link_after(&tail->link, &n->link);
+			ix->free_root = mem_node_insert(ix->free_root, tail);
+		}
+	}
+
+	a->link.prev = &a->link;
+	a->link.next = &a->link;
+	ix->alloc_root = mem_node_insert(ix->alloc_root, a);
+
+	*address = aligned_addr;
+	return 0;
+}
+
+STATIC int mem_index_put(struct mem_alloc *m, uint64_t address)
+{
+	struct mem_alloc_index *ix = mem_alloc_index(m);
+	struct mem_node *n = NULL;
+	uint64_t size;
+
+	ix->alloc_root = mem_node_remove(ix->alloc_root, address, &n);
+	if (!n) {
+		ERR("attempt to free non-allocated 0x%lx\n", address);
+		return 1; // Address not found.
+	}
+
+	size = n->link.size;
+	mem_node_free(ix, n);
+
+	return mem_index_add_free(m, address, size);
+}
+
+int mem_alloc_init_ex(struct mem_alloc *m, int flags)
+{
+	mem_alloc_init(m);
+
+	if (flags & MEM_ALLOC_INDEXED) {
+		struct mem_alloc_index *ix;
+
+		ix = opae_calloc(1, sizeof(struct mem_alloc_index));
+		if (!ix) {
+			ERR("calloc() failed\n");
+			return 1;
+		}
+		m->allocated.address = (uint64_t)(uintptr_t)ix;
+	}
+
+	return 0;
+}
+
 STATIC void mem_alloc_coalesce(struct mem_link *head,
 			       struct mem_link *l)
 {
@@ -156,6 +623,9 @@ int mem_alloc_add_free(struct mem_alloc *m, uint64_t address, uint64_t size)
 	struct mem_link *node;
 	struct mem_link *p;
 
+	if (mem_alloc_index(m))
+		return mem_index_add_free(m, address, size);
+
 	node = mem_link_alloc(address, size);
 	if (!node) {
 		ERR("malloc() failed\n");
@@ -287,6 +757,9 @@ int mem_alloc_get(struct mem_alloc *m, uint64_t *address, uint64_t size)
 {
 	struct mem_link *p;
 
+	if (mem_alloc_index(m))
+		return mem_index_get(m, address, size);
+
 	for (p = m->free.next ; p != &m->free ; p = p->next) {
 		uint64_t aligned_addr = ALIGNED(p->address, size);
 		if ((aligned_addr + size) <= (p->address + p->size)) { // First fit.
@@ -327,6 +800,9 @@ int mem_alloc_put(struct mem_alloc *m, uint64_t address)
 {
 	struct mem_link *p;
 
+	if (mem_alloc_index(m))
+		return mem_index_put(m, address);
+
 	for (p = m->allocated.next ; p != &m->allocated ; p = p->next) {
 		if (address == p->address) {
 			return mem_alloc_free_node(m, p);
@@ -383,6 +859,48 @@ STATIC int mem_alloc_drop_free_region(struct mem_alloc *m,
 	return 0;
 }
 
+// mem_alloc_apply_constraint() for the indexed engine.
+STATIC int mem_index_apply_constraint(struct mem_alloc *m,
+				      struct mem_alloc *m_constr)
+{
+	struct mem_alloc_index *ix = mem_alloc_index(m);
+	struct mem_alloc tmp;
+	struct mem_link *p;
+	int r;
+
+	// Apply the constraint to a list-engine copy of the free set,
+	// then rebuild the index from the result.
+	mem_alloc_init(&tmp);
+	for (p = m->free.next ; p != &m->free ; p = p->next) {
+		r = mem_alloc_add_free(&tmp, p->address, p->size);
+		if (r)
+			goto out_destroy;
+	}
+
+	r = mem_alloc_apply_constraint(&tmp, m_constr);
+	if (r)
+		goto out_destroy;
+
+	for (p = m->free.next ; p != &m->free ; ) {
+		struct mem_node *n = (struct mem_node *)p;
+		p = p->next;
+		mem_node_free(ix, n);
+	}
+	m->free.prev = &m->free;
+	m->free.next = &m->free;
+	ix->free_root = NULL;
+
+	for (p = tmp.free.next ; p != &tmp.free ; p = p->next) {
+		r = mem_index_add_free(m, p->address, p->size);
+		if (r)
+			break;
+	}
+
+out_destroy:
+	mem_alloc_destroy(&tmp);
+	return r;
+}
+
 // Walk the free list m_constr and remove any ranges NOT in m_constr from
 // the free list in m. This guarantees that all free addresses in m are
 // also present in m_constr.
@@ -394,6 +912,9 @@ int mem_alloc_apply_constraint(struct mem_alloc *m, struct mem_alloc *m_constr)
 	if ((m == NULL) || (m_constr == NULL))
 		return 1;
 
+	if (mem_alloc_index(m))
+		return mem_index_apply_constraint(m, m_constr);
+
 	if (m_constr->free.next->address != 0) {
 		// First constraint region does not start at 0. Drop from
 		// 0 to start address.
@@ -1173,25 +1173,31 @@ STATIC int opae_vfio_init(struct opae_vfio *v,
 	v->group.group_fd = -1;
 	v->device.device_fd = -1;
 
-	mem_alloc_init(&v->iova_alloc);
+	if (mem_alloc_init_ex(&v->iova_alloc, MEM_ALLOC_INDEXED)) {
+		ERR("mem_alloc_init_ex()\n");
+		return 12;
+	}
 
 	result = opae_hash_map_init(&v->cont_buffers,
-				    19441, // num_buckets
+				    64,    // initial slots (grows on demand)
 				    0,     // hash_seed
-				    OPAE_HASH_MAP_UNIQUE_KEYSPACE,
-				    opae_u64_key_hash,
+				    OPAE_HASH_MAP_UNIQUE_KEYSPACE |
+				    OPAE_HASH_MAP_OPEN_ADDRESSING,
+				    opae_ptr_key_hash,
 				    opae_u64_key_compare,
 				    NULL,  // key_cleanup
 				    opae_vfio_value_cleanup);
 	if (result) {
 		ERR("opae_hash_map_init()\n");
-		return 11;
+		res = 11;
+		goto out_destroy_alloc;
 	}
 	v->cont_buffers.cleanup_context = v;
 
 	if (pthread_mutexattr_init(&mattr)) {
 		ERR("pthread_mutexattr_init()\n");
-		return 1;
+		res = 1;
+		goto out_destroy_map;
 	}
 
 	if (pthread_mutexattr_settype(&mattr, PTHREAD_MUTEX_RECURSIVE)) {
@@ -1264,15 +1270,29 @@ STATIC int opae_vfio_init(struct opae_vfio *v,
 	return 0;
 
 out_destroy_container:
+	// opae_vfio_destroy() also releases cont_buffers and iova_alloc.
 	pthread_mutex_lock(&v->lock);
 	opae_vfio_destroy(v);
 
+	if (pthread_mutexattr_destroy(&mattr)) {
+		ERR("pthread_mutexattr_destroy()\n");
+		res = 10;
+	}
+
+	return res;
+
 out_destroy_attr:
 	if (pthread_mutexattr_destroy(&mattr)) {
 		ERR("pthread_mutexattr_destroy()\n");
 		res = 10;
 	}
 
+out_destroy_map:
+	opae_hash_map_destroy(&v->cont_buffers);
+
+out_destroy_alloc:
+	mem_alloc_destroy(&v->iova_alloc);
+
 	return res;
 }
 
@@ -53,6 +53,7 @@
 #include "dfl.h"
 
 #include "opae_int.h"
+#include "mmio-batch.h"
 #include "props.h"
 #include "cfg-file.h"
 #include "mock/opae_std.h"
@@ -1120,6 +1121,104 @@ out_unlock:
 	return res;
 }
 
+fpga_result __UIO_API__ uio_fpgaReadMMIOBatch(fpga_handle handle,
+					      uint32_t mmio_num,
+					      fpga_mmio_op *ops,
+					      uint32_t num_ops)
+{
+	uio_handle *h;
+	uio_token *t;
+	uint32_t user_mmio;
+	fpga_result res = FPGA_OK;
+	int err;
+
+	if (!num_ops)
+		return FPGA_OK;
+	ASSERT_NOT_NULL(ops);
+
+	h = handle_check_and_lock(handle);
+	ASSERT_NOT_NULL(h);
+
+	t = h->token;
+
+	if (t->hdr.objtype == FPGA_DEVICE) {
+		res = FPGA_NOT_SUPPORTED;
+		goto out_unlock;
+	}
+
+	if (mmio_num >= USER_MMIO_MAX) {
+		res = FPGA_INVALID_PARAM;
+		goto out_unlock;
+	}
+
+	user_mmio = t->user_mmio[mmio_num];
+	if (user_mmio > h->mmio_size) {
+		res = FPGA_INVALID_PARAM;
+		goto out_unlock;
+	}
+
+	res = opae_mmio_batch_check(ops, num_ops, h->mmio_size - user_mmio);
+	if (res) {
+		OPAE_ERR("Invalid MMIO batch descriptor");
+		goto out_unlock;
+	}
+
+	opae_mmio_batch_read(get_user_offset(h, mmio_num, 0), ops, num_ops);
+
+out_unlock:
+	opae_mutex_unlock(err, &h->lock);
+	return res;
+}
+
+fpga_result __UIO_API__ uio_fpgaWriteMMIOBatch(fpga_handle handle,
+					       uint32_t mmio_num,
+					       const fpga_mmio_op *ops,
+					       uint32_t num_ops)
+{
+	uio_handle *h;
+	uio_token *t;
+	uint32_t user_mmio;
+	fpga_result res = FPGA_OK;
+	int err;
+
+	if (!num_ops)
+		return FPGA_OK;
+	ASSERT_NOT_NULL(ops);
+
+	h = handle_check_and_lock(handle);
+	ASSERT_NOT_NULL(h);
+
+	t = h->token;
+
+	if (t->hdr.objtype == FPGA_DEVICE) {
+		res = FPGA_NOT_SUPPORTED;
+		goto out_unlock;
+	}
+
+	if (mmio_num >= USER_MMIO_MAX) {
+		res = FPGA_INVALID_PARAM;
+		goto out_unlock;
+	}
+
+	user_mmio = t->user_mmio[mmio_num];
+	if (user_mmio > h->mmio_size) {
+		res = FPGA_INVALID_PARAM;
+		goto out_unlock;
+	}
+
+	res = opae_mmio_batch_check(ops, num_ops, h->mmio_size - user_mmio);
+	if (res) {
+		OPAE_ERR("Invalid MMIO batch descriptor");
+		goto out_unlock;
+	}
+
+	opae_mmio_batch_write(get_user_offset(h, mmio_num, 0), ops, num_ops);
+
+out_unlock:
+	opae_mutex_unlock(err, &h->lock);
+	return res;
+}
+
 fpga_result __UIO_API__ uio_fpgaMapMMIO(fpga_handle handle,
 					uint32_t mmio_num,
 					uint64_t **mmio_ptr)
@@ -54,6 +54,7 @@
 #include "fpga-dfl.h"
 
 #include "opae_int.h"
+#include "mmio-batch.h"
 #include "props.h"
 #include "cfg-file.h"
 #include "mock/opae_std.h"
@@ -673,6 +674,191 @@ close:
 	return res;
 }
 
+#define HUGE_1G (1*1024*1024*1024)
+#define HUGE_2M (2*1024*1024)
+#define ROUND_UP(N, M) ((N + M - 1) & ~(M-1))
+
+#define VFIO_POOL_MIN_ALLOC 4096
+
+STATIC void vfio_pool_buffer_cleanup(void *value, void *context)
+{
+	UNUSED_PARAM(context);
+	opae_free(value);
+}
+
+STATIC vfio_buffer_pool *vfio_pool_create(void)
+{
+	vfio_buffer_pool *pool;
+
+	pool = opae_calloc(1, sizeof(vfio_buffer_pool));
+	if (!pool) {
+		OPAE_ERR("calloc() failed");
+		return NULL;
+	}
+
+	if (opae_hash_map_init(&pool->buffers,
+			       64,   // initial slots (grows on demand)
+			       0,    // hash_seed
+			       OPAE_HASH_MAP_UNIQUE_KEYSPACE |
+			       OPAE_HASH_MAP_OPEN_ADDRESSING,
+			       opae_ptr_key_hash,
+			       opae_u64_key_compare,
+			       NULL, // key_cleanup
+			       vfio_pool_buffer_cleanup)) {
+		OPAE_ERR("opae_hash_map_init() failed");
+		opae_free(pool);
+		return NULL;
+	}
+
+	pool->arena_size = vfio_buffer_pool_arena_size;
+
+	return pool;
+}
+
+/*
+ * Release the pool's bookkeeping and each of its arenas. Sub-buffers
+ * that are still outstanding become invalid when their arena is freed.
+ */
+STATIC void vfio_pool_destroy(vfio_buffer_pool *pool, struct opae_vfio *v)
+{
+	vfio_buffer_arena *a;
+
+	opae_hash_map_destroy(&pool->buffers);
+
+	for (a = pool->arenas ; a ; ) {
+		vfio_buffer_arena *trash = a;
+		a = a->next;
+
+		mem_alloc_destroy(&trash->alloc);
+		if (v && opae_vfio_buffer_free(v, trash->virt))
+			OPAE_ERR("error freeing vfio buffer arena");
+		opae_free(trash);
+	}
+
+	opae_free(pool);
+}
+
+STATIC vfio_buffer_arena *vfio_pool_add_arena(vfio_buffer_pool *pool,
+					      struct opae_vfio *v)
+{
+	vfio_buffer_arena *a;
+	size_t sz = pool->arena_size;
+
+	if (pool->num_arenas >= vfio_buffer_pool_max_arenas)
+		return NULL;
+
+	a = opae_calloc(1, sizeof(vfio_buffer_arena));
+	if (!a) {
+		OPAE_ERR("calloc() failed");
+		return NULL;
+	}
+
+	if (opae_vfio_buffer_allocate_ex(v, &sz, &a->virt, &a->iova, 0)) {
+		OPAE_DBG("could not allocate buffer arena");
+		opae_free(a);
+		return NULL;
+	}
+
+	a->size = sz;
+	if (mem_alloc_init_ex(&a->alloc, MEM_ALLOC_INDEXED) ||
+	    mem_alloc_add_free(&a->alloc, 0, sz)) {
+		OPAE_ERR("arena allocator init failed");
+		mem_alloc_destroy(&a->alloc);
+		if (opae_vfio_buffer_free(v, a->virt))
+			OPAE_ERR("error freeing vfio buffer arena");
+		opae_free(a);
+		return NULL;
+	}
+
+	a->next = pool->arenas;
+	pool->arenas = a;
+	++pool->num_arenas;
+
+	return a;
+}
+
+/*
+ * Carve a sub-buffer out of the first arena that can hold it, growing
+ * the pool by one arena when none can. Sizes are rounded to a power of
+ * two so that mem_alloc_get() returns naturally-aligned offsets.
+ */
+STATIC struct opae_vfio_buffer *vfio_pool_alloc(vfio_buffer_pool *pool,
+						struct opae_vfio *v,
+						uint64_t len)
+{
+	vfio_buffer_arena *a;
+	struct opae_vfio_buffer *binfo;
+	uint64_t sz = VFIO_POOL_MIN_ALLOC;
+	uint64_t offset = 0;
+
+	while (sz < len)
+		sz <<= 1;
+
+	for (a = pool->arenas ; a ; a = a->next) {
+		if ((sz <= a->size) && !mem_alloc_get(&a->alloc, &offset, sz))
+			break;
+	}
+
+	if (!a) {
+		a = vfio_pool_add_arena(pool, v);
+		if (!a || (sz > a->size) ||
+		    mem_alloc_get(&a->alloc, &offset, sz))
+			return NULL;
+	}
+
+	binfo = opae_calloc(1, sizeof(struct opae_vfio_buffer));
+	if (!binfo) {
+		OPAE_ERR("calloc() failed");
+		goto out_put;
+	}
+
+	binfo->buffer_ptr = a->virt + offset;
+	binfo->buffer_size = sz;
+	binfo->buffer_iova = a->iova + offset;
+
+	if (opae_hash_map_add(&pool->buffers, binfo->buffer_ptr, binfo)) {
+		OPAE_ERR("opae_hash_map_add() failed");
+		opae_free(binfo);
+		goto out_put;
+	}
+
+	return binfo;
+
+out_put:
+	mem_alloc_put(&a->alloc, offset);
+	return NULL;
+}
+
+/*
+ * Return a sub-buffer to its arena. Returns non-zero when binfo was
+ * not allocated from the pool.
+ */
+STATIC int vfio_pool_free(vfio_buffer_pool *pool,
+			  struct opae_vfio_buffer *binfo)
+{
+	vfio_buffer_arena *a;
+	struct opae_vfio_buffer *found = NULL;
+
+	if (opae_hash_map_find(&pool->buffers, binfo->buffer_ptr,
+			       (void **)&found) || (found != binfo))
+		return 1;
+
+	for (a = pool->arenas ; a ; a = a->next) {
+		if ((binfo->buffer_ptr >= a->virt) &&
+		    (binfo->buffer_ptr < a->virt + a->size))
+			break;
+	}
+
+	if (!a || mem_alloc_put(&a->alloc, binfo->buffer_ptr - a->virt)) {
+		OPAE_ERR("pool buffer %p has no arena", binfo->buffer_ptr);
+		return 2;
+	}
+
+	opae_hash_map_remove(&pool->buffers, binfo->buffer_ptr);
+
+	return 0;
+}
+
 fpga_result __VFIO_API__ vfio_fpgaOpen(fpga_token token, fpga_handle *handle, int flags)
 {
 	fpga_result res = FPGA_EXCEPTION;
@@ -743,6 +929,14 @@ fpga_result __VFIO_API__ vfio_fpgaOpen(fpga_token token, fpga_handle *handle, in
 #endif // GCC_VERSION
 #endif // x86
 
+	if (vfio_buffer_pool_enabled) {
+		_handle->pool = vfio_pool_create();
+		if (!_handle->pool) {
+			res = FPGA_NO_MEMORY;
+			goto out_attr_destroy;
+		}
+	}
+
 	if (_handle->parent_afu) {
 		if (opae_vfio_apply_group_constraint(
 				_handle->vfio_pair->device,
@@ -761,6 +955,8 @@ out_attr_destroy:
 	pthread_mutexattr_destroy(&mattr);
 	if (res && _handle) {
 		pthread_mutex_destroy(&_handle->lock);
+		if (_handle->pool)
+			vfio_pool_destroy(_handle->pool, NULL);
 		if (_handle->vfio_pair)
 			close_vfio_pair(&_handle->vfio_pair);
 		if (_handle->token) {
@@ -798,6 +994,12 @@ fpga_result __VFIO_API__ vfio_fpgaClose(fpga_handle handle)
 		h->flags &= ~(OPAE_FLAG_SVA_FD_VALID | OPAE_FLAG_PASID_VALID);
 	}
 
+	if (h->pool) {
+		vfio_pool_destroy(h->pool,
+				  h->vfio_pair ? h->vfio_pair->device : NULL);
+		h->pool = NULL;
+	}
+
 	close_vfio_pair(&h->vfio_pair);
 
 	if (pthread_mutex_unlock(&h->lock) ||
@@ -1188,6 +1390,104 @@ out_unlock:
 	return res;
 }
 
+fpga_result __VFIO_API__ vfio_fpgaReadMMIOBatch(fpga_handle handle,
+					      uint32_t mmio_num,
+					      fpga_mmio_op *ops,
+					      uint32_t num_ops)
+{
+	vfio_handle *h;
+	vfio_token *t;
+	uint32_t user_mmio;
+	fpga_result res = FPGA_OK;
+	int err;
+
+	if (!num_ops)
+		return FPGA_OK;
+	ASSERT_NOT_NULL(ops);
+
+	h = handle_check_and_lock(handle);
+	ASSERT_NOT_NULL(h);
+
+	t = h->token;
+
+	if (t->hdr.objtype == FPGA_DEVICE) {
+		res = FPGA_NOT_SUPPORTED;
+		goto out_unlock;
+	}
+
+	if (mmio_num >= USER_MMIO_MAX) {
+		res = FPGA_INVALID_PARAM;
+		goto out_unlock;
+	}
+
+	user_mmio = t->user_mmio[mmio_num];
+	if (user_mmio > h->mmio_size) {
+		res = FPGA_INVALID_PARAM;
+		goto out_unlock;
+	}
+
+	res = opae_mmio_batch_check(ops, num_ops, h->mmio_size - user_mmio);
+	if (res) {
+		OPAE_ERR("Invalid MMIO batch descriptor");
+		goto out_unlock;
+	}
+
+	opae_mmio_batch_read(get_user_offset(h, mmio_num, 0), ops, num_ops);
+
+out_unlock:
+	opae_mutex_unlock(err, &h->lock);
+	return res;
+}
+
+fpga_result __VFIO_API__ vfio_fpgaWriteMMIOBatch(fpga_handle handle,
+					       uint32_t mmio_num,
+					       const fpga_mmio_op *ops,
+					       uint32_t num_ops)
+{
+	vfio_handle *h;
+	vfio_token *t;
+	uint32_t user_mmio;
+	fpga_result res = FPGA_OK;
+	int err;
+
+	if (!num_ops)
+		return FPGA_OK;
+	ASSERT_NOT_NULL(ops);
+
+	h = handle_check_and_lock(handle);
+	ASSERT_NOT_NULL(h);
+
+	t = h->token;
+
+	if (t->hdr.objtype == FPGA_DEVICE) {
+		res = FPGA_NOT_SUPPORTED;
+		goto out_unlock;
+	}
+
+	if (mmio_num >= USER_MMIO_MAX) {
+		res = FPGA_INVALID_PARAM;
+		goto out_unlock;
+	}
+
+	user_mmio = t->user_mmio[mmio_num];
+	if (user_mmio > h->mmio_size) {
+		res = FPGA_INVALID_PARAM;
+		goto out_unlock;
+	}
+
+	res = opae_mmio_batch_check(ops, num_ops, h->mmio_size - user_mmio);
+	if (res) {
+		OPAE_ERR("Invalid MMIO batch descriptor");
+		goto out_unlock;
+	}
+
+	opae_mmio_batch_write(get_user_offset(h, mmio_num, 0), ops, num_ops);
+
+out_unlock:
+	opae_mutex_unlock(err, &h->lock);
+	return res;
+}
+
 fpga_result __VFIO_API__ vfio_fpgaMapMMIO(fpga_handle handle,
 					  uint32_t mmio_num,
 					  uint64_t **mmio_ptr)
@@ -1490,10 +1790,6 @@ fpga_result __VFIO_API__ vfio_fpgaDestroyToken(fpga_token *token)
 	return FPGA_INVALID_PARAM;
 }
 
-#define HUGE_1G (1*1024*1024*1024)
-#define HUGE_2M (2*1024*1024)
-#define ROUND_UP(N, M) ((N + M - 1) & ~(M-1))
-
 fpga_result __VFIO_API__ vfio_fpgaPrepareBuffer(fpga_handle handle,
 						uint64_t len,
 						void **buf_addr,
@@ -1530,6 +1826,23 @@ fpga_result __VFIO_API__ vfio_fpgaPrepareBuffer(fpga_handle handle,
 	struct opae_vfio *v = h->vfio_pair->device;
 	uint64_t iova = 0;
 	size_t sz;
+	int err;
+
+	if (h->pool && !(flags & FPGA_BUF_PREALLOCATED) &&
+	    (len <= h->pool->arena_size / 4)) {
+		if (opae_mutex_lock(err, &h->lock))
+			return FPGA_EXCEPTION;
+		binfo = vfio_pool_alloc(h->pool, v, len);
+		opae_mutex_unlock(err, &h->lock);
+
+		if (binfo) {
+			*buf_addr = binfo->buffer_ptr;
+			*wsid = (uint64_t)binfo;
+			return FPGA_OK;
+		}
+		OPAE_DBG("buffer pool exhausted, allocating directly");
+	}
+
 	if (len > HUGE_2M)
 		sz = ROUND_UP(len, HUGE_1G);
 	else if (len > 4096)
@@ -1577,6 +1890,19 @@ fpga_result __VFIO_API__ vfio_fpgaReleaseBuffer(fpga_handle handle,
 
 	ASSERT_NOT_NULL(binfo);
 
+	if (h->pool) {
+		int err;
+		int not_pooled;
+
+		if (opae_mutex_lock(err, &h->lock))
+			return FPGA_EXCEPTION;
+		not_pooled = vfio_pool_free(h->pool, binfo);
+		opae_mutex_unlock(err, &h->lock);
+
+		if (!not_pooled)
+			return FPGA_OK;
+	}
+
 	if (opae_vfio_buffer_free(v, binfo->buffer_ptr)) {
 		OPAE_ERR("error freeing vfio buffer");
 		res = FPGA_NOT_FOUND;
@@ -92,6 +92,31 @@ typedef struct _vfio_pair {
 	struct opae_vfio *physfn;
 } vfio_pair_t;
 
+/*
+ * A hugepage region that is allocated and IOMMU-mapped once, then
+ * carved into sub-buffers by fpgaPrepareBuffer(). alloc tracks
+ * offsets from the start of the arena.
+ */
+typedef struct _vfio_buffer_arena {
+	uint8_t *virt;
+	uint64_t iova;
+	size_t size;
+	struct mem_alloc alloc;
+	struct _vfio_buffer_arena *next;
+} vfio_buffer_arena;
+
+/*
+ * Per-handle DMA buffer pool. buffers maps the virtual address of
+ * each outstanding sub-buffer to its struct opae_vfio_buffer.
+ * arena_size is the size of each arena, latched at pool creation.
+ */
+typedef struct _vfio_buffer_pool {
+	vfio_buffer_arena *arenas;
+	uint32_t num_arenas;
+	size_t arena_size;
+	opae_hash_map buffers;
+} vfio_buffer_pool;
+
 typedef struct _vfio_handle {
 	uint32_t magic;
 	vfio_token *token;
@@ -102,6 +127,7 @@ typedef struct _vfio_handle {
 	pthread_mutex_t lock;
 	int sva_fd;
 	int pasid;
+	vfio_buffer_pool *pool;
 #define OPAE_FLAG_HAS_AVX512 (1u << 0)
 #define OPAE_FLAG_SVA_FD_VALID (1u << 1)  // Indicates sva_fd file handle is valid
 #define OPAE_FLAG_PASID_VALID (1u << 2)   // Indicates pasid is set
@@ -115,6 +141,10 @@ typedef struct _vfio_event_handle {
 	uint32_t flags;
 } vfio_event_handle;
 
+extern bool vfio_buffer_pool_enabled;
+extern uint64_t vfio_buffer_pool_arena_size;
+extern uint32_t vfio_buffer_pool_max_arenas;
+
 int vfio_pci_discover(const char *gpattern);
 void vfio_free_device_list(void);
 vfio_token *vfio_get_token(vfio_pci_device_t *dev,
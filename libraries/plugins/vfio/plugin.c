@@ -30,6 +30,7 @@
 
 #include <stdlib.h>
 #include <dlfcn.h>
+#include <json-c/json.h>
 
 #include <opae/types_enum.h>
 
@@ -80,10 +81,98 @@ int __VFIO_API__ vfio_plugin_finalize(void)
 	return 0;
 }
 
+#define VFIO_POOL_ARENA_2M (2LL * 1024 * 1024)
+#define VFIO_POOL_ARENA_1G (1024LL * 1024 * 1024)
+
+bool vfio_buffer_pool_enabled;
+uint64_t vfio_buffer_pool_arena_size = 1024 * 1024 * 1024;
+uint32_t vfio_buffer_pool_max_arenas = 4;
+
+/*
+ * Parse the plugin "configuration" object from opae.cfg. All keys are
+ * optional, so an empty object leaves the plugin defaults in place.
+ *
+ * "buffer-pool": true            - serve fpgaPrepareBuffer() requests of up
+ *                                  to a quarter arena from per-handle
+ *                                  pre-mapped hugepage arenas.
+ * "buffer-pool-arena-size": <n>  - arena size in bytes (default 1 GiB).
+ *                                  Must be 2 MiB or a whole number of
+ *                                  1 GiB hugepages.
+ * "buffer-pool-max-arenas": <n>  - arenas per handle (default 4).
+ */
+STATIC int vfio_parse_config(const char *cfg)
+{
+	json_object *root;
+	enum json_tokener_error j_err = json_tokener_success;
+	json_object *j_value = NULL;
+	int res = 1;
+
+	vfio_buffer_pool_enabled = false;
+	vfio_buffer_pool_arena_size = 1024 * 1024 * 1024;
+	vfio_buffer_pool_max_arenas = 4;
+
+	if (!cfg)
+		return 0;
+
+	root = json_tokener_parse_verbose(cfg, &j_err);
+	if (!root) {
+		OPAE_ERR("error parsing vfio config: %s",
+			 json_tokener_error_desc(j_err));
+		return 1;
+	}
+
+	if (json_object_object_get_ex(root, "buffer-pool", &j_value)) {
+		if (!json_object_is_type(j_value, json_type_boolean)) {
+			OPAE_ERR("buffer-pool key not boolean");
+			goto out_put;
+		}
+		vfio_buffer_pool_enabled =
+			json_object_get_boolean(j_value) ? true : false;
+	}
+
+	if (json_object_object_get_ex(root, "buffer-pool-arena-size",
+				      &j_value)) {
+		int64_t arena_size;
+
+		if (!json_object_is_type(j_value, json_type_int) ||
+		    (json_object_get_int64(j_value) <= 0)) {
+			OPAE_ERR("buffer-pool-arena-size key not a positive integer");
+			goto out_put;
+		}
+
+		arena_size = json_object_get_int64(j_value);
+		if ((arena_size != VFIO_POOL_ARENA_2M) &&
+		    (arena_size % VFIO_POOL_ARENA_1G)) {
+			OPAE_ERR("buffer-pool-arena-size must be 2 MiB "
+				 "or a multiple of 1 GiB");
+			goto out_put;
+		}
+		vfio_buffer_pool_arena_size = (uint64_t)arena_size;
+	}
+
+	if (json_object_object_get_ex(root, "buffer-pool-max-arenas",
+				      &j_value)) {
+		if (!json_object_is_type(j_value, json_type_int) ||
+		    (json_object_get_int(j_value) <= 0)) {
+			OPAE_ERR("buffer-pool-max-arenas key not a positive integer");
+			goto out_put;
+		}
+		vfio_buffer_pool_max_arenas =
+			(uint32_t)json_object_get_int(j_value);
+	}
+
+	res = 0;
+
+out_put:
+	json_object_put(root);
+	return res;
+}
+
 int __VFIO_API__ opae_plugin_configure(opae_api_adapter_table *adapter,
 				       const char *jsonConfig)
 {
-	UNUSED_PARAM(jsonConfig);
+	if (vfio_parse_config(jsonConfig))
+		return 1;
 
 	adapter->fpgaOpen = dlsym(adapter->plugin.dl_handle, "vfio_fpgaOpen");
 	adapter->fpgaClose =
@@ -106,6 +195,10 @@ int __VFIO_API__ opae_plugin_configure(opae_api_adapter_table *adapter,
 		dlsym(adapter->plugin.dl_handle, "vfio_fpgaReadMMIO32");
 	adapter->fpgaWriteMMIO512 =
 		dlsym(adapter->plugin.dl_handle, "vfio_fpgaWriteMMIO512");
+	adapter->fpgaReadMMIOBatch =
+		dlsym(adapter->plugin.dl_handle, "vfio_fpgaReadMMIOBatch");
+	adapter->fpgaWriteMMIOBatch =
+		dlsym(adapter->plugin.dl_handle, "vfio_fpgaWriteMMIOBatch");
 	adapter->fpgaMapMMIO =
 		dlsym(adapter->plugin.dl_handle, "vfio_fpgaMapMMIO");
 	adapter->fpgaUnmapMMIO =
@@ -41,8 +41,6 @@
 #include "mock/opae_std.h"
 
 #define METADATA_GUID "58656F6E-4650-4741-B747-425376303031"
-#define METADATA_GUID_LEN 16
-#define METADATA_MAX_LEN 8192
 #define FPGA_GBS_6_3_0_MAGIC	0x1d1f8680 // dec: 488605312
 #define PR_INTERFACE_ID 	"pr/interface_id"
 #define INTFC_ID_LOW_LEN	16
@@ -39,6 +39,8 @@ extern "C" {
 
 #define GUID_LEN		36
 #define AFU_NAME_LEN		512
+#define METADATA_GUID_LEN	16
+#define METADATA_MAX_LEN	8192
 
 // GBS Metadata format /json
 struct gbs_metadata {
@@ -256,88 +256,61 @@ out_unlock:
 fpga_result __XFPGA_API__
 xfpga_fpgaReleaseBuffer(fpga_handle handle, uint64_t wsid)
 {
-	void *buf_addr;
-	uint64_t iova;
-	uint64_t len;
-	int err;
-
 	struct _fpga_handle *_handle = (struct _fpga_handle *)handle;
-	fpga_result result = FPGA_NOT_FOUND;
+	struct wsid_map wm;
+	fpga_result result;
 
-	result = handle_check_and_lock(_handle);
+	/* The wsid tracker is internally sharded and locked, so buffer
+	 * release does not serialize on the handle mutex. */
+	result = handle_check(_handle);
 	if (result)
 		return result;
 
-	/* Fetch the buffer physical address and length */
-	struct wsid_map *wm = wsid_find(_handle->wsid_root, wsid);
-	if (!wm) {
+	/* Fetch and remove the workspace in one step, so that concurrent
+	 * releases of the same wsid cannot both unmap it. */
+	if (!wsid_take(_handle->wsid_root, wsid, &wm)) {
 		OPAE_MSG("WSID not found");
-		result = FPGA_INVALID_PARAM;
-		goto out_unlock;
+		return FPGA_INVALID_PARAM;
 	}
 
-	buf_addr = (void *) wm->addr;
-	iova = wm->phys;
-	len = wm->len;
+	bool preallocated = (wm.flags & FPGA_BUF_PREALLOCATED);
 
-	bool preallocated = (wm->flags & FPGA_BUF_PREALLOCATED);
-
-	if (opae_port_unmap(_handle->fddev, iova)) {
+	if (opae_port_unmap(_handle->fddev, wm.phys)) {
 		OPAE_MSG("FPGA_PORT_DMA_UNMAP ioctl failed: %s",
 			 strerror(errno));
-		result = FPGA_INVALID_PARAM;
-		goto ws_free;
+		return FPGA_INVALID_PARAM;
 	}
 
 	/* If the buffer was allocated in xfpga_fpgaPrepareBuffer() (i.e. it was not
 	 * preallocated), we need to unmap it here. Otherwise (if it was
 	 * preallocated) the mapping needs to stay intact. */
 	if (!preallocated) {
-		result = buffer_release(buf_addr, len);
+		result = buffer_release((void *) wm.addr, wm.len);
 		if (result != FPGA_OK) {
 			OPAE_MSG("Buffer release failed");
-			goto ws_free;
+			return result;
 		}
 	}
 
-	/* Return */
-	result = FPGA_OK;
-
-ws_free:
-	/* Remove workspace */
-	wsid_del(_handle->wsid_root, wsid);
-
-out_unlock:
-	err = pthread_mutex_unlock(&_handle->lock);
-	if (err) {
-		OPAE_ERR("pthread_mutex_unlock() failed: %s", strerror(err));
-	}
-	return result;
+	return FPGA_OK;
 }
 
 fpga_result __XFPGA_API__ xfpga_fpgaGetIOAddress(fpga_handle handle, uint64_t wsid,
 					  uint64_t *ioaddr)
 {
 	struct _fpga_handle *_handle = (struct _fpga_handle *)handle;
-	struct wsid_map *wm;
-	fpga_result result = FPGA_OK;
-	int err;
+	struct wsid_map wm;
+	fpga_result result;
 
-	result = handle_check_and_lock(_handle);
+	result = handle_check(_handle);
 	if (result)
 		return result;
 
-	wm = wsid_find(_handle->wsid_root, wsid);
-	if (!wm) {
+	if (!wsid_lookup(_handle->wsid_root, wsid, &wm)) {
 		OPAE_MSG("WSID not found");
-		result = FPGA_NOT_FOUND;
-	} else {
-		*ioaddr = wm->phys;
+		return FPGA_NOT_FOUND;
 	}
 
-	err = pthread_mutex_unlock(&_handle->lock);
-	if (err) {
-		OPAE_ERR("pthread_mutex_unlock() failed: %s", strerror(err));
-	}
-	return result;
+	*ioaddr = wm.phys;
+	return FPGA_OK;
 }
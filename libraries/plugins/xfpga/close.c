@@ -51,6 +51,7 @@ fpga_result __XFPGA_API__ xfpga_fpgaClose(fpga_handle handle)
 	struct _fpga_handle *_handle = (struct _fpga_handle *)handle;
 	fpga_result result = FPGA_OK;
 	int err = 0;
+	uint32_t i;
 
 	result = handle_check_and_lock(_handle);
 	if (result)
@@ -65,6 +66,9 @@ fpga_result __XFPGA_API__ xfpga_fpgaClose(fpga_handle handle)
 		return FPGA_INVALID_PARAM;
 	}
 
+	for (i = 0; i < XFPGA_MMIO_FAST_REGIONS; ++i)
+		mmio_fast_retire(_handle, i);
+
 	wsid_tracker_cleanup(_handle->wsid_root, NULL);
 	wsid_tracker_cleanup(_handle->mmio_root, unmap_mmio_region);
 	free_umsg_buffer(handle);
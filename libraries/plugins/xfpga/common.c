@@ -88,6 +88,23 @@ fpga_result handle_check_and_lock(struct _fpga_handle *handle)
 	return FPGA_OK;
 }
 
+/*
+ * Check handle object for validity without taking its mutex.
+ * For operations whose state is serialized elsewhere (eg the wsid tracker).
+ */
+fpga_result handle_check(struct _fpga_handle *handle)
+{
+	ASSERT_NOT_NULL(handle);
+
+	if (__atomic_load_n(&handle->magic, __ATOMIC_ACQUIRE) !=
+	    FPGA_HANDLE_MAGIC) {
+		OPAE_MSG("Invalid handle object");
+		return FPGA_INVALID_PARAM;
+	}
+
+	return FPGA_OK;
+}
+
 /*
  * Check event handle object for validity and lock its mutex
  * If event_handle_check_and_lock() returns FPGA_OK, assume the mutex to be
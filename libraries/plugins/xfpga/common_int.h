@@ -86,6 +86,13 @@
 /* Check validity of various objects */
 fpga_result prop_check_and_lock(struct _fpga_properties *prop);
 fpga_result handle_check_and_lock(struct _fpga_handle *handle);
+fpga_result handle_check(struct _fpga_handle *handle);
 fpga_result event_handle_check_and_lock(struct _fpga_event_handle *eh);
 
+/* Plugin configuration (see plugin.c) */
+extern bool xfpga_mmio_fast_path;
+
+/* Unpublish a fast-path MMIO region, waiting for in-flight accessors */
+void mmio_fast_retire(struct _fpga_handle *handle, uint32_t mmio_num);
+
 #endif // ___FPGA_COMMON_INT_H__
@@ -124,19 +124,15 @@ fpga_result discover_afu_metrics_feature(fpga_handle handle, uint64_t *offset)
 }
 
 
-fpga_result get_afu_metric_value(fpga_handle handle,
-				fpga_metric_vector *enum_vector,
-				uint64_t metric_num,
+fpga_result get_afu_enum_metric_value(fpga_handle handle,
+				struct _fpga_enum_metric *_fpga_enum_metric,
 				struct fpga_metric *fpga_metric)
 {
 	fpga_result result                           = FPGA_OK;
-	uint64_t index                               = 0;
 	struct metric_bbb_value metric_csr;
-	struct _fpga_enum_metric *_fpga_enum_metric  = NULL;
-	uint64_t num_enun_metrics                    = 0;
 
 	if (handle == NULL ||
-		enum_vector == NULL ||
+		_fpga_enum_metric == NULL ||
 		fpga_metric == NULL) {
 		OPAE_ERR("Invalid Input Paramters");
 		return FPGA_INVALID_PARAM;
@@ -144,30 +140,35 @@ fpga_result get_afu_metric_value(fpga_handle handle,
 
 	memset(&metric_csr, 0, sizeof(metric_csr));
 
-	result = fpga_vector_total(enum_vector, &num_enun_metrics);
+	result = xfpga_fpgaReadMMIO64(handle, 0, _fpga_enum_metric->mmio_offset, &metric_csr.csr);
 	if (result != FPGA_OK) {
-		OPAE_ERR("Failed to get metric total");
-		return FPGA_NOT_FOUND;
+		OPAE_ERR("Failed to get metric");
+		return result;
 	}
+	fpga_metric->value.ivalue = metric_csr.value;
 
-	result = FPGA_NOT_FOUND;
-	for (index = 0; index < num_enun_metrics; index++) {
-
-		_fpga_enum_metric = (struct _fpga_enum_metric *)	fpga_vector_get(enum_vector, index);
-
-		if (metric_num == _fpga_enum_metric->metric_num) {
+	return result;
+}
 
-			result = xfpga_fpgaReadMMIO64(handle, 0, _fpga_enum_metric->mmio_offset, &metric_csr.csr);
-			if (result != FPGA_OK) {
-				OPAE_ERR("Failed to get metric");
-				break;
-			}
-			fpga_metric->value.ivalue = metric_csr.value;
-		}
+fpga_result get_afu_metric_value(fpga_handle handle,
+				fpga_metric_vector *enum_vector,
+				uint64_t metric_num,
+				struct fpga_metric *fpga_metric)
+{
+	struct _fpga_enum_metric *_fpga_enum_metric  = NULL;
 
+	if (handle == NULL ||
+		enum_vector == NULL ||
+		fpga_metric == NULL) {
+		OPAE_ERR("Invalid Input Paramters");
+		return FPGA_INVALID_PARAM;
 	}
 
-	return result;
+	_fpga_enum_metric = find_enum_metric(enum_vector, metric_num);
+	if (_fpga_enum_metric == NULL)
+		return FPGA_NOT_FOUND;
+
+	return get_afu_enum_metric_value(handle, _fpga_enum_metric, fpga_metric);
 }
 
 fpga_result add_afu_metrics_vector(fpga_metric_vector *vector,
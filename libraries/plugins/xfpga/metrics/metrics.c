@@ -420,3 +420,108 @@ out_unlock:
 	}
 	return result;
 }
+
+fpga_result __XFPGA_API__ xfpga_fpgaGetMetricsAll(fpga_handle handle,
+						fpga_metric *metrics,
+						uint64_t *num_metrics)
+{
+	fpga_result result                          = FPGA_OK;
+	uint64_t found                              = 0;
+	struct _fpga_handle *_handle                = (struct _fpga_handle *)handle;
+	int err                                     = 0;
+	uint64_t i                                  = 0;
+	uint64_t num_enun_metrics                   = 0;
+	struct _fpga_enum_metric *_fpga_enum_metric = NULL;
+	fpga_objtype objtype;
+
+	if (_handle == NULL) {
+		OPAE_ERR("NULL fpga handle");
+		return FPGA_INVALID_PARAM;
+	}
+
+	result = handle_check_and_lock(_handle);
+	if (result)
+		return result;
+
+	if (_handle->fddev < 0) {
+		OPAE_ERR("Invalid handle file descriptor");
+		result = FPGA_INVALID_PARAM;
+		goto out_unlock;
+	}
+
+	if (metrics == NULL ||
+		num_metrics == NULL) {
+		OPAE_ERR("Invalid Input parameters");
+		result = FPGA_INVALID_PARAM;
+		goto out_unlock;
+	}
+
+	result = enum_fpga_metrics(handle);
+	if (result != FPGA_OK) {
+		OPAE_ERR("Failed to Discover Metrics");
+		result = FPGA_NOT_FOUND;
+		goto out_unlock;
+	}
+
+	result = fpga_vector_total(&(_handle->fpga_enum_metric_vector), &num_enun_metrics);
+	if (result != FPGA_OK) {
+		OPAE_ERR("Failed to get metric total");
+		goto out_unlock;
+	}
+
+	result = get_fpga_object_type(handle, &objtype);
+	if (result != FPGA_OK) {
+		OPAE_ERR("Failed to get object type");
+		result = FPGA_INVALID_PARAM;
+		goto out_unlock;
+	}
+
+	if (objtype != FPGA_ACCELERATOR && objtype != FPGA_DEVICE) {
+		result = FPGA_INVALID_PARAM;
+		goto out_unlock;
+	}
+
+	if (*num_metrics > num_enun_metrics)
+		*num_metrics = num_enun_metrics;
+
+	// Walk the table in order; no per-metric lookup.
+	for (i = 0; i < *num_metrics; i++) {
+
+		_fpga_enum_metric = (struct _fpga_enum_metric *)
+			fpga_vector_get(&(_handle->fpga_enum_metric_vector), i);
+
+		metrics[i].metric_num = _fpga_enum_metric->metric_num;
+		metrics[i].isvalid = false;
+
+		if (objtype == FPGA_ACCELERATOR) {
+			result = get_afu_enum_metric_value(handle,
+							   _fpga_enum_metric,
+							   &metrics[i]);
+			metrics[i].isvalid = (result == FPGA_OK);
+		} else {
+			result = get_fme_enum_metric_value(handle,
+							   _fpga_enum_metric,
+							   &metrics[i]);
+		}
+
+		if (result != FPGA_OK) {
+			OPAE_MSG("Failed to get metric value  at Index = %ld", i);
+			continue;
+		}
+
+		found++;
+	}
+
+	// API returns not found if doesnot found any metric
+	result = found ? FPGA_OK : FPGA_NOT_FOUND;
+
+out_unlock:
+
+	clear_cached_values(_handle);
+	err = pthread_mutex_unlock(&_handle->lock);
+	if (err) {
+		OPAE_ERR("pthread_mutex_unlock() failed: %s", strerror(err));
+	}
+
+	return result;
+}
@@ -192,6 +192,13 @@ fpga_result get_fme_metric_value(fpga_handle handle,
 				uint64_t metric_id,
 				struct fpga_metric *fpga_metric);
 
+fpga_result get_fme_enum_metric_value(fpga_handle handle,
+				struct _fpga_enum_metric *_fpga_enum_metric,
+				struct fpga_metric *fpga_metric);
+
+struct _fpga_enum_metric *find_enum_metric(fpga_metric_vector *enum_vector,
+				uint64_t metric_num);
+
 fpga_result add_metric_info(struct _fpga_enum_metric *_enum_metrics,
 				struct fpga_metric_info *fpga_metric_info);
 
@@ -233,6 +240,10 @@ fpga_result get_afu_metric_value(fpga_handle handle,
 				uint64_t metric_num,
 				struct fpga_metric *fpga_metric);
 
+fpga_result get_afu_enum_metric_value(fpga_handle handle,
+				struct _fpga_enum_metric *_fpga_enum_metric,
+				struct fpga_metric *fpga_metric);
+
 fpga_result add_afu_metrics_vector(fpga_metric_vector *vector,
 				uint64_t *metric_id,
 				uint64_t group_value,
@@ -347,6 +347,9 @@ fpga_result  dfl_enum_max10_metrics_info_pattern(struct _fpga_handle *_handle,
 			goto out;
 		}
 
+		classify_max10_metric((struct _fpga_enum_metric *)
+			fpga_vector_get(vector, vector->total - 1));
+
 		*metric_num = *metric_num + 1;
 
 	} // end for loop
@@ -366,6 +369,79 @@ fpga_result  dfl_enum_max10_metrics_info(struct _fpga_handle *_handle,
 	return dfl_enum_max10_metrics_info_pattern(_handle, vector, metric_num, hw_type, DFL_MAX10_SYSFS_PATH);
 }
 
+// Sets the plausible value range of a max10 metric, so that it
+// doesn't have to be worked out from the name on every read.
+void classify_max10_metric(struct _fpga_enum_metric *_fpga_enum_metric)
+{
+	if (_fpga_enum_metric == NULL)
+		return;
+
+	_fpga_enum_metric->flags |= FPGA_ENUM_METRIC_LIMITS;
+
+	if (strstr(_fpga_enum_metric->metric_name, DFL_POWER)) {
+		_fpga_enum_metric->low_limit = POWER_LOW_LIMIT;
+		_fpga_enum_metric->high_limit = POWER_HIGH_LIMIT;
+	} else if (strstr(_fpga_enum_metric->metric_name, DFL_VOLTAGE) ||
+		   strstr(_fpga_enum_metric->metric_name, DFL_CURRENT)) {
+		_fpga_enum_metric->low_limit = VOLTAMP_LOW_LIMIT;
+		_fpga_enum_metric->high_limit = VOLTAMP_HIGH_LIMIT;
+	} else if (strstr(_fpga_enum_metric->metric_name, DFL_TEMPERATURE)) {
+		_fpga_enum_metric->low_limit = THERMAL_LOW_LIMIT;
+		_fpga_enum_metric->high_limit = THERMAL_HIGH_LIMIT;
+	} else {
+		// no limits
+		_fpga_enum_metric->flags &= ~FPGA_ENUM_METRIC_LIMITS;
+	}
+}
+
+void close_max10_value_fd(struct _fpga_enum_metric *_fpga_enum_metric)
+{
+	if (_fpga_enum_metric == NULL ||
+	    !(_fpga_enum_metric->flags & FPGA_ENUM_METRIC_FD_OPEN))
+		return;
+
+	opae_close(_fpga_enum_metric->value_fd);
+	_fpga_enum_metric->value_fd = -1;
+	_fpga_enum_metric->flags &= ~FPGA_ENUM_METRIC_FD_OPEN;
+}
+
+// Reads the metric's sysfs value through an fd that stays open
+// until the metric table is freed. sysfs attributes are re-generated
+// on each read from offset 0, so pread() returns the current value.
+STATIC fpga_result read_max10_sysfs_u64(struct _fpga_enum_metric *_fpga_enum_metric,
+					uint64_t *value)
+{
+	char buf[SYSFS_PATH_MAX] = { 0, };
+	ssize_t res;
+
+	if (!(_fpga_enum_metric->flags & FPGA_ENUM_METRIC_FD_OPEN)) {
+		_fpga_enum_metric->value_fd =
+			opae_open(_fpga_enum_metric->metric_sysfs, O_RDONLY);
+		if (_fpga_enum_metric->value_fd < 0) {
+			OPAE_MSG("open(%s) failed", _fpga_enum_metric->metric_sysfs);
+			_fpga_enum_metric->value_fd = -1;
+			return FPGA_NOT_FOUND;
+		}
+		_fpga_enum_metric->flags |= FPGA_ENUM_METRIC_FD_OPEN;
+	}
+
+	do {
+		res = pread(_fpga_enum_metric->value_fd, buf, sizeof(buf) - 1, 0);
+	} while (res < 0 && errno == EINTR);
+
+	if (res <= 0) {
+		OPAE_MSG("Read from %s failed", _fpga_enum_metric->metric_sysfs);
+		// The attribute may have gone away; re-open on the next read.
+		close_max10_value_fd(_fpga_enum_metric);
+		return FPGA_NOT_FOUND;
+	}
+
+	buf[res] = '\0';
+	*value = strtoull(buf, NULL, 0);
+
+	return FPGA_OK;
+}
+
 fpga_result read_max10_value(struct _fpga_enum_metric *_fpga_enum_metric,
 					double *dvalue)
 {
@@ -378,7 +454,7 @@ fpga_result read_max10_value(struct _fpga_enum_metric *_fpga_enum_metric,
 		return FPGA_INVALID_PARAM;
 	}
 
-	result = sysfs_read_u64(_fpga_enum_metric->metric_sysfs, &value);
+	result = read_max10_sysfs_u64(_fpga_enum_metric, &value);
 	if (result != FPGA_OK) {
 		OPAE_MSG("Failed to read Metrics values");
 		return result;
@@ -387,27 +463,10 @@ fpga_result read_max10_value(struct _fpga_enum_metric *_fpga_enum_metric,
 	*dvalue = ((double)value / MILLI);
 
 	// Check for limits
-	if (strstr(_fpga_enum_metric->metric_name, DFL_POWER)) {
-
-		if (*dvalue  < POWER_LOW_LIMIT || *dvalue  > POWER_HIGH_LIMIT)
-			result = FPGA_EXCEPTION;
-
-	} else if (strstr(_fpga_enum_metric->metric_name, DFL_VOLTAGE)) {
-
-		if (*dvalue < VOLTAMP_LOW_LIMIT || *dvalue > VOLTAMP_HIGH_LIMIT)
-			result = FPGA_EXCEPTION;
-
-	} else if (strstr(_fpga_enum_metric->metric_name, DFL_CURRENT)) {
-
-		if (*dvalue < VOLTAMP_LOW_LIMIT || *dvalue > VOLTAMP_HIGH_LIMIT)
-			result = FPGA_EXCEPTION;
-
-	} else if (strstr(_fpga_enum_metric->metric_name, DFL_TEMPERATURE)) {
-
-		if (*dvalue < THERMAL_LOW_LIMIT || *dvalue > THERMAL_HIGH_LIMIT)
-			result = FPGA_EXCEPTION;
-
-	}
+	if ((_fpga_enum_metric->flags & FPGA_ENUM_METRIC_LIMITS) &&
+	    (*dvalue < _fpga_enum_metric->low_limit ||
+	     *dvalue > _fpga_enum_metric->high_limit))
+		result = FPGA_EXCEPTION;
 
 	return result;
 }
@@ -156,6 +156,10 @@ fpga_result add_metric_vector(fpga_metric_vector *vector,
 	fpga_enum_metric->hw_type = hw_type;
 	fpga_enum_metric->metric_num = metric_num;
 	fpga_enum_metric->mmio_offset = mmio_offset;
+	fpga_enum_metric->flags = 0;
+	fpga_enum_metric->value_fd = -1;
+	fpga_enum_metric->low_limit = 0.0;
+	fpga_enum_metric->high_limit = 0.0;
 
 	fpga_vector_push(vector, fpga_enum_metric);
 
@@ -409,6 +413,11 @@ fpga_result free_fpga_enum_metrics_vector(struct _fpga_handle *_handle)
 		return FPGA_INVALID_PARAM;
 	}
 
+	for (i = 0; i < num_enun_metrics; i++) {
+		close_max10_value_fd((struct _fpga_enum_metric *)
+			fpga_vector_get(&(_handle->fpga_enum_metric_vector), i));
+	}
+
 	for (i = 0; i < num_enun_metrics; i++) {
 		fpga_vector_delete(&(_handle->fpga_enum_metric_vector), i);
 	}
@@ -802,84 +811,114 @@ fpga_result get_pwr_thermal_max10_value(const char *sysfs_path,
 
 
 
-// Reads fme metric value
-fpga_result  get_fme_metric_value(fpga_handle handle,
-					fpga_metric_vector *enum_vector,
-					uint64_t metric_num,
-					struct fpga_metric *fpga_metric)
+// Finds the enumerated metric with the given metric_num.
+// Metrics are numbered in enumeration order, so the number
+// is normally also the vector index.
+struct _fpga_enum_metric *find_enum_metric(fpga_metric_vector *enum_vector,
+					uint64_t metric_num)
 {
-	fpga_result result                          = FPGA_OK;
-	uint64_t index                              = 0;
 	struct _fpga_enum_metric *_fpga_enum_metric = NULL;
 	uint64_t num_enun_metrics                  = 0;
+	uint64_t index                              = 0;
+
+	if (fpga_vector_total(enum_vector, &num_enun_metrics) != FPGA_OK)
+		return NULL;
+
+	if (metric_num < num_enun_metrics) {
+		_fpga_enum_metric = (struct _fpga_enum_metric *)
+			fpga_vector_get(enum_vector, metric_num);
+		if (_fpga_enum_metric &&
+		    _fpga_enum_metric->metric_num == metric_num)
+			return _fpga_enum_metric;
+	}
+
+	for (index = 0; index < num_enun_metrics ; index++) {
+		_fpga_enum_metric = (struct _fpga_enum_metric *)
+			fpga_vector_get(enum_vector, index);
+		if (_fpga_enum_metric &&
+		    _fpga_enum_metric->metric_num == metric_num)
+			return _fpga_enum_metric;
+	}
+
+	return NULL;
+}
+
+// Reads the value of an enumerated fme metric
+fpga_result get_fme_enum_metric_value(fpga_handle handle,
+				struct _fpga_enum_metric *_fpga_enum_metric,
+				struct fpga_metric *fpga_metric)
+{
+	fpga_result result = FPGA_NOT_FOUND;
 	metric_value value = {0};
 
-	if (enum_vector == NULL ||
+	if (_fpga_enum_metric == NULL ||
 		fpga_metric == NULL) {
 		OPAE_ERR("Invalid Input Paramters");
 		return FPGA_INVALID_PARAM;
 	}
 
-	result = fpga_vector_total(enum_vector, &num_enun_metrics);
-	if (result != FPGA_OK) {
-		OPAE_ERR("Failed to get metric total");
-		return FPGA_NOT_FOUND;
-	}
-
 	fpga_metric->isvalid = false;
-	result = FPGA_NOT_FOUND;
-	for (index = 0; index < num_enun_metrics ; index++) {
 
-		_fpga_enum_metric = (struct _fpga_enum_metric *)	fpga_vector_get(enum_vector, index);
+	// DCP Power & Thermal
+	if ((_fpga_enum_metric->hw_type == FPGA_HW_DCP_RC) &&
+		((_fpga_enum_metric->metric_type == FPGA_METRIC_TYPE_POWER) ||
+		(_fpga_enum_metric->metric_type == FPGA_METRIC_TYPE_THERMAL))) {
 
-		if (metric_num == _fpga_enum_metric->metric_num) {
+		result  = get_bmc_metrics_values(handle, _fpga_enum_metric, fpga_metric);
+		if (result != FPGA_OK) {
+			OPAE_MSG("Failed to get BMC metric value");
+		} else {
+			fpga_metric->isvalid = true;
+		}
+		fpga_metric->metric_num = _fpga_enum_metric->metric_num;
 
-			// Found Metic
-			memset(&value, 0, sizeof(value));
+	}
 
-			// DCP Power & Thermal
-			if ((_fpga_enum_metric->hw_type == FPGA_HW_DCP_RC) &&
-				((_fpga_enum_metric->metric_type == FPGA_METRIC_TYPE_POWER) ||
-				(_fpga_enum_metric->metric_type == FPGA_METRIC_TYPE_THERMAL))) {
+	// Read power theraml values from Max10
+	if (((_fpga_enum_metric->hw_type == FPGA_HW_DCP_N3000) ||
+		(_fpga_enum_metric->hw_type == FPGA_HW_DCP_D5005) ||
+		(_fpga_enum_metric->hw_type == FPGA_HW_ADP_N6000) ||
+		(_fpga_enum_metric->hw_type == FPGA_HW_IPU_C6100) ||
+		(_fpga_enum_metric->hw_type == FPGA_HW_DCP_CMC) ||
+		(_fpga_enum_metric->hw_type == FPGA_HW_DCP_N5010)) &&
+		((_fpga_enum_metric->metric_type == FPGA_METRIC_TYPE_POWER) ||
+		(_fpga_enum_metric->metric_type == FPGA_METRIC_TYPE_THERMAL))) {
 
+		result = read_max10_value(_fpga_enum_metric, &value.dvalue);
+		if (result != FPGA_OK) {
+			OPAE_MSG("Failed to get Max10 metric value");
+		} else {
+			fpga_metric->isvalid = true;
+		}
+		fpga_metric->value = value;
+		fpga_metric->metric_num = _fpga_enum_metric->metric_num;
 
-				result  = get_bmc_metrics_values(handle, _fpga_enum_metric, fpga_metric);
-				if (result != FPGA_OK) {
-					OPAE_MSG("Failed to get BMC metric value");
-				} else {
-					fpga_metric->isvalid = true;
-				}
-				fpga_metric->metric_num = metric_num;
-
-			 }
-
-
-			// Read power theraml values from Max10
-			if (((_fpga_enum_metric->hw_type == FPGA_HW_DCP_N3000) ||
-				(_fpga_enum_metric->hw_type == FPGA_HW_DCP_D5005) ||
-				(_fpga_enum_metric->hw_type == FPGA_HW_ADP_N6000) ||
-				(_fpga_enum_metric->hw_type == FPGA_HW_IPU_C6100) ||
-				(_fpga_enum_metric->hw_type == FPGA_HW_DCP_CMC) ||
-				(_fpga_enum_metric->hw_type == FPGA_HW_DCP_N5010)) &&
-				((_fpga_enum_metric->metric_type == FPGA_METRIC_TYPE_POWER) ||
-				(_fpga_enum_metric->metric_type == FPGA_METRIC_TYPE_THERMAL))) {
-
-				result = read_max10_value(_fpga_enum_metric, &value.dvalue);
-				if (result != FPGA_OK) {
-					OPAE_MSG("Failed to get Max10 metric value");
-				} else {
-					fpga_metric->isvalid = true;
-				}
-				fpga_metric->value = value;
-				fpga_metric->metric_num = metric_num;
+	}
 
-			}
+	return result;
+}
 
-			break;
-		}
+// Reads fme metric value
+fpga_result  get_fme_metric_value(fpga_handle handle,
+					fpga_metric_vector *enum_vector,
+					uint64_t metric_num,
+					struct fpga_metric *fpga_metric)
+{
+	struct _fpga_enum_metric *_fpga_enum_metric = NULL;
+
+	if (enum_vector == NULL ||
+		fpga_metric == NULL) {
+		OPAE_ERR("Invalid Input Paramters");
+		return FPGA_INVALID_PARAM;
 	}
 
-	return result;
+	fpga_metric->isvalid = false;
+
+	_fpga_enum_metric = find_enum_metric(enum_vector, metric_num);
+	if (_fpga_enum_metric == NULL)
+		return FPGA_NOT_FOUND;
+
+	return get_fme_enum_metric_value(handle, _fpga_enum_metric, fpga_metric);
 }
 
 
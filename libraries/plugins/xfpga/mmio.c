@@ -33,6 +33,7 @@
 #include "common_int.h"
 #include "opae_drv.h"
 #include "intel-fpga.h"
+#include "mmio-batch.h"
 
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -40,6 +41,7 @@
 #include <sys/mman.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <sched.h>
 
 /* Port UAFU */
 #define AFU_PERMISSION (FPGA_REGION_READ | FPGA_REGION_WRITE | FPGA_REGION_MMAP)
@@ -136,6 +138,103 @@ STATIC fpga_result map_mmio_region(fpga_handle handle, uint32_t mmio_num)
 	return FPGA_OK;
 }
 
+/*
+ * Lock-free MMIO fast path.
+ *
+ * When the plugin is configured with "mmio-fast-path", every MMIO region
+ * that is mapped for a handle is also published into handle->mmio_fast[],
+ * indexed by mmio_num. CSR reads and writes then load the published
+ * wsid_map, bounds check, and touch the BAR directly, without taking
+ * handle->lock or walking handle->mmio_root.
+ *
+ * A published wsid_map is immutable. It is retired only by fpgaUnmapMMIO()
+ * and fpgaClose(), which clear the slot before unmapping the region and
+ * freeing the wsid_map. Accessors are counted per region, in one of two
+ * epochs. Retiring a region flips its epoch and waits only for the
+ * accessors counted in the old one, so neither traffic on other regions
+ * nor accessors that arrive after the flip can hold the retire up.
+ *
+ * Callers validate the handle magic with handle_check() first.
+ */
+STATIC volatile uint8_t *mmio_fast_enter(struct _fpga_handle *_handle,
+					 uint32_t mmio_num,
+					 uint64_t offset,
+					 uint64_t width,
+					 uint32_t *epoch)
+{
+	struct wsid_map *wm;
+	uint32_t *users;
+	uint32_t e;
+
+	if (!(_handle->flags & OPAE_FLAG_MMIO_FASTPATH) ||
+	    (mmio_num >= XFPGA_MMIO_FAST_REGIONS))
+		return NULL;
+
+	users = _handle->mmio_fast_users[mmio_num];
+
+	// Count ourselves in the current epoch. If a retire flipped the
+	// epoch meanwhile, it may not wait for us: back out and retry.
+	while (1) {
+		e = __atomic_load_n(&_handle->mmio_fast_epoch[mmio_num],
+				    __ATOMIC_SEQ_CST);
+		__atomic_add_fetch(&users[e], 1, __ATOMIC_SEQ_CST);
+		if (e == __atomic_load_n(&_handle->mmio_fast_epoch[mmio_num],
+					 __ATOMIC_SEQ_CST))
+			break;
+		__atomic_sub_fetch(&users[e], 1, __ATOMIC_RELEASE);
+	}
+
+	wm = __atomic_load_n(&_handle->mmio_fast[mmio_num], __ATOMIC_SEQ_CST);
+	if (wm && (offset <= wm->len) && (width <= wm->len - offset)) {
+		*epoch = e;
+		return (volatile uint8_t *)wm->offset + offset;
+	}
+
+	// Not published (yet) or out of range: take the slow path.
+	__atomic_sub_fetch(&users[e], 1, __ATOMIC_RELEASE);
+	return NULL;
+}
+
+STATIC void mmio_fast_exit(struct _fpga_handle *_handle,
+			   uint32_t mmio_num,
+			   uint32_t epoch)
+{
+	__atomic_sub_fetch(&_handle->mmio_fast_users[mmio_num][epoch],
+			   1, __ATOMIC_RELEASE);
+}
+
+/* Called with _handle->lock held. */
+STATIC void mmio_fast_publish(struct _fpga_handle *_handle,
+			      struct wsid_map *wm)
+{
+	if (!(_handle->flags & OPAE_FLAG_MMIO_FASTPATH) ||
+	    (wm->index >= XFPGA_MMIO_FAST_REGIONS))
+		return;
+
+	__atomic_store_n(&_handle->mmio_fast[wm->index], wm, __ATOMIC_SEQ_CST);
+}
+
+/* Called with _handle->lock held. */
+void mmio_fast_retire(struct _fpga_handle *_handle, uint32_t mmio_num)
+{
+	uint32_t e;
+
+	if (mmio_num >= XFPGA_MMIO_FAST_REGIONS ||
+	    !__atomic_load_n(&_handle->mmio_fast[mmio_num], __ATOMIC_SEQ_CST))
+		return;
+
+	__atomic_store_n(&_handle->mmio_fast[mmio_num], NULL, __ATOMIC_SEQ_CST);
+
+	// Accessors that enter from here on count in the other epoch and
+	// find the slot empty. Wait for those that may hold the old mapping.
+	e = __atomic_load_n(&_handle->mmio_fast_epoch[mmio_num], __ATOMIC_SEQ_CST);
+	__atomic_store_n(&_handle->mmio_fast_epoch[mmio_num], e ^ 1, __ATOMIC_SEQ_CST);
+
+	while (__atomic_load_n(&_handle->mmio_fast_users[mmio_num][e],
+			       __ATOMIC_SEQ_CST))
+		sched_yield();
+}
+
 /* Lazy mapping of MMIO region (only map if not already mapped) */
 STATIC fpga_result find_or_map_wm(fpga_handle handle, uint32_t mmio_num,
 				struct wsid_map **wm_out)
@@ -156,6 +255,7 @@ STATIC fpga_result find_or_map_wm(fpga_handle handle, uint32_t mmio_num,
 			OPAE_ERR("unable to map wsid for mmio region %d", mmio_num);
 			return FPGA_NO_MEMORY;
 		}
+		mmio_fast_publish(_handle, wm);
 	}
 
 	*wm_out = wm;
@@ -171,6 +271,8 @@ fpga_result __XFPGA_API__ xfpga_fpgaWriteMMIO32(fpga_handle handle,
 	int err;
 	struct _fpga_handle *_handle = (struct _fpga_handle *) handle;
 	struct wsid_map *wm = NULL;
+	volatile uint8_t *p;
+	uint32_t epoch;
 	fpga_result result = FPGA_OK;
 
 	if (offset % sizeof(uint32_t) != 0) {
@@ -178,6 +280,17 @@ fpga_result __XFPGA_API__ xfpga_fpgaWriteMMIO32(fpga_handle handle,
 		return FPGA_INVALID_PARAM;
 	}
 
+	result = handle_check(_handle);
+	if (result)
+		return result;
+
+	p = mmio_fast_enter(_handle, mmio_num, offset, sizeof(uint32_t), &epoch);
+	if (p) {
+		*((volatile uint32_t *)p) = value;
+		mmio_fast_exit(_handle, mmio_num, epoch);
+		return FPGA_OK;
+	}
+
 	result = handle_check_and_lock(_handle);
 	if (result)
 		return result;
@@ -210,6 +323,8 @@ fpga_result __XFPGA_API__ xfpga_fpgaReadMMIO32(fpga_handle handle,
 	int err;
 	struct _fpga_handle *_handle = (struct _fpga_handle *) handle;
 	struct wsid_map *wm = NULL;
+	volatile uint8_t *p;
+	uint32_t epoch;
 	fpga_result result = FPGA_OK;
 
 	if (offset % sizeof(uint32_t) != 0) {
@@ -217,6 +332,17 @@ fpga_result __XFPGA_API__ xfpga_fpgaReadMMIO32(fpga_handle handle,
 		return FPGA_INVALID_PARAM;
 	}
 
+	result = handle_check(_handle);
+	if (result)
+		return result;
+
+	p = mmio_fast_enter(_handle, mmio_num, offset, sizeof(uint32_t), &epoch);
+	if (p) {
+		*value = *((volatile uint32_t *)p);
+		mmio_fast_exit(_handle, mmio_num, epoch);
+		return FPGA_OK;
+	}
+
 	result = handle_check_and_lock(_handle);
 	if (result)
 		return result;
@@ -249,6 +375,8 @@ fpga_result __XFPGA_API__ xfpga_fpgaWriteMMIO64(fpga_handle handle,
 	int err;
 	struct _fpga_handle *_handle = (struct _fpga_handle *) handle;
 	struct wsid_map *wm = NULL;
+	volatile uint8_t *p;
+	uint32_t epoch;
 	fpga_result result = FPGA_OK;
 
 	if (offset % sizeof(uint64_t) != 0) {
@@ -256,6 +384,17 @@ fpga_result __XFPGA_API__ xfpga_fpgaWriteMMIO64(fpga_handle handle,
 		return FPGA_INVALID_PARAM;
 	}
 
+	result = handle_check(_handle);
+	if (result)
+		return result;
+
+	p = mmio_fast_enter(_handle, mmio_num, offset, sizeof(uint64_t), &epoch);
+	if (p) {
+		*((volatile uint64_t *)p) = value;
+		mmio_fast_exit(_handle, mmio_num, epoch);
+		return FPGA_OK;
+	}
+
 	result = handle_check_and_lock(_handle);
 	if (result)
 		return result;
@@ -288,6 +427,8 @@ fpga_result __XFPGA_API__ xfpga_fpgaReadMMIO64(fpga_handle handle,
 	int err;
 	struct _fpga_handle *_handle = (struct _fpga_handle *) handle;
 	struct wsid_map *wm = NULL;
+	volatile uint8_t *p;
+	uint32_t epoch;
 	fpga_result result = FPGA_OK;
 
 	if (offset % sizeof(uint64_t) != 0) {
@@ -295,6 +436,17 @@ fpga_result __XFPGA_API__ xfpga_fpgaReadMMIO64(fpga_handle handle,
 		return FPGA_INVALID_PARAM;
 	}
 
+	result = handle_check(_handle);
+	if (result)
+		return result;
+
+	p = mmio_fast_enter(_handle, mmio_num, offset, sizeof(uint64_t), &epoch);
+	if (p) {
+		*value = *((volatile uint64_t *)p);
+		mmio_fast_exit(_handle, mmio_num, epoch);
+		return FPGA_OK;
+	}
+
 	result = handle_check_and_lock(_handle);
 	if (result)
 		return result;
@@ -319,6 +471,82 @@ out_unlock:
 	return result;
 }
 
+fpga_result __XFPGA_API__ xfpga_fpgaReadMMIOBatch(fpga_handle handle,
+					uint32_t mmio_num,
+					fpga_mmio_op *ops,
+					uint32_t num_ops)
+{
+	int err;
+	struct _fpga_handle *_handle = (struct _fpga_handle *) handle;
+	struct wsid_map *wm = NULL;
+	fpga_result result = FPGA_OK;
+
+	if (!num_ops)
+		return FPGA_OK;
+	ASSERT_NOT_NULL(ops);
+
+	result = handle_check_and_lock(_handle);
+	if (result)
+		return result;
+
+	result = find_or_map_wm(handle, mmio_num, &wm);
+	if (result)
+		goto out_unlock;
+
+	result = opae_mmio_batch_check(ops, num_ops, wm->len);
+	if (result) {
+		OPAE_MSG("Invalid MMIO batch descriptor");
+		goto out_unlock;
+	}
+
+	opae_mmio_batch_read((volatile uint8_t *)wm->offset, ops, num_ops);
+
+out_unlock:
+	err = pthread_mutex_unlock(&_handle->lock);
+	if (err) {
+		OPAE_ERR("pthread_mutex_unlock() failed: %s", strerror(err));
+	}
+	return result;
+}
+
+fpga_result __XFPGA_API__ xfpga_fpgaWriteMMIOBatch(fpga_handle handle,
+					 uint32_t mmio_num,
+					 const fpga_mmio_op *ops,
+					 uint32_t num_ops)
+{
+	int err;
+	struct _fpga_handle *_handle = (struct _fpga_handle *) handle;
+	struct wsid_map *wm = NULL;
+	fpga_result result = FPGA_OK;
+
+	if (!num_ops)
+		return FPGA_OK;
+	ASSERT_NOT_NULL(ops);
+
+	result = handle_check_and_lock(_handle);
+	if (result)
+		return result;
+
+	result = find_or_map_wm(handle, mmio_num, &wm);
+	if (result)
+		goto out_unlock;
+
+	result = opae_mmio_batch_check(ops, num_ops, wm->len);
+	if (result) {
+		OPAE_MSG("Invalid MMIO batch descriptor");
+		goto out_unlock;
+	}
+
+	opae_mmio_batch_write((volatile uint8_t *)wm->offset, ops, num_ops);
+
+out_unlock:
+	err = pthread_mutex_unlock(&_handle->lock);
+	if (err) {
+		OPAE_ERR("pthread_mutex_unlock() failed: %s", strerror(err));
+	}
+	return result;
+}
+
 #if (defined(__i386__) || defined(__x86_64__) || defined(__ia64__)) && GCC_VERSION >= 40900
 static inline void copy512(const void *src, void *dst)
 {
@@ -428,6 +656,8 @@ fpga_result __XFPGA_API__ xfpga_fpgaUnmapMMIO(fpga_handle handle,
 		goto out_unlock;
 	}
 
+	mmio_fast_retire(_handle, mmio_num);
+
 	/* Unmap UAFU MMIO */
 	mmio_ptr = (void *) wm->offset;
 	if (munmap((void *) mmio_ptr, wm->len)) {
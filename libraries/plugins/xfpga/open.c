@@ -87,7 +87,7 @@ xfpga_fpgaOpen(fpga_token token, fpga_handle *handle, int flags)
 	_handle->fdfpgad = -1;
 
 	// Init MMIO table
-	_handle->mmio_root = wsid_tracker_init(4);
+	_handle->mmio_root = wsid_tracker_init_indexed(4, XFPGA_MMIO_FAST_REGIONS);
 	if (NULL == _handle->mmio_root) {
 		result = FPGA_NO_MEMORY;
 		goto out_free1;
@@ -152,6 +152,9 @@ xfpga_fpgaOpen(fpga_token token, fpga_handle *handle, int flags)
 #endif // GCC_VERSION
 #endif // x86
 
+	if (xfpga_mmio_fast_path)
+		_handle->flags |= OPAE_FLAG_MMIO_FASTPATH;
+
 	// set handle return value
 	*handle = (void *)_handle;
 
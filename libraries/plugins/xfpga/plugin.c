@@ -29,6 +29,7 @@
 #endif // HAVE_CONFIG_H
 
 #include <dlfcn.h>
+#include <json-c/json.h>
 
 #include "xfpga.h"
 #include "adapter.h"
@@ -56,10 +57,57 @@ int __XFPGA_API__ xfpga_plugin_finalize(void)
 	return 0;
 }
 
+bool xfpga_mmio_fast_path;
+
+/*
+ * Parse the plugin "configuration" object from opae.cfg. All keys are
+ * optional, so an empty object leaves the plugin defaults in place.
+ *
+ * "mmio-fast-path": true  - serve fpgaReadMMIO / fpgaWriteMMIO from a
+ *                           lock-free per-handle region table.
+ */
+STATIC int xfpga_parse_config(const char *cfg)
+{
+	json_object *root;
+	enum json_tokener_error j_err = json_tokener_success;
+	json_object *j_mmio_fast_path = NULL;
+	int res = 1;
+
+	xfpga_mmio_fast_path = false;
+
+	if (!cfg)
+		return 0;
+
+	root = json_tokener_parse_verbose(cfg, &j_err);
+	if (!root) {
+		OPAE_ERR("error parsing xfpga config: %s",
+			 json_tokener_error_desc(j_err));
+		return 1;
+	}
+
+	if (json_object_object_get_ex(root,
+				      "mmio-fast-path",
+				      &j_mmio_fast_path)) {
+		if (!json_object_is_type(j_mmio_fast_path, json_type_boolean)) {
+			OPAE_ERR("mmio-fast-path key not boolean");
+			goto out_put;
+		}
+		xfpga_mmio_fast_path =
+			json_object_get_boolean(j_mmio_fast_path) ? true : false;
+	}
+
+	res = 0;
+
+out_put:
+	json_object_put(root);
+	return res;
+}
+
 int __XFPGA_API__ opae_plugin_configure(opae_api_adapter_table *adapter,
 				       const char *jsonConfig)
 {
-	UNUSED_PARAM(jsonConfig);
+	if (xfpga_parse_config(jsonConfig))
+		return 1;
 
 	adapter->fpgaOpen = dlsym(adapter->plugin.dl_handle, "xfpga_fpgaOpen");
 	adapter->fpgaClose =
@@ -82,6 +130,10 @@ int __XFPGA_API__ opae_plugin_configure(opae_api_adapter_table *adapter,
 		dlsym(adapter->plugin.dl_handle, "xfpga_fpgaReadMMIO32");
 	adapter->fpgaWriteMMIO512 =
 		dlsym(adapter->plugin.dl_handle, "xfpga_fpgaWriteMMIO512");
+	adapter->fpgaReadMMIOBatch =
+		dlsym(adapter->plugin.dl_handle, "xfpga_fpgaReadMMIOBatch");
+	adapter->fpgaWriteMMIOBatch =
+		dlsym(adapter->plugin.dl_handle, "xfpga_fpgaWriteMMIOBatch");
 	adapter->fpgaMapMMIO =
 		dlsym(adapter->plugin.dl_handle, "xfpga_fpgaMapMMIO");
 	adapter->fpgaUnmapMMIO =
@@ -141,6 +193,8 @@ int __XFPGA_API__ opae_plugin_configure(opae_api_adapter_table *adapter,
 		adapter->plugin.dl_handle, "xfpga_fpgaReleaseFromInterface");
 	adapter->fpgaReconfigureSlot =
 		dlsym(adapter->plugin.dl_handle, "xfpga_fpgaReconfigureSlot");
+	adapter->fpgaReconfigureSlotByFd =
+		dlsym(adapter->plugin.dl_handle, "xfpga_fpgaReconfigureSlotByFd");
 	adapter->fpgaTokenGetObject =
 		dlsym(adapter->plugin.dl_handle, "xfpga_fpgaTokenGetObject");
 	adapter->fpgaHandleGetObject =
@@ -181,6 +235,9 @@ int __XFPGA_API__ opae_plugin_configure(opae_api_adapter_table *adapter,
 	adapter->fpgaGetMetricsThresholdInfo =
 		dlsym(adapter->plugin.dl_handle, "xfpga_fpgaGetMetricsThresholdInfo");
 
+	adapter->fpgaGetMetricsAll =
+		dlsym(adapter->plugin.dl_handle, "xfpga_fpgaGetMetricsAll");
+
 	adapter->initialize =
 		dlsym(adapter->plugin.dl_handle, "xfpga_plugin_initialize");
 	adapter->finalize =
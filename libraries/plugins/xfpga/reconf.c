@@ -35,6 +35,7 @@
 #include <limits.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 
 #include "xfpga.h"
 #include "bitstream_int.h"
@@ -55,6 +56,9 @@
 #define FPGA_GBS_MAX_POWER    60            // watts
 #define FPGA_THRESHOLD2(x)    ((x*10)/100)  // threshold1 + 10%
 
+// Size of each read when a bitstream is streamed from a pipe
+#define RECONF_READ_CHUNK     (1 * MB)
+
 #pragma pack(push, 1)
 // GBS Header
 struct bitstream_header {
@@ -413,3 +417,197 @@ out_unlock:
 
 	return result;
 }
+
+// Read up to len bytes, stopping early only at end of stream.
+STATIC ssize_t read_bitstream_fd(int fd, uint8_t *buf, size_t len)
+{
+	size_t total = 0;
+	ssize_t n;
+
+	while (total < len) {
+		n = opae_read(fd, buf + total, len - total);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		if (!n)
+			break;
+		total += (size_t)n;
+	}
+
+	return (ssize_t)total;
+}
+
+// Map the remainder of a regular file, starting at the current
+// offset of fd. Only the header and metadata are touched before
+// the PR ioctl, which then faults in the AFU logic sequentially.
+STATIC fpga_result map_bitstream_fd(int fd, const struct stat *st,
+				    void **map, size_t *map_len,
+				    const uint8_t **bitstream,
+				    size_t *bitstream_len)
+{
+	off_t start;
+	off_t map_start;
+	void *addr;
+
+	start = lseek(fd, 0, SEEK_CUR);
+	if (start < 0 || start >= st->st_size)
+		return FPGA_INVALID_PARAM;
+
+	map_start = start & ~((off_t)sysconf(_SC_PAGESIZE) - 1);
+	*map_len = (size_t)(st->st_size - map_start);
+
+	addr = mmap(NULL, *map_len, PROT_READ, MAP_PRIVATE, fd, map_start);
+	if (addr == MAP_FAILED) {
+		OPAE_DBG("mmap failed: %s", strerror(errno));
+		return FPGA_NOT_SUPPORTED;
+	}
+
+	if (madvise(addr, *map_len, MADV_SEQUENTIAL))
+		OPAE_DBG("madvise failed: %s", strerror(errno));
+
+	*map = addr;
+	*bitstream = (const uint8_t *)addr + (start - map_start);
+	*bitstream_len = (size_t)(st->st_size - start);
+
+	return FPGA_OK;
+}
+
+// Read a bitstream from a pipe (or any fd that can't be mapped).
+// The header and metadata are read and validated first, so that an
+// invalid or incompatible bitstream is rejected before its AFU logic
+// is read. The logic is then read in RECONF_READ_CHUNK pieces.
+STATIC fpga_result read_streamed_bitstream(fpga_handle fpga, int fd,
+					   uint8_t **bitstream,
+					   size_t *bitstream_len)
+{
+	uint8_t header[METADATA_GUID_LEN + sizeof(uint32_t)];
+	int32_t json_len;
+	size_t capacity;
+	size_t len;
+	ssize_t n;
+	uint8_t *buf;
+	uint8_t *p;
+
+	n = read_bitstream_fd(fd, header, sizeof(header));
+	if (n != (ssize_t)sizeof(header)) {
+		OPAE_MSG("Truncated bitstream header");
+		return n < 0 ? FPGA_EXCEPTION : FPGA_INVALID_PARAM;
+	}
+
+	if (check_bitstream_guid(header) != FPGA_OK) {
+		OPAE_MSG("Invalid bitstream GUID");
+		return FPGA_INVALID_PARAM;
+	}
+
+	json_len = get_bitstream_json_len(header);
+	if (json_len < 0 || json_len >= METADATA_MAX_LEN) {
+		OPAE_MSG("Invalid bitstream metadata length");
+		return FPGA_INVALID_PARAM;
+	}
+
+	len = sizeof(header) + (size_t)json_len;
+	capacity = len + RECONF_READ_CHUNK;
+
+	buf = opae_malloc(capacity);
+	if (!buf) {
+		OPAE_ERR("Could not allocate memory for bitstream");
+		return FPGA_NO_MEMORY;
+	}
+
+	memcpy(buf, header, sizeof(header));
+
+	n = read_bitstream_fd(fd, buf + sizeof(header), (size_t)json_len);
+	if (n != json_len) {
+		OPAE_MSG("Truncated bitstream metadata");
+		opae_free(buf);
+		return n < 0 ? FPGA_EXCEPTION : FPGA_INVALID_PARAM;
+	}
+
+	if (validate_bitstream_metadata(fpga, buf) != FPGA_OK) {
+		OPAE_MSG("Invalid JSON data");
+		opae_free(buf);
+		return FPGA_INVALID_PARAM;
+	}
+
+	while (true) {
+		if (capacity - len < RECONF_READ_CHUNK) {
+			p = realloc(buf, capacity * 2);
+			if (!p) {
+				OPAE_ERR("Could not allocate memory for bitstream");
+				opae_free(buf);
+				return FPGA_NO_MEMORY;
+			}
+			buf = p;
+			capacity *= 2;
+		}
+
+		n = read_bitstream_fd(fd, buf + len, RECONF_READ_CHUNK);
+		if (n < 0) {
+			OPAE_ERR("Failed to read bitstream: %s", strerror(errno));
+			opae_free(buf);
+			return FPGA_EXCEPTION;
+		}
+
+		len += (size_t)n;
+		if (n < RECONF_READ_CHUNK)
+			break;
+	}
+
+	*bitstream = buf;
+	*bitstream_len = len;
+
+	return FPGA_OK;
+}
+
+fpga_result __XFPGA_API__ xfpga_fpgaReconfigureSlotByFd(fpga_handle fpga,
+							uint32_t slot,
+							int fd,
+							int flags)
+{
+	fpga_result result;
+	struct stat st;
+	void *map = NULL;
+	size_t map_len = 0;
+	const uint8_t *mapped = NULL;
+	uint8_t *buf = NULL;
+	size_t len = 0;
+
+	if (!fpga) {
+		OPAE_ERR("NULL handle");
+		return FPGA_INVALID_PARAM;
+	}
+
+	if (fd < 0 || fstat(fd, &st)) {
+		OPAE_ERR("Invalid bitstream file descriptor");
+		return FPGA_INVALID_PARAM;
+	}
+
+	// The PR ioctl takes the whole image in one user buffer, so
+	// a regular file is mapped rather than copied onto the heap.
+	if (S_ISREG(st.st_mode)) {
+		result = map_bitstream_fd(fd, &st, &map, &map_len,
+					  &mapped, &len);
+		if (result == FPGA_OK) {
+			result = xfpga_fpgaReconfigureSlot(fpga, slot, mapped,
+							   len, flags);
+			munmap(map, map_len);
+			lseek(fd, 0, SEEK_END);
+			return result;
+		}
+		if (result != FPGA_NOT_SUPPORTED) {
+			OPAE_MSG("Invalid bitstream file offset");
+			return result;
+		}
+	}
+
+	result = read_streamed_bitstream(fpga, fd, &buf, &len);
+	if (result != FPGA_OK)
+		return result;
+
+	result = xfpga_fpgaReconfigureSlot(fpga, slot, buf, len, flags);
+	opae_free(buf);
+
+	return result;
+}
@@ -94,6 +94,9 @@
 
 // Get file descriptor from event handle
 #define FILE_DESCRIPTOR(eh) (((struct _fpga_event_handle *)eh)->fd)
+
+// Number of MMIO regions eligible for the lock-free fast path
+#define XFPGA_MMIO_FAST_REGIONS 8
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -142,6 +145,15 @@ struct _fpga_enum_metric {
 
 	uint64_t mmio_offset;                            // AFU Metric BBS mmio offset
 
+	uint32_t flags;                                  // FPGA_ENUM_METRIC_* flags
+#define FPGA_ENUM_METRIC_FD_OPEN 0x00000001              // value_fd is open
+#define FPGA_ENUM_METRIC_LIMITS  0x00000002              // limits are valid
+
+	int value_fd;                                    // Cached metric_sysfs fd
+
+	double low_limit;                                // Plausible value range
+	double high_limit;
+
 };
 
 
@@ -174,8 +186,14 @@ struct _fpga_handle {
 	void *bmc_handle;                                    // bmc module handle
 	struct _fpga_bmc_metric *_bmc_metric_cache_value;    // bmc cache values
 	uint64_t num_bmc_metric;                             // num of bmc values
-#define OPAE_FLAG_HAS_MMX512 (1u << 0)
+#define OPAE_FLAG_HAS_MMX512    (1u << 0)
+#define OPAE_FLAG_MMIO_FASTPATH (1u << 1)
 	uint32_t flags;
+
+	// Lock-free MMIO fast path (see mmio.c)
+	struct wsid_map *mmio_fast[XFPGA_MMIO_FAST_REGIONS]; // published regions
+	uint32_t mmio_fast_epoch[XFPGA_MMIO_FAST_REGIONS];   // current epoch, 0 or 1
+	uint32_t mmio_fast_users[XFPGA_MMIO_FAST_REGIONS][2]; // accessors in flight, per epoch
 };
 
 /*
@@ -206,10 +224,18 @@ struct wsid_map {
 
 /*
  * Hash table to store wsid_maps
+ *
+ * Bucket i is guarded by shard_locks[i % n_shards]. When index_table is
+ * present (see wsid_tracker_init_indexed()), the first map added for each
+ * index below n_index_slots is also reachable directly by index.
  */
 struct wsid_tracker {
 	uint64_t          n_hash_buckets;
 	struct wsid_map **table;
+	uint32_t          n_shards;
+	pthread_mutex_t  *shard_locks;
+	uint32_t          n_index_slots;
+	struct wsid_map **index_table;
 };
 
 /*
@@ -30,14 +30,41 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <pthread.h>
+#include <opae/log.h>
 #include "wsid_list_int.h"
 #include "mock/opae_std.h"
 
 /*
- * The code here assumes the caller handles any required mutexes.
- * The logic here is not thread safe on its own.
+ * The tracker serializes its own updates. Each hash bucket belongs to
+ * one of up to WSID_MAX_SHARDS lock shards, so that threads working on
+ * different wsids rarely contend. A struct wsid_map returned by
+ * wsid_find() or wsid_find_by_index() remains valid until its wsid is
+ * deleted; callers that may race with a delete of the same wsid should
+ * use wsid_lookup() or wsid_take(), which copy the entry under the lock.
  */
+#define WSID_MAX_SHARDS 64
+
+static inline pthread_mutex_t *wsid_shard(struct wsid_tracker *root,
+					  uint32_t bucket)
+{
+	return &root->shard_locks[bucket % root->n_shards];
+}
+
+static inline void wsid_lock(pthread_mutex_t *lock)
+{
+	int err = pthread_mutex_lock(lock);
+	if (err)
+		OPAE_ERR("pthread_mutex_lock() failed: %s", strerror(err));
+}
+
+static inline void wsid_unlock(pthread_mutex_t *lock)
+{
+	int err = pthread_mutex_unlock(lock);
+	if (err)
+		OPAE_ERR("pthread_mutex_unlock() failed: %s", strerror(err));
+}
 
 /**
  * @brief Initialize a wsid tracker hash table
@@ -47,21 +74,62 @@
  */
 struct wsid_tracker *wsid_tracker_init(uint32_t n_hash_buckets)
 {
+	return wsid_tracker_init_indexed(n_hash_buckets, 0);
+}
+
+/**
+ * @brief Initialize a wsid tracker hash table with a direct index table
+ *        wsid_find_by_index() is O(1) for index < n_index_slots.
+ * @param n_hash_buckets
+ * @param n_index_slots
+ *
+ * @return
+ */
+struct wsid_tracker *wsid_tracker_init_indexed(uint32_t n_hash_buckets,
+					       uint32_t n_index_slots)
+{
+	uint32_t i;
+
 	if (!n_hash_buckets || (n_hash_buckets > 16384))
 		return NULL;
 
-	struct wsid_tracker *root = opae_malloc(sizeof(struct wsid_tracker));
+	struct wsid_tracker *root = opae_calloc(1, sizeof(struct wsid_tracker));
 	if (!root)
 		return NULL;
 
 	root->n_hash_buckets = n_hash_buckets;
 	root->table = opae_calloc(n_hash_buckets, sizeof(struct wsid_map *));
-	if (!root->table) {
-		opae_free(root);
-		return NULL;
+	if (!root->table)
+		goto out_free;
+
+	root->n_shards = (n_hash_buckets < WSID_MAX_SHARDS) ?
+		n_hash_buckets : WSID_MAX_SHARDS;
+	root->shard_locks = opae_calloc(root->n_shards, sizeof(pthread_mutex_t));
+	if (!root->shard_locks)
+		goto out_free;
+
+	for (i = 0 ; i < root->n_shards ; ++i)
+		pthread_mutex_init(&root->shard_locks[i], NULL);
+
+	if (n_index_slots) {
+		root->index_table = opae_calloc(n_index_slots,
+						sizeof(struct wsid_map *));
+		if (!root->index_table)
+			goto out_free;
+		root->n_index_slots = n_index_slots;
 	}
 
 	return root;
+
+out_free:
+	if (root->shard_locks) {
+		for (i = 0 ; i < root->n_shards ; ++i)
+			pthread_mutex_destroy(&root->shard_locks[i]);
+		opae_free(root->shard_locks);
+	}
+	opae_free(root->table);
+	opae_free(root);
+	return NULL;
 }
 
 /**
@@ -77,6 +145,31 @@ static inline uint32_t wsid_hash(struct wsid_tracker *root, uint64_t wsid)
 	return h % root->n_hash_buckets;
 }
 
+static inline void wsid_index_publish(struct wsid_tracker *root,
+				      struct wsid_map *wm)
+{
+	struct wsid_map *expected = NULL;
+
+	if (wm->index >= root->n_index_slots)
+		return;
+
+	__atomic_compare_exchange_n(&root->index_table[wm->index],
+				    &expected, wm, false,
+				    __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+}
+
+static inline void wsid_index_retire(struct wsid_tracker *root,
+				     struct wsid_map *wm)
+{
+	struct wsid_map *expected = wm;
+
+	if (wm->index >= root->n_index_slots)
+		return;
+
+	__atomic_compare_exchange_n(&root->index_table[wm->index],
+				    &expected, NULL, false,
+				    __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+}
 
 /**
  * @brief Add entry to WSID tracker
@@ -101,6 +194,7 @@ bool wsid_add(struct wsid_tracker *root,
 	      int flags)
 {
 	uint32_t idx = wsid_hash(root, wsid);
+	pthread_mutex_t *lock = wsid_shard(root, idx);
 	struct wsid_map *tmp = opae_malloc(sizeof(struct wsid_map));
 
 	if (!tmp)
@@ -113,12 +207,39 @@ bool wsid_add(struct wsid_tracker *root,
 	tmp->offset = offset;
 	tmp->index  = index;
 	tmp->flags  = flags;
-	tmp->next   = root->table[idx];
 
+	wsid_lock(lock);
+	tmp->next   = root->table[idx];
 	root->table[idx] = tmp;
+	wsid_index_publish(root, tmp);
+	wsid_unlock(lock);
+
 	return true;
 }
 
+/*
+ * Unlink the entry for wsid from its bucket, with the shard lock held.
+ * Returns the unlinked entry, or NULL if not found.
+ */
+static struct wsid_map *wsid_unlink(struct wsid_tracker *root,
+				    uint32_t idx,
+				    uint64_t wsid)
+{
+	struct wsid_map **link = &root->table[idx];
+
+	while (*link && (*link)->wsid != wsid)
+		link = &(*link)->next;
+
+	if (!*link)
+		return NULL; /* not found */
+
+	struct wsid_map *tmp = *link;
+	*link = tmp->next;
+	wsid_index_retire(root, tmp);
+
+	return tmp;
+}
+
 /**
  * @brief Remove entry from tracker
  *
@@ -128,29 +249,37 @@ bool wsid_add(struct wsid_tracker *root,
  * @return true if success, false otherwise
  */
 bool wsid_del(struct wsid_tracker *root, uint64_t wsid)
+{
+	return wsid_take(root, wsid, NULL);
+}
+
+/**
+ * @brief Remove entry from tracker, returning a copy of it
+ *
+ * @param root
+ * @param wsid
+ * @param out  receives the removed entry (may be NULL)
+ *
+ * @return true if success, false otherwise
+ */
+bool wsid_take(struct wsid_tracker *root, uint64_t wsid, struct wsid_map *out)
 {
 	uint32_t idx = wsid_hash(root, wsid);
-	struct wsid_map *tmp = root->table[idx];
+	pthread_mutex_t *lock = wsid_shard(root, idx);
+	struct wsid_map *tmp;
 
-	if (!tmp)
-		return false; /* empty list */
+	wsid_lock(lock);
+	tmp = wsid_unlink(root, idx, wsid);
+	wsid_unlock(lock);
 
-	if (tmp->wsid == wsid) { /* first entry */
-		root->table[idx] = root->table[idx]->next;
-		opae_free(tmp);
-		return true;
-	}
+	if (!tmp)
+		return false;
 
-	while (tmp->next && tmp->next->wsid != wsid) { /* find */
-		tmp = tmp->next;
+	if (out) {
+		*out = *tmp;
+		out->next = NULL;
 	}
-
-	if (!tmp->next)
-		return false; /* not found */
-
-	struct wsid_map *tmp2 = tmp->next;
-	tmp->next = tmp->next->next;
-	opae_free(tmp2);
+	opae_free(tmp);
 
 	return true;
 }
@@ -181,6 +310,11 @@ void wsid_tracker_cleanup(struct wsid_tracker *root,
 		}
 	}
 
+	for (idx = 0; idx < root->n_shards; idx += 1)
+		pthread_mutex_destroy(&root->shard_locks[idx]);
+
+	opae_free(root->shard_locks);
+	opae_free(root->index_table);
 	opae_free(root->table);
 	opae_free(root);
 }
@@ -196,14 +330,46 @@ void wsid_tracker_cleanup(struct wsid_tracker *root,
 struct wsid_map *wsid_find(struct wsid_tracker *root, uint64_t wsid)
 {
 	uint32_t idx = wsid_hash(root, wsid);
-	struct wsid_map *tmp = root->table[idx];
+	pthread_mutex_t *lock = wsid_shard(root, idx);
+	struct wsid_map *tmp;
 
+	wsid_lock(lock);
+	tmp = root->table[idx];
 	while (tmp && tmp->wsid != wsid)
 		tmp = tmp->next;
+	wsid_unlock(lock);
 
 	return tmp;
 }
 
+/**
+ * @brief Copy the entry for wsid
+ *
+ * @param root
+ * @param wsid
+ * @param out  receives the entry
+ *
+ * @return true if found, false otherwise
+ */
+bool wsid_lookup(struct wsid_tracker *root, uint64_t wsid, struct wsid_map *out)
+{
+	uint32_t idx = wsid_hash(root, wsid);
+	pthread_mutex_t *lock = wsid_shard(root, idx);
+	struct wsid_map *tmp;
+
+	wsid_lock(lock);
+	tmp = root->table[idx];
+	while (tmp && tmp->wsid != wsid)
+		tmp = tmp->next;
+	if (tmp) {
+		*out = *tmp;
+		out->next = NULL;
+	}
+	wsid_unlock(lock);
+
+	return tmp != NULL;
+}
+
 /**
  * @ brief Find entry in linked list
  *
@@ -214,16 +380,26 @@ struct wsid_map *wsid_find(struct wsid_tracker *root, uint64_t wsid)
  */
 struct wsid_map *wsid_find_by_index(struct wsid_tracker *root, uint32_t index)
 {
-    /*
-     * The hash table isn't set up for finding by index, but this search is
-     * used only for MMIO spaces, which should have a small number of entries.
-     */
 	uint32_t idx;
+
+	if (index < root->n_index_slots)
+		return __atomic_load_n(&root->index_table[index],
+				       __ATOMIC_ACQUIRE);
+
+	/*
+	 * The hash table isn't set up for finding by index, but this search
+	 * is used only for MMIO spaces, which should have a small number of
+	 * entries.
+	 */
 	for (idx = 0; idx < root->n_hash_buckets; idx += 1) {
-		struct wsid_map *tmp = root->table[idx];
+		pthread_mutex_t *lock = wsid_shard(root, idx);
+		struct wsid_map *tmp;
 
+		wsid_lock(lock);
+		tmp = root->table[idx];
 		while (tmp && tmp->index != index)
 			tmp = tmp->next;
+		wsid_unlock(lock);
 
 		if (tmp)
 			return tmp;
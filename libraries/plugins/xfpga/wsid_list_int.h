@@ -34,6 +34,8 @@
  * WSID tracking structure manipulation functions
  */
 struct wsid_tracker *wsid_tracker_init(uint32_t n_hash_buckets);
+struct wsid_tracker *wsid_tracker_init_indexed(uint32_t n_hash_buckets,
+					       uint32_t n_index_slots);
 void wsid_tracker_cleanup(struct wsid_tracker *root, void (*clean)(struct wsid_map *));
 
 bool wsid_add(struct wsid_tracker *root,
@@ -45,9 +47,11 @@ bool wsid_add(struct wsid_tracker *root,
 	      uint64_t index,
 	      int      flags);
 bool wsid_del(struct wsid_tracker *root, uint64_t wsid);
+bool wsid_take(struct wsid_tracker *root, uint64_t wsid, struct wsid_map *out);
 uint64_t wsid_gen(void);
 
 struct wsid_map *wsid_find(struct wsid_tracker *root, uint64_t wsid);
+bool wsid_lookup(struct wsid_tracker *root, uint64_t wsid, struct wsid_map *out);
 struct wsid_map *wsid_find_by_index(struct wsid_tracker *root, uint32_t index);
 
 #endif // ___FPGA_COMMON_INT_H__
@@ -52,6 +52,11 @@ fpga_result xfpga_fpgaReadMMIO32(fpga_handle handle, uint32_t mmio_num,
 				 uint64_t offset, uint32_t *value);
 fpga_result xfpga_fpgaWriteMMIO512(fpga_handle handle, uint32_t mmio_num,
 				  uint64_t offset, const void *value);
+fpga_result xfpga_fpgaReadMMIOBatch(fpga_handle handle, uint32_t mmio_num,
+				    fpga_mmio_op *ops, uint32_t num_ops);
+fpga_result xfpga_fpgaWriteMMIOBatch(fpga_handle handle, uint32_t mmio_num,
+				     const fpga_mmio_op *ops,
+				     uint32_t num_ops);
 fpga_result xfpga_fpgaMapMMIO(fpga_handle handle, uint32_t mmio_num,
 			      uint64_t **mmio_ptr);
 fpga_result xfpga_fpgaUnmapMMIO(fpga_handle handle, uint32_t mmio_num);
@@ -100,6 +105,8 @@ fpga_result xfpga_fpgaReleaseFromInterface(fpga_handle fpga,
 fpga_result xfpga_fpgaReconfigureSlot(fpga_handle fpga, uint32_t slot,
 				      const uint8_t *bitstream,
 				      size_t bitstream_len, int flags);
+fpga_result xfpga_fpgaReconfigureSlotByFd(fpga_handle fpga, uint32_t slot,
+					  int fd, int flags);
 fpga_result xfpga_fpgaTokenGetObject(fpga_token token, const char *name,
 				     fpga_object *object, int flags);
 fpga_result xfpga_fpgaHandleGetObject(fpga_token handle, const char *name,
@@ -145,6 +152,10 @@ fpga_result xfpga_fpgaGetMetricsThresholdInfo(fpga_handle handle,
 			metric_threshold *metric_threshold,
 			uint32_t *num_thresholds);
 
+fpga_result xfpga_fpgaGetMetricsAll(fpga_handle handle,
+				    fpga_metric *metrics,
+				    uint64_t *num_metrics);
+
 #ifdef __cplusplus
 }
 #endif // __cplusplus
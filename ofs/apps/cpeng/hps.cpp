@@ -31,6 +31,7 @@
 #include <unistd.h>
 #include "afu_test.h"
 #include "ofs_cpeng.h"
+#include "ofs_cpeng_ring.h"
 
 const char *cpeng_guid = "44bfc10d-b42a-44e5-bd42-57dc93ea7f91";
 
@@ -66,6 +67,7 @@ public:
     , timeout_usec_(default_timeout_usec.count())
     , chunk_(pg_size)
     , data_request_limit_(512)
+    , buffers_(2)
     , soft_reset_(false)
     , skip_ssbl_verify_(false)
     , skip_kernel_verify_(false)
@@ -106,6 +108,11 @@ public:
       ->check(CLI::IsMember(limits));
     app->add_option("-c,--chunk", chunk_, "Chunk size. 0 indicates no chunks")
       ->default_str(std::to_string(chunk_));
+    app->add_option("-b,--buffers", buffers_,
+                    "Number of chunk buffers. More than 1 overlaps "
+                    "reading the file with the copy")
+      ->default_str(std::to_string(buffers_))
+      ->check(CLI::Range(1, 64));
     app->add_flag("--soft-reset", soft_reset_, "Issue soft reset only");
     app->add_flag("--skip-ssbl-verify", skip_ssbl_verify_, "Do not wait for ssbl verify");
     app->add_flag("--skip-kernel-verify", skip_kernel_verify_, "Do not wait for kernel verify");
@@ -144,63 +151,47 @@ public:
     // if chunk_ CLI arg is 0, use the file size
     // otherwise, use the smaller of chunk_ and file size
     size_t chunk = chunk_ ? std::min(static_cast<size_t>(chunk_), sz) : sz;
-    shared_buffer::ptr_t buffer(0);
+    // a single buffer holds the entire file, so there is nothing to overlap
+    uint32_t n_buffers = chunk < sz ? buffers_ : 1;
+    std::vector<shared_buffer::ptr_t> buffers;
+    std::vector<ofs_cpeng_buffer> ring;
     // make sure we align our buffer size to data request limit
     try {
-      buffer = shared_buffer::allocate(afu->handle(),
-                                       aligned(chunk, data_request_limit_));
+      for (uint32_t i = 0; i < n_buffers; ++i) {
+        auto buffer = shared_buffer::allocate(afu->handle(),
+                                              aligned(chunk, data_request_limit_));
+        auto ptr = const_cast<uint8_t*>(buffer->c_type());
+        memset(ptr, 0, buffer->size());
+        ring.push_back({ptr, buffer->io_address(),
+                        static_cast<uint32_t>(buffer->size())});
+        buffers.push_back(buffer);
+      }
     } catch (opae_exception &ex) {
-      log_->error("could not allocate {} bytes of memory", chunk);
+      log_->error("could not allocate {} buffer(s) of {} bytes",
+                  n_buffers, chunk);
       if (chunk > pg_size) {
         auto hugepage_sz = chunk <= MB(2) ? "2MB" : "1GB";
         log_->error("might need {} hugepages reserved", hugepage_sz);
       }
       return 3;
     }
-    // get a char* of the buffer so we can read into it every chunk iteration
-    auto ptr = reinterpret_cast<char*>(const_cast<uint8_t*>(buffer->c_type()));
-
-    memset(ptr, 0, buffer->size());
-    size_t written = 0;
-    log_->info("starting copy of file:{}, size: {}, chunk size: {}",
-               filename_, sz, chunk);
-    uint32_t n_chunks = 0;
-    // set our xfer size to chunk size
-    // but align it with req. limit size in case
-    // our chunk is the entire file
-    auto xfer_sz = aligned(chunk, data_request_limit_);
+
+    log_->info("starting copy of file:{}, size: {}, chunk size: {}, buffers: {}",
+               filename_, sz, chunk, n_buffers);
     // set the data req. limit to CLI arg (default arg is 512, default in HW is 1k)
     ofs_cpeng_set_data_req_limit(&cpeng, limit_map[data_request_limit_]);
-    while (written < sz) {
-        auto unread = sz-written;
-        inp.read(ptr, chunk);
-        if (ofs_cpeng_copy_chunk(
-              &cpeng, buffer->io_address(),
-              destination_offset_ + written,
-              xfer_sz,
-              timeout_usec_)) {
-          auto status = ofs_cpeng_dma_status(&cpeng);
-          log_->warn("copy chunk: {}, size: {}, unread: {}, dma_status: {:x}",
-                      n_chunks, xfer_sz, unread, status);
-          if (dmastatus_err(&cpeng)) {
-            return 4;
-          }
-        }
-        ++n_chunks;
-        written += chunk;
-        // if we're at the last chunk,
-        // 1. zero out our buffer
-        // 2. set 'chunk' to number of unread bytes
-        // 3. set 'xfer_sz' to the req. limit aligned value of the last chunk
-        if (unread < chunk) {
-          memset(ptr, 0, chunk);
-          chunk = unread;
-          xfer_sz = aligned(chunk, data_request_limit_);
-          log_->info("last chunk {}, aligned {}", chunk, xfer_sz);
-        }
+    reader rd { &inp, sz, chunk, 0 };
+    // the last chunk is zero padded up to the req. limit aligned size
+    if (ofs_cpeng_copy_image_ring(&cpeng, ring.data(), ring.size(),
+                                  destination_offset_, data_request_limit_,
+                                  read_chunk, &rd, timeout_usec_)) {
+      auto status = ofs_cpeng_dma_status(&cpeng);
+      log_->error("copy failed, chunks read: {}, dma_status: {:x}",
+                  rd.n_chunks, status);
+      dmastatus_err(&cpeng);
+      return 4;
     }
-    log_->info("transferred file in {} chunk(s)", n_chunks);
-    ofs_cpeng_image_complete(&cpeng);
+    log_->info("transferred file in {} chunk(s)", rd.n_chunks);
 
     // wait for both ssbl and kernel verify (if not skipped)
     if (!skip_ssbl_verify_) {
@@ -215,6 +206,28 @@ public:
 
 
 private:
+  struct reader {
+    std::ifstream *inp;
+    size_t size;
+    size_t chunk;
+    uint32_t n_chunks;
+  };
+
+  // called from the cpeng ring reader thread to load the next chunk
+  static int64_t read_chunk(void *context, ofs_cpeng_buffer *buf, uint64_t offset)
+  {
+    auto rd = reinterpret_cast<reader*>(context);
+    if (offset >= rd->size) {
+      return 0;
+    }
+    auto count = std::min(rd->chunk, rd->size - offset);
+    if (!rd->inp->read(reinterpret_cast<char*>(buf->ptr), count)) {
+      return -1;
+    }
+    ++rd->n_chunks;
+    return count;
+  }
+
   bool dmastatus_err(ofs_cpeng *cpeng)
   {
     if (ofs_cpeng_dma_status_error(cpeng)) {
@@ -260,6 +273,7 @@ private:
   uint32_t timeout_usec_;
   uint32_t chunk_;
   uint32_t data_request_limit_;
+  uint32_t buffers_;
   bool soft_reset_;
   bool skip_ssbl_verify_;
   bool skip_kernel_verify_;
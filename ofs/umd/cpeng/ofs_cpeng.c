@@ -24,4 +24,175 @@
 // ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
 // POSSIBILITY OF SUCH DAMAGE.
 
+#include <errno.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
 #include "ofs_cpeng.h"
+#include "ofs_cpeng_ring.h"
+
+typedef struct _cpeng_ring {
+	pthread_mutex_t lock;
+	pthread_cond_t filled;
+	pthread_cond_t drained;
+	ofs_cpeng_buffer *buffers;
+	int64_t *lengths;
+	uint32_t size;
+	uint64_t head; // number of buffers filled
+	uint64_t tail; // number of buffers copied
+	bool eof;
+	bool abort;
+	bool error;
+	ofs_cpeng_fill_fn fill;
+	void *context;
+} cpeng_ring;
+
+static void *cpeng_ring_reader(void *arg)
+{
+	cpeng_ring *r = (cpeng_ring *)arg;
+	uint64_t offset = 0;
+	uint32_t slot;
+	int64_t len;
+
+	pthread_mutex_lock(&r->lock);
+	while (!r->abort) {
+		while (r->head - r->tail == r->size && !r->abort)
+			pthread_cond_wait(&r->drained, &r->lock);
+		if (r->abort)
+			break;
+		slot = r->head % r->size;
+		pthread_mutex_unlock(&r->lock);
+
+		len = r->fill(r->context, &r->buffers[slot], offset);
+
+		pthread_mutex_lock(&r->lock);
+		if (len < 0 || len > (int64_t)r->buffers[slot].size) {
+			OFS_ERR("fill failed at offset 0x%" PRIx64, offset);
+			r->error = true;
+			r->eof = true;
+		} else if (!len) {
+			r->eof = true;
+		} else {
+			r->lengths[slot] = len;
+			offset += len;
+			++r->head;
+		}
+		pthread_cond_signal(&r->filled);
+		if (r->eof)
+			break;
+	}
+	pthread_mutex_unlock(&r->lock);
+	return NULL;
+}
+
+int ofs_cpeng_copy_image_ring(ofs_cpeng *drv,
+			      ofs_cpeng_buffer *ring,
+			      uint32_t ring_size,
+			      uint64_t offset,
+			      uint32_t align,
+			      ofs_cpeng_fill_fn fill,
+			      void *context,
+			      uint64_t timeout_usec)
+{
+	cpeng_ring r;
+	pthread_t reader;
+	uint64_t xfer;
+	uint32_t slot;
+	int64_t len;
+	int res = 0;
+
+	if (!drv || !ring || !ring_size || !fill) {
+		OFS_ERR("invalid buffer ring parameters");
+		return 1;
+	}
+	if (!align)
+		align = 1;
+
+	memset(&r, 0, sizeof(r));
+	r.buffers = ring;
+	r.size = ring_size;
+	r.fill = fill;
+	r.context = context;
+	r.lengths = calloc(ring_size, sizeof(int64_t));
+	if (!r.lengths) {
+		OFS_ERR("calloc failed");
+		return 1;
+	}
+	pthread_mutex_init(&r.lock, NULL);
+	pthread_cond_init(&r.filled, NULL);
+	pthread_cond_init(&r.drained, NULL);
+
+	if (pthread_create(&reader, NULL, cpeng_ring_reader, &r)) {
+		OFS_ERR("failed to create ring reader: %s", strerror(errno));
+		res = 1;
+		goto out_destroy;
+	}
+
+	while (true) {
+		pthread_mutex_lock(&r.lock);
+		while (r.tail == r.head && !r.eof)
+			pthread_cond_wait(&r.filled, &r.lock);
+		if (r.tail == r.head) {
+			pthread_mutex_unlock(&r.lock);
+			break;
+		}
+		slot = r.tail % r.size;
+		len = r.lengths[slot];
+		pthread_mutex_unlock(&r.lock);
+
+		// pad the copy up to the alignment with zeros
+		xfer = (len + align - 1) / align * align;
+		if (xfer > ring[slot].size) {
+			OFS_ERR("buffer size %u is not aligned to %u",
+				ring[slot].size, align);
+			res = 1;
+			break;
+		}
+		if (xfer > (uint64_t)len)
+			memset((uint8_t *)ring[slot].ptr + len, 0, xfer - len);
+
+		if (ofs_cpeng_copy_chunk(drv, ring[slot].iova, offset,
+					 xfer, timeout_usec)) {
+			// Only a DMA error status aborts the copy. Otherwise
+			// the chunk is reported and the copy carries on, as
+			// hps has always done.
+			if (ofs_cpeng_dma_status_error(drv)) {
+				res = 1;
+				break;
+			}
+			OFS_ERR("copy of chunk at offset 0x%" PRIx64 " failed, continuing",
+				offset);
+		} else if (OFS_WAIT_FOR_EQ(drv->r_CSR_HOST2CE_MRD_START->f_MRD_START,
+				    0, timeout_usec, 100)) {
+			OFS_ERR("timed out waiting for MRD_START");
+			res = 1;
+			break;
+		}
+		offset += len;
+
+		pthread_mutex_lock(&r.lock);
+		++r.tail;
+		pthread_cond_signal(&r.drained);
+		pthread_mutex_unlock(&r.lock);
+	}
+
+	pthread_mutex_lock(&r.lock);
+	r.abort = true;
+	pthread_cond_signal(&r.drained);
+	pthread_mutex_unlock(&r.lock);
+	pthread_join(reader, NULL);
+
+	if (r.error)
+		res = 1;
+	if (!res)
+		ofs_cpeng_image_complete(drv);
+
+out_destroy:
+	pthread_cond_destroy(&r.drained);
+	pthread_cond_destroy(&r.filled);
+	pthread_mutex_destroy(&r.lock);
+	free(r.lengths);
+	return res;
+}
@@ -0,0 +1,96 @@
+// Copyright(c) 2024, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef __OFS_CPENG_RING_H__
+#define __OFS_CPENG_RING_H__
+#include <stdint.h>
+#include "ofs_cpeng.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * A DMA-able buffer used as one slot of a copy engine buffer ring.
+ * ptr is the host virtual address, iova the address programmed into
+ * the copy engine, size the usable size of the buffer in bytes.
+ */
+typedef struct _ofs_cpeng_buffer {
+	void *ptr;
+	uint64_t iova;
+	uint32_t size;
+} ofs_cpeng_buffer;
+
+/**
+ * Fill callback for ofs_cpeng_copy_image_ring.
+ *
+ * Called from the ring reader thread to load the next part of the image
+ * into buf->ptr. offset is the image offset of the first byte to be loaded.
+ * Returns the number of bytes loaded (at most buf->size), 0 at the end of
+ * the image or a negative value on error. Every fill except the last one
+ * is expected to return a multiple of the alignment given to
+ * ofs_cpeng_copy_image_ring.
+ */
+typedef int64_t (*ofs_cpeng_fill_fn)(void *context,
+				     ofs_cpeng_buffer *buf,
+				     uint64_t offset);
+
+/**
+ * Copy an image to HPS memory through a ring of DMA buffers.
+ *
+ * A reader thread calls fill() to load the ring while the calling thread
+ * hands the filled buffers, in order, to the copy engine. Loading buffer
+ * N+1 therefore overlaps with the copy of buffer N. The size of each copy
+ * is padded with zeros up to a multiple of align, so every buffer must be
+ * sized to a multiple of align. A copy that fails without the DMA error
+ * status set is logged and skipped; a DMA error status aborts the copy.
+ * On success the image is marked complete.
+ *
+ * @param[in] drv          Initialized copy engine driver.
+ * @param[in] ring         Array of ring_size buffers.
+ * @param[in] ring_size    Number of buffers in ring (at least 1).
+ * @param[in] offset       Destination offset in HPS memory.
+ * @param[in] align        Copy size alignment (the data request limit).
+ * @param[in] fill         Callback used to load a buffer.
+ * @param[in] context      Opaque pointer passed to fill.
+ * @param[in] timeout_usec Timeout for each copy.
+ * @returns 0 on success, non-zero if a fill failed or the copy engine
+ *          reported a DMA error.
+ */
+int ofs_cpeng_copy_image_ring(ofs_cpeng *drv,
+			      ofs_cpeng_buffer *ring,
+			      uint32_t ring_size,
+			      uint64_t offset,
+			      uint32_t align,
+			      ofs_cpeng_fill_fn fill,
+			      void *context,
+			      uint64_t timeout_usec);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __OFS_CPENG_RING_H__
@@ -24,11 +24,18 @@
 // ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
 // POSSIBILITY OF SUCH DAMAGE.
 #pragma once
+#include <sys/wait.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+
 #include <opae/cxx/core/events.h>
 #include <opae/cxx/core/shared_buffer.h>
 #include <opae/cxx/core/token.h>
 
 #include "afu_test.h"
+#include "host_exerciser_sweep.h"
 
 namespace host_exerciser {
 using opae::fpga::types::event;
@@ -37,6 +44,7 @@ using opae::fpga::types::token;
 
 static const uint64_t HELPBK_TEST_TIMEOUT = 30000;
 static const uint64_t HELPBK_TEST_SLEEP_INVL = 100;
+static const uint64_t HE_SWEEP_SAMPLE_INVL = 1000;
 static const uint64_t CL = 64;
 static const uint64_t KB = 1024;
 static const uint64_t MB = KB * 1024;
@@ -372,6 +380,14 @@ indicating one of the following series of read/write requests:
 1: rd-rd-wr-wr
 2: rd-rd-rd-rd-wr-wr-wr-wr)desc";
 
+// Sweep help
+const char *sweep_help = R"desc(Run every combination of the --sweep-* parameter lists in
+continuous mode and write one record per combination, including
+bandwidth, clock ticks and host-side MMIO read latency percentiles
+sampled while the test is running)desc";
+
+const std::vector<std::string> he_sweep_modes = { "read", "write", "trput" };
+
 
 class host_exerciser : public test_afu {
 public:
@@ -380,6 +396,7 @@ public:
   , count_(1)
   , he_interleave_(0)
   , he_interrupt_(0xffff)
+  , he_sweep_num_instances_(1)
   {
     // Mode
     app_.add_option("-m,--mode", he_modes_, "host exerciser mode {lpbk,read, write, trput}")
@@ -420,6 +437,39 @@ public:
 
     app_.add_option("--clock-mhz", he_clock_mhz_,
         "Clock frequency (MHz) -- when zero, read the frequency from the AFU")->default_val("0");
+
+    // Parameter sweep
+    app_.add_option("--sweep", he_sweep_, sweep_help)->default_val("false");
+
+    app_.add_option("--sweep-cls", he_sweep_cls_,
+        "Request lengths to sweep (default: all supported)")
+        ->check(CLI::IsMember(he_req_cls_len))->delimiter(',');
+
+    app_.add_option("--sweep-mode", he_sweep_modes_,
+        "Read/write mixes to sweep {read, write, trput} (default: all)")
+        ->check(CLI::IsMember(he_sweep_modes))->delimiter(',');
+
+    app_.add_option("--sweep-interleave", he_sweep_interleave_,
+        "Throughput mode interleave patterns to sweep (default: --interleave)")
+        ->check(CLI::Range(0, 2))->delimiter(',');
+
+    app_.add_option("--sweep-time", he_sweep_time_,
+        "Continuous mode durations in seconds to sweep (default: --contmodetime)")
+        ->check(CLI::Range(1, 3600))->delimiter(',');
+
+    app_.add_option("--sweep-format", he_sweep_format_, "Sweep output format {json, csv}")
+        ->transform(CLI::CheckedTransformer(he_sweep_format))->default_val("json");
+
+    app_.add_option("--sweep-output", he_sweep_output_,
+        "Sweep output file, - for stdout")->default_val("-");
+
+    app_.add_option("--sweep-pci-address", he_sweep_pci_addr_,
+        "Run the sweep concurrently on the host exercisers at these PCIe addresses")
+        ->delimiter(',');
+
+    app_.add_option("--sweep-instances", he_sweep_instances_,
+        "Numbers of concurrent instances to sweep (default: one per --sweep-pci-address)")
+        ->delimiter(',');
    }
 
   virtual int run(CLI::App *app, test_command::ptr_t test) override
@@ -429,9 +479,21 @@ public:
     logger_->set_pattern("    %v");
     // Info prints details of an individual run. Turn it on if doing only one test
     // and the user hasn't changed level from the default.
-    if ((log_level_.compare("warning") == 0) && !he_test_all_)
+    if ((log_level_.compare("warning") == 0) && !he_test_all_ && !he_sweep_)
         logger_->set_level(spdlog::level::info);
 
+    // A sweep easily outlasts the default test timeout. Unless one was
+    // given, allow for every grid point plus the time to reset between them.
+    if (he_sweep_ && !option_passed("--timeout"))
+        timeout_msec_ = static_cast<uint32_t>(
+            std::max<uint64_t>(timeout_msec_, he_sweep_time_msec()));
+
+    if (he_sweep_ && !he_sweep_pci_addr_.empty()) {
+      res = run_sweep_instances(app, test);
+      spdlog::drop_all();
+      return res;
+    }
+
     logger_->info("starting test run, count of {0:d}", count_);
     uint32_t count = 0;
     try {
@@ -555,6 +617,16 @@ public:
   uint32_t he_interrupt_;
   uint32_t he_contmodetime_;
   uint32_t he_clock_mhz_;
+  bool he_sweep_;
+  std::vector<std::string> he_sweep_cls_;
+  std::vector<std::string> he_sweep_modes_;
+  std::vector<uint32_t> he_sweep_interleave_;
+  std::vector<uint32_t> he_sweep_time_;
+  uint32_t he_sweep_format_;
+  std::string he_sweep_output_;
+  std::vector<std::string> he_sweep_pci_addr_;
+  std::vector<uint32_t> he_sweep_instances_;
+  uint32_t he_sweep_num_instances_;
 
   std::map<uint32_t, uint32_t> limits_;
 
@@ -578,6 +650,121 @@ public:
     return handle_device_->get_token();
   }
 
+  // Run the sweep in one worker process per --sweep-pci-address, for
+  // each number of concurrent instances, and merge the records. Each
+  // worker opens its own handle, since a host exerciser can't be
+  // shared between processes.
+  int run_sweep_instances(CLI::App *app, test_command::ptr_t test)
+  {
+    std::vector<uint32_t> instances = he_sweep_instances_;
+    std::vector<he_sweep_result> results;
+    int res = exit_codes::success;
+
+    if (instances.empty())
+      instances.push_back(he_sweep_pci_addr_.size());
+    for (auto n : instances) {
+      if (!n || n > he_sweep_pci_addr_.size()) {
+        logger_->error("--sweep-instances {0} must be between 1 and the "
+                       "number of --sweep-pci-address values", n);
+        return exit_codes::error;
+      }
+    }
+
+    std::ofstream file;
+    if (he_sweep_output_ != "-") {
+      file.open(he_sweep_output_);
+      if (!file.is_open()) {
+        logger_->error("Failed to open sweep output {0}", he_sweep_output_);
+        return exit_codes::error;
+      }
+    }
+    std::ostream &os = file.is_open() ? file : std::cout;
+
+    // Release the handles opened by main(). The workers may need them.
+    handle_.reset();
+    handle_device_.reset();
+
+    bool spawn_failed = false;
+    for (auto n : instances) {
+      std::vector<std::pair<pid_t, std::string>> workers;
+
+      logger_->debug("sweep: {0} concurrent instances", n);
+      for (uint32_t i = 0; i < n; ++i) {
+        char path[] = "/tmp/host_exerciser_sweep_XXXXXX";
+        int fd = mkstemp(path);
+        if (fd < 0) {
+          logger_->error("mkstemp failed: {0}", strerror(errno));
+          spawn_failed = true;
+          break;
+        }
+        close(fd);
+
+        pid_t pid = fork();
+        if (pid < 0) {
+          logger_->error("fork failed: {0}", strerror(errno));
+          unlink(path);
+          spawn_failed = true;
+          break;
+        }
+
+        if (!pid) {
+          pci_addr_ = he_sweep_pci_addr_[i];
+          he_sweep_num_instances_ = n;
+          he_sweep_format_ = HE_SWEEP_FORMAT_CSV;
+          he_sweep_output_ = path;
+
+          int status = open_handle(test->afu_id());
+          if (status == exit_codes::not_run)
+            status = test_afu::run(app, test);
+          std::cout.flush();
+          _exit(status);
+        }
+
+        workers.push_back(std::make_pair(pid, std::string(path)));
+      }
+
+      for (const auto &w : workers) {
+        int wstatus = 0;
+
+        if (waitpid(w.first, &wstatus, 0) < 0 ||
+            !WIFEXITED(wstatus) || WEXITSTATUS(wstatus))
+          res = exit_codes::error;
+
+        std::ifstream in(w.second);
+        if (!he_sweep_read_csv(in, results)) {
+          logger_->error("malformed sweep records from worker {0}", w.first);
+          res = exit_codes::error;
+        }
+        unlink(w.second.c_str());
+      }
+
+      if (spawn_failed) {
+        res = exit_codes::error;
+        break;
+      }
+    }
+
+    he_sweep_write(os, he_sweep_format_, results);
+
+    return res;
+  }
+
+  // Upper bound on the wall time of a sweep, in msec.
+  uint64_t he_sweep_time_msec()
+  {
+    uint64_t points = he_sweep_cls_.empty() ? he_req_cls_len.size() : he_sweep_cls_.size();
+    uint64_t seconds = 0;
+
+    points *= he_sweep_modes_.empty() ? he_sweep_modes.size() : he_sweep_modes_.size();
+    points *= he_sweep_interleave_.empty() ? 1 : he_sweep_interleave_.size();
+    if (he_sweep_time_.empty())
+      seconds = he_contmodetime_ + 2;
+    for (auto t : he_sweep_time_)
+      seconds += t + 2;
+
+    return std::min<uint64_t>(points * seconds * 1000, UINT32_MAX);
+  }
+
   bool option_passed(std::string option_str)
   {
       if (app_.count(option_str) == 0)
@@ -26,6 +26,8 @@
 #pragma once
 
 #include <unistd.h>
+#include <chrono>
+#include <fstream>
 
 #include "afu_test.h"
 #include "host_exerciser.h"
@@ -375,7 +377,25 @@ public:
         return 0;
     }
 
-    bool he_continuousmode()
+    // Sample the host-side latency of an MMIO status read for one
+    // second while the test runs, instead of sleeping.
+    void he_sample_mmio_latency(std::vector<uint64_t> &samples)
+    {
+        auto end = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+
+        while (!g_he_exit) {
+            auto start = std::chrono::steady_clock::now();
+            if (start >= end)
+                break;
+            host_exe_->read64(HE_STATUS0);
+            auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count();
+            samples.push_back(static_cast<uint64_t>(ns));
+            usleep(HE_SWEEP_SAMPLE_INVL);
+        }
+    }
+
+    bool he_continuousmode(std::vector<uint64_t> *latency = nullptr)
     {
         uint32_t count = 0;
         if (host_exe_->he_continuousmode_ && host_exe_->he_contmodetime_ > 0)
@@ -384,7 +404,10 @@ public:
             host_exe_->logger_->debug("Ctrl+C  to stop continuous mode");
 
             while (!g_he_exit) {
-                sleep(1);
+                if (latency)
+                    he_sample_mmio_latency(*latency);
+                else
+                    sleep(1);
                 count++;
                 if (count > host_exe_->he_contmodetime_)
                     break;
@@ -502,7 +525,9 @@ public:
     }
 
     // The test state has been configured. Run one test instance.
-    int run_single_test()
+    // In continuous mode, MMIO read latency samples are appended to
+    // latency when it is given.
+    int run_single_test(std::vector<uint64_t> *latency = nullptr)
     {
         int status = 0;
 
@@ -559,7 +584,7 @@ public:
             }
         } else if (host_exe_->he_continuousmode_) {
             // Continuous mode
-            he_continuousmode();
+            he_continuousmode(latency);
 
             if (host_exe_->logger_->should_log(spdlog::level::debug)) {
                 std::cout << std::endl;
@@ -729,6 +754,128 @@ public:
         return status;
     }
 
+    std::string he_device_address()
+    {
+        auto props = fpga::properties::get(token_);
+        char addr[32];
+
+        snprintf(addr, sizeof(addr), "%04x:%02x:%02x.%x",
+                 uint32_t(props->segment), uint32_t(props->bus),
+                 uint32_t(props->device), uint32_t(props->function));
+        return std::string(addr);
+    }
+
+    // Run every combination of the sweep parameter lists in continuous
+    // mode and emit one record per combination as JSON or CSV.
+    int run_sweep()
+    {
+        int status = 0;
+        std::vector<std::string> cls_list = host_exe_->he_sweep_cls_;
+        std::vector<std::string> mode_list = host_exe_->he_sweep_modes_;
+        std::vector<uint32_t> interleave_list = host_exe_->he_sweep_interleave_;
+        std::vector<uint32_t> time_list = host_exe_->he_sweep_time_;
+
+        if (cls_list.empty()) {
+            for (auto cls = he_req_cls_len.begin(); cls != he_req_cls_len.end(); ++cls) {
+                if (cls->second > he_lpbk_max_reqlen_) break;
+                cls_list.push_back(cls->first);
+            }
+        }
+        for (const auto &cls : cls_list) {
+            if (he_req_cls_len.at(cls) > he_lpbk_max_reqlen_) {
+                std::cerr << "Request length " << cls
+                          << " is not supported by this platform." << std::endl;
+                return -1;
+            }
+        }
+        if (mode_list.empty())
+            mode_list = he_sweep_modes;
+        if (interleave_list.empty())
+            interleave_list.push_back(host_exe_->he_interleave_);
+        if (time_list.empty())
+            time_list.push_back(host_exe_->he_contmodetime_ ? host_exe_->he_contmodetime_ : 1);
+
+        std::ofstream file;
+        if (host_exe_->he_sweep_output_ != "-") {
+            file.open(host_exe_->he_sweep_output_);
+            if (!file.is_open()) {
+                std::cerr << "Failed to open sweep output "
+                          << host_exe_->he_sweep_output_ << std::endl;
+                return -1;
+            }
+        }
+        std::ostream &os = file.is_open() ? file : std::cout;
+
+        volatile he_dsm_status *dsm_status =
+            reinterpret_cast<he_dsm_status *>((uint8_t*)dsm_->c_type());
+        std::string device = he_device_address();
+        std::vector<he_sweep_result> results;
+
+        he_lpbk_cfg_.AtomicFunc = HOSTEXE_ATOMIC_OFF;
+        he_lpbk_cfg_.IntrTestMode = 0;
+        host_exe_->he_continuousmode_ = true;
+        he_lpbk_cfg_.Continuous = 1;
+
+        for (const auto &cls : cls_list) {
+            set_cfg_reqlen(he_req_cls_len.at(cls));
+
+            for (const auto &mode : mode_list) {
+                he_lpbk_cfg_.TestMode = he_modes.at(mode);
+
+                for (size_t i = 0; i < interleave_list.size(); ++i) {
+                    // Interleave only applies to throughput mode.
+                    uint32_t interleave = 0;
+                    if (he_lpbk_cfg_.TestMode == HOST_EXEMODE_TRPUT)
+                        interleave = interleave_list[i];
+                    else if (i > 0)
+                        break;
+                    he_lpbk_cfg_.TputInterleave = interleave;
+
+                    for (const auto seconds : time_list) {
+                        if (g_he_exit)
+                            break;
+
+                        host_exe_->he_contmodetime_ = seconds;
+                        host_exe_->logger_->debug("sweep: {0} {1} interleave {2} {3}s",
+                                                  cls, mode, interleave, seconds);
+
+                        std::vector<uint64_t> latency;
+                        latency.reserve(size_t(seconds + 1) * 1000000 / HE_SWEEP_SAMPLE_INVL);
+                        int test_status = run_single_test(&latency);
+                        status |= test_status;
+
+                        he_sweep_result r = {};
+                        r.device = device;
+                        r.instances = host_exe_->he_sweep_num_instances_;
+                        r.cls = cls;
+                        r.mode = mode;
+                        r.interleave = interleave;
+                        r.seconds = seconds;
+                        r.status = test_status;
+                        r.num_ticks = dsm_num_ticks(dsm_status);
+                        r.num_reads = dsm_num_reads(dsm_status);
+                        r.num_writes = dsm_num_writes(dsm_status);
+
+                        uint64_t num_lines = r.num_reads + r.num_writes;
+                        if (he_lpbk_cfg_.TestMode == HOST_EXEMODE_READ)
+                            num_lines = r.num_reads;
+                        else if (he_lpbk_cfg_.TestMode == HOST_EXEMODE_WRITE)
+                            num_lines = r.num_writes;
+                        if (r.num_ticks)
+                            r.bandwidth = he_num_xfers_to_bw(num_lines, r.num_ticks);
+
+                        he_sweep_latency(latency, r);
+                        results.push_back(r);
+                    }
+                }
+            }
+        }
+
+        he_sweep_write(os, host_exe_->he_sweep_format_, results);
+
+        return status;
+    }
+
     virtual int run(test_afu *afu, CLI::App *app)
     {
         (void)app;
@@ -873,7 +1020,9 @@ public:
         d_afu->write64(HE_NUM_LINES, (LPBK1_BUFFER_SIZE / (1 * CL)) -1);
 
         int status = 0;
-        if (host_exe_->he_test_all_)
+        if (host_exe_->he_sweep_)
+            status = run_sweep();
+        else if (host_exe_->he_test_all_)
             status = run_all_tests();
         else
             status = run_single_test();
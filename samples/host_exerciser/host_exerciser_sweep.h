@@ -0,0 +1,211 @@
+// Copyright(c) 2024, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <istream>
+#include <map>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace host_exerciser {
+
+enum {
+  HE_SWEEP_FORMAT_JSON = 0,
+  HE_SWEEP_FORMAT_CSV = 1,
+};
+
+const std::map<std::string, uint32_t> he_sweep_format = {
+  { "json", HE_SWEEP_FORMAT_JSON},
+  { "csv", HE_SWEEP_FORMAT_CSV},
+};
+
+// One point of the sweep grid, and what was measured for it.
+struct he_sweep_result {
+  std::string device;       // PCIe address of the AFU that ran the point
+  uint32_t instances;       // host exercisers running the grid concurrently
+  std::string cls;          // request length, as spelled on the command line
+  std::string mode;         // read, write or trput
+  uint32_t interleave;
+  uint32_t seconds;         // continuous-mode duration
+  int status;
+  uint64_t num_ticks;
+  uint64_t num_reads;
+  uint64_t num_writes;
+  double bandwidth;         // GB/s
+  uint64_t samples;         // host-side MMIO latency samples taken
+  double lat_p50;           // ns
+  double lat_p90;
+  double lat_p99;
+  double lat_max;
+};
+
+// Nearest-rank percentile (pct in [0, 100]) of a sorted sample set.
+inline double he_percentile(const std::vector<uint64_t> &sorted, double pct)
+{
+  if (sorted.empty())
+    return 0.0;
+  size_t rank = static_cast<size_t>(std::ceil(pct * sorted.size() / 100.0));
+  if (rank < 1)
+    rank = 1;
+  if (rank > sorted.size())
+    rank = sorted.size();
+  return static_cast<double>(sorted[rank - 1]);
+}
+
+inline void he_sweep_latency(std::vector<uint64_t> &samples,
+                             he_sweep_result &r)
+{
+  std::sort(samples.begin(), samples.end());
+  r.samples = samples.size();
+  r.lat_p50 = he_percentile(samples, 50.0);
+  r.lat_p90 = he_percentile(samples, 90.0);
+  r.lat_p99 = he_percentile(samples, 99.0);
+  r.lat_max = he_percentile(samples, 100.0);
+}
+
+inline void he_sweep_write_csv(std::ostream &os,
+                               const std::vector<he_sweep_result> &results)
+{
+  os << "device,instances,cls,mode,interleave,seconds,status,num_ticks,"
+        "num_reads,num_writes,bandwidth_gbps,latency_samples,latency_p50_ns,"
+        "latency_p90_ns,latency_p99_ns,latency_max_ns" << std::endl;
+  os << std::fixed;
+  for (const auto &r : results) {
+    os << r.device << ","
+       << r.instances << ","
+       << r.cls << ","
+       << r.mode << ","
+       << r.interleave << ","
+       << r.seconds << ","
+       << (r.status ? "FAIL" : "PASS") << ","
+       << r.num_ticks << ","
+       << r.num_reads << ","
+       << r.num_writes << ","
+       << std::setprecision(3) << r.bandwidth << ","
+       << r.samples << ","
+       << std::setprecision(0) << r.lat_p50 << ","
+       << r.lat_p90 << ","
+       << r.lat_p99 << ","
+       << r.lat_max << std::endl;
+  }
+}
+
+inline void he_sweep_write_json(std::ostream &os,
+                                const std::vector<he_sweep_result> &results)
+{
+  os << "[" << std::endl;
+  os << std::fixed;
+  for (size_t i = 0; i < results.size(); ++i) {
+    const auto &r = results[i];
+    os << "  {"
+       << "\"device\": \"" << r.device << "\", "
+       << "\"instances\": " << r.instances << ", "
+       << "\"cls\": \"" << r.cls << "\", "
+       << "\"mode\": \"" << r.mode << "\", "
+       << "\"interleave\": " << r.interleave << ", "
+       << "\"seconds\": " << r.seconds << ", "
+       << "\"status\": \"" << (r.status ? "FAIL" : "PASS") << "\", "
+       << "\"num_ticks\": " << r.num_ticks << ", "
+       << "\"num_reads\": " << r.num_reads << ", "
+       << "\"num_writes\": " << r.num_writes << ", "
+       << "\"bandwidth_gbps\": " << std::setprecision(3) << r.bandwidth << ", "
+       << "\"latency_ns\": {"
+       << "\"samples\": " << r.samples << ", "
+       << std::setprecision(0)
+       << "\"p50\": " << r.lat_p50 << ", "
+       << "\"p90\": " << r.lat_p90 << ", "
+       << "\"p99\": " << r.lat_p99 << ", "
+       << "\"max\": " << r.lat_max << "}}"
+       << (i + 1 < results.size() ? "," : "") << std::endl;
+  }
+  os << "]" << std::endl;
+}
+
+// Parse records written by he_sweep_write_csv() and append them to
+// results. Returns false if a line is malformed.
+inline bool he_sweep_read_csv(std::istream &is,
+                              std::vector<he_sweep_result> &results)
+{
+  std::string line;
+
+  if (!std::getline(is, line)) // header
+    return true;
+
+  while (std::getline(is, line)) {
+    std::vector<std::string> f;
+    std::stringstream ss(line);
+    std::string field;
+
+    if (line.empty())
+      continue;
+    while (std::getline(ss, field, ','))
+      f.push_back(field);
+    if (f.size() != 16)
+      return false;
+
+    he_sweep_result r = {};
+    try {
+      r.device = f[0];
+      r.instances = static_cast<uint32_t>(std::stoul(f[1]));
+      r.cls = f[2];
+      r.mode = f[3];
+      r.interleave = static_cast<uint32_t>(std::stoul(f[4]));
+      r.seconds = static_cast<uint32_t>(std::stoul(f[5]));
+      r.status = (f[6] == "PASS") ? 0 : 1;
+      r.num_ticks = std::stoull(f[7]);
+      r.num_reads = std::stoull(f[8]);
+      r.num_writes = std::stoull(f[9]);
+      r.bandwidth = std::stod(f[10]);
+      r.samples = std::stoull(f[11]);
+      r.lat_p50 = std::stod(f[12]);
+      r.lat_p90 = std::stod(f[13]);
+      r.lat_p99 = std::stod(f[14]);
+      r.lat_max = std::stod(f[15]);
+    } catch (std::exception &) {
+      return false;
+    }
+    results.push_back(r);
+  }
+
+  return true;
+}
+
+inline void he_sweep_write(std::ostream &os, uint32_t format,
+                           const std::vector<he_sweep_result> &results)
+{
+  if (format == HE_SWEEP_FORMAT_CSV)
+    he_sweep_write_csv(os, results);
+  else
+    he_sweep_write_json(os, results);
+}
+
+} // end of namespace host_exerciser
@@ -35,6 +35,10 @@ fpga_result opae_bitstream_read_file(const char *file,
 				     uint8_t **buf,
 				     size_t *len);
 
+fpga_result opae_bitstream_map_file(const char *file,
+				    uint8_t **buf,
+				    size_t *len);
+
 void opae_resolve_legacy_bitstream(opae_bitstream_info *info);
 
 void *opae_bitstream_parse_metadata(const char *metadata,
@@ -110,6 +114,25 @@ TEST_P(bitstream_c_p, read_err0) {
 	    FPGA_EXCEPTION);
 }
 
+/**
+ * @test       map_err0
+ * @brief      Test: opae_bitstream_map_file
+ * @details    If the given file doesn't exist,<br>
+ *             the fn returns FPGA_EXCEPTION.<br>
+ *             If the given path is not a regular file,<br>
+ *             the fn returns FPGA_NOT_SUPPORTED.<br>
+ */
+TEST_P(bitstream_c_p, map_err0) {
+  uint8_t *buf = nullptr;
+  size_t len = 0;
+  EXPECT_EQ(opae_bitstream_map_file("doesntexist", &buf, &len),
+	    FPGA_EXCEPTION);
+  EXPECT_EQ(opae_bitstream_map_file("/dev/null", &buf, &len),
+	    FPGA_NOT_SUPPORTED);
+  EXPECT_EQ(buf, nullptr);
+  EXPECT_EQ(len, 0);
+}
+
 /**
  * @test       is_legacy
  * @brief      Test: opae_is_legacy_bitstream
@@ -320,6 +343,37 @@ TEST_P(bitstream_c_p, load_ok0) {
   EXPECT_EQ(opae_unload_bitstream(&info), FPGA_OK);
 }
 
+/**
+ * @test       load_ok1
+ * @brief      Test: opae_load_bitstream
+ * @details    Given a GBS file with metadata,<br>
+ *             the fn maps the file read-only, parses a<br>
+ *             NUL-terminated heap copy of the metadata,<br>
+ *             leaves the file contents unmodified<br>
+ *             and returns FPGA_OK.<br>
+ */
+TEST_P(bitstream_c_p, load_ok1) {
+  std::vector<uint8_t> gbs_data(null_gbs_);
+  gbs_data.insert(gbs_data.end(), 64, 0xa5);
+
+  std::ofstream gbs;
+  gbs.open(tmpnull_gbs_, std::ios::out|std::ios::binary);
+  gbs.write((const char *)gbs_data.data(), gbs_data.size());
+  gbs.close();
+
+  opae_bitstream_info info;
+  ASSERT_EQ(opae_load_bitstream(tmpnull_gbs_, &info), FPGA_OK);
+  EXPECT_TRUE(info.data_mapped);
+  ASSERT_EQ(info.data_len, gbs_data.size());
+  EXPECT_EQ(memcmp(info.data, gbs_data.data(), info.data_len), 0);
+  EXPECT_EQ(info.rbf_data, info.data + null_gbs_.size());
+  EXPECT_EQ(info.rbf_len, 64);
+  EXPECT_EQ(info.metadata_version, 1);
+  EXPECT_NE(info.parsed_metadata, nullptr);
+  EXPECT_EQ(opae_unload_bitstream(&info), FPGA_OK);
+  EXPECT_EQ(info.data, nullptr);
+}
+
 /**
  * @test       unload_err0
  * @brief      Test: opae_unload_bitstream
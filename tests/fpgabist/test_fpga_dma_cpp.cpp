@@ -0,0 +1,101 @@
+// Copyright(c) 2024, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif // HAVE_CONFIG_H
+
+#include "gtest/gtest.h"
+
+#include "fpga_dma_internal.h"
+#include "fpga_dma.h"
+
+class fpga_dma_vec : public ::testing::Test {
+ protected:
+  fpga_dma_vec()
+  : transfer_(nullptr)
+  {}
+
+  virtual void SetUp() override
+  {
+    dma_.ch_type = TX_ST;
+    ASSERT_EQ(fpgaDMATransferInit(&transfer_), FPGA_OK);
+    ASSERT_EQ(fpgaDMATransferSetTransferType(transfer_, HOST_MM_TO_FPGA_ST),
+              FPGA_OK);
+  }
+
+  virtual void TearDown() override
+  {
+    EXPECT_EQ(fpgaDMATransferDestroy(&transfer_), FPGA_OK);
+  }
+
+  struct fpga_dma_handle dma_;
+  fpga_dma_transfer_t transfer_;
+};
+
+/**
+ * @test    misaligned_middle
+ * @brief   Test: fpgaDMATransferVec()
+ * @details Only the first and last segments of a packet carry<br>
+ *          SOP and EOP, so a middle segment that is not a whole<br>
+ *          number of cache lines is rejected with<br>
+ *          FPGA_INVALID_PARAM before anything is enqueued.<br>
+ */
+TEST_F(fpga_dma_vec, misaligned_middle)
+{
+  const fpga_dma_segment_t segs[] = {
+    { 0x1000, 0, 64 },
+    { 0x2000, 0, 100 },
+    { 0x3000, 0, 36 },
+  };
+
+  ASSERT_EQ(fpgaDMATransferSetTxControl(transfer_, GENERATE_SOP_AND_EOP),
+            FPGA_OK);
+  EXPECT_EQ(fpgaDMATransferVec(&dma_, transfer_, segs, 3),
+            FPGA_INVALID_PARAM);
+  EXPECT_TRUE(dma_.ingress_queue.empty());
+}
+
+/**
+ * @test    misaligned_first
+ * @brief   Test: fpgaDMATransferVec()
+ * @details With GENERATE_EOP, the first segment is issued without<br>
+ *          packet signalling, so it must be a whole number of<br>
+ *          cache lines.<br>
+ */
+TEST_F(fpga_dma_vec, misaligned_first)
+{
+  const fpga_dma_segment_t segs[] = {
+    { 0x1000, 0, 100 },
+    { 0x2000, 0, 36 },
+  };
+
+  ASSERT_EQ(fpgaDMATransferSetTxControl(transfer_, GENERATE_EOP),
+            FPGA_OK);
+  EXPECT_EQ(fpgaDMATransferVec(&dma_, transfer_, segs, 2),
+            FPGA_INVALID_PARAM);
+  EXPECT_TRUE(dma_.ingress_queue.empty());
+}
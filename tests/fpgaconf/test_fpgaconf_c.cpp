@@ -43,6 +43,9 @@ struct config {
        } mode;
   int flags;
   char *filename;
+  bool stream;
+  bool all;
+  unsigned int jobs;
 };
 extern struct config config;
 
@@ -64,6 +67,18 @@ int find_fpga(fpga_properties device_filter,
 int program_bitstream(fpga_token token, uint32_t slot_num,
                       opae_bitstream_info *info, int flags);
 
+int program_bitstream_fd(fpga_token token, uint32_t slot_num,
+                         int fd, int flags);
+
+int stream_bitstream(fpga_properties device_filter, uint32_t slot_num);
+
+int find_all_fpgas(fpga_properties device_filter,
+                   fpga_guid interface_id,
+                   fpga_token **fpgas);
+
+int program_all(fpga_properties device_filter, uint32_t slot_num,
+                opae_bitstream_info *info);
+
 int fpgaconf_main(int argc, char *argv[]);
 
 }
@@ -344,6 +359,54 @@ TEST_P(fpgaconf_c_p, parse_args3) {
   EXPECT_NE(parse_args(2, (char**)argv), 0);
 }
 
+/**
+ * @test       parse_args4
+ * @brief      Test: parse_args
+ * @details    When given --stream,<br>
+ *             parse_args sets config.stream and accepts "-"<br>
+ *             as the gbs file name for stdin.<br>
+ */
+TEST_P(fpgaconf_c_p, parse_args4) {
+  const char *argv[] = { "fpgaconf", "--stream", "-", NULL };
+  EXPECT_EQ(parse_args(3, (char**)argv), 0);
+  EXPECT_TRUE(config.stream);
+  ASSERT_NE(config.filename, nullptr);
+  EXPECT_STREQ(config.filename, "-");
+  opae_free(config.filename);
+  config.filename = nullptr;
+
+  // "-" is only stdin in streaming mode
+  config.stream = false;
+  optind = 0;
+  const char *argv2[] = { "fpgaconf", "-", NULL };
+  EXPECT_NE(parse_args(2, (char**)argv2), 0);
+}
+
+/**
+ * @test       parse_args5
+ * @brief      Test: parse_args
+ * @details    When given --all and a valid --jobs,<br>
+ *             parse_args populates config.all and config.jobs.<br>
+ *             An invalid --jobs, or --all with --stream,<br>
+ *             causes parse_args to fail.<br>
+ */
+TEST_P(fpgaconf_c_p, parse_args5) {
+  const char *argv[] = { "fpgaconf", "--all", "-j", "4", tmp_gbs_, NULL };
+  EXPECT_EQ(parse_args(5, (char**)argv), 0);
+  EXPECT_TRUE(config.all);
+  EXPECT_EQ(config.jobs, 4);
+  opae_free(config.filename);
+  config.filename = nullptr;
+
+  optind = 0;
+  const char *argv2[] = { "fpgaconf", "--all", "--jobs", "0", tmp_gbs_, NULL };
+  EXPECT_NE(parse_args(5, (char**)argv2), 0);
+
+  optind = 0;
+  const char *argv3[] = { "fpgaconf", "--all", "--stream", tmp_gbs_, NULL };
+  EXPECT_NE(parse_args(4, (char**)argv3), 0);
+}
+
 /**
  * @test       ifc_id1
  * @brief      Test: print_interface_id
@@ -979,6 +1042,157 @@ TEST_P(fpgaconf_c_mock_p, prog_bs2) {
   EXPECT_EQ(fpgaDestroyProperties(&filter), FPGA_OK);
 }
 
+/**
+ * @test       prog_bs_fd0
+ * @brief      Test: program_bitstream_fd
+ * @details    When config.dry_run is set to true,<br>
+ *             program_bitstream_fd skips the PR step and returns 1.<br>
+ *             Otherwise it attempts the PR, which fails to set<br>
+ *             user clocks, causing the function to return -1.<br>
+ */
+TEST_P(fpgaconf_c_mock_p, prog_bs_fd0) {
+  fpga_properties filter = NULL;
+
+  ASSERT_EQ(fpgaGetProperties(NULL, &filter), FPGA_OK);
+
+  ASSERT_EQ(fpgaPropertiesSetSegment(filter, platform_.devices[0].segment), FPGA_OK);
+  ASSERT_EQ(fpgaPropertiesSetBus(filter, platform_.devices[0].bus), FPGA_OK);
+  ASSERT_EQ(fpgaPropertiesSetDevice(filter, platform_.devices[0].device), FPGA_OK);
+  ASSERT_EQ(fpgaPropertiesSetFunction(filter, platform_.devices[0].function), FPGA_OK);
+
+  fpga_token tok = nullptr;
+  EXPECT_EQ(find_fpga(filter, NULL, &tok), 1);
+  ASSERT_NE(tok, nullptr);
+
+  int fd = opae_open(tmp_gbs_, O_RDONLY);
+  ASSERT_GE(fd, 0);
+
+  config.dry_run = true;
+  EXPECT_EQ(program_bitstream_fd(tok, 0, fd, 0), 1);
+
+  config.dry_run = false;
+  EXPECT_EQ(program_bitstream_fd(tok, 0, fd, 0), -1);
+
+  opae_close(fd);
+  EXPECT_EQ(fpgaDestroyToken(&tok), FPGA_OK);
+  EXPECT_EQ(fpgaDestroyProperties(&filter), FPGA_OK);
+}
+
+/**
+ * @test       main_stream0
+ * @brief      Test: fpgaconf_main
+ * @details    When --stream is given with a PCIe address that<br>
+ *             identifies a device, fpgaconf_main finds the device<br>
+ *             without loading the bitstream and returns 0 (dry run).<br>
+ *             When the gbs file can't be opened, it returns 2.<br>
+ */
+TEST_P(fpgaconf_c_mock_p, main_stream0) {
+  char zero[20];
+  char one[20];
+  char two[20];
+  char three[20];
+  char four[20];
+  char five[20];
+  strcpy(zero, "fpgaconf");
+  strcpy(one, "--stream");
+  strcpy(two, "-n");
+  strcpy(three, "-B");
+  sprintf(four, "%d", platform_.devices[0].bus);
+  strcpy(five, tmp_gbs_);
+
+  char *argv[] = { zero, one, two, three, four,
+                   five, NULL };
+
+  EXPECT_EQ(fpgaconf_main(6, argv), 0);
+
+  config.filename = opae_strdup("no-file.gbs");
+  EXPECT_EQ(stream_bitstream(NULL, 0), 2);
+  opae_free(config.filename);
+  config.filename = nullptr;
+}
+
+/**
+ * @test       find_all_fpgas0
+ * @brief      Test: find_all_fpgas
+ * @details    find_all_fpgas returns a token for every device<br>
+ *             matching the PR interface ID, or 0 when none match.<br>
+ */
+TEST_P(fpgaconf_c_mock_p, find_all_fpgas0) {
+  fpga_properties filter = NULL;
+  ASSERT_EQ(fpgaGetProperties(NULL, &filter), FPGA_OK);
+
+  fpga_guid pr_ifc_id;
+  ASSERT_EQ(uuid_parse(platform_.devices[0].fme_guid, pr_ifc_id), 0);
+
+  fpga_token *toks = nullptr;
+  int num = find_all_fpgas(filter, pr_ifc_id, &toks);
+  ASSERT_GE(num, 1);
+  ASSERT_NE(toks, nullptr);
+  for (int i = 0; i < num; ++i) {
+    EXPECT_EQ(fpgaDestroyToken(&toks[i]), FPGA_OK);
+  }
+  opae_free(toks);
+
+  EXPECT_EQ(find_all_fpgas(filter, test_guid, &toks), 0);
+  EXPECT_EQ(toks, nullptr);
+
+  EXPECT_EQ(fpgaDestroyProperties(&filter), FPGA_OK);
+}
+
+/**
+ * @test       prog_all0
+ * @brief      Test: program_all
+ * @details    When config.dry_run is set,<br>
+ *             program_all programs every matching slot (skipping PR)<br>
+ *             and returns 0. When no slot matches it returns 4.<br>
+ *             When PR fails (user clocks on mock), it returns 5.<br>
+ */
+TEST_P(fpgaconf_c_mock_p, prog_all0) {
+  fpga_properties filter = NULL;
+  ASSERT_EQ(fpgaGetProperties(NULL, &filter), FPGA_OK);
+
+  opae_bitstream_info info;
+  ASSERT_EQ(opae_load_bitstream(tmp_gbs_, &info), FPGA_OK);
+
+  config.dry_run = true;
+  config.jobs = 1;
+  EXPECT_EQ(program_all(filter, 0, &info), 0);
+
+  config.dry_run = false;
+  config.jobs = 0;
+  EXPECT_EQ(program_all(filter, 0, &info), 5);
+
+  memcpy(info.pr_interface_id, test_guid, sizeof(fpga_guid));
+  EXPECT_EQ(program_all(filter, 0, &info), 4);
+
+  EXPECT_EQ(opae_unload_bitstream(&info), FPGA_OK);
+  EXPECT_EQ(fpgaDestroyProperties(&filter), FPGA_OK);
+}
+
+/**
+ * @test       main_all0
+ * @brief      Test: fpgaconf_main
+ * @details    When --all is given with a valid bitstream,<br>
+ *             fpgaconf_main programs every matching slot<br>
+ *             and returns 0 (dry run).<br>
+ */
+TEST_P(fpgaconf_c_mock_p, main_all0) {
+  char zero[20];
+  char one[20];
+  char two[20];
+  char three[20];
+  char four[20];
+  strcpy(zero, "fpgaconf");
+  strcpy(one, "--all");
+  strcpy(two, "-n");
+  strcpy(three, "-V");
+  strcpy(four, tmp_gbs_);
+
+  char *argv[] = { zero, one, two, three, four, NULL };
+
+  EXPECT_EQ(fpgaconf_main(5, argv), 0);
+}
+
 GTEST_ALLOW_UNINSTANTIATED_PARAMETERIZED_TEST(fpgaconf_c_mock_p);
 INSTANTIATE_TEST_SUITE_P(fpgaconf_c, fpgaconf_c_mock_p,
                          ::testing::ValuesIn(test_platform::mock_platforms({"skx-p"})));
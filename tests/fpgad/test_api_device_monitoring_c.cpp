@@ -107,6 +107,46 @@ TEST_P(fpgad_device_monitoring_c_p, mon02) {
   EXPECT_EQ(d.num_error_occurrences, 0);
 }
 
+/**
+ * @test       watch01
+ * @brief      Test: mon_add_device_watch, mon_remove_device_watches
+ * @details    mon_add_device_watch opens the given attribute and adds<br>
+ *             its fd to the device's watch list, failing for missing<br>
+ *             files and when the list is full.<br>
+ *             mon_remove_device_watches closes them all.<br>
+ */
+TEST_P(fpgad_device_monitoring_c_p, watch01) {
+  fpgad_monitored_device d;
+  d.num_watches = 0;
+
+  char path[] = "/tmp/fpgad-watch-XXXXXX";
+  int fd = mkstemp(path);
+  ASSERT_GE(fd, 0);
+  ASSERT_EQ(write(fd, "0\n", 2), 2);
+  close(fd);
+
+  EXPECT_FALSE(mon_add_device_watch(&d, "/tmp/fpgad-no-such-file"));
+  EXPECT_EQ(d.num_watches, 0);
+
+  ASSERT_TRUE(mon_add_device_watch(&d, path));
+  ASSERT_TRUE(mon_add_device_watch(&d, path));
+  EXPECT_EQ(d.num_watches, 2);
+  EXPECT_GE(d.watch_fds[0], 0);
+  EXPECT_NE(d.watch_fds[0], d.watch_fds[1]);
+
+  fd = d.watch_fds[0];
+  mon_remove_device_watches(&d);
+  EXPECT_EQ(d.num_watches, 0);
+  EXPECT_EQ(fcntl(fd, F_GETFD), -1);
+
+  // Verify overflow checks
+  d.num_watches = MAX_DEV_WATCHES;
+  EXPECT_FALSE(mon_add_device_watch(&d, path));
+  d.num_watches = 0;
+
+  unlink(path);
+}
+
 GTEST_ALLOW_UNINSTANTIATED_PARAMETERIZED_TEST(fpgad_device_monitoring_c_p);
 INSTANTIATE_TEST_SUITE_P(fpgad_c, fpgad_device_monitoring_c_p,
                          ::testing::ValuesIn(test_platform::platforms({ "skx-p" })));
@@ -30,7 +30,26 @@
 extern "C" {
 #include "fpgad/api/opae_events_api.h"
 
-extern api_client_event_registry *event_registry_list;
+extern api_client_event_registry *event_registry_index[OPAE_API_EVENT_BUCKETS];
+extern api_client_event_registry *client_registry_index[OPAE_API_EVENT_BUCKETS];
+extern size_t num_event_registrations;
+
+unsigned event_bucket(fpga_event_type e, uint64_t object_id);
+unsigned client_bucket(int conn_socket);
+}
+
+static api_client_event_registry *find_registry(int conn_socket,
+                                                fpga_event_type e,
+                                                uint64_t object_id)
+{
+  api_client_event_registry *r;
+  for (r = event_registry_index[event_bucket(e, object_id)] ; r ; r = r->next) {
+    if (r->conn_socket == conn_socket &&
+        r->event == e &&
+        r->object_id == object_id)
+      return r;
+  }
+  return nullptr;
 }
 
 #define NO_OPAE_C
@@ -54,25 +73,23 @@ TEST_P(fpgad_opae_events_api_c_p, events01) {
  * @test       events02
  * @brief      Test: opae_api_unregister_event, opae_api_register_event
  * @details    Verifies the fn's ability to correctly remove<br>
- *             items from event_registry_list.<br>
+ *             items from the event registry.<br>
  */
 TEST_P(fpgad_opae_events_api_c_p, events02) {
   const int num = 4;
   int i;
   api_client_event_registry registries[] = {
-    { 0, -1, 0, FPGA_EVENT_ERROR, 0, NULL },
-    { 1, -1, 0, FPGA_EVENT_ERROR, 0, NULL },
-    { 2, -1, 0, FPGA_EVENT_ERROR, 0, NULL },
-    { 3, -1, 0, FPGA_EVENT_ERROR, 0, NULL },
+    { 0, -1, 0, FPGA_EVENT_ERROR, 0, NULL, NULL },
+    { 1, -1, 0, FPGA_EVENT_ERROR, 0, NULL, NULL },
+    { 2, -1, 0, FPGA_EVENT_ERROR, 0, NULL, NULL },
+    { 3, -1, 0, FPGA_EVENT_ERROR, 0, NULL, NULL },
   };
-  api_client_event_registry *l;
 
-  ASSERT_EQ(event_registry_list, (void *)NULL);
+  ASSERT_EQ(num_event_registrations, 0);
   EXPECT_NE(opae_api_unregister_event(0,
                                       FPGA_EVENT_ERROR,
                                       0), 0);
 
-  // 3 -> 2 -> 1 -> 0
   for (i = 0 ; i < num ; ++i) {
     api_client_event_registry *r = &registries[i];
     EXPECT_EQ(opae_api_register_event(r->conn_socket,
@@ -80,52 +97,35 @@ TEST_P(fpgad_opae_events_api_c_p, events02) {
                                       r->event,
                                       r->object_id), 0);
   }
+  EXPECT_EQ(num_event_registrations, num);
 
   // Try removing a registry that isn't there.
   EXPECT_NE(opae_api_unregister_event(4,
                                       FPGA_EVENT_ERROR,
                                       0), 0);
-
-  // remove 2
-  EXPECT_EQ(opae_api_unregister_event(2,
-                                      FPGA_EVENT_ERROR,
-                                      0), 0);
-  // 3 -> 1 -> 0
-  l = event_registry_list;
-  EXPECT_EQ(l->conn_socket, 3);
-  EXPECT_EQ(l->next->conn_socket, 1);
-  EXPECT_EQ(l->next->next->conn_socket, 0);
-  EXPECT_EQ(l->next->next->next, (void *)NULL);
-
-  // remove 3
-  EXPECT_EQ(opae_api_unregister_event(3,
-                                      FPGA_EVENT_ERROR,
+  EXPECT_NE(opae_api_unregister_event(0,
+                                      FPGA_EVENT_POWER_THERMAL,
                                       0), 0);
-   // 1 -> 0
-  l = event_registry_list;
-  EXPECT_EQ(l->conn_socket, 1);
-  EXPECT_EQ(l->next->conn_socket, 0);
-  EXPECT_EQ(l->next->next, (void *)NULL);
 
-  // remove 0
-  EXPECT_EQ(opae_api_unregister_event(0,
-                                      FPGA_EVENT_ERROR,
-                                      0), 0);
-  // 1 
-  l = event_registry_list;
-  EXPECT_EQ(l->conn_socket, 1);
-  EXPECT_EQ(l->next, (void *)NULL);
+  // remove 2, 3, 0, 1
+  const int order[] = { 2, 3, 0, 1 };
+  for (i = 0 ; i < num ; ++i) {
+    EXPECT_NE(find_registry(order[i], FPGA_EVENT_ERROR, 0), nullptr);
+    EXPECT_EQ(opae_api_unregister_event(order[i],
+                                        FPGA_EVENT_ERROR,
+                                        0), 0);
+    EXPECT_EQ(find_registry(order[i], FPGA_EVENT_ERROR, 0), nullptr);
+    EXPECT_EQ(client_registry_index[client_bucket(order[i])], nullptr);
+    EXPECT_EQ(num_event_registrations, num - i - 1);
+  }
 
-  // remove 1
-  EXPECT_EQ(opae_api_unregister_event(1,
-                                      FPGA_EVENT_ERROR,
-                                      0), 0);
-  EXPECT_EQ(event_registry_list, (void *)NULL);
+  EXPECT_EQ(event_registry_index[event_bucket(FPGA_EVENT_ERROR, 0)],
+            nullptr);
 }
 
 /**
  * @test       events03
- * @brief      Test: opae_api_send_EVENT_ERROR, check_and_send_EVENT_ERROR
+ * @brief      Test: opae_api_send_EVENT_ERROR
  * @details    Verifies the fn's ability to correctly signal<br>
  *             an FPGA_EVENT_ERROR.<br>
  */
@@ -134,21 +134,61 @@ TEST_P(fpgad_opae_events_api_c_p, events03) {
   memset(&d, 0, sizeof(d));
   d.object_id = 43;
 
-  ASSERT_EQ(event_registry_list, (void *)NULL);
+  ASSERT_EQ(num_event_registrations, 0);
 
   ASSERT_EQ(opae_api_register_event(0,
                                     -1,
                                     FPGA_EVENT_ERROR,
 				    43), 0);
+  ASSERT_EQ(opae_api_register_event(0,
+                                    -1,
+                                    FPGA_EVENT_ERROR,
+				    44), 0);
 
   opae_api_send_EVENT_ERROR(&d);
 
-  EXPECT_EQ(event_registry_list->data, 2);
+  EXPECT_EQ(find_registry(0, FPGA_EVENT_ERROR, 43)->data, 2);
+  EXPECT_EQ(find_registry(0, FPGA_EVENT_ERROR, 44)->data, 1);
 
   EXPECT_EQ(opae_api_unregister_event(0,
                                       FPGA_EVENT_ERROR,
                                       43), 0);
-  EXPECT_EQ(event_registry_list, (void *)NULL);
+  opae_api_unregister_all_events_for(0);
+  EXPECT_EQ(num_event_registrations, 0);
+}
+
+/**
+ * @test       events04
+ * @brief      Test: opae_api_unregister_all_events_for
+ * @details    Removes all of one client's registrations,<br>
+ *             including those of other clients that share<br>
+ *             its hash bucket, leaving the others.<br>
+ */
+TEST_P(fpgad_opae_events_api_c_p, events04) {
+  const int a = 5;
+  const int b = 5 + OPAE_API_EVENT_BUCKETS; // same client bucket as a
+  int i;
+
+  ASSERT_EQ(num_event_registrations, 0);
+
+  for (i = 0 ; i < 8 ; ++i) {
+    ASSERT_EQ(opae_api_register_event(a, -1, FPGA_EVENT_ERROR, i), 0);
+    ASSERT_EQ(opae_api_register_event(b, -1, FPGA_EVENT_ERROR, i), 0);
+  }
+  ASSERT_EQ(opae_api_register_event(a, -1, FPGA_EVENT_POWER_THERMAL, 0), 0);
+
+  opae_api_unregister_all_events_for(a);
+  EXPECT_EQ(num_event_registrations, 8);
+
+  for (i = 0 ; i < 8 ; ++i) {
+    EXPECT_EQ(find_registry(a, FPGA_EVENT_ERROR, i), nullptr);
+    EXPECT_NE(find_registry(b, FPGA_EVENT_ERROR, i), nullptr);
+  }
+  EXPECT_EQ(find_registry(a, FPGA_EVENT_POWER_THERMAL, 0), nullptr);
+
+  opae_api_unregister_all_events();
+  EXPECT_EQ(num_event_registrations, 0);
+  EXPECT_EQ(client_registry_index[client_bucket(b)], nullptr);
 }
 
 GTEST_ALLOW_UNINSTANTIATED_PARAMETERIZED_TEST(fpgad_opae_events_api_c_p);
@@ -33,21 +33,30 @@ extern "C" {
 
 #define EVENT_DISPATCH_QUEUE_DEPTH 512
 
+typedef struct _evt_dispatch_slot {
+  uint64_t seq;
+  event_dispatch_queue_item item;
+} evt_dispatch_slot;
+
 typedef struct _evt_dispatch_queue {
-  event_dispatch_queue_item q[EVENT_DISPATCH_QUEUE_DEPTH];
-  unsigned head;
-  unsigned tail;
-  pthread_mutex_t lock;
+  evt_dispatch_slot q[EVENT_DISPATCH_QUEUE_DEPTH];
+  uint64_t tail;
+  uint64_t head;
+  uint64_t drops;
+  uint64_t high_water;
+  uint64_t reported_high_water;
 } evt_dispatch_queue;
 
 extern evt_dispatch_queue normal_queue;
 extern evt_dispatch_queue high_priority_queue;
 
 bool evt_queue_is_full(evt_dispatch_queue *q);
+void evt_queue_init(evt_dispatch_queue *q);
 }
 
 #include <thread>
 #include <chrono>
+#include <vector>
 
 #define NO_OPAE_C
 #include "mock/opae_fixtures.h"
@@ -71,49 +80,111 @@ class fpgad_evt_c_p : public opae_base_p<> {
 
 };
 
+static void test_evt_response(fpgad_monitored_device *dev,
+                              void *context)
+{
+  UNUSED_PARAM(dev);
+  UNUSED_PARAM(context);
+}
+
 /**
  * @test       q_full0
  * @brief      Test: evt_queue_is_full
- * @details    When the fn is called on a full queue,<br>
- *             it returns true.<br>
+ * @details    The queue reports full once EVENT_DISPATCH_QUEUE_DEPTH<br>
+ *             items are queued, and not full again after one is taken,<br>
+ *             including after the ring has wrapped.<br>
  */
 TEST_P(fpgad_evt_c_p, q_full0) {
-  evt_dispatch_queue q;
+  fpgad_monitored_device d;
+  event_dispatch_queue_item item;
 
-  // case 0
-  q.head = 0;
-  q.tail = EVENT_DISPATCH_QUEUE_DEPTH - 1;
-  EXPECT_TRUE(evt_queue_is_full(&q));
+  evt_queue_init(&normal_queue);
 
-  // case 1
-  q.head = 1;
-  q.tail = 0;
-  EXPECT_TRUE(evt_queue_is_full(&q));
-}
+  for (int lap = 0 ; lap < 2 ; ++lap) {
+    while (!evt_queue_is_full(&normal_queue))
+      ASSERT_TRUE(evt_queue_response(test_evt_response, &d, NULL));
 
-static void test_evt_response(fpgad_monitored_device *dev,
-                              void *context)
-{
-  UNUSED_PARAM(dev);
-  UNUSED_PARAM(context);
+    EXPECT_EQ(normal_queue.tail - normal_queue.head,
+              EVENT_DISPATCH_QUEUE_DEPTH);
+
+    ASSERT_TRUE(evt_queue_get(&item));
+    EXPECT_EQ(item.device, &d);
+    EXPECT_FALSE(evt_queue_is_full(&normal_queue));
+
+    while (evt_queue_get(&item))
+      /* drain */ ;
+  }
+
+  EXPECT_EQ(normal_queue.high_water, EVENT_DISPATCH_QUEUE_DEPTH);
+  evt_queue_init(&normal_queue);
 }
 
 /**
  * @test       q_full1
  * @brief      Test: evt_queue_response
  * @details    When normal_queue is full,<br>
- *             the function logs an error and returns false.<br>
+ *             the function counts a drop and returns false.<br>
  */
 TEST_P(fpgad_evt_c_p, q_full1) {
   fpgad_monitored_device d;
+  event_dispatch_queue_item item;
+
+  evt_queue_init(&normal_queue);
+  for (int i = 0 ; i < EVENT_DISPATCH_QUEUE_DEPTH ; ++i)
+    ASSERT_TRUE(evt_queue_response(test_evt_response, &d, NULL));
 
-  normal_queue.head = 1;
-  normal_queue.tail = 0;
   EXPECT_FALSE(evt_queue_response(test_evt_response,
                                   &d,
                                   NULL));
-  normal_queue.head = 0;
-  normal_queue.tail = 0;
+  EXPECT_EQ(normal_queue.drops, 1);
+
+  while (evt_queue_get(&item))
+    /* drain */ ;
+  evt_queue_init(&normal_queue);
+}
+
+/**
+ * @test       mpsc
+ * @brief      Test: evt_queue_response, evt_queue_get
+ * @details    Items queued concurrently by several producers<br>
+ *             are each received exactly once.<br>
+ */
+TEST_P(fpgad_evt_c_p, mpsc) {
+  const int producers = 4;
+  const int per_producer = 5000;
+  std::vector<fpgad_monitored_device> devs(producers);
+  std::vector<int> seen(producers * per_producer, 0);
+  std::vector<std::thread> threads;
+
+  evt_queue_init(&normal_queue);
+
+  for (int p = 0 ; p < producers ; ++p) {
+    threads.push_back(std::thread([&devs, p, per_producer]() {
+      for (intptr_t i = 0 ; i < per_producer ; ) {
+        if (evt_queue_response(test_evt_response, &devs[p],
+                               (void *)(p * per_producer + i)))
+          ++i;
+      }
+    }));
+  }
+
+  int received = 0;
+  event_dispatch_queue_item item;
+  while (received < producers * per_producer) {
+    if (evt_queue_get(&item)) {
+      ++seen[(intptr_t)item.context];
+      ++received;
+    }
+  }
+
+  for (auto &t : threads)
+    t.join();
+
+  for (int i = 0 ; i < producers * per_producer ; ++i)
+    ASSERT_EQ(seen[i], 1);
+
+  EXPECT_FALSE(evt_queue_get(&item));
+  evt_queue_init(&normal_queue);
 }
 
 static void stop_running_response(fpgad_monitored_device *dev,
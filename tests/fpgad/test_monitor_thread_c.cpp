@@ -27,30 +27,74 @@
 #include <config.h>
 #endif // HAVE_CONFIG_H
 
+#include <poll.h>
+#include <thread>
+#include <chrono>
+
 extern "C" {
 #include "fpgad/api/logging.h"
 #include "fpgad/monitored_device.h"
 #include "fpgad/monitor_thread.h"
 #include "fpgad/event_dispatcher_thread.h"
+#include "mock/opae_std.h"
 
 #define EVENT_DISPATCH_QUEUE_DEPTH 512
 
+typedef struct _evt_dispatch_slot {
+  uint64_t seq;
+  event_dispatch_queue_item item;
+} evt_dispatch_slot;
+
 typedef struct _evt_dispatch_queue {
-  event_dispatch_queue_item q[EVENT_DISPATCH_QUEUE_DEPTH];
-  unsigned head;
-  unsigned tail;
-  pthread_mutex_t lock;
+  evt_dispatch_slot q[EVENT_DISPATCH_QUEUE_DEPTH];
+  uint64_t tail;
+  uint64_t head;
+  uint64_t drops;
+  uint64_t high_water;
+  uint64_t reported_high_water;
 } evt_dispatch_queue;
 
 extern evt_dispatch_queue normal_queue;
 extern evt_dispatch_queue high_priority_queue;
 
+void evt_queue_init(evt_dispatch_queue *q);
+
 void mon_queue_response(fpgad_detection_status status,
                         fpgad_respond_event_t response,
                         fpgad_monitored_device *d,
                         void *response_context);
 
 void mon_monitor(fpgad_monitored_device *d);
+
+extern fpgad_monitored_device *monitored_device_list;
+
+typedef struct _mon_events {
+  int uevent_fd;
+  unsigned gen;
+  struct pollfd *fds;
+  nfds_t num_fds;
+  uint64_t next_poll;
+  uint64_t next_fallback;
+} mon_events;
+
+bool mon_uevent_is_fpga(const char *msg, size_t len);
+void mon_events_init(mon_events *e);
+void mon_events_run(monitor_thread_config *c, mon_events *e);
+void mon_events_destroy(mon_events *e);
+
+typedef struct _mon_worker {
+  monitor_thread_config *c;
+  volatile bool *stop;
+  unsigned index;
+  unsigned num_workers;
+  unsigned gen;
+  fpgad_monitored_device **devs;
+  unsigned num_devs;
+  pthread_t thread;
+} mon_worker;
+
+int mon_worker_shard(mon_worker *w);
+int mon_run_workers(monitor_thread_config *c);
 }
 
 #define NO_OPAE_C
@@ -89,20 +133,23 @@ static void test_evt_response(fpgad_monitored_device *dev,
  *             calls to the function log an error and drop the request.<br>
  */
 TEST_P(fpgad_monitor_c_p, high_q_full) {
+  fpgad_monitored_device d;
+  event_dispatch_queue_item item;
 
-  high_priority_queue.head = 1;
-  high_priority_queue.tail = 0;
+  evt_queue_init(&high_priority_queue);
+  for (int i = 0 ; i < EVENT_DISPATCH_QUEUE_DEPTH ; ++i)
+    ASSERT_TRUE(evt_queue_response_high(test_evt_response, &d, NULL));
 
-  fpgad_monitored_device d;
   mon_queue_response(FPGAD_STATUS_DETECTED_HIGH,
                      test_evt_response,
                      &d,
                      NULL);
-  EXPECT_EQ(high_priority_queue.head, 1);
-  EXPECT_EQ(high_priority_queue.tail, 0);
+  EXPECT_EQ(high_priority_queue.drops, 1);
+  EXPECT_EQ(high_priority_queue.tail, EVENT_DISPATCH_QUEUE_DEPTH);
 
-  high_priority_queue.head = 0;
-  high_priority_queue.tail = 0;
+  while (evt_queue_get_high(&item))
+    /* drain */ ;
+  evt_queue_init(&high_priority_queue);
 }
 
 /**
@@ -112,20 +159,23 @@ TEST_P(fpgad_monitor_c_p, high_q_full) {
  *             calls to the function log an error and drop the request.<br>
  */
 TEST_P(fpgad_monitor_c_p, normal_q_full) {
+  fpgad_monitored_device d;
+  event_dispatch_queue_item item;
 
-  normal_queue.head = 1;
-  normal_queue.tail = 0;
+  evt_queue_init(&normal_queue);
+  for (int i = 0 ; i < EVENT_DISPATCH_QUEUE_DEPTH ; ++i)
+    ASSERT_TRUE(evt_queue_response(test_evt_response, &d, NULL));
 
-  fpgad_monitored_device d;
   mon_queue_response(FPGAD_STATUS_DETECTED,
                      test_evt_response,
                      &d,
                      NULL);
-  EXPECT_EQ(normal_queue.head, 1);
-  EXPECT_EQ(normal_queue.tail, 0);
+  EXPECT_EQ(normal_queue.drops, 1);
+  EXPECT_EQ(normal_queue.tail, EVENT_DISPATCH_QUEUE_DEPTH);
 
-  normal_queue.head = 0;
-  normal_queue.tail = 0;
+  while (evt_queue_get(&item))
+    /* drain */ ;
+  evt_queue_init(&normal_queue);
 }
 
 /**
@@ -173,15 +223,219 @@ TEST_P(fpgad_monitor_c_p, null_response0) {
   d.detections = detections;
   d.responses = responses;
 
-  normal_queue.head = 0;
-  normal_queue.tail = 0;
+  evt_queue_init(&normal_queue);
 
   mon_monitor(&d);
   EXPECT_EQ(normal_queue.head, 0);
   EXPECT_EQ(normal_queue.tail, 0);
+}
+
+/**
+ * @test       uevent_is_fpga
+ * @brief      Test: mon_uevent_is_fpga
+ * @details    Only uevents whose subsystem or devpath refer<br>
+ *             to an FPGA device are reported.<br>
+ */
+TEST_P(fpgad_monitor_c_p, uevent_is_fpga) {
+  const char dfl[] = "change@/devices/pci0000:00/0000:00:02.0/"
+                     "fpga_region/region0/dfl-port.0\0"
+                     "ACTION=change\0SUBSYSTEM=dfl";
+  const char hwmon[] = "change@/devices/x/dfl-fme.0/hwmon/hwmon3\0"
+                       "ACTION=change\0"
+                       "DEVPATH=/devices/x/dfl-fme.0/hwmon/hwmon3\0"
+                       "SUBSYSTEM=hwmon";
+  const char usb[] = "add@/devices/usb1/1-1\0ACTION=add\0"
+                     "DEVPATH=/devices/usb1/1-1\0SUBSYSTEM=usb";
+
+  EXPECT_TRUE(mon_uevent_is_fpga(dfl, sizeof(dfl)));
+  EXPECT_TRUE(mon_uevent_is_fpga(hwmon, sizeof(hwmon)));
+  EXPECT_FALSE(mon_uevent_is_fpga(usb, sizeof(usb)));
+}
+
+static fpgad_detection_status
+counting_detection(fpgad_monitored_device *dev,
+                   void *context)
+{
+  UNUSED_PARAM(dev);
+  ++*(int *)context;
+  return FPGAD_STATUS_NOT_DETECTED;
+}
+
+/**
+ * @test       events_run
+ * @brief      Test: mon_events_run
+ * @details    The first pass runs every device's detections.<br>
+ *             After that, devices without watches are polled each<br>
+ *             poll interval, while watched devices that don't signal<br>
+ *             wait for the fallback interval.<br>
+ */
+TEST_P(fpgad_monitor_c_p, events_run) {
+  struct fpgad_config cfg;
+  memset(&cfg, 0, sizeof(cfg));
+  cfg.poll_interval_usec = 1000;
+  cfg.poll_fallback_usec = 60 * 1000 * 1000;
+  cfg.event_driven = true;
+
+  monitor_thread_config mc = { &cfg, 0, 0 };
+
+  char path[] = "/tmp/fpgad-watch-XXXXXX";
+  int fd = mkstemp(path);
+  ASSERT_GE(fd, 0);
+
+  int polled = 0;
+  int watched = 0;
+
+  fpgad_detect_event_t detections[] = {
+    counting_detection,
+    nullptr,
+  };
+  void *polled_contexts[] = { &polled, nullptr };
+  void *watched_contexts[] = { &watched, nullptr };
+
+  fpgad_monitored_device d0;
+  memset(&d0, 0, sizeof(d0));
+  d0.detections = detections;
+  d0.detection_contexts = polled_contexts;
+
+  fpgad_monitored_device d1;
+  memset(&d1, 0, sizeof(d1));
+  d1.detections = detections;
+  d1.detection_contexts = watched_contexts;
+  d1.watch_fds[0] = fd;
+  d1.num_watches = 1;
+
+  mon_monitor_device(&d0);
+  mon_monitor_device(&d1);
+
+  mon_events e;
+  mon_events_init(&e);
+
+  mon_events_run(&mc, &e);
+  EXPECT_EQ(e.num_fds, 2);
+  EXPECT_EQ(polled, 1);
+  EXPECT_EQ(watched, 1);
+
+  mon_events_run(&mc, &e);
+  mon_events_run(&mc, &e);
+  EXPECT_EQ(polled, 3);
+  EXPECT_EQ(watched, 1);
+
+  mon_events_destroy(&e);
+  EXPECT_EQ(e.fds, nullptr);
+
+  monitored_device_list = nullptr;
+  close(fd);
+  unlink(path);
+}
+
+/**
+ * @test       poll_stats
+ * @brief      Test: mon_monitor
+ * @details    Each call records the time spent<br>
+ *             in the device's detections.<br>
+ */
+TEST_P(fpgad_monitor_c_p, poll_stats) {
+  int count = 0;
+  fpgad_detect_event_t detections[] = {
+    counting_detection,
+    nullptr,
+  };
+  void *contexts[] = { &count, nullptr };
+
+  fpgad_monitored_device d;
+  memset(&d, 0, sizeof(d));
+  d.detections = detections;
+  d.detection_contexts = contexts;
+
+  mon_monitor(&d);
+  mon_monitor(&d);
+  EXPECT_EQ(count, 2);
+  EXPECT_EQ(d.poll_count, 2);
+  EXPECT_GE(d.poll_max_usec, d.poll_last_usec);
+  EXPECT_GE(d.poll_total_usec, d.poll_max_usec);
+}
+
+/**
+ * @test       worker_shard
+ * @brief      Test: mon_worker_shard
+ * @details    Worker i of n is given every n-th<br>
+ *             monitored device, starting at device i.<br>
+ */
+TEST_P(fpgad_monitor_c_p, worker_shard) {
+  fpgad_monitored_device d[3];
+  memset(d, 0, sizeof(d));
+
+  for (int i = 0 ; i < 3 ; ++i)
+    mon_monitor_device(&d[i]);
+
+  mon_worker w0;
+  memset(&w0, 0, sizeof(w0));
+  w0.index = 0;
+  w0.num_workers = 2;
+
+  mon_worker w1 = w0;
+  w1.index = 1;
+
+  ASSERT_EQ(mon_worker_shard(&w0), 0);
+  ASSERT_EQ(mon_worker_shard(&w1), 0);
+
+  ASSERT_EQ(w0.num_devs, 2);
+  EXPECT_EQ(w0.devs[0], &d[0]);
+  EXPECT_EQ(w0.devs[1], &d[2]);
+  ASSERT_EQ(w1.num_devs, 1);
+  EXPECT_EQ(w1.devs[0], &d[1]);
+
+  opae_free(w0.devs);
+  opae_free(w1.devs);
+  monitored_device_list = nullptr;
+}
+
+/**
+ * @test       run_workers
+ * @brief      Test: mon_run_workers
+ * @details    The workers poll their devices until fpgad<br>
+ *             stops, and then are joined.<br>
+ */
+TEST_P(fpgad_monitor_c_p, run_workers) {
+  struct fpgad_config cfg;
+  memset(&cfg, 0, sizeof(cfg));
+  cfg.poll_interval_usec = 1000;
+  cfg.monitor_workers = 2;
+  cfg.running = true;
+
+  monitor_thread_config mc = { &cfg, 0, 0 };
+
+  int counts[2] = { 0, 0 };
+  fpgad_detect_event_t detections[] = {
+    counting_detection,
+    nullptr,
+  };
+  void *contexts0[] = { &counts[0], nullptr };
+  void *contexts1[] = { &counts[1], nullptr };
+
+  fpgad_monitored_device d[2];
+  memset(d, 0, sizeof(d));
+  d[0].detections = detections;
+  d[0].detection_contexts = contexts0;
+  d[1].detections = detections;
+  d[1].detection_contexts = contexts1;
+
+  mon_monitor_device(&d[0]);
+  mon_monitor_device(&d[1]);
+
+  std::thread stopper([&cfg]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    cfg.running = false;
+  });
+
+  EXPECT_EQ(mon_run_workers(&mc), 0);
+  stopper.join();
+
+  EXPECT_GT(counts[0], 0);
+  EXPECT_GT(counts[1], 0);
+  EXPECT_EQ(d[0].poll_count, (uint64_t)counts[0]);
 
-  normal_queue.head = 0;
-  normal_queue.tail = 0;
+  monitored_device_list = nullptr;
 }
 
 GTEST_ALLOW_UNINSTANTIATED_PARAMETERIZED_TEST(fpgad_monitor_c_p);
@@ -416,6 +416,37 @@ TEST_P(mock_port_fpgad_xfpga_c_p, configure) {
   fpgad_plugin_destroy(&d);
 }
 
+/**
+ * @test       configured_poll
+ * @brief      Test: fpgad_plugin_configure, fpgad_xfpga_detect_AP1_or_AP2
+ * @details    After configure, the device's sysfs objects are held<br>
+ *             open and each poll, starting at the first detection,<br>
+ *             sees the current value of the sysfs files.<br>
+ */
+TEST_P(mock_port_fpgad_xfpga_c_p, configured_poll) {
+  fpgad_monitored_device d;
+  fpgad_config_data s;
+  init_monitored_device(&d, &s);
+
+  ASSERT_EQ(fpgad_plugin_configure(&d, NULL), 0);
+  ASSERT_NE(d.plugin_context, nullptr);
+
+  // detections[0] is AP1.
+  void *ap1 = d.detection_contexts[0];
+
+  set_AP1_state(true);
+  EXPECT_EQ(d.detections[0](&d, ap1), FPGAD_STATUS_DETECTED);
+  EXPECT_EQ(d.num_error_occurrences, 1);
+  EXPECT_EQ(d.error_occurrences[0], ap1);
+
+  set_AP1_state(false);
+  EXPECT_EQ(d.detections[0](&d, ap1), FPGAD_STATUS_NOT_DETECTED);
+  EXPECT_EQ(d.num_error_occurrences, 0);
+
+  fpgad_plugin_destroy(&d);
+  EXPECT_EQ(d.plugin_context, nullptr);
+}
+
 GTEST_ALLOW_UNINSTANTIATED_PARAMETERIZED_TEST(mock_port_fpgad_xfpga_c_p);
 INSTANTIATE_TEST_SUITE_P(fpgad_c, mock_port_fpgad_xfpga_c_p,
                          ::testing::ValuesIn(test_platform::mock_platforms({ "skx-p" })));
@@ -29,6 +29,8 @@
 
 #define NO_OPAE_C
 #include "mock/opae_fixtures.h"
+#include <cmath>
+#include "sampler.h"
 
 extern "C" {
 struct config {
@@ -37,6 +39,15 @@ struct config {
 		bool afu_metrics;
 		int open_flags;
 	} target;
+	struct stream {
+		bool enabled;
+		double rate_hz;
+		uint64_t count;
+		uint64_t history;
+		const char *metrics;
+		const char *output;
+		bool binary;
+	} stream;
 };
 
 extern struct config config;
@@ -46,6 +57,11 @@ void FpgaMetricsAppShowHelp(void);
 fpga_result parse_args(int argc, char *argv[]);
 int fpgametrics_main(int argc, char *argv[]);
 void print_bus_info(struct bdf_info *info);
+fpga_result parse_metric_list(const char *list,
+			      const struct fpga_metric_info *metric_info,
+			      uint64_t num_metrics,
+			      uint64_t *ids,
+			      uint64_t *num_ids);
 }
 
 using namespace opae::testing;
@@ -235,6 +251,201 @@ TEST_P(fpga_metrics_c_p, main2) {
   EXPECT_EQ(fpgametrics_main(3, argv2), 1);
 }
 
+/**
+ * @test       parse_args6
+ * @brief      Test: parse_args
+ * @details    When given the streaming options,<br>
+ *             parse_args enables streaming mode and<br>
+ *             populates the global config struct.<br>
+ */
+TEST_P(fpga_metrics_c_p, parse_args6) {
+  char zero[20];
+  char one[20];
+  char two[20];
+  char three[20];
+  char four[20];
+  char five[20];
+  char six[20];
+  char seven[20];
+  char eight[20];
+  char nine[20];
+  char ten[20];
+  strcpy(zero, "fpgametrics");
+  strcpy(one, "-r");
+  strcpy(two, "250");
+  strcpy(three, "-c");
+  strcpy(four, "10");
+  strcpy(five, "-m");
+  strcpy(six, "1,3");
+  strcpy(seven, "-b");
+  strcpy(eight, "-H");
+  strcpy(nine, "128");
+  strcpy(ten, "-o");
+
+  char *argv[] = { zero, one, two, three, four, five, six,
+                   seven, eight, nine, ten, zero, NULL };
+  EXPECT_EQ(parse_args(12, argv), FPGA_OK);
+  EXPECT_TRUE(config.stream.enabled);
+  EXPECT_EQ(config.stream.rate_hz, 250.0);
+  EXPECT_EQ(config.stream.count, 10);
+  EXPECT_STREQ(config.stream.metrics, "1,3");
+  EXPECT_TRUE(config.stream.binary);
+  EXPECT_EQ(config.stream.history, 128);
+  EXPECT_STREQ(config.stream.output, "fpgametrics");
+}
+
+/**
+ * @test       parse_args7
+ * @brief      Test: parse_args
+ * @details    When given an invalid rate, count or history,<br>
+ *             parse_args returns FPGA_INVALID_PARAM.<br>
+ */
+TEST_P(fpga_metrics_c_p, parse_args7) {
+  char zero[20];
+  char one[20];
+  char two[20];
+  strcpy(zero, "fpgametrics");
+
+  char *argv[] = { zero, one, two, NULL };
+
+  strcpy(one, "-r");
+  strcpy(two, "0");
+  EXPECT_EQ(parse_args(3, argv), FPGA_INVALID_PARAM);
+
+  optind = 0;
+  strcpy(two, "fast");
+  EXPECT_EQ(parse_args(3, argv), FPGA_INVALID_PARAM);
+
+  optind = 0;
+  strcpy(one, "-c");
+  strcpy(two, "10x");
+  EXPECT_EQ(parse_args(3, argv), FPGA_INVALID_PARAM);
+
+  optind = 0;
+  strcpy(one, "-H");
+  strcpy(two, "0");
+  EXPECT_EQ(parse_args(3, argv), FPGA_INVALID_PARAM);
+}
+
+/**
+ * @test       parse_metric_list
+ * @brief      Test: parse_metric_list
+ * @details    Metric numbers are 1-based and names match either<br>
+ *             the metric name or the qualifier name, ignoring case.<br>
+ *             Unknown names and out-of-range numbers are rejected.<br>
+ */
+TEST_P(fpga_metrics_c_p, parse_metric_list) {
+  struct fpga_metric_info info[3];
+  uint64_t ids[3];
+  uint64_t num_ids = 0;
+
+  memset(info, 0, sizeof(info));
+  strcpy(info[0].metric_name, "Board Power");
+  strcpy(info[0].qualifier_name, "power_mgmt:Board Power");
+  strcpy(info[1].metric_name, "FPGA Die Temperature");
+  strcpy(info[1].qualifier_name, "thermal_mgmt:FPGA Die Temperature");
+  strcpy(info[2].metric_name, "12V Current");
+  strcpy(info[2].qualifier_name, "power_mgmt:12V Current");
+
+  EXPECT_EQ(parse_metric_list("3,fpga die temperature,power_mgmt:Board Power",
+                              info, 3, ids, &num_ids), FPGA_OK);
+  ASSERT_EQ(num_ids, 3);
+  EXPECT_EQ(ids[0], 2);
+  EXPECT_EQ(ids[1], 1);
+  EXPECT_EQ(ids[2], 0);
+
+  EXPECT_EQ(parse_metric_list("4", info, 3, ids, &num_ids),
+            FPGA_INVALID_PARAM);
+  EXPECT_EQ(parse_metric_list("0", info, 3, ids, &num_ids),
+            FPGA_INVALID_PARAM);
+  EXPECT_EQ(parse_metric_list("nope", info, 3, ids, &num_ids),
+            FPGA_INVALID_PARAM);
+  EXPECT_EQ(parse_metric_list(",", info, 3, ids, &num_ids),
+            FPGA_INVALID_PARAM);
+  EXPECT_EQ(parse_metric_list("1,2,3,1", info, 3, ids, &num_ids),
+            FPGA_INVALID_PARAM);
+}
+
+/**
+ * @test       p2_quantile
+ * @brief      Test: p2_init, p2_add, p2_value
+ * @details    The P-square estimator is exact for up to five<br>
+ *             observations and tracks the quantiles of a<br>
+ *             uniform sequence closely.<br>
+ */
+TEST_P(fpga_metrics_c_p, p2_quantile) {
+  p2_quantile q50, q99;
+
+  p2_init(&q50, 0.5);
+  EXPECT_TRUE(std::isnan(p2_value(&q50)));
+
+  p2_add(&q50, 3.0);
+  p2_add(&q50, 1.0);
+  p2_add(&q50, 2.0);
+  EXPECT_EQ(p2_value(&q50), 2.0);
+
+  p2_init(&q50, 0.5);
+  p2_init(&q99, 0.99);
+  // Visit 0..9999 in a scrambled order.
+  for (uint64_t i = 0; i < 10000; ++i) {
+    double x = (double)((i * 7919) % 10000);
+    p2_add(&q50, x);
+    p2_add(&q99, x);
+  }
+  EXPECT_NEAR(p2_value(&q50), 5000.0, 150.0);
+  EXPECT_NEAR(p2_value(&q99), 9900.0, 150.0);
+}
+
+/**
+ * @test       main3
+ * @brief      Test: fpgametrics_main
+ * @details    When given the streaming options,<br>
+ *             fpgametrics_main writes one CSV header line and<br>
+ *             one line per sample to the output file.<br>
+ */
+TEST_P(fpga_metrics_c_p, main3) {
+  char zero[20];
+  char one[20];
+  char two[20];
+  char three[20];
+  char four[20];
+  char five[20];
+  char six[20];
+  char seven[20];
+  char eight[40];
+  char tmpfile[] = "fpgametrics-XXXXXX.csv";
+  int fd = mkstemps(tmpfile, 4);
+  ASSERT_GE(fd, 0);
+  close(fd);
+
+  strcpy(zero, "fpgametrics");
+  strcpy(one, "-B");
+  sprintf(two, "%d", platform_.devices[0].bus);
+  strcpy(three, "-r");
+  strcpy(four, "200");
+  strcpy(five, "-c");
+  strcpy(six, "5");
+  strcpy(seven, "-o");
+  strcpy(eight, tmpfile);
+
+  char *argv[] = { zero, one, two, three, four, five, six,
+                   seven, eight, NULL };
+  EXPECT_EQ(fpgametrics_main(9, argv), FPGA_OK);
+
+  FILE *fp = fopen(tmpfile, "r");
+  ASSERT_NE(fp, nullptr);
+  char line[4096];
+  int lines = 0;
+  ASSERT_NE(fgets(line, sizeof(line), fp), nullptr);
+  EXPECT_EQ(strncmp(line, "timestamp_ns,", 13), 0);
+  while (fgets(line, sizeof(line), fp))
+    ++lines;
+  fclose(fp);
+  unlink(tmpfile);
+
+  EXPECT_EQ(lines, 5);
+}
+
 GTEST_ALLOW_UNINSTANTIATED_PARAMETERIZED_TEST(fpga_metrics_c_p);
 INSTANTIATE_TEST_SUITE_P(fpgametrics_c, fpga_metrics_c_p,
                          ::testing::ValuesIn(test_platform::mock_platforms({ "dfl-n3000" })));
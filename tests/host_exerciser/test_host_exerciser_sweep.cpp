@@ -0,0 +1,221 @@
+// Copyright(c) 2024, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif // HAVE_CONFIG_H
+
+#include <sstream>
+
+#include "gtest/gtest.h"
+
+#include "host_exerciser_sweep.h"
+
+using namespace host_exerciser;
+
+static he_sweep_result make_result(const char *device, uint32_t instances)
+{
+  he_sweep_result r = {};
+
+  r.device = device;
+  r.instances = instances;
+  r.cls = "cl_4";
+  r.mode = "trput";
+  r.interleave = 2;
+  r.seconds = 5;
+  r.status = 0;
+  r.num_ticks = 1000;
+  r.num_reads = 200;
+  r.num_writes = 300;
+  r.bandwidth = 12.5;
+  r.samples = 4000;
+  r.lat_p50 = 800;
+  r.lat_p90 = 900;
+  r.lat_p99 = 1500;
+  r.lat_max = 4000;
+
+  return r;
+}
+
+/**
+ * @test    percentile
+ * @brief   Test: he_percentile()
+ * @details The percentile is the nearest-rank value: the smallest<br>
+ *          sample such that at least pct percent of the samples are<br>
+ *          less than or equal to it.<br>
+ */
+TEST(host_exerciser_sweep, percentile)
+{
+  std::vector<uint64_t> v;
+
+  EXPECT_EQ(he_percentile(v, 50.0), 0.0);
+
+  for (uint64_t i = 1; i <= 17; ++i)
+    v.push_back(i * 10);
+
+  // ceil(0.9 * 17) = 16
+  EXPECT_EQ(he_percentile(v, 90.0), 160.0);
+  // ceil(0.5 * 17) = 9
+  EXPECT_EQ(he_percentile(v, 50.0), 90.0);
+  EXPECT_EQ(he_percentile(v, 99.0), 170.0);
+  EXPECT_EQ(he_percentile(v, 100.0), 170.0);
+  EXPECT_EQ(he_percentile(v, 0.0), 10.0);
+
+  v.resize(10);
+  // ceil(0.9 * 10) = 9: exact ranks don't round up.
+  EXPECT_EQ(he_percentile(v, 90.0), 90.0);
+  EXPECT_EQ(he_percentile(v, 50.0), 50.0);
+}
+
+/**
+ * @test    latency
+ * @brief   Test: he_sweep_latency()
+ * @details The samples are sorted and summarized into the result.<br>
+ */
+TEST(host_exerciser_sweep, latency)
+{
+  std::vector<uint64_t> v = { 5, 1, 4, 2, 3 };
+  he_sweep_result r = {};
+
+  he_sweep_latency(v, r);
+  EXPECT_EQ(r.samples, 5);
+  EXPECT_EQ(r.lat_p50, 3.0);
+  EXPECT_EQ(r.lat_p90, 5.0);
+  EXPECT_EQ(r.lat_p99, 5.0);
+  EXPECT_EQ(r.lat_max, 5.0);
+}
+
+/**
+ * @test    write_csv
+ * @brief   Test: he_sweep_write_csv()
+ * @details One header line, then one line per result.<br>
+ */
+TEST(host_exerciser_sweep, write_csv)
+{
+  std::vector<he_sweep_result> results;
+  std::ostringstream os;
+  he_sweep_result fail = make_result("0000:b1:00.3", 2);
+
+  fail.status = 1;
+  results.push_back(make_result("0000:b1:00.2", 2));
+  results.push_back(fail);
+
+  he_sweep_write_csv(os, results);
+  EXPECT_EQ(os.str(),
+    "device,instances,cls,mode,interleave,seconds,status,num_ticks,"
+    "num_reads,num_writes,bandwidth_gbps,latency_samples,latency_p50_ns,"
+    "latency_p90_ns,latency_p99_ns,latency_max_ns\n"
+    "0000:b1:00.2,2,cl_4,trput,2,5,PASS,1000,200,300,12.500,4000,"
+    "800,900,1500,4000\n"
+    "0000:b1:00.3,2,cl_4,trput,2,5,FAIL,1000,200,300,12.500,4000,"
+    "800,900,1500,4000\n");
+}
+
+/**
+ * @test    write_json
+ * @brief   Test: he_sweep_write_json()
+ * @details The results are written as a JSON array of objects.<br>
+ */
+TEST(host_exerciser_sweep, write_json)
+{
+  std::vector<he_sweep_result> results;
+  std::ostringstream os;
+
+  he_sweep_write_json(os, results);
+  EXPECT_EQ(os.str(), "[\n]\n");
+
+  results.push_back(make_result("0000:b1:00.2", 1));
+  results.push_back(make_result("0000:b1:00.3", 1));
+
+  os.str("");
+  he_sweep_write_json(os, results);
+
+  const std::string rec =
+    "\"instances\": 1, \"cls\": \"cl_4\", \"mode\": \"trput\", "
+    "\"interleave\": 2, \"seconds\": 5, \"status\": \"PASS\", "
+    "\"num_ticks\": 1000, \"num_reads\": 200, \"num_writes\": 300, "
+    "\"bandwidth_gbps\": 12.500, \"latency_ns\": {\"samples\": 4000, "
+    "\"p50\": 800, \"p90\": 900, \"p99\": 1500, \"max\": 4000}}";
+  EXPECT_EQ(os.str(),
+    "[\n"
+    "  {\"device\": \"0000:b1:00.2\", " + rec + ",\n"
+    "  {\"device\": \"0000:b1:00.3\", " + rec + "\n"
+    "]\n");
+}
+
+/**
+ * @test    read_csv
+ * @brief   Test: he_sweep_read_csv()
+ * @details Records written by he_sweep_write_csv() read back<br>
+ *          unchanged, and malformed lines are rejected.<br>
+ */
+TEST(host_exerciser_sweep, read_csv)
+{
+  std::vector<he_sweep_result> results;
+  std::vector<he_sweep_result> parsed;
+  std::stringstream ss;
+  he_sweep_result fail = make_result("0000:b1:00.3", 2);
+
+  fail.status = 1;
+  results.push_back(make_result("0000:b1:00.2", 2));
+  results.push_back(fail);
+
+  he_sweep_write_csv(ss, results);
+  ASSERT_TRUE(he_sweep_read_csv(ss, parsed));
+  ASSERT_EQ(parsed.size(), 2);
+
+  for (size_t i = 0; i < parsed.size(); ++i) {
+    EXPECT_EQ(parsed[i].device, results[i].device);
+    EXPECT_EQ(parsed[i].instances, results[i].instances);
+    EXPECT_EQ(parsed[i].cls, results[i].cls);
+    EXPECT_EQ(parsed[i].mode, results[i].mode);
+    EXPECT_EQ(parsed[i].interleave, results[i].interleave);
+    EXPECT_EQ(parsed[i].seconds, results[i].seconds);
+    EXPECT_EQ(parsed[i].status, results[i].status);
+    EXPECT_EQ(parsed[i].num_ticks, results[i].num_ticks);
+    EXPECT_EQ(parsed[i].num_reads, results[i].num_reads);
+    EXPECT_EQ(parsed[i].num_writes, results[i].num_writes);
+    EXPECT_DOUBLE_EQ(parsed[i].bandwidth, results[i].bandwidth);
+    EXPECT_EQ(parsed[i].samples, results[i].samples);
+    EXPECT_DOUBLE_EQ(parsed[i].lat_p50, results[i].lat_p50);
+    EXPECT_DOUBLE_EQ(parsed[i].lat_p90, results[i].lat_p90);
+    EXPECT_DOUBLE_EQ(parsed[i].lat_p99, results[i].lat_p99);
+    EXPECT_DOUBLE_EQ(parsed[i].lat_max, results[i].lat_max);
+  }
+
+  // An empty stream holds no records.
+  std::stringstream empty;
+  parsed.clear();
+  EXPECT_TRUE(he_sweep_read_csv(empty, parsed));
+  EXPECT_TRUE(parsed.empty());
+
+  std::stringstream bad("header\n0000:b1:00.2,1,cl_4\n");
+  EXPECT_FALSE(he_sweep_read_csv(bad, parsed));
+
+  std::stringstream nan("header\n"
+    "0000:b1:00.2,x,cl_4,trput,2,5,PASS,1,2,3,1.0,4,5,6,7,8\n");
+  EXPECT_FALSE(he_sweep_read_csv(nan, parsed));
+}
@@ -23,12 +23,16 @@
 // CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
 // ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
 // POSSIBILITY OF SUCH DAMAGE.
+#include <atomic>
 #include <chrono>
+#include <cstring>
 #include <future>
 #include <thread>
+#include <vector>
 #include <uuid/uuid.h>
 #include "gtest/gtest.h"
 #include "ofs_cpeng.h"
+#include "ofs_cpeng_ring.h"
 
 
 /**
@@ -93,3 +97,180 @@ TEST(ofs_cpeng, copy_chunk)
   EXPECT_EQ(r_dst.f_CSR_DST_ADDR, 0x4000);
   EXPECT_EQ(r_size.f_CSR_DATA_SIZE, 8192);
 }
+
+struct ring_source {
+  std::vector<uint8_t> data;
+  size_t chunk;
+  bool fail;
+};
+
+static int64_t ring_fill(void *context, ofs_cpeng_buffer *buf, uint64_t offset)
+{
+  auto src = reinterpret_cast<ring_source*>(context);
+  if (src->fail) {
+    return -1;
+  }
+  if (offset >= src->data.size()) {
+    return 0;
+  }
+  auto count = std::min(src->chunk, src->data.size() - offset);
+  memcpy(buf->ptr, src->data.data() + offset, count);
+  return count;
+}
+
+/**
+ * @test    copy_image_ring
+ * @brief   Tests: ofs_cpeng_copy_image_ring
+ * @details Tests ofs_cpeng_copy_image_ring with a ring of two buffers. A
+ *          thread stands in for the copy engine by recording each copy and
+ *          clearing MRD_START. Verify that every chunk is copied in order to
+ *          consecutive destinations, that the last chunk is padded with
+ *          zeros up to the alignment and that the image is marked complete.
+ * */
+TEST(ofs_cpeng, copy_image_ring)
+{
+  ofs_cpeng otest;
+  CSR_SRC_ADDR r_src = {0};
+  CSR_DST_ADDR r_dst = {0};
+  CSR_DATA_SIZE r_size = {0};
+  CSR_HOST2CE_MRD_START r_start = {0};
+  CSR_CE2HOST_STATUS r_status = {0};
+  CSR_HOST2HPS_IMG_XFR r_xfr = {0};
+
+  otest.r_CSR_SRC_ADDR = &r_src;
+  otest.r_CSR_DST_ADDR = &r_dst;
+  otest.r_CSR_DATA_SIZE = &r_size;
+  otest.r_CSR_HOST2CE_MRD_START = &r_start;
+  otest.r_CSR_CE2HOST_STATUS = &r_status;
+  otest.r_CSR_HOST2HPS_IMG_XFR = &r_xfr;
+  r_status.f_CE_DMA_STS = 0b10;
+
+  std::vector<uint8_t> mem0(1024, 0xff), mem1(1024, 0xff);
+  ofs_cpeng_buffer ring[] = {
+    { mem0.data(), 0x1000, 1024 },
+    { mem1.data(), 0x2000, 1024 }
+  };
+
+  ring_source src = { std::vector<uint8_t>(2500), 1024, false };
+  for (size_t i = 0; i < src.data.size(); ++i) {
+    src.data[i] = i & 0xff;
+  }
+
+  struct copy {
+    uint64_t src, dst, size;
+    uint8_t last;
+  };
+  std::vector<copy> copies;
+  std::atomic<bool> done(false);
+  std::thread engine([&]() {
+    volatile CSR_HOST2CE_MRD_START *start = &r_start;
+    while (!done) {
+      if (start->f_MRD_START) {
+        auto mem = r_src.f_CSR_SRC_ADDR == 0x1000 ? mem0.data() : mem1.data();
+        copies.push_back({ r_src.f_CSR_SRC_ADDR, r_dst.f_CSR_DST_ADDR,
+                           r_size.f_CSR_DATA_SIZE,
+                           mem[r_size.f_CSR_DATA_SIZE - 1] });
+        start->f_MRD_START = 0;
+      }
+    }
+  });
+
+  EXPECT_EQ(ofs_cpeng_copy_image_ring(&otest, ring, 2, 0x4000, 512,
+                                      ring_fill, &src, 100000), 0);
+  done = true;
+  engine.join();
+
+  ASSERT_EQ(copies.size(), 3);
+  EXPECT_EQ(copies[0].src, 0x1000);
+  EXPECT_EQ(copies[0].dst, 0x4000);
+  EXPECT_EQ(copies[0].size, 1024);
+  EXPECT_EQ(copies[1].src, 0x2000);
+  EXPECT_EQ(copies[1].dst, 0x4400);
+  EXPECT_EQ(copies[1].size, 1024);
+  EXPECT_EQ(copies[2].src, 0x1000);
+  EXPECT_EQ(copies[2].dst, 0x4800);
+  EXPECT_EQ(copies[2].size, 512);
+  EXPECT_EQ(copies[2].last, 0);
+  EXPECT_EQ(mem0[451], (2048 + 451) & 0xff);
+  EXPECT_EQ(r_xfr.f_HOST2HPS_IMG_XFR, 1);
+}
+
+/**
+ * @test    copy_image_ring_err
+ * @brief   Tests: ofs_cpeng_copy_image_ring
+ * @details Verify that ofs_cpeng_copy_image_ring rejects invalid
+ *          parameters, and that a failed fill or a failed copy is reported
+ *          without marking the image complete.
+ * */
+TEST(ofs_cpeng, copy_image_ring_err)
+{
+  ofs_cpeng otest;
+  CSR_SRC_ADDR r_src = {0};
+  CSR_DST_ADDR r_dst = {0};
+  CSR_DATA_SIZE r_size = {0};
+  CSR_HOST2CE_MRD_START r_start = {0};
+  CSR_CE2HOST_STATUS r_status = {0};
+  CSR_HOST2HPS_IMG_XFR r_xfr = {0};
+
+  otest.r_CSR_SRC_ADDR = &r_src;
+  otest.r_CSR_DST_ADDR = &r_dst;
+  otest.r_CSR_DATA_SIZE = &r_size;
+  otest.r_CSR_HOST2CE_MRD_START = &r_start;
+  otest.r_CSR_CE2HOST_STATUS = &r_status;
+  otest.r_CSR_HOST2HPS_IMG_XFR = &r_xfr;
+
+  std::vector<uint8_t> mem(1024);
+  ofs_cpeng_buffer ring[] = { { mem.data(), 0x1000, 1024 } };
+  ring_source src = { std::vector<uint8_t>(2048), 1024, true };
+
+  EXPECT_NE(ofs_cpeng_copy_image_ring(&otest, ring, 0, 0, 512,
+                                      ring_fill, &src, 1000), 0);
+  EXPECT_NE(ofs_cpeng_copy_image_ring(&otest, ring, 1, 0, 512,
+                                      nullptr, &src, 1000), 0);
+
+  EXPECT_NE(ofs_cpeng_copy_image_ring(&otest, ring, 1, 0, 512,
+                                      ring_fill, &src, 1000), 0);
+  EXPECT_EQ(r_start.f_MRD_START, 0);
+
+  // DMA status reports an error
+  src.fail = false;
+  r_status.f_CE_DMA_STS = 0b11;
+  EXPECT_NE(ofs_cpeng_copy_image_ring(&otest, ring, 1, 0, 512,
+                                      ring_fill, &src, 1000), 0);
+  EXPECT_EQ(r_start.f_MRD_START, 1);
+  EXPECT_EQ(r_xfr.f_HOST2HPS_IMG_XFR, 0);
+}
+
+/**
+ * @test    copy_image_ring_warn
+ * @brief   Tests: ofs_cpeng_copy_image_ring
+ * @details When a copy times out without the DMA error status set,
+ *          verify that ofs_cpeng_copy_image_ring carries on with the
+ *          remaining chunks and marks the image complete.
+ * */
+TEST(ofs_cpeng, copy_image_ring_warn)
+{
+  ofs_cpeng otest;
+  CSR_SRC_ADDR r_src = {0};
+  CSR_DST_ADDR r_dst = {0};
+  CSR_DATA_SIZE r_size = {0};
+  CSR_HOST2CE_MRD_START r_start = {0};
+  CSR_CE2HOST_STATUS r_status = {0};
+  CSR_HOST2HPS_IMG_XFR r_xfr = {0};
+
+  otest.r_CSR_SRC_ADDR = &r_src;
+  otest.r_CSR_DST_ADDR = &r_dst;
+  otest.r_CSR_DATA_SIZE = &r_size;
+  otest.r_CSR_HOST2CE_MRD_START = &r_start;
+  otest.r_CSR_CE2HOST_STATUS = &r_status;
+  otest.r_CSR_HOST2HPS_IMG_XFR = &r_xfr;
+
+  std::vector<uint8_t> mem(1024);
+  ofs_cpeng_buffer ring[] = { { mem.data(), 0x1000, 1024 } };
+  ring_source src = { std::vector<uint8_t>(2048), 1024, false };
+
+  EXPECT_EQ(ofs_cpeng_copy_image_ring(&otest, ring, 1, 0x4000, 512,
+                                      ring_fill, &src, 1000), 0);
+  EXPECT_EQ(r_dst.f_CSR_DST_ADDR, 0x4400);
+  EXPECT_EQ(r_xfr.f_HOST2HPS_IMG_XFR, 1);
+}
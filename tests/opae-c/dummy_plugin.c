@@ -181,6 +181,7 @@ int __attribute__((visibility("default"))) opae_plugin_configure(opae_api_adapte
 	adapter->fpgaAssignToInterface = NULL;
 	adapter->fpgaReleaseFromInterface = NULL;
 	adapter->fpgaReconfigureSlot = NULL;
+	adapter->fpgaReconfigureSlotByFd = NULL;
 	adapter->fpgaTokenGetObject = NULL;
 	adapter->fpgaHandleGetObject = NULL;
 	adapter->fpgaObjectGetObject = NULL;
@@ -28,10 +28,21 @@
 #endif // HAVE_CONFIG_H
 
 #include <linux/ioctl.h>
+#include <thread>
+#include <vector>
 
 extern "C" {
 #include "intel-fpga.h"
 #include "fpga-dfl.h"
+#include "props.h"
+void opae_enum_cache_invalidate(void);
+void opae_enum_cache_flush(void);
+bool opae_enum_cache_dev_node(const char *name);
+extern uint64_t enum_cache_hits;
+extern uint64_t enum_cache_misses;
+int opae_enum_cache_filter_ok(struct _fpga_properties *f);
+int opae_enum_cache_match(struct _fpga_properties *f,
+                          struct _fpga_properties *s);
 }
 
 #include "mock/opae_fixtures.h"
@@ -593,6 +604,52 @@ TEST_P(enum_c_p, clone_token01) {
   EXPECT_EQ(fpgaDestroyToken(&token), FPGA_OK);
 }
 
+/**
+ * @test       clone_threads
+ * @brief      Test: fpgaCloneToken, fpgaDestroyToken, fpgaGetProperties
+ * @details    Threads that concurrently clone, query and destroy<br>
+ *             copies of the same token find its parent, and leave<br>
+ *             its reference count and the token leak list intact.<br>
+ */
+TEST_P(enum_c_p, clone_threads) {
+  fpga_token device = get_device_token(0);
+  ASSERT_NE(device, nullptr);
+  fpga_token token = get_accelerator_token(device, 0);
+  ASSERT_NE(token, nullptr);
+
+#ifdef LIBOPAE_DEBUG
+  uint32_t in_use = opae_wrapped_tokens_in_use();
+#endif // LIBOPAE_DEBUG
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([token, device]() {
+      for (int i = 0; i < 200; ++i) {
+        fpga_token clone = nullptr;
+        fpga_properties props = nullptr;
+        fpga_token parent = nullptr;
+        EXPECT_EQ(fpgaCloneToken(token, &clone), FPGA_OK);
+        EXPECT_EQ(fpgaGetProperties(clone, &props), FPGA_OK);
+        // The parent is a reference owned by props.
+        EXPECT_EQ(fpgaPropertiesGetParent(props, &parent), FPGA_OK);
+        EXPECT_EQ(parent, device);
+        EXPECT_EQ(fpgaDestroyProperties(&props), FPGA_OK);
+        EXPECT_EQ(fpgaDestroyToken(&clone), FPGA_OK);
+      }
+    });
+  }
+  for (auto &t : threads)
+    t.join();
+
+#ifdef LIBOPAE_DEBUG
+  EXPECT_EQ(opae_wrapped_tokens_in_use(), in_use);
+#endif // LIBOPAE_DEBUG
+
+  opae_wrapped_token *wt = opae_validate_wrapped_token(token);
+  ASSERT_NE(wt, nullptr);
+  EXPECT_EQ(wt->ref_count, 1);
+}
+
 TEST_P(enum_c_p, clone_wo_src_dst) {
   fpga_token device = get_device_token(0);
   fpga_token clone = nullptr;
@@ -857,3 +914,168 @@ INSTANTIATE_TEST_SUITE_P(enum_c, enum_c_socket_p,
                                                                         "dfl-n6000-sku1",
                                                                         "dfl-c6100"
                                                                       })));
+
+/**
+ * @test       cache_invalidate
+ * @brief      Test: fpgaEnumerate
+ * @details    With OPAE_ENUM_CACHE=1, a repeated enumeration is<br>
+ *             served from the enumeration cache, and the first<br>
+ *             enumeration after opae_enum_cache_invalidate() re-reads<br>
+ *             the devices. The results are the same either way.<br>
+ */
+TEST_P(enum_c_p, cache_invalidate) {
+  uint32_t cached = 0;
+  uint32_t fresh = 0;
+  uint64_t hits;
+  uint64_t misses;
+
+  ASSERT_EQ(setenv("OPAE_ENUM_CACHE", "1", 1), 0);
+  ASSERT_EQ(setenv("OPAE_ENUM_CACHE_TTL_MS", "60000", 1), 0);
+  opae_enum_cache_flush();
+
+  ASSERT_EQ(fpgaPropertiesSetObjectType(filter_, FPGA_ACCELERATOR), FPGA_OK);
+
+  EXPECT_EQ(fpgaEnumerate(&filter_, 1, tokens_.data(), tokens_.size(),
+                          &fresh), FPGA_OK);
+  DestroyTokens();
+
+  hits = enum_cache_hits;
+  misses = enum_cache_misses;
+  EXPECT_EQ(fpgaEnumerate(&filter_, 1, tokens_.data(), tokens_.size(),
+                          &cached), FPGA_OK);
+  DestroyTokens();
+  EXPECT_GT(enum_cache_hits, hits);
+  EXPECT_EQ(enum_cache_misses, misses);
+  EXPECT_EQ(cached, fresh);
+
+  opae_enum_cache_invalidate();
+
+  hits = enum_cache_hits;
+  misses = enum_cache_misses;
+  EXPECT_EQ(fpgaEnumerate(&filter_, 1, tokens_.data(), tokens_.size(),
+                          &fresh), FPGA_OK);
+  EXPECT_EQ(enum_cache_hits, hits);
+  EXPECT_GT(enum_cache_misses, misses);
+  EXPECT_EQ(cached, fresh);
+  EXPECT_EQ(cached, GetNumFpgas());
+
+  unsetenv("OPAE_ENUM_CACHE");
+  unsetenv("OPAE_ENUM_CACHE_TTL_MS");
+  opae_enum_cache_flush();
+}
+
+/**
+ * @test       parallel
+ * @brief      Test: fpgaEnumerate
+ * @details    When OPAE_ENUM_THREADS is greater than one,<br>
+ *             the plugins are enumerated concurrently and return<br>
+ *             the same tokens, in the same order, as a serial<br>
+ *             enumeration.<br>
+ */
+TEST_P(enum_c_p, parallel) {
+  uint32_t serial = 0;
+  uint32_t parallel = 0;
+  std::vector<uint64_t> serial_ids;
+
+  ASSERT_EQ(fpgaEnumerate(nullptr, 0, tokens_.data(), tokens_.size(),
+                          &serial), FPGA_OK);
+  for (uint32_t i = 0; i < serial && i < tokens_.size(); ++i) {
+    fpga_properties p = nullptr;
+    uint64_t id = 0;
+    ASSERT_EQ(fpgaGetProperties(tokens_[i], &p), FPGA_OK);
+    EXPECT_EQ(fpgaPropertiesGetObjectID(p, &id), FPGA_OK);
+    EXPECT_EQ(fpgaDestroyProperties(&p), FPGA_OK);
+    serial_ids.push_back(id);
+  }
+  DestroyTokens();
+
+  ASSERT_EQ(setenv("OPAE_ENUM_THREADS", "4", 1), 0);
+
+  EXPECT_EQ(fpgaEnumerate(nullptr, 0, tokens_.data(), tokens_.size(),
+                          &parallel), FPGA_OK);
+  EXPECT_EQ(serial, parallel);
+  for (uint32_t i = 0; i < serial_ids.size(); ++i) {
+    fpga_properties p = nullptr;
+    uint64_t id = 0;
+    ASSERT_EQ(fpgaGetProperties(tokens_[i], &p), FPGA_OK);
+    EXPECT_EQ(fpgaPropertiesGetObjectID(p, &id), FPGA_OK);
+    EXPECT_EQ(fpgaDestroyProperties(&p), FPGA_OK);
+    EXPECT_EQ(serial_ids[i], id);
+  }
+  DestroyTokens();
+
+  // A short token buffer receives the first matches, in order.
+  if (serial > 1) {
+    EXPECT_EQ(fpgaEnumerate(nullptr, 0, tokens_.data(), 1,
+                            &parallel), FPGA_OK);
+    fpga_properties p = nullptr;
+    uint64_t id = 0;
+    ASSERT_EQ(fpgaGetProperties(tokens_[0], &p), FPGA_OK);
+    EXPECT_EQ(fpgaPropertiesGetObjectID(p, &id), FPGA_OK);
+    EXPECT_EQ(fpgaDestroyProperties(&p), FPGA_OK);
+    EXPECT_EQ(serial_ids[0], id);
+    DestroyTokens();
+  }
+
+  EXPECT_EQ(unsetenv("OPAE_ENUM_THREADS"), 0);
+}
+
+/**
+ * @test       cache_dev_node
+ * @brief      Test: opae_enum_cache_dev_node
+ * @details    Only DFL, intel-fpga, uio and vfio device nodes<br>
+ *             invalidate the enumeration cache.<br>
+ */
+TEST(enum_c, cache_dev_node) {
+  EXPECT_TRUE(opae_enum_cache_dev_node("dfl-fme.0"));
+  EXPECT_TRUE(opae_enum_cache_dev_node("dfl-port.1"));
+  EXPECT_TRUE(opae_enum_cache_dev_node("intel-fpga-port.0"));
+  EXPECT_TRUE(opae_enum_cache_dev_node("uio3"));
+  EXPECT_TRUE(opae_enum_cache_dev_node("vfio"));
+  EXPECT_FALSE(opae_enum_cache_dev_node("tty0"));
+  EXPECT_FALSE(opae_enum_cache_dev_node("dfl"));
+  EXPECT_FALSE(opae_enum_cache_dev_node("null"));
+}
+
+/**
+ * @test       cache_match
+ * @brief      Test: opae_enum_cache_filter_ok, opae_enum_cache_match
+ * @details    Filters on static fields are evaluated against the<br>
+ *             cached properties, filters on live fields bypass the<br>
+ *             cache, and fields missing from the snapshot make the<br>
+ *             result unknown.<br>
+ */
+TEST(enum_c, cache_match) {
+  fpga_properties filter = nullptr;
+  fpga_properties snap = nullptr;
+  fpga_guid guid = { 0x01, 0x02 };
+
+  ASSERT_EQ(fpgaGetProperties(nullptr, &filter), FPGA_OK);
+  ASSERT_EQ(fpgaGetProperties(nullptr, &snap), FPGA_OK);
+  struct _fpga_properties *f = (struct _fpga_properties *)filter;
+  struct _fpga_properties *s = (struct _fpga_properties *)snap;
+
+  EXPECT_NE(opae_enum_cache_filter_ok(f), 0);
+  EXPECT_EQ(opae_enum_cache_match(f, s), 1);
+
+  ASSERT_EQ(fpgaPropertiesSetObjectType(filter, FPGA_ACCELERATOR), FPGA_OK);
+  ASSERT_EQ(fpgaPropertiesSetGUID(filter, guid), FPGA_OK);
+  EXPECT_NE(opae_enum_cache_filter_ok(f), 0);
+
+  // Snapshot has no objtype yet.
+  EXPECT_EQ(opae_enum_cache_match(f, s), -1);
+
+  ASSERT_EQ(fpgaPropertiesSetObjectType(snap, FPGA_ACCELERATOR), FPGA_OK);
+  ASSERT_EQ(fpgaPropertiesSetGUID(snap, guid), FPGA_OK);
+  EXPECT_EQ(opae_enum_cache_match(f, s), 1);
+
+  guid[0] = 0xff;
+  ASSERT_EQ(fpgaPropertiesSetGUID(snap, guid), FPGA_OK);
+  EXPECT_EQ(opae_enum_cache_match(f, s), 0);
+
+  ASSERT_EQ(fpgaPropertiesSetNumErrors(filter, 0), FPGA_OK);
+  EXPECT_EQ(opae_enum_cache_filter_ok(f), 0);
+
+  EXPECT_EQ(fpgaDestroyProperties(&filter), FPGA_OK);
+  EXPECT_EQ(fpgaDestroyProperties(&snap), FPGA_OK);
+}
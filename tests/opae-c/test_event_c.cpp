@@ -28,6 +28,7 @@
 #endif // HAVE_CONFIG_H
 
 #include <poll.h>
+#include <unistd.h>
 #include "mock/opae_fpgad_fixtures.h"
 
 using namespace opae::testing;
@@ -196,6 +197,78 @@ TEST_P(event_c_p, destroy_err) {
                                 event_handle_), FPGA_OK);
 }
 
+static void event_loop_cb(fpga_event_handle eh, uint64_t count,
+                          void *context)
+{
+  fpga_event_loop loop = *(fpga_event_loop *)context;
+  // Removing the handle being dispatched is allowed.
+  EXPECT_EQ(fpgaEventLoopRemove(loop, eh), FPGA_OK);
+  EXPECT_EQ(count, 2);
+}
+
+/**
+ * @test       event_loop
+ * @brief      Test: fpgaCreateEventLoop, fpgaEventLoopAdd,
+ *             fpgaEventLoopWait, fpgaEventLoopDispatch,
+ *             fpgaEventLoopRemove, fpgaDestroyEventLoop
+ * @details    A registered event handle added to an event loop<br>
+ *             is reported once signaled, with its count when<br>
+ *             added with FPGA_EVENT_LOOP_CONSUME, and its<br>
+ *             callback may remove it from the loop.<br>
+ */
+TEST_P(event_c_p, event_loop) {
+  fpga_event_loop loop = nullptr;
+  fpga_event_loop_ready ready[4];
+  uint32_t num_ready = 99;
+  uint64_t one = 1;
+  int fd = -1;
+
+  EXPECT_EQ(fpgaCreateEventLoop(&loop, 1), FPGA_INVALID_PARAM);
+  ASSERT_EQ(fpgaCreateEventLoop(&loop, 0), FPGA_OK);
+
+  // Not yet registered.
+  EXPECT_EQ(fpgaEventLoopAdd(loop, event_handle_, nullptr, nullptr, 0),
+            FPGA_INVALID_PARAM);
+
+  ASSERT_EQ(fpgaRegisterEvent(accel_, FPGA_EVENT_ERROR,
+                              event_handle_, 0), FPGA_OK);
+  ASSERT_EQ(fpgaGetOSObjectFromEventHandle(event_handle_, &fd), FPGA_OK);
+
+  EXPECT_EQ(fpgaEventLoopAdd(loop, event_handle_, event_loop_cb, &loop,
+                             FPGA_EVENT_LOOP_CONSUME), FPGA_OK);
+  EXPECT_EQ(fpgaEventLoopAdd(loop, event_handle_, event_loop_cb, &loop,
+                             FPGA_EVENT_LOOP_CONSUME), FPGA_BUSY);
+
+  EXPECT_EQ(fpgaEventLoopWait(loop, ready, 4, &num_ready, 0), FPGA_OK);
+  EXPECT_EQ(num_ready, 0);
+
+  ASSERT_EQ(write(fd, &one, sizeof(one)), sizeof(one));
+  EXPECT_EQ(fpgaEventLoopWait(loop, ready, 4, &num_ready, 1000), FPGA_OK);
+  ASSERT_EQ(num_ready, 1);
+  EXPECT_EQ(ready[0].event_handle, event_handle_);
+  EXPECT_EQ(ready[0].context, &loop);
+  EXPECT_EQ(ready[0].count, 1);
+
+  // Consumed, so no longer ready.
+  EXPECT_EQ(fpgaEventLoopWait(loop, ready, 4, &num_ready, 0), FPGA_OK);
+  EXPECT_EQ(num_ready, 0);
+
+  ASSERT_EQ(write(fd, &one, sizeof(one)), sizeof(one));
+  ASSERT_EQ(write(fd, &one, sizeof(one)), sizeof(one));
+  EXPECT_EQ(fpgaEventLoopDispatch(loop, 1000, &num_ready), FPGA_OK);
+  EXPECT_EQ(num_ready, 1);
+
+  // The callback removed the handle.
+  EXPECT_EQ(fpgaEventLoopRemove(loop, event_handle_), FPGA_NOT_FOUND);
+
+  EXPECT_EQ(fpgaDestroyEventLoop(&loop), FPGA_OK);
+  EXPECT_EQ(loop, nullptr);
+  EXPECT_EQ(fpgaDestroyEventLoop(&loop), FPGA_INVALID_PARAM);
+
+  EXPECT_EQ(fpgaUnregisterEvent(accel_, FPGA_EVENT_ERROR,
+                                event_handle_), FPGA_OK);
+}
+
 GTEST_ALLOW_UNINSTANTIATED_PARAMETERIZED_TEST(event_c_p);
 INSTANTIATE_TEST_SUITE_P(event_c, event_c_p, 
                          ::testing::ValuesIn(test_platform::platforms({})));
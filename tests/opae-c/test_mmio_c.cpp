@@ -32,6 +32,10 @@
 #include "fpga-dfl.h"
 #include "mock/opae_fixtures.h"
 
+extern "C" {
+#include "opae_int.h"
+}
+
 using namespace opae::testing;
 
 static int mmio_ioctl(mock_object * m, int request, va_list argp){
@@ -206,6 +210,101 @@ TEST_P(mmio_c_p, mmio512_neg_test) {
 }
 #endif // TEST_SUPPORTS_AVX512
 
+/**
+ * @test       mmio_batch
+ * @brief      Test: fpgaWriteMMIOBatch, fpgaReadMMIOBatch
+ * @details    Write a run of two qwords and a dword with one<br>
+ *             fpgaWriteMMIOBatch, read them back with one<br>
+ *             fpgaReadMMIOBatch.<br>
+ *             Values written should equal values read.<br>
+ */
+TEST_P(mmio_c_p, mmio_batch) {
+  fpga_mmio_op wr[3] = {
+    { CSR_SCRATCHPAD0, 8, 0xdeadbeefdecafbad },
+    { CSR_SCRATCHPAD0 + 8, 8, 0x0123456789abcdef },
+    { CSR_SCRATCHPAD0 + 16, 4, 0xc0cac01a }
+  };
+  fpga_mmio_op rd[3] = {
+    { CSR_SCRATCHPAD0, 8, 0 },
+    { CSR_SCRATCHPAD0 + 8, 8, 0 },
+    { CSR_SCRATCHPAD0 + 16, 4, 0 }
+  };
+
+  EXPECT_EQ(fpgaWriteMMIOBatch(accel_, which_mmio_, wr, 3), FPGA_OK);
+  EXPECT_EQ(fpgaReadMMIOBatch(accel_, which_mmio_, rd, 3), FPGA_OK);
+  for (int i = 0 ; i < 3 ; ++i)
+    EXPECT_EQ(wr[i].value, rd[i].value);
+}
+
+/**
+ * @test       mmio_batch_neg_test
+ * @brief      Test: fpgaWriteMMIOBatch, fpgaReadMMIOBatch
+ * @details    When given an invalid handle, NULL descriptors,<br>
+ *             or a misaligned or unsupported width descriptor,<br>
+ *             the batch APIs return FPGA_INVALID_PARAM.<br>
+ *             An empty batch succeeds.<br>
+ */
+TEST_P(mmio_c_p, mmio_batch_neg_test) {
+  fpga_mmio_op op = { CSR_SCRATCHPAD0, 8, 0 };
+
+  EXPECT_EQ(fpgaReadMMIOBatch(NULL, which_mmio_, &op, 1), FPGA_INVALID_PARAM);
+  EXPECT_EQ(fpgaWriteMMIOBatch(NULL, which_mmio_, &op, 1), FPGA_INVALID_PARAM);
+
+  EXPECT_EQ(fpgaReadMMIOBatch(accel_, which_mmio_, NULL, 1), FPGA_INVALID_PARAM);
+  EXPECT_EQ(fpgaWriteMMIOBatch(accel_, which_mmio_, NULL, 1), FPGA_INVALID_PARAM);
+  EXPECT_EQ(fpgaReadMMIOBatch(accel_, which_mmio_, NULL, 0), FPGA_OK);
+
+  op.offset = CSR_SCRATCHPAD0 + 4;
+  EXPECT_EQ(fpgaReadMMIOBatch(accel_, which_mmio_, &op, 1), FPGA_INVALID_PARAM);
+  op.offset = CSR_SCRATCHPAD0;
+  op.width = 2;
+  EXPECT_EQ(fpgaWriteMMIOBatch(accel_, which_mmio_, &op, 1), FPGA_INVALID_PARAM);
+}
+
+/**
+ * @test       mmio_batch_fallback
+ * @brief      Test: fpgaWriteMMIOBatch, fpgaReadMMIOBatch
+ * @details    When the plugin has no native batch support,<br>
+ *             the batch is issued one access at a time, and a<br>
+ *             batch with an unsupported width descriptor fails<br>
+ *             with FPGA_INVALID_PARAM before any register is written.<br>
+ */
+TEST_P(mmio_c_p, mmio_batch_fallback) {
+  opae_wrapped_handle *wh = opae_validate_wrapped_handle(accel_);
+  ASSERT_NE(wh, nullptr);
+  auto rd_batch = wh->adapter_table->fpgaReadMMIOBatch;
+  auto wr_batch = wh->adapter_table->fpgaWriteMMIOBatch;
+  wh->adapter_table->fpgaReadMMIOBatch = nullptr;
+  wh->adapter_table->fpgaWriteMMIOBatch = nullptr;
+
+  fpga_mmio_op wr[2] = {
+    { CSR_SCRATCHPAD0, 8, 0xdeadbeefdecafbad },
+    { CSR_SCRATCHPAD0 + 8, 4, 0xc0cac01a }
+  };
+  fpga_mmio_op rd[2] = {
+    { CSR_SCRATCHPAD0, 8, 0 },
+    { CSR_SCRATCHPAD0 + 8, 4, 0 }
+  };
+  uint64_t value = 0;
+
+  EXPECT_EQ(fpgaWriteMMIOBatch(accel_, which_mmio_, wr, 2), FPGA_OK);
+  EXPECT_EQ(fpgaReadMMIOBatch(accel_, which_mmio_, rd, 2), FPGA_OK);
+  EXPECT_EQ(wr[0].value, rd[0].value);
+  EXPECT_EQ(wr[1].value, rd[1].value);
+
+  wr[0].value = 0x0123456789abcdef;
+  wr[1].width = 2;
+  EXPECT_EQ(fpgaWriteMMIOBatch(accel_, which_mmio_, wr, 2), FPGA_INVALID_PARAM);
+  EXPECT_EQ(fpgaReadMMIO64(accel_, which_mmio_, CSR_SCRATCHPAD0, &value), FPGA_OK);
+  EXPECT_EQ(value, 0xdeadbeefdecafbad);
+
+  rd[1].offset = CSR_SCRATCHPAD0 + 2;
+  EXPECT_EQ(fpgaReadMMIOBatch(accel_, which_mmio_, rd, 2), FPGA_INVALID_PARAM);
+
+  wh->adapter_table->fpgaReadMMIOBatch = rd_batch;
+  wh->adapter_table->fpgaWriteMMIOBatch = wr_batch;
+}
+
 GTEST_ALLOW_UNINSTANTIATED_PARAMETERIZED_TEST(mmio_c_p);
 INSTANTIATE_TEST_SUITE_P(mmio_c, mmio_c_p,
                          ::testing::ValuesIn(test_platform::platforms({
@@ -28,6 +28,7 @@
 #endif // HAVE_CONFIG_H
 
 #include <array>
+#include <vector>
 
 extern "C" {
 #include "opae_int.h"
@@ -40,6 +41,10 @@ int opae_plugin_mgr_free_adapter(opae_api_adapter_table *adapter);
 int opae_plugin_mgr_register_adapter(opae_api_adapter_table *adapter);
 int opae_plugin_mgr_for_each_adapter
 	(int (*callback)(const opae_api_adapter_table *, void *), void *context);
+int opae_plugin_mgr_for_each_adapter_parallel(
+	void (*work)(const opae_api_adapter_table *, void *, void *),
+	int (*merge)(const opae_api_adapter_table *, void *, void *),
+	size_t result_size, void *context, uint32_t max_threads);
 int opae_plugin_mgr_configure_plugin(opae_api_adapter_table *adapter,
 				     const char *config);
 int process_cfg_buffer(const char *buffer, const char *filename);
@@ -195,6 +200,52 @@ TEST_P(pluginmgr_c_p, foreach_err) {
   EXPECT_EQ(2, test_plugin_finalize_called);
 }
 
+static void test_parallel_work(const opae_api_adapter_table *adapter,
+                               void *result, void *context)
+{
+  (void)context;
+  *(const opae_api_adapter_table **)result = adapter;
+}
+
+static int test_parallel_merge(const opae_api_adapter_table *adapter,
+                               void *result, void *context)
+{
+  std::vector<const opae_api_adapter_table *> *order =
+    (std::vector<const opae_api_adapter_table *> *)context;
+  EXPECT_EQ(adapter, *(const opae_api_adapter_table **)result);
+  order->push_back(adapter);
+  return order->size() == 1 ? OPAE_ENUM_STOP : OPAE_ENUM_CONTINUE;
+}
+
+/**
+ * @test       foreach_parallel
+ * @brief      Test: opae_plugin_mgr_for_each_adapter_parallel
+ * @details    Each adapter's work result is handed to merge in<br>
+ *             plugin list order, merge is called for every adapter<br>
+ *             even after it returns OPAE_ENUM_STOP, and the first<br>
+ *             non-continue merge result is returned.<br>
+ */
+TEST_P(pluginmgr_c_p, foreach_parallel) {
+  for (uint32_t threads : { 1, 2, 4 }) {
+    std::vector<const opae_api_adapter_table *> order;
+
+    EXPECT_EQ(OPAE_ENUM_STOP,
+              opae_plugin_mgr_for_each_adapter_parallel(
+                test_parallel_work, test_parallel_merge,
+                sizeof(opae_api_adapter_table *), &order, threads));
+    ASSERT_EQ(2, order.size());
+    EXPECT_EQ(faux_adapter0_, order[0]);
+    EXPECT_EQ(faux_adapter1_, order[1]);
+  }
+
+  EXPECT_EQ(OPAE_ENUM_STOP,
+            opae_plugin_mgr_for_each_adapter_parallel(
+              nullptr, test_parallel_merge, 0, nullptr, 2));
+
+  EXPECT_EQ(0, opae_plugin_mgr_finalize_all());
+  EXPECT_EQ(nullptr, adapter_list);
+}
+
 /**
  * @test       bad_init_all
  * @brief      Test: opae_plugin_mgr_initialize_all
@@ -45,6 +45,27 @@ TEST_P(reconf_c_p, pr) {
                                 bitstream, 5, 0), FPGA_INVALID_PARAM);
 }
 
+/**
+ * @test       pr_fd
+ * @brief      Test: fpgaReconfigureSlotByFd
+ * @details    When fpgaReconfigureSlotByFd is called with an invalid fd<br>
+ *             or a stream that is not a bitstream,<br>
+ *             then the fn returns FPGA_INVALID_PARAM.<br>
+ */
+TEST_P(reconf_c_p, pr_fd) {
+  EXPECT_EQ(fpgaReconfigureSlotByFd(device_, 0, -1, 0), FPGA_INVALID_PARAM);
+
+  int fds[2];
+  uint8_t bitstream[] = { 'b', 'i', 't', 's', 0 };
+  ASSERT_EQ(pipe(fds), 0);
+  ASSERT_EQ(write(fds[1], bitstream, sizeof(bitstream)),
+            (ssize_t)sizeof(bitstream));
+  close(fds[1]);
+  EXPECT_EQ(fpgaReconfigureSlotByFd(device_, 0, fds[0], 0),
+            FPGA_INVALID_PARAM);
+  close(fds[0]);
+}
+
 GTEST_ALLOW_UNINSTANTIATED_PARAMETERIZED_TEST(reconf_c_p);
 INSTANTIATE_TEST_SUITE_P(reconf_c, reconf_c_p,
                          ::testing::ValuesIn(test_platform::platforms({})));
@@ -0,0 +1,175 @@
+// Copyright(c) 2024, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif // HAVE_CONFIG_H
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "mock/opae_fixtures.h"
+#include "telemetry-shm.h"
+
+using namespace opae::testing;
+
+class telemetry_c_p : public opae_p<> {
+ protected:
+  telemetry_c_p() :
+    shm_(nullptr)
+  {}
+
+  virtual void SetUp() override {
+    opae_p<>::SetUp();
+
+    fpga_properties props = nullptr;
+    uint16_t seg = 0;
+    uint8_t bus = 0;
+    uint8_t dev = 0;
+    uint8_t fn = 0;
+
+    ASSERT_EQ(fpgaGetProperties(device_token_, &props), FPGA_OK);
+    EXPECT_EQ(fpgaPropertiesGetSegment(props, &seg), FPGA_OK);
+    EXPECT_EQ(fpgaPropertiesGetBus(props, &bus), FPGA_OK);
+    EXPECT_EQ(fpgaPropertiesGetDevice(props, &dev), FPGA_OK);
+    EXPECT_EQ(fpgaPropertiesGetFunction(props, &fn), FPGA_OK);
+    EXPECT_EQ(fpgaDestroyProperties(&props), FPGA_OK);
+
+    opae_telemetry_shm_name(name_, seg, bus, dev, fn);
+    shm_unlink(name_);
+  }
+
+  virtual void TearDown() override {
+    if (shm_) {
+      munmap(shm_, sizeof(opae_telemetry_shm));
+      shm_unlink(name_);
+    }
+    opae_p<>::TearDown();
+  }
+
+  // Create the segment as fpgad-vc does.
+  void publish_segment() {
+    int fd = shm_open(name_, O_CREAT | O_RDWR, 0644);
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(ftruncate(fd, sizeof(opae_telemetry_shm)), 0);
+    void *p = mmap(NULL, sizeof(opae_telemetry_shm),
+                   PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    ASSERT_NE(p, MAP_FAILED);
+    shm_ = reinterpret_cast<opae_telemetry_shm *>(p);
+    shm_->version = OPAE_TELEMETRY_SHM_VERSION;
+    shm_->size = sizeof(opae_telemetry_shm);
+    shm_->magic = OPAE_TELEMETRY_SHM_MAGIC;
+  }
+
+  char name_[OPAE_TELEMETRY_SHM_NAME_LEN];
+  opae_telemetry_shm *shm_;
+};
+
+/**
+ * @test       open_err
+ * @brief      Test: fpgaTelemetryOpen
+ * @details    When the parameters are invalid, or no segment<br>
+ *             has been published for the device,<br>
+ *             fpgaTelemetryOpen returns an error.<br>
+ */
+TEST_P(telemetry_c_p, open_err) {
+  fpga_telemetry t = nullptr;
+
+  EXPECT_EQ(fpgaTelemetryOpen(nullptr, &t), FPGA_INVALID_PARAM);
+  EXPECT_EQ(fpgaTelemetryOpen(device_token_, nullptr), FPGA_INVALID_PARAM);
+  EXPECT_EQ(fpgaTelemetryOpen(device_token_, &t), FPGA_NOT_FOUND);
+
+  publish_segment();
+  shm_->version = OPAE_TELEMETRY_SHM_VERSION + 1;
+  EXPECT_EQ(fpgaTelemetryOpen(device_token_, &t), FPGA_NOT_SUPPORTED);
+
+  EXPECT_EQ(fpgaTelemetryClose(nullptr), FPGA_INVALID_PARAM);
+  EXPECT_EQ(fpgaTelemetryClose(&t), FPGA_INVALID_PARAM);
+}
+
+/**
+ * @test       read
+ * @brief      Test: fpgaTelemetryOpen, fpgaTelemetryRead, fpgaTelemetryClose
+ * @details    fpgaTelemetryRead returns FPGA_NOT_FOUND until the<br>
+ *             first publish, then a copy of the published table.<br>
+ *             While a publish is in progress, it returns FPGA_BUSY.<br>
+ */
+TEST_P(telemetry_c_p, read) {
+  fpga_telemetry t = nullptr;
+  fpga_telemetry_snapshot snap;
+
+  publish_segment();
+  ASSERT_EQ(fpgaTelemetryOpen(accel_token_, &t), FPGA_OK);
+
+  EXPECT_EQ(fpgaTelemetryRead(t, nullptr), FPGA_INVALID_PARAM);
+  EXPECT_EQ(fpgaTelemetryRead(nullptr, &snap), FPGA_INVALID_PARAM);
+  EXPECT_EQ(fpgaTelemetryRead(t, &snap), FPGA_NOT_FOUND);
+
+  opae_telemetry_write_begin(shm_);
+  shm_->snapshot.timestamp_ns = 1000;
+  shm_->snapshot.num_sensors = 2;
+  strcpy(shm_->snapshot.sensors[0].name, "FPGA Core Temperature");
+  strcpy(shm_->snapshot.sensors[0].type, "Temperature");
+  shm_->snapshot.sensors[0].value = 60000;
+  shm_->snapshot.sensors[0].high_warn = 90000;
+  shm_->snapshot.sensors[0].flags = FPGA_TELEMETRY_HIGH_WARN_VALID;
+  strcpy(shm_->snapshot.sensors[1].name, "Board Power");
+  strcpy(shm_->snapshot.sensors[1].type, "Power");
+  shm_->snapshot.sensors[1].value = 70000000;
+  shm_->snapshot.sensors[1].high_warn = 65000000;
+  shm_->snapshot.sensors[1].flags = FPGA_TELEMETRY_HIGH_WARN_VALID |
+                                    FPGA_TELEMETRY_TRIPPED;
+  shm_->snapshot.sensors[1].timestamp_ns = 999;
+
+  // Write in progress.
+  EXPECT_EQ(fpgaTelemetryRead(t, &snap), FPGA_BUSY);
+
+  opae_telemetry_write_end(shm_);
+
+  memset(&snap, 0, sizeof(snap));
+  ASSERT_EQ(fpgaTelemetryRead(t, &snap), FPGA_OK);
+  EXPECT_EQ(snap.timestamp_ns, 1000);
+  EXPECT_EQ(snap.sequence, 1);
+  ASSERT_EQ(snap.num_sensors, 2);
+  EXPECT_STREQ(snap.sensors[0].name, "FPGA Core Temperature");
+  EXPECT_STREQ(snap.sensors[0].type, "Temperature");
+  EXPECT_EQ(snap.sensors[0].value, 60000);
+  EXPECT_EQ(snap.sensors[0].high_warn, 90000);
+  EXPECT_STREQ(snap.sensors[1].name, "Board Power");
+  EXPECT_EQ(snap.sensors[1].value, 70000000);
+  EXPECT_EQ(snap.sensors[1].flags, FPGA_TELEMETRY_HIGH_WARN_VALID |
+                                   FPGA_TELEMETRY_TRIPPED);
+  EXPECT_EQ(snap.sensors[1].timestamp_ns, 999);
+
+  EXPECT_EQ(fpgaTelemetryClose(&t), FPGA_OK);
+  EXPECT_EQ(t, nullptr);
+}
+
+GTEST_ALLOW_UNINSTANTIATED_PARAMETERIZED_TEST(telemetry_c_p);
+INSTANTIATE_TEST_SUITE_P(telemetry_c, telemetry_c_p,
+                         ::testing::ValuesIn(test_platform::platforms({"skx-p"})));
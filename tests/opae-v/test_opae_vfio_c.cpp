@@ -121,6 +121,8 @@ fpga_result vfio_fpgaReleaseBuffer(fpga_handle handle, uint64_t wsid);
 fpga_result vfio_fpgaGetIOAddress(fpga_handle handle,
                                   uint64_t wsid,
                                   uint64_t *ioaddr);
+vfio_buffer_pool *vfio_pool_create(void);
+void vfio_pool_destroy(vfio_buffer_pool *pool, struct opae_vfio *v);
 
 fpga_result vfio_fpgaCreateEventHandle(fpga_event_handle *event_handle);
 fpga_result vfio_fpgaDestroyEventHandle(fpga_event_handle *event_handle);
@@ -3105,6 +3107,76 @@ TEST(opae_v, release_buffer_err0)
   EXPECT_EQ(FPGA_NOT_FOUND, vfio_fpgaReleaseBuffer(&handle, (uint64_t)&binfo));
 }
 
+/**
+ * @test    buffer_pool_ok
+ * @brief   Test: vfio_fpgaPrepareBuffer(), vfio_fpgaReleaseBuffer()
+ * @details When the handle has a buffer pool with a free arena,<br>
+ *          then vfio_fpgaPrepareBuffer() carves the buffer from<br>
+ *          the arena, its IOVA is relative to the arena IOVA,<br>
+ *          and vfio_fpgaReleaseBuffer() returns it for reuse.<br>
+ *          A request that no arena can hold falls back to<br>
+ *          direct allocation.
+ */
+TEST(opae_v, buffer_pool_ok)
+{
+  const size_t arena_size = 1024 * 1024;
+  uint8_t *mem = (uint8_t *)opae_malloc(arena_size);
+  ASSERT_NE(nullptr, mem);
+
+  vfio_buffer_pool *pool = vfio_pool_create();
+  ASSERT_NE(nullptr, pool);
+
+  vfio_buffer_arena *a = (vfio_buffer_arena *)opae_calloc(1, sizeof(*a));
+  ASSERT_NE(nullptr, a);
+  a->virt = mem;
+  a->iova = 0x40000000;
+  a->size = arena_size;
+  mem_alloc_init(&a->alloc);
+  ASSERT_EQ(0, mem_alloc_add_free(&a->alloc, 0, arena_size));
+  pool->arenas = a;
+  pool->num_arenas = 1;
+
+  uint32_t max_arenas = vfio_buffer_pool_max_arenas;
+  vfio_buffer_pool_max_arenas = 1;
+
+  vfio_pair_t pair;
+  memset(&pair, 0, sizeof(pair));
+
+  vfio_handle handle;
+  memset(&handle, 0, sizeof(handle));
+  handle.magic = VFIO_HANDLE_MAGIC;
+  handle.lock = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+  handle.vfio_pair = &pair;
+  handle.pool = pool;
+
+  void *buf = nullptr;
+  uint64_t wsid = 0;
+  uint64_t iova = 0;
+  EXPECT_EQ(FPGA_OK, vfio_fpgaPrepareBuffer(&handle, 65536, &buf, &wsid, 0));
+  EXPECT_GE((uint8_t *)buf, mem);
+  EXPECT_LT((uint8_t *)buf, mem + arena_size);
+  EXPECT_EQ(0, ((uint8_t *)buf - mem) % 65536);
+
+  EXPECT_EQ(FPGA_OK, vfio_fpgaGetIOAddress(&handle, wsid, &iova));
+  EXPECT_EQ(a->iova + ((uint8_t *)buf - mem), iova);
+
+  EXPECT_EQ(FPGA_OK, vfio_fpgaReleaseBuffer(&handle, wsid));
+
+  void *buf2 = nullptr;
+  EXPECT_EQ(FPGA_OK, vfio_fpgaPrepareBuffer(&handle, 65536, &buf2, &wsid, 0));
+  EXPECT_EQ(buf, buf2);
+
+  // Larger than the arena: the direct path fails without a device.
+  void *buf3 = nullptr;
+  uint64_t wsid3 = 0;
+  EXPECT_EQ(FPGA_EXCEPTION,
+            vfio_fpgaPrepareBuffer(&handle, 2 * arena_size, &buf3, &wsid3, 0));
+
+  vfio_buffer_pool_max_arenas = max_arenas;
+  vfio_pool_destroy(pool, nullptr);
+  opae_free(mem);
+}
+
 /**
  * @test    get_io_addr_ok
  * @brief   Test: vfio_fpgaGetIOAddress()
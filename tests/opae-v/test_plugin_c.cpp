@@ -93,6 +93,7 @@ fpga_result vfio_fpgaUnregisterEvent(fpga_handle handle,
 
 extern libopae_config_data *opae_v_supported_devices;
 extern vfio_pci_device_t *_pci_devices;
+int vfio_parse_config(const char *cfg);
 }
 
 /**
@@ -178,3 +179,38 @@ TEST(opae_v, vfio_plugin_config)
 
   dlclose(adapter.plugin.dl_handle);
 }
+
+/**
+ * @test    vfio_plugin_config_buffer_pool
+ * @brief   Test: vfio_parse_config()
+ * @details The buffer-pool keys are optional and default<br>
+ *          to direct allocation. Keys of the wrong type,<br>
+ *          and arena sizes other than 2 MiB or a multiple<br>
+ *          of 1 GiB, cause the function to return non-zero.
+ */
+TEST(opae_v, vfio_plugin_config_buffer_pool)
+{
+  EXPECT_EQ(0, vfio_parse_config(nullptr));
+  EXPECT_FALSE(vfio_buffer_pool_enabled);
+
+  EXPECT_EQ(0, vfio_parse_config("{}"));
+  EXPECT_FALSE(vfio_buffer_pool_enabled);
+
+  EXPECT_EQ(0, vfio_parse_config("{ \"buffer-pool\": true, "
+                                 "\"buffer-pool-arena-size\": 2097152, "
+                                 "\"buffer-pool-max-arenas\": 8 }"));
+  EXPECT_TRUE(vfio_buffer_pool_enabled);
+  EXPECT_EQ(2097152, vfio_buffer_pool_arena_size);
+  EXPECT_EQ(8, vfio_buffer_pool_max_arenas);
+
+  EXPECT_NE(0, vfio_parse_config("{ \"buffer-pool\": 1 }"));
+  EXPECT_NE(0, vfio_parse_config("{ \"buffer-pool-max-arenas\": 0 }"));
+  EXPECT_NE(0, vfio_parse_config("{ \"buffer-pool-arena-size\": 4194304 }"));
+  EXPECT_NE(0, vfio_parse_config("{ \"buffer-pool-arena-size\": 1610612736 }"));
+  EXPECT_EQ(0, vfio_parse_config("{ \"buffer-pool-arena-size\": 2147483648 }"));
+  EXPECT_EQ(2147483648, vfio_buffer_pool_arena_size);
+  EXPECT_NE(0, vfio_parse_config("{ \"buffer-pool\": "));
+
+  EXPECT_EQ(0, vfio_parse_config(nullptr));
+  EXPECT_FALSE(vfio_buffer_pool_enabled);
+}
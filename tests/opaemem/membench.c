@@ -0,0 +1,159 @@
+// Copyright(c) 2024, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// Compares the default (list) and MEM_ALLOC_INDEXED allocator engines
+// on a fragmenting workload similar to an IOVA space under load.
+//
+// usage: opaemembench [<allocations> [<rounds>]]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <opae/mem_alloc.h>
+
+#define BENCH_SPACE_SIZE (UINT64_C(1) << 46)
+
+static double elapsed_ms(const struct timespec *start,
+			 const struct timespec *end)
+{
+	return (end->tv_sec - start->tv_sec) * 1000.0 +
+	       (end->tv_nsec - start->tv_nsec) / 1000000.0;
+}
+
+static void shuffle(uint64_t *a, int n)
+{
+	int i;
+	int r;
+	uint64_t temp;
+
+	for (i = n - 1 ; i > 0 ; --i) {
+		r = rand() % (i + 1);
+		temp = a[r];
+		a[r] = a[i];
+		a[i] = temp;
+	}
+}
+
+// The operations under test must run in NDEBUG builds too, so their
+// results are checked here rather than in assert().
+static void check(int res, const char *what)
+{
+	if (res) {
+		fprintf(stderr, "%s failed\n", what);
+		exit(1);
+	}
+}
+
+// Sizes are powers of two from 4KiB to 8MiB.
+static uint64_t random_size(void)
+{
+	return UINT64_C(4096) << (rand() % 12);
+}
+
+static void bench(const char *name, int flags,
+		  int allocs, int rounds, unsigned seed)
+{
+	struct mem_alloc m;
+	struct timespec start;
+	struct timespec end;
+	uint64_t *addrs;
+	int i;
+	int r;
+	int res;
+
+	addrs = malloc(allocs * sizeof(uint64_t));
+	check(!addrs, "malloc");
+
+	srand(seed);
+
+	check(mem_alloc_init_ex(&m, flags), "mem_alloc_init_ex");
+	check(mem_alloc_add_free(&m, 0, BENCH_SPACE_SIZE), "mem_alloc_add_free");
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	for (i = 0 ; i < allocs ; ++i) {
+		res = mem_alloc_get(&m, &addrs[i], random_size());
+		check(res, "mem_alloc_get");
+	}
+
+	for (r = 0 ; r < rounds ; ++r) {
+		// Release half of the blocks in random order, leaving
+		// the space fragmented, then fill the holes again.
+		shuffle(addrs, allocs);
+
+		for (i = 0 ; i < allocs / 2 ; ++i) {
+			res = mem_alloc_put(&m, addrs[i]);
+			check(res, "mem_alloc_put");
+		}
+
+		for (i = 0 ; i < allocs / 2 ; ++i) {
+			res = mem_alloc_get(&m, &addrs[i], random_size());
+			check(res, "mem_alloc_get");
+		}
+	}
+
+	for (i = 0 ; i < allocs ; ++i) {
+		res = mem_alloc_put(&m, addrs[i]);
+		check(res, "mem_alloc_put");
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	// Everything was released, so the space must have coalesced again.
+	check(m.free.next == &m.free ||
+	      m.free.next->next != &m.free ||
+	      m.free.next->size != BENCH_SPACE_SIZE, "coalesce");
+
+	mem_alloc_destroy(&m);
+	free(addrs);
+
+	printf("%-8s %8d allocs %4d rounds %12.3f ms\n",
+	       name, allocs, rounds, elapsed_ms(&start, &end));
+}
+
+int main(int argc, char *argv[])
+{
+	int allocs = 10000;
+	int rounds = 10;
+	unsigned seed = (unsigned)time(NULL);
+
+	if (argc > 1)
+		allocs = atoi(argv[1]);
+	if (argc > 2)
+		rounds = atoi(argv[2]);
+
+	if (allocs < 2 || rounds < 0) {
+		fprintf(stderr, "usage: %s [<allocations> [<rounds>]]\n",
+			argv[0]);
+		return 1;
+	}
+
+	bench("list", 0, allocs, rounds, seed);
+	bench("indexed", MEM_ALLOC_INDEXED, allocs, rounds, seed);
+
+	return 0;
+}
@@ -0,0 +1,235 @@
+// Copyright(c) 2024, Intel Corporation
+//
+// Redistribution  and  use  in source  and  binary  forms,  with  or  without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of  source code  must retain the  above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name  of Intel Corporation  nor the names of its contributors
+//   may be used to  endorse or promote  products derived  from this  software
+//   without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING,  BUT NOT LIMITED TO,  THE
+// IMPLIED WARRANTIES OF  MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT  SHALL THE COPYRIGHT OWNER  OR CONTRIBUTORS BE
+// LIABLE  FOR  ANY  DIRECT,  INDIRECT,  INCIDENTAL,  SPECIAL,  EXEMPLARY,  OR
+// CONSEQUENTIAL  DAMAGES  (INCLUDING,  BUT  NOT LIMITED  TO,  PROCUREMENT  OF
+// SUBSTITUTE GOODS OR SERVICES;  LOSS OF USE,  DATA, OR PROFITS;  OR BUSINESS
+// INTERRUPTION)  HOWEVER CAUSED  AND ON ANY THEORY  OF LIABILITY,  WHETHER IN
+// CONTRACT,  STRICT LIABILITY,  OR TORT  (INCLUDING NEGLIGENCE  OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,  EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif // HAVE_CONFIG_H
+
+#include "gtest/gtest.h"
+#include "mock/opae_std.h"
+
+#include <opae/hash_map.h>
+
+#include <map>
+
+extern "C" {
+uint32_t opae_hash_map_oa_items(opae_hash_map *hm);
+}
+
+static int value_cleanups;
+
+static void count_value_cleanup(void *value, void *context)
+{
+  (void) value;
+  (void) context;
+  ++value_cleanups;
+}
+
+/**
+ * @test    chained_basic
+ * @brief   Test: opae_hash_map_add(), opae_hash_map_find(),<br>
+ *          opae_hash_map_remove()
+ * @details For the default (chained) hash map,<br>
+ *          adding an existing key replaces its value,<br>
+ *          and removed keys are no longer found.
+ */
+TEST(hash_map, chained_basic)
+{
+  opae_hash_map hm;
+  void *value = nullptr;
+
+  value_cleanups = 0;
+  ASSERT_EQ(opae_hash_map_init(&hm, 17, 0, 0,
+                               opae_u64_key_hash,
+                               opae_u64_key_compare,
+                               nullptr,
+                               count_value_cleanup), FPGA_OK);
+  EXPECT_TRUE(opae_hash_map_is_empty(&hm));
+
+  EXPECT_EQ(opae_hash_map_add(&hm, (void *)1, (void *)10), FPGA_OK);
+  EXPECT_EQ(opae_hash_map_add(&hm, (void *)18, (void *)180), FPGA_OK);
+  EXPECT_EQ(opae_hash_map_add(&hm, (void *)1, (void *)11), FPGA_OK);
+  EXPECT_EQ(value_cleanups, 1);
+
+  EXPECT_EQ(opae_hash_map_find(&hm, (void *)1, &value), FPGA_OK);
+  EXPECT_EQ(value, (void *)11);
+  EXPECT_EQ(opae_hash_map_find(&hm, (void *)18, &value), FPGA_OK);
+  EXPECT_EQ(value, (void *)180);
+
+  EXPECT_EQ(opae_hash_map_remove(&hm, (void *)1), FPGA_OK);
+  EXPECT_EQ(opae_hash_map_find(&hm, (void *)1, &value), FPGA_NOT_FOUND);
+  EXPECT_EQ(opae_hash_map_remove(&hm, (void *)1), FPGA_NOT_FOUND);
+
+  EXPECT_EQ(opae_hash_map_destroy(&hm), FPGA_OK);
+  EXPECT_EQ(value_cleanups, 3);
+}
+
+/**
+ * @test    open_basic
+ * @brief   Test: OPAE_HASH_MAP_OPEN_ADDRESSING
+ * @details The slot count is rounded up to a power of two,<br>
+ *          adding an existing key replaces its value,<br>
+ *          and opae_hash_map_is_empty() tracks the item count.
+ */
+TEST(hash_map, open_basic)
+{
+  opae_hash_map hm;
+  void *value = nullptr;
+
+  value_cleanups = 0;
+  ASSERT_EQ(opae_hash_map_init(&hm, 5, 0,
+                               OPAE_HASH_MAP_OPEN_ADDRESSING,
+                               opae_ptr_key_hash,
+                               opae_u64_key_compare,
+                               nullptr,
+                               count_value_cleanup), FPGA_OK);
+  EXPECT_EQ(hm.num_buckets, 8);
+  EXPECT_NE(hm.buckets, nullptr);
+  EXPECT_TRUE(opae_hash_map_is_empty(&hm));
+
+  EXPECT_EQ(opae_hash_map_add(&hm, (void *)0x1000, (void *)1), FPGA_OK);
+  EXPECT_EQ(opae_hash_map_add(&hm, (void *)0x1000, (void *)2), FPGA_OK);
+  EXPECT_EQ(value_cleanups, 1);
+  EXPECT_EQ(opae_hash_map_oa_items(&hm), 1);
+  EXPECT_FALSE(opae_hash_map_is_empty(&hm));
+
+  EXPECT_EQ(opae_hash_map_find(&hm, (void *)0x1000, &value), FPGA_OK);
+  EXPECT_EQ(value, (void *)2);
+  EXPECT_EQ(opae_hash_map_find(&hm, (void *)0x2000, &value), FPGA_NOT_FOUND);
+
+  EXPECT_EQ(opae_hash_map_remove(&hm, (void *)0x1000), FPGA_OK);
+  EXPECT_EQ(value_cleanups, 2);
+  EXPECT_TRUE(opae_hash_map_is_empty(&hm));
+  EXPECT_EQ(opae_hash_map_remove(&hm, (void *)0x1000), FPGA_NOT_FOUND);
+
+  EXPECT_EQ(opae_hash_map_destroy(&hm), FPGA_OK);
+}
+
+/**
+ * @test    open_grow
+ * @brief   Test: OPAE_HASH_MAP_OPEN_ADDRESSING
+ * @details The slot array grows to keep the load factor<br>
+ *          at or below 3/4, and every key stays reachable.
+ */
+TEST(hash_map, open_grow)
+{
+  opae_hash_map hm;
+  void *value = nullptr;
+  uint64_t i;
+
+  value_cleanups = 0;
+  ASSERT_EQ(opae_hash_map_init(&hm, 8, 0,
+                               OPAE_HASH_MAP_UNIQUE_KEYSPACE |
+                               OPAE_HASH_MAP_OPEN_ADDRESSING,
+                               opae_ptr_key_hash,
+                               opae_u64_key_compare,
+                               nullptr,
+                               count_value_cleanup), FPGA_OK);
+
+  for (i = 0 ; i < 1000 ; ++i) {
+    ASSERT_EQ(opae_hash_map_add(&hm, (void *)(i << 12), (void *)i), FPGA_OK);
+    EXPECT_LE((uint64_t)opae_hash_map_oa_items(&hm) * 4, (uint64_t)hm.num_buckets * 3);
+  }
+  EXPECT_EQ(hm.num_buckets, 2048);
+
+  for (i = 0 ; i < 1000 ; ++i) {
+    ASSERT_EQ(opae_hash_map_find(&hm, (void *)(i << 12), &value), FPGA_OK);
+    EXPECT_EQ(value, (void *)i);
+  }
+
+  EXPECT_EQ(opae_hash_map_destroy(&hm), FPGA_OK);
+  EXPECT_EQ(value_cleanups, 1000);
+}
+
+/**
+ * @test    open_matches_std_map
+ * @brief   Test: OPAE_HASH_MAP_OPEN_ADDRESSING
+ * @details A randomized sequence of adds, finds and removes<br>
+ *          (exercising backward-shift deletion) agrees with<br>
+ *          std::map at every step.
+ */
+TEST(hash_map, open_matches_std_map)
+{
+  opae_hash_map hm;
+  std::map<uint64_t, uint64_t> ref;
+  void *value = nullptr;
+  int i;
+
+  srand(0x5eed);
+
+  ASSERT_EQ(opae_hash_map_init(&hm, 16, 0x1234,
+                               OPAE_HASH_MAP_OPEN_ADDRESSING,
+                               opae_ptr_key_hash,
+                               opae_u64_key_compare,
+                               nullptr,
+                               nullptr), FPGA_OK);
+
+  for (i = 0 ; i < 20000 ; ++i) {
+    uint64_t key = (uint64_t)(rand() % 512) << 6;
+    int op = rand() % 3;
+
+    if (op == 0) {
+      ASSERT_EQ(opae_hash_map_add(&hm, (void *)key, (void *)(uint64_t)i), FPGA_OK);
+      ref[key] = i;
+    } else if (op == 1) {
+      fpga_result res = opae_hash_map_remove(&hm, (void *)key);
+      ASSERT_EQ(res, ref.erase(key) ? FPGA_OK : FPGA_NOT_FOUND);
+    } else {
+      fpga_result res = opae_hash_map_find(&hm, (void *)key, &value);
+      auto it = ref.find(key);
+      if (it == ref.end()) {
+        ASSERT_EQ(res, FPGA_NOT_FOUND);
+      } else {
+        ASSERT_EQ(res, FPGA_OK);
+        ASSERT_EQ(value, (void *)it->second);
+      }
+    }
+    ASSERT_EQ(opae_hash_map_oa_items(&hm), ref.size());
+  }
+
+  EXPECT_EQ(opae_hash_map_destroy(&hm), FPGA_OK);
+}
+
+/**
+ * @test    ptr_key_hash
+ * @brief   Test: opae_ptr_key_hash()
+ * @details Page-aligned keys spread over a power-of-two<br>
+ *          number of buckets, and results are in range.
+ */
+TEST(hash_map, ptr_key_hash)
+{
+  std::map<uint32_t, int> hits;
+  uint64_t i;
+
+  for (i = 0 ; i < 4096 ; ++i) {
+    uint32_t h = opae_ptr_key_hash(1024, 0, (void *)(i << 12));
+    ASSERT_LT(h, 1024);
+    ++hits[h];
+  }
+
+  // The low 12 bits are always zero, so a modulus hash would
+  // land every key in bucket 0.
+  EXPECT_GT(hits.size(), 900);
+}
@@ -32,9 +32,12 @@
 
 #include <opae/mem_alloc.h>
 
+#include <vector>
+
 #define ALIGNED(__addr, __size) ((__addr + __size - 1) & ~(__size - 1))
 
 extern "C" {
+struct mem_alloc_index *mem_alloc_index(struct mem_alloc *m);
 struct mem_link *mem_link_alloc(uint64_t address, uint64_t size);
 void mem_alloc_coalesce(struct mem_link *head, struct mem_link *l);
 int mem_alloc_allocate_node(struct mem_alloc *m,
@@ -79,6 +82,8 @@ TEST(mem_alloc, destroy)
 {
   struct mem_alloc m;
 
+  m.allocated.address = 0;
+
   struct mem_link *free_link = (struct mem_link *)
 	  opae_malloc(sizeof(struct mem_link));
   struct mem_link *allocated_link = (struct mem_link *)
@@ -711,3 +716,173 @@ TEST(mem_alloc, put1)
 
   opae_free(node);
 }
+
+/**
+ * @test    indexed_coalesce
+ * @brief   Test: mem_alloc_add_free()
+ * @details For a MEM_ALLOC_INDEXED allocator,<br>
+ *          adjacent free ranges are merged on the free list<br>
+ *          regardless of insertion order, and adding a range<br>
+ *          that is already free returns non-zero.
+ */
+TEST(mem_alloc, indexed_coalesce)
+{
+  struct mem_alloc m;
+  struct mem_link *a;
+
+  ASSERT_EQ(mem_alloc_init_ex(&m, MEM_ALLOC_INDEXED), 0);
+  ASSERT_NE(mem_alloc_index(&m), nullptr);
+
+  EXPECT_EQ(mem_alloc_add_free(&m, 0x2000, 4096), 0);
+  EXPECT_EQ(mem_alloc_add_free(&m, 0x0000, 4096), 0);
+
+  a = m.free.next;
+  EXPECT_EQ(a->address, 0x0000);
+  EXPECT_EQ(a->next->address, 0x2000);
+  EXPECT_EQ(a->next->next, &m.free);
+
+  EXPECT_NE(mem_alloc_add_free(&m, 0x2000, 4096), 0);
+
+  EXPECT_EQ(mem_alloc_add_free(&m, 0x1000, 4096), 0);
+
+  a = m.free.next;
+  EXPECT_EQ(a->address, 0x0000);
+  EXPECT_EQ(a->size, 3 * 4096);
+  EXPECT_EQ(a->prev, &m.free);
+  EXPECT_EQ(a->next, &m.free);
+
+  mem_alloc_destroy(&m);
+  EXPECT_EQ(mem_alloc_index(&m), nullptr);
+}
+
+/**
+ * @test    indexed_get_put
+ * @brief   Test: mem_alloc_get(), mem_alloc_put()
+ * @details For a MEM_ALLOC_INDEXED allocator,<br>
+ *          allocations are size-aligned and first-fit,<br>
+ *          freeing an unknown address fails, and freeing<br>
+ *          everything restores a single free range.
+ */
+TEST(mem_alloc, indexed_get_put)
+{
+  struct mem_alloc m;
+  uint64_t a = 0;
+  uint64_t b = 0;
+  uint64_t c = 0;
+
+  ASSERT_EQ(mem_alloc_init_ex(&m, MEM_ALLOC_INDEXED), 0);
+  ASSERT_EQ(mem_alloc_add_free(&m, 0x1000, 0x7000), 0);
+
+  EXPECT_EQ(mem_alloc_get(&m, &a, 0x1000), 0);
+  EXPECT_EQ(a, 0x1000);
+  EXPECT_EQ(mem_alloc_get(&m, &b, 0x4000), 0);
+  EXPECT_EQ(b, 0x4000);
+  EXPECT_EQ(mem_alloc_get(&m, &c, 0x1000), 0);
+  EXPECT_EQ(c, 0x2000);
+
+  EXPECT_NE(mem_alloc_get(&m, &c, 0x4000), 0);
+  EXPECT_NE(mem_alloc_put(&m, 0x3000), 0);
+
+  EXPECT_EQ(mem_alloc_put(&m, b), 0);
+  EXPECT_NE(mem_alloc_put(&m, b), 0);
+  EXPECT_EQ(mem_alloc_put(&m, a), 0);
+  EXPECT_EQ(mem_alloc_put(&m, 0x2000), 0);
+
+  EXPECT_EQ(m.free.next->address, 0x1000);
+  EXPECT_EQ(m.free.next->size, 0x7000);
+  EXPECT_EQ(m.free.next->next, &m.free);
+
+  mem_alloc_destroy(&m);
+}
+
+/**
+ * @test    indexed_apply_constraint
+ * @brief   Test: mem_alloc_apply_constraint()
+ * @details For a MEM_ALLOC_INDEXED allocator,<br>
+ *          ranges outside the constraint are dropped<br>
+ *          and later allocations honor the result.
+ */
+TEST(mem_alloc, indexed_apply_constraint)
+{
+  struct mem_alloc m;
+  struct mem_alloc constr;
+  uint64_t a = 0;
+
+  ASSERT_EQ(mem_alloc_init_ex(&m, MEM_ALLOC_INDEXED), 0);
+  ASSERT_EQ(mem_alloc_add_free(&m, 0, 0x10000), 0);
+
+  mem_alloc_init(&constr);
+  ASSERT_EQ(mem_alloc_add_free(&constr, 0x4000, 0x4000), 0);
+
+  EXPECT_EQ(mem_alloc_apply_constraint(&m, &constr), 0);
+
+  EXPECT_EQ(m.free.next->address, 0x4000);
+  EXPECT_EQ(m.free.next->size, 0x4000);
+  EXPECT_EQ(m.free.next->next, &m.free);
+
+  EXPECT_EQ(mem_alloc_get(&m, &a, 0x1000), 0);
+  EXPECT_EQ(a, 0x4000);
+
+  mem_alloc_destroy(&constr);
+  mem_alloc_destroy(&m);
+}
+
+/**
+ * @test    indexed_matches_list
+ * @brief   Test: MEM_ALLOC_INDEXED
+ * @details A randomized sequence of gets and puts yields<br>
+ *          the same addresses and free lists from the<br>
+ *          indexed engine as from the default engine.
+ */
+TEST(mem_alloc, indexed_matches_list)
+{
+  struct mem_alloc list;
+  struct mem_alloc idx;
+  std::vector<uint64_t> live;
+  struct mem_link *p;
+  struct mem_link *q;
+  int i;
+
+  srand(0x5eed);
+
+  mem_alloc_init(&list);
+  ASSERT_EQ(mem_alloc_init_ex(&idx, MEM_ALLOC_INDEXED), 0);
+
+  ASSERT_EQ(mem_alloc_add_free(&list, 0x1000, 0x3ff000), 0);
+  ASSERT_EQ(mem_alloc_add_free(&idx, 0x1000, 0x3ff000), 0);
+
+  for (i = 0 ; i < 5000 ; ++i) {
+    if (live.empty() || (rand() % 3)) {
+      uint64_t size = UINT64_C(0x1000) << (rand() % 6);
+      uint64_t la = 0;
+      uint64_t ia = 0;
+      int lr = mem_alloc_get(&list, &la, size);
+      int ir = mem_alloc_get(&idx, &ia, size);
+
+      ASSERT_EQ(lr, ir);
+      if (!lr) {
+        ASSERT_EQ(la, ia);
+        live.push_back(la);
+      }
+    } else {
+      size_t j = rand() % live.size();
+
+      ASSERT_EQ(mem_alloc_put(&list, live[j]), 0);
+      ASSERT_EQ(mem_alloc_put(&idx, live[j]), 0);
+      live[j] = live.back();
+      live.pop_back();
+    }
+  }
+
+  for (p = list.free.next, q = idx.free.next ;
+       p != &list.free && q != &idx.free ;
+       p = p->next, q = q->next) {
+    EXPECT_EQ(p->address, q->address);
+    EXPECT_EQ(p->size, q->size);
+  }
+  EXPECT_EQ(p, &list.free);
+  EXPECT_EQ(q, &idx.free);
+
+  mem_alloc_destroy(&list);
+  mem_alloc_destroy(&idx);
+}
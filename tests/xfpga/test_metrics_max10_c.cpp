@@ -146,6 +146,58 @@ TEST_P(metrics_max10_c_p, test_metric_max10_2) {
   EXPECT_EQ(FPGA_OK, fpga_vector_free(&vector));
 }
 
+/**
+* @test       test_metric_max10_5
+* @brief      Tests: xfpga_fpgaGetMetricsAll
+* @details    The metric table is built once per handle, with each
+*             metric's limits classified at enumeration. Reading all
+*             metrics opens each value file once and keeps it open
+*             across calls.
+*/
+TEST_P(metrics_max10_c_p, test_metric_max10_5) {
+  struct _fpga_handle *_handle = (struct _fpga_handle *)device_;
+  uint64_t num_metrics = 0;
+  uint64_t i;
+
+  ASSERT_EQ(FPGA_OK, xfpga_fpgaGetNumMetrics(device_, &num_metrics));
+  ASSERT_GT(num_metrics, 0);
+
+  struct fpga_metric *metrics = (struct fpga_metric *)opae_calloc(
+         sizeof(struct fpga_metric), num_metrics + 1);
+  ASSERT_NE(metrics, nullptr);
+
+  uint64_t num = num_metrics + 1;
+  EXPECT_EQ(FPGA_OK, xfpga_fpgaGetMetricsAll(device_, metrics, &num));
+  EXPECT_EQ(num, num_metrics);
+
+  struct _fpga_enum_metric *m = (struct _fpga_enum_metric *)
+         fpga_vector_get(&_handle->fpga_enum_metric_vector, 0);
+  ASSERT_NE(m, nullptr);
+  EXPECT_NE(0, m->flags & FPGA_ENUM_METRIC_FD_OPEN);
+  int fd = m->value_fd;
+  EXPECT_GE(fd, 0);
+
+  for (i = 0; i < num; ++i) {
+    EXPECT_EQ(i, metrics[i].metric_num);
+    EXPECT_EQ(find_enum_metric(&_handle->fpga_enum_metric_vector, i)->metric_num, i);
+  }
+  EXPECT_EQ(nullptr, find_enum_metric(&_handle->fpga_enum_metric_vector, num));
+
+  // Same fd on the next pass.
+  EXPECT_EQ(FPGA_OK, xfpga_fpgaGetMetricsAll(device_, metrics, &num));
+  EXPECT_EQ(fd, m->value_fd);
+
+  uint64_t id = 0;
+  EXPECT_EQ(FPGA_OK, xfpga_fpgaGetMetricsByIndex(device_, &id, 1, metrics));
+  EXPECT_EQ(fd, m->value_fd);
+
+  EXPECT_EQ(FPGA_INVALID_PARAM, xfpga_fpgaGetMetricsAll(NULL, metrics, &num));
+  EXPECT_EQ(FPGA_INVALID_PARAM, xfpga_fpgaGetMetricsAll(device_, NULL, &num));
+  EXPECT_EQ(FPGA_INVALID_PARAM, xfpga_fpgaGetMetricsAll(device_, metrics, NULL));
+
+  opae_free(metrics);
+}
+
 GTEST_ALLOW_UNINSTANTIATED_PARAMETERIZED_TEST(metrics_max10_c_p);
 INSTANTIATE_TEST_SUITE_P(metrics_max10_c, metrics_max10_c_p,
                          ::testing::ValuesIn(test_platform::mock_platforms({"dfl-n3000"})));
@@ -340,7 +340,7 @@ TEST_P(metrics_utils_dcp_c_p, test_metric_utils_14) {
       FPGA_METRIC_DATATYPE_INT,
       FPGA_METRIC_TYPE_POWER,
       FPGA_HW_UNKNOWN,
-      0};
+      0, 0, -1, 0.0, 0.0};
 
   struct fpga_metric fpga_metric;
 
@@ -40,6 +40,10 @@ KEEP_XFPGA_SYMBOLS
 #include "types_int.h"
 #include "sysfs_int.h"
 
+#include <atomic>
+#include <thread>
+#include <vector>
+
 extern "C" {
 int xfpga_plugin_initialize(void);
 int xfpga_plugin_finalize(void);
@@ -446,6 +450,161 @@ TEST_P (mmio_c_p, test_neg_read_write_512) {
 #endif
 }
 
+/**
+* @test       mmio_c_p
+* @brief      Test: test_mmio_fast_path
+* @details    When the handle has OPAE_FLAG_MMIO_FASTPATH set:
+*             the first access maps and publishes the region,
+*             subsequent 32/64-bit accesses are served from the
+*             published region, out-of-region accesses still fail,
+*             and xfpga_fpgaUnmapMMIO retires the published region.
+*
+*/
+TEST_P (mmio_c_p, test_mmio_fast_path) {
+#ifndef BUILD_ASE
+  struct _fpga_handle *h = (struct _fpga_handle *)accel_;
+  uint64_t value64 = 0;
+  uint32_t value32 = 0;
+
+  h->flags |= OPAE_FLAG_MMIO_FASTPATH;
+  EXPECT_EQ(h->mmio_fast[0], nullptr);
+
+  // First access takes the slow path and publishes region 0.
+  EXPECT_EQ(FPGA_OK, xfpga_fpgaWriteMMIO64(accel_, 0, CSR_SCRATCHPAD0, 0xdecafbad));
+  ASSERT_NE(h->mmio_fast[0], nullptr);
+
+  EXPECT_EQ(FPGA_OK, xfpga_fpgaReadMMIO64(accel_, 0, CSR_SCRATCHPAD0, &value64));
+  EXPECT_EQ(0xdecafbad, value64);
+
+  EXPECT_EQ(FPGA_OK, xfpga_fpgaWriteMMIO32(accel_, 0, CSR_SCRATCHPAD0, 0xc0cac01a));
+  EXPECT_EQ(FPGA_OK, xfpga_fpgaReadMMIO32(accel_, 0, CSR_SCRATCHPAD0, &value32));
+  EXPECT_EQ(0xc0cac01a, value32);
+
+  EXPECT_NE(FPGA_OK, xfpga_fpgaReadMMIO64(accel_, 0, MMIO_OUT_REGION_ADDRESS, &value64));
+  // An offset that wraps offset + width must not pass the bounds check.
+  EXPECT_EQ(FPGA_INVALID_PARAM,
+            xfpga_fpgaReadMMIO64(accel_, 0, 0xfffffffffffffff8, &value64));
+  EXPECT_EQ(0, h->mmio_fast_users[0][0]);
+  EXPECT_EQ(0, h->mmio_fast_users[0][1]);
+
+  // A handle that fails the magic check never reaches the published region.
+  h->magic = FPGA_INVALID_MAGIC;
+  EXPECT_EQ(FPGA_INVALID_PARAM,
+            xfpga_fpgaReadMMIO64(accel_, 0, CSR_SCRATCHPAD0, &value64));
+  EXPECT_EQ(FPGA_INVALID_PARAM,
+            xfpga_fpgaWriteMMIO32(accel_, 0, CSR_SCRATCHPAD0, 0));
+  h->magic = FPGA_HANDLE_MAGIC;
+
+  EXPECT_EQ(FPGA_OK, xfpga_fpgaUnmapMMIO(accel_, 0));
+  EXPECT_EQ(h->mmio_fast[0], nullptr);
+  EXPECT_EQ(1, h->mmio_fast_epoch[0]);
+  EXPECT_TRUE(mmio_map_is_empty(h->mmio_root));
+#endif
+}
+
+/**
+* @test       mmio_c_p
+* @brief      Test: test_mmio_fast_path_unmap_mt
+* @details    When the handle has OPAE_FLAG_MMIO_FASTPATH set and
+*             several threads read CSRs continuously,
+*             xfpga_fpgaUnmapMMIO and the remapping done by the
+*             next slow path access complete repeatedly while the
+*             traffic continues, and every read succeeds.
+*
+*/
+TEST_P (mmio_c_p, test_mmio_fast_path_unmap_mt) {
+#ifndef BUILD_ASE
+  struct _fpga_handle *h = (struct _fpga_handle *)accel_;
+  std::atomic<bool> stop(false);
+  std::atomic<uint64_t> reads(0);
+  std::atomic<uint64_t> failures(0);
+  std::vector<std::thread> readers;
+  uint64_t value64 = 0;
+  int unmapped = 0;
+
+  h->flags |= OPAE_FLAG_MMIO_FASTPATH;
+  ASSERT_EQ(FPGA_OK, xfpga_fpgaReadMMIO64(accel_, 0, CSR_SCRATCHPAD0, &value64));
+  ASSERT_NE(h->mmio_fast[0], nullptr);
+
+  for (int i = 0; i < 4; ++i) {
+    readers.emplace_back([&]() {
+      uint64_t v;
+      while (!stop) {
+        if (xfpga_fpgaReadMMIO64(accel_, 0, CSR_SCRATCHPAD0, &v) != FPGA_OK)
+          ++failures;
+        ++reads;
+      }
+    });
+  }
+
+  for (int i = 0; i < 200; ++i) {
+    // Let the readers remap and republish the region.
+    uint64_t start = reads;
+    while (reads < start + 100)
+      std::this_thread::yield();
+    if (xfpga_fpgaUnmapMMIO(accel_, 0) == FPGA_OK)
+      ++unmapped;
+  }
+
+  stop = true;
+  for (auto &t : readers)
+    t.join();
+
+  EXPECT_GT(unmapped, 0);
+  EXPECT_EQ(0, failures);
+  EXPECT_EQ(0, h->mmio_fast_users[0][0]);
+  EXPECT_EQ(0, h->mmio_fast_users[0][1]);
+
+  xfpga_fpgaUnmapMMIO(accel_, 0);
+  EXPECT_EQ(h->mmio_fast[0], nullptr);
+#endif
+}
+
+/**
+* @test       mmio_c_p
+* @brief      Test: test_mmio_batch
+* @details    When the parameters are valid and the drivers are loaded:
+*             xfpga_fpgaWriteMMIOBatch writes a contiguous qword run and a
+*             dword, and xfpga_fpgaReadMMIOBatch reads the same values back.
+*             A batch containing an out-of-region descriptor fails without
+*             performing any of its accesses.
+*
+*/
+TEST_P (mmio_c_p, test_mmio_batch) {
+#ifndef BUILD_ASE
+  uint64_t* mmio_ptr = NULL;
+  fpga_mmio_op wr[3] = {
+    { CSR_SCRATCHPAD0, 8, 0xdeadbeefdecafbad },
+    { CSR_SCRATCHPAD0 + 8, 8, 0x0123456789abcdef },
+    { CSR_SCRATCHPAD0 + 16, 4, 0xc0cac01a }
+  };
+  fpga_mmio_op rd[3] = {
+    { CSR_SCRATCHPAD0, 8, 0 },
+    { CSR_SCRATCHPAD0 + 8, 8, 0 },
+    { CSR_SCRATCHPAD0 + 16, 4, 0 }
+  };
+
+  ASSERT_EQ(FPGA_OK, xfpga_fpgaMapMMIO(accel_, 0, &mmio_ptr));
+  ASSERT_NE(mmio_ptr, nullptr);
+
+  EXPECT_EQ(FPGA_OK, xfpga_fpgaWriteMMIOBatch(accel_, 0, wr, 3));
+  EXPECT_EQ(0xdeadbeefdecafbad, mmio_ptr[CSR_SCRATCHPAD0 / sizeof(uint64_t)]);
+  EXPECT_EQ(0x0123456789abcdef, mmio_ptr[CSR_SCRATCHPAD0 / sizeof(uint64_t) + 1]);
+
+  EXPECT_EQ(FPGA_OK, xfpga_fpgaReadMMIOBatch(accel_, 0, rd, 3));
+  for (int i = 0 ; i < 3 ; ++i)
+    EXPECT_EQ(wr[i].value, rd[i].value);
+
+  // The bad descriptor is last; the first write must not land.
+  wr[0].value = 0;
+  wr[2].offset = MMIO_OUT_REGION_ADDRESS;
+  EXPECT_EQ(FPGA_INVALID_PARAM, xfpga_fpgaWriteMMIOBatch(accel_, 0, wr, 3));
+  EXPECT_EQ(0xdeadbeefdecafbad, mmio_ptr[CSR_SCRATCHPAD0 / sizeof(uint64_t)]);
+
+  EXPECT_EQ(FPGA_OK, xfpga_fpgaUnmapMMIO(accel_, 0));
+#endif
+}
+
 GTEST_ALLOW_UNINSTANTIATED_PARAMETERIZED_TEST(mmio_c_p);
 INSTANTIATE_TEST_SUITE_P(mmio_c, mmio_c_p,
                          ::testing::ValuesIn(test_platform::platforms({
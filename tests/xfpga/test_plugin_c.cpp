@@ -41,6 +41,7 @@ int xfpga_plugin_initialize(void);
 int xfpga_plugin_finalize(void);
 int opae_plugin_configure(opae_api_adapter_table *adapter,
                           const char *jsonConfig);
+extern bool xfpga_mmio_fast_path;
 }
 
 using namespace opae::testing;
@@ -118,6 +119,30 @@ TEST_P(xfpga_plugin_c_p, test_plugin_2) {
     opae_plugin_mgr_free_adapter_test(adapter_table);
 }
 
+/*
+* @test       plugin
+* @brief      Tests:opae_plugin_configure
+* @details    The "mmio-fast-path" configuration key selects the
+*             lock-free MMIO path. Malformed configurations are rejected.<br>
+*/
+TEST_P(xfpga_plugin_c_p, test_plugin_mmio_fast_path) {
+
+  opae_api_adapter_table *adapter_table = opae_plugin_mgr_alloc_adapter_test("libxfpga.so");
+
+  EXPECT_EQ(opae_plugin_configure(adapter_table, "{ \"mmio-fast-path\": true }"), 0);
+  EXPECT_TRUE(xfpga_mmio_fast_path);
+
+  EXPECT_EQ(opae_plugin_configure(adapter_table, "{}"), 0);
+  EXPECT_FALSE(xfpga_mmio_fast_path);
+
+  EXPECT_NE(opae_plugin_configure(adapter_table, "{ \"mmio-fast-path\": 1 }"), 0);
+  EXPECT_NE(opae_plugin_configure(adapter_table, "{ bad json"), 0);
+  EXPECT_FALSE(xfpga_mmio_fast_path);
+
+  if (adapter_table)
+    opae_plugin_mgr_free_adapter_test(adapter_table);
+}
+
 GTEST_ALLOW_UNINSTANTIATED_PARAMETERIZED_TEST(xfpga_plugin_c_p);
 INSTANTIATE_TEST_SUITE_P(xfpga_plugin_c, xfpga_plugin_c_p,
                          ::testing::ValuesIn(test_platform::mock_platforms({
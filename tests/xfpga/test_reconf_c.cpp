@@ -43,6 +43,9 @@ fpga_result open_accel(fpga_handle handle, fpga_token *token, fpga_handle *accel
 fpga_result clear_port_errors(fpga_handle handle);
 fpga_result validate_bitstream(fpga_handle, const uint8_t *bitstream, 
                                size_t bitstream_len, int *header_len);
+fpga_result read_streamed_bitstream(fpga_handle fpga, int fd,
+                                    uint8_t **bitstream,
+                                    size_t *bitstream_len);
 int xfpga_plugin_initialize(void);
 int xfpga_plugin_finalize(void);
 }
@@ -379,6 +382,94 @@ TEST_P(reconf_c_mock_p, fpga_reconf_slot_enotsup) {
   EXPECT_EQ(result, FPGA_EXCEPTION);
 }
 
+/**
+ * @test    fpga_reconf_slot_by_fd
+ * @brief   Tests: fpgaReconfigureSlotByFd
+ * @details Given a valid bitstream in a regular file or in a pipe,
+ *          fpgaReconfigureSlotByFd returns FPGA_OK. Given an invalid
+ *          file descriptor it returns FPGA_INVALID_PARAM.
+ */
+TEST_P(reconf_c_mock_p, fpga_reconf_slot_by_fd) {
+  char tmpfile[] = "reconf-XXXXXX.gbs";
+  int fd = mkstemps(tmpfile, 4);
+  ASSERT_GE(fd, 0);
+  ASSERT_EQ(write(fd, bitstream_valid_.data(), bitstream_valid_.size()),
+            (ssize_t)bitstream_valid_.size());
+  ASSERT_EQ(lseek(fd, 0, SEEK_SET), 0);
+
+  EXPECT_EQ(xfpga_fpgaReconfigureSlotByFd(device_, 0, fd, 0), FPGA_OK);
+  EXPECT_EQ(lseek(fd, 0, SEEK_CUR), (off_t)bitstream_valid_.size());
+
+  // nothing left to read
+  EXPECT_EQ(xfpga_fpgaReconfigureSlotByFd(device_, 0, fd, 0),
+            FPGA_INVALID_PARAM);
+  close(fd);
+  unlink(tmpfile);
+
+  int fds[2];
+  ASSERT_EQ(pipe(fds), 0);
+  ASSERT_EQ(write(fds[1], bitstream_valid_.data(), bitstream_valid_.size()),
+            (ssize_t)bitstream_valid_.size());
+  close(fds[1]);
+
+  EXPECT_EQ(xfpga_fpgaReconfigureSlotByFd(device_, 0, fds[0], 0), FPGA_OK);
+  close(fds[0]);
+
+  EXPECT_EQ(xfpga_fpgaReconfigureSlotByFd(device_, 0, -1, 0),
+            FPGA_INVALID_PARAM);
+  EXPECT_EQ(xfpga_fpgaReconfigureSlotByFd(NULL, 0, 0, 0),
+            FPGA_INVALID_PARAM);
+}
+
+/**
+ * @test    read_streamed_bitstream
+ * @brief   Tests: read_streamed_bitstream
+ * @details Given a pipe, read_streamed_bitstream returns the whole
+ *          bitstream. A truncated header or metadata, or a bad GUID, is
+ *          rejected with FPGA_INVALID_PARAM before the rest is read.
+ */
+TEST_P(reconf_c_mock_p, read_streamed_bitstream) {
+  int fds[2];
+  uint8_t *buf = nullptr;
+  size_t len = 0;
+  std::vector<uint8_t> gbs(bitstream_valid_);
+  gbs.insert(gbs.end(), 4096, 0x5a);
+
+  ASSERT_EQ(pipe(fds), 0);
+  ASSERT_EQ(write(fds[1], gbs.data(), gbs.size()), (ssize_t)gbs.size());
+  close(fds[1]);
+  ASSERT_EQ(read_streamed_bitstream(device_, fds[0], &buf, &len), FPGA_OK);
+  close(fds[0]);
+  ASSERT_EQ(len, gbs.size());
+  EXPECT_EQ(memcmp(buf, gbs.data(), len), 0);
+  opae_free(buf);
+
+  // truncated metadata
+  ASSERT_EQ(pipe(fds), 0);
+  ASSERT_EQ(write(fds[1], gbs.data(), 24), 24);
+  close(fds[1]);
+  EXPECT_EQ(read_streamed_bitstream(device_, fds[0], &buf, &len),
+            FPGA_INVALID_PARAM);
+  close(fds[0]);
+
+  // invalid GUID
+  gbs[0] ^= 0xff;
+  ASSERT_EQ(pipe(fds), 0);
+  ASSERT_EQ(write(fds[1], gbs.data(), gbs.size()), (ssize_t)gbs.size());
+  close(fds[1]);
+  EXPECT_EQ(read_streamed_bitstream(device_, fds[0], &buf, &len),
+            FPGA_INVALID_PARAM);
+  close(fds[0]);
+
+  // truncated header
+  ASSERT_EQ(pipe(fds), 0);
+  ASSERT_EQ(write(fds[1], gbs.data(), 8), 8);
+  close(fds[1]);
+  EXPECT_EQ(read_streamed_bitstream(device_, fds[0], &buf, &len),
+            FPGA_INVALID_PARAM);
+  close(fds[0]);
+}
+
 GTEST_ALLOW_UNINSTANTIATED_PARAMETERIZED_TEST(reconf_c_mock_p);
 INSTANTIATE_TEST_SUITE_P(reconf, reconf_c_mock_p,
                          ::testing::ValuesIn(test_platform::mock_platforms({ "dfl-n3000","dfl-d5005" })));
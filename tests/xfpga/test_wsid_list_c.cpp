@@ -186,3 +186,60 @@ TEST_F(wsid_list_f, stress) {
   EXPECT_EQ(stress_count, 0);
   wsid_root_ = nullptr;
 }
+
+/*
+ * @test    wsid_take
+ *
+ * @details wsid_take() removes the entry and returns a copy of it.
+ *          A second take of the same wsid fails.
+ */
+TEST_F(wsid_list_f, wsid_take) {
+  uint64_t index = distribution_(generator_) % count_;
+  wsid_map wm;
+
+  EXPECT_TRUE(wsid_lookup(wsid_root_, index_to_wsid(index), &wm));
+  EXPECT_EQ(wm.phys, index_to_phys(index));
+
+  EXPECT_TRUE(wsid_take(wsid_root_, index_to_wsid(index), &wm));
+  EXPECT_EQ(wm.addr, index_to_addr(index));
+  EXPECT_EQ(wm.len, index_to_len(index));
+  EXPECT_EQ(wm.next, nullptr);
+
+  EXPECT_FALSE(wsid_take(wsid_root_, index_to_wsid(index), &wm));
+  EXPECT_FALSE(wsid_lookup(wsid_root_, index_to_wsid(index), &wm));
+  EXPECT_EQ(wsid_find(wsid_root_, index_to_wsid(index)), nullptr);
+}
+
+/*
+ * @test    wsid_indexed
+ *
+ * @details For a tracker created by wsid_tracker_init_indexed(),
+ *          wsid_find_by_index() returns the entry for a small index
+ *          from the direct table, and deleting it clears the slot.
+ */
+TEST(wsid_list, wsid_indexed) {
+  struct wsid_tracker *root = wsid_tracker_init_indexed(4, 8);
+  ASSERT_NE(root, nullptr);
+  EXPECT_EQ(root->n_index_slots, 8);
+
+  EXPECT_EQ(wsid_find_by_index(root, 2), nullptr);
+
+  EXPECT_TRUE(wsid_add(root, 100, 0x1000, 0, 0x1000, 0x1000, 2, 0));
+  EXPECT_TRUE(wsid_add(root, 101, 0x2000, 0, 0x1000, 0x2000, 9, 0));
+
+  wsid_map *wm = wsid_find_by_index(root, 2);
+  ASSERT_NE(wm, nullptr);
+  EXPECT_EQ(wm->wsid, 100);
+  EXPECT_EQ(root->index_table[2], wm);
+
+  // Indices beyond the table fall back to the bucket scan.
+  wm = wsid_find_by_index(root, 9);
+  ASSERT_NE(wm, nullptr);
+  EXPECT_EQ(wm->wsid, 101);
+
+  EXPECT_TRUE(wsid_del(root, 100));
+  EXPECT_EQ(root->index_table[2], nullptr);
+  EXPECT_EQ(wsid_find_by_index(root, 2), nullptr);
+
+  wsid_tracker_cleanup(root, nullptr);
+}